@@ -0,0 +1,25 @@
+//密钥协商数据包定义
+
+#ifndef KEY_EXCHANGE_PACKET_H
+#define KEY_EXCHANGE_PACKET_H
+
+#include "packet_types.h"
+#include "../../security/asymmetric/key_management/key_exchange.h"
+
+#define KEY_EXCHANGE_VERSION 1
+
+#pragma pack(push, 1)
+// INIT 与 REPLY 共用格式，ctrl.type区分方向:
+//   INIT : session_id = 0, confirm全0
+//   REPLY: session_id为发送端分配的会话ID (网络字节序)，confirm为密钥确认值
+struct KeyExchangePacket {
+    ControlHeader ctrl;
+    uint8_t version;
+    uint32_t session_id;
+    uint8_t nonce[KEY_EXCHANGE_NONCE_SIZE];
+    uint8_t public_key[SM2_POINT_SIZE];
+    uint8_t confirm[KEY_EXCHANGE_CONFIRM_SIZE];
+};
+#pragma pack(pop)
+
+#endif
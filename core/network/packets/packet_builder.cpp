@@ -8,6 +8,7 @@
 #include <cstring>
 #include <string.h>
 #include "../../security/crypto/random_generator.h"
+#include "../../../utils/performance/metrics.h"
 #include "../../network/session/session_manager.h"
 #include "../../network/session/session_context.h"
 
@@ -26,7 +27,7 @@ vector<uint8_t> PacketBuilder::BuildPacket(
     }
 
     // 获取会话信息
-    SessionContext* session = SessionManager::GetInstance().GetSession(session_id);
+    SessionHandle session = SessionManager::GetInstance().GetSession(session_id);
     if (!session || !session->IsValid()) {
         throw std::runtime_error("Invalid session");
     }
@@ -43,8 +44,8 @@ vector<uint8_t> PacketBuilder::BuildPacket(
         throw std::runtime_error("Failed to initialize SM4");
     }
     memcpy(ctx_4.iv, iv, 16);
-    vector<uint8_t> ciphertext(payload_len);
-    sm4_crypt_cbc(&ctx_4, 1, payload, ciphertext.data(), payload_len);
+    vector<uint8_t> ciphertext(sm4_cbc_padded_len(payload_len));
+    sm4_cbc_encrypt_padded(&ctx_4, payload, payload_len, ciphertext.data());
     
     // 计算SM3哈希
     SM3_CTX ctx_3;
@@ -57,8 +58,10 @@ vector<uint8_t> PacketBuilder::BuildPacket(
 
     // 构建数据包头
     PacketHeader header;
+    memset(&header, 0, sizeof(header));
     header.session_id = htonl(session_id);
     header.seq_num = htonl(session->GetAndIncrementSeq());
+    header.total_fragments = htons(1);
     header.payload_len = htons(static_cast<uint16_t>(ciphertext.size()));
     memcpy(header.iv, iv, 16);
     memcpy(header.sm3_digest, digest, 32);
@@ -70,6 +73,11 @@ vector<uint8_t> PacketBuilder::BuildPacket(
     packet.insert(packet.end(), header_ptr, header_ptr + sizeof(PacketHeader));
     packet.insert(packet.end(), ciphertext.begin(), ciphertext.end());
 
+    // 缓存序列化结果，重传时原样发送 (不重新加密、不占用新seq)
+    if (RetransmitBuffer* rtx = session->GetRetransmitBuffer()) {
+        rtx->Store(ntohl(header.seq_num), packet.data(), packet.size());
+    }
+
     return packet;
 }
 
@@ -89,10 +97,14 @@ bool PacketBuilder::ParsePacket(
     memcpy(&header, packet_data, sizeof(PacketHeader));
     header.session_id = ntohl(header.session_id);
     header.seq_num = ntohl(header.seq_num);
+    header.fragment_id = ntohs(header.fragment_id);
+    header.stream_seq = ntohl(header.stream_seq);
+    header.timestamp = ntohl(header.timestamp);
+    header.total_fragments = ntohs(header.total_fragments);
     header.payload_len = ntohs(header.payload_len);
 
     // 确保session有效性检查
-    SessionContext* session = SessionManager::GetInstance().GetSession(header.session_id);
+    SessionHandle session = SessionManager::GetInstance().GetSession(header.session_id);
     if (!session || !session->IsValid()) {
         throw runtime_error("无效或过期的会话");
     }
@@ -115,7 +127,7 @@ bool PacketBuilder::ParsePacket(
     }
     memcpy(ctx_4.iv, iv, 16);
     decrypted_payload.resize(header.payload_len);
-    sm4_crypt_cbc(&ctx_4, 0, ciphertext, decrypted_payload.data(), header.payload_len);
+    size_t plain_len = sm4_cbc_decrypt_padded(&ctx_4, ciphertext, header.payload_len, decrypted_payload.data());
 
     //计算SM3哈希值并验证完整性
     SM3_CTX ctx;
@@ -127,5 +139,194 @@ bool PacketBuilder::ParsePacket(
     uint8_t digest[32];
     sm3_final(&ctx, digest);
 
-    return memcmp(digest, header.sm3_digest, 32) == 0; // 验证哈希值
-}
\ No newline at end of file
+    if (memcmp(digest, header.sm3_digest, 32) != 0) return false; // 验证哈希值
+    if (plain_len == 0) return false; // 填充不合法
+    decrypted_payload.resize(plain_len);
+    return true;
+}
+
+bool PacketBuilder::ParsePacket(
+    const sockaddr_in& from,
+    const uint8_t* packet_data,
+    size_t packet_len,
+    PacketHeader& header,
+    vector<uint8_t>& decrypted_payload,
+    const uint8_t sm4_key[16],
+    const uint8_t sm3_salt[32]
+) {
+    if (packet_len < sizeof(PacketHeader)) {
+        return false; //数据包长度不足
+    }
+
+    uint32_t session_id;
+    memcpy(&session_id, packet_data, sizeof(session_id));
+    if (!SessionManager::GetInstance().Demux(from, ntohl(session_id))) {
+        return false; //来源地址与会话不匹配
+    }
+    return ParsePacket(packet_data, packet_len, header, decrypted_payload, sm4_key, sm3_salt);
+}
+
+size_t PacketBuilder::SealInPlace(SessionContext& session, uint8_t* buf, size_t capacity, bool retain) {
+    if (!buf || capacity < sizeof(PacketHeader)) return 0;
+
+    PacketHeader header;
+    memcpy(&header, buf, sizeof(PacketHeader));
+    const size_t plain_len = ntohs(header.payload_len);
+    const size_t cipher_len = sm4_cbc_padded_len(plain_len);
+    if (plain_len == 0 || cipher_len > UINT16_MAX || sizeof(PacketHeader) + cipher_len > capacity) return 0;
+
+    // 复制当前epoch的密钥，轮换在其他线程发生也不影响本包
+    KeyMaterial keys;
+    if (!session.GetKeys().AcquireForSend(&keys)) return 0;
+    session.UpdateLastActive();   // 发送端持有句柄直接封装，不经过GetSession
+    if (!utils::SecureRandom::GenerateIV(header.iv)) {
+        memset(&keys, 0, sizeof(keys));
+        return 0;
+    }
+
+    uint8_t* ciphertext = buf + sizeof(PacketHeader);
+    utils::StageTimer timer(utils::Stage::Encrypt);
+    memcpy(keys.sm4.iv, header.iv, 16);
+    sm4_cbc_encrypt_padded(&keys.sm4, ciphertext, plain_len, ciphertext);
+
+    timer.Next(utils::Stage::Hash);
+    SM3_CTX ctx_3;
+    sm3_init(&ctx_3);
+    sm3_update(&ctx_3, keys.salt, 32);
+    sm3_update(&ctx_3, header.iv, 16);
+    sm3_update(&ctx_3, ciphertext, cipher_len);
+    sm3_final(&ctx_3, header.sm3_digest);
+    timer.Stop();
+
+    header.payload_len = htons(static_cast<uint16_t>(cipher_len));
+    header.flags = (header.flags & ~PACKET_FLAG_KEY_EPOCH) | ((keys.epoch & 1) ? PACKET_FLAG_KEY_EPOCH : 0);
+    memcpy(buf, &header, sizeof(PacketHeader));
+    memset(&keys, 0, sizeof(keys));
+
+    const size_t packet_len = sizeof(PacketHeader) + cipher_len;
+    // 缓存序列化结果，重传时原样发送 (不重新加密、不占用新seq)
+    RetransmitBuffer* rtx = retain ? session.GetRetransmitBuffer() : nullptr;
+    if (rtx) {
+        rtx->Store(ntohl(header.seq_num), buf, packet_len);
+    }
+    return packet_len;
+}
+
+size_t PacketBuilder::OpenPacket(
+    const sockaddr_in& from,
+    const uint8_t* packet_data,
+    size_t packet_len,
+    PacketHeader& header,
+    uint8_t* out
+) {
+    if (!packet_data || !out || packet_len < sizeof(PacketHeader)) {
+        return 0; //数据包长度不足
+    }
+
+    memcpy(&header, packet_data, sizeof(PacketHeader));
+    header.session_id = ntohl(header.session_id);
+    header.seq_num = ntohl(header.seq_num);
+    header.fragment_id = ntohs(header.fragment_id);
+    header.stream_seq = ntohl(header.stream_seq);
+    header.timestamp = ntohl(header.timestamp);
+    header.total_fragments = ntohs(header.total_fragments);
+    header.payload_len = ntohs(header.payload_len);
+
+    if (packet_len != PacketLength(header.payload_len, header.flags)) {
+        utils::Metrics::Count(utils::Event::Malformed);
+        return 0; // 数据包长度不匹配
+    }
+
+    SessionHandle session = SessionManager::GetInstance().Demux(from, header.session_id);
+    if (!session) {
+        utils::Metrics::Count(utils::Event::DemuxFailures);
+        return 0; //来源地址与会话不匹配
+    }
+
+    KeyMaterial keys;
+    SessionKeys& session_keys = session->GetKeys();
+    if (!session_keys.AcquireForReceive((header.flags & PACKET_FLAG_KEY_EPOCH) ? 1 : 0, &keys)) {
+        utils::Metrics::Count(utils::Event::KeyUnavailable);
+        return 0; //该epoch的密钥不可用 (过旧或尚未派生)
+    }
+
+    const uint8_t* ciphertext = packet_data + sizeof(PacketHeader);
+
+    utils::StageTimer timer(utils::Stage::Verify);
+    SM3_CTX ctx;
+    uint8_t digest[32];
+    sm3_init(&ctx);
+    sm3_update(&ctx, keys.salt, 32);
+    sm3_update(&ctx, header.iv, 16);
+    sm3_update(&ctx, ciphertext, header.payload_len);
+    sm3_final(&ctx, digest);
+    if (memcmp(digest, header.sm3_digest, 32) != 0) {
+        memset(&keys, 0, sizeof(keys));
+        utils::Metrics::Count(utils::Event::AuthFailures);
+        return 0;
+    }
+    timer.Stop();
+
+    // 对端已切换到新epoch
+    if (keys.epoch != session_keys.GetEpoch()) {
+        session_keys.ConfirmEpoch(keys.epoch);
+    }
+
+    utils::StageTimer decrypt_timer(utils::Stage::Decrypt);
+    memcpy(keys.sm4.iv, header.iv, 16);
+    size_t plain_len = sm4_cbc_decrypt_padded(&keys.sm4, ciphertext, header.payload_len, out);
+    decrypt_timer.Stop();
+    memset(&keys, 0, sizeof(keys));
+    return plain_len;
+}
+
+vector<uint8_t> PacketBuilder::BuildPacket(
+    uint32_t session_id,
+    const uint8_t* payload,
+    size_t payload_len)
+{
+    if (!payload || payload_len == 0 || payload_len >= UINT16_MAX) {
+        throw std::runtime_error("Invalid parameters");
+    }
+
+    SessionHandle session = SessionManager::GetInstance().GetSession(session_id);
+    if (!session || !session->IsValid()) {
+        throw std::runtime_error("Invalid session");
+    }
+    if (!session->GetKeys().IsInstalled()) {
+        throw std::runtime_error("Session keys not installed");
+    }
+
+    vector<uint8_t> packet(sizeof(PacketHeader) + sm4_cbc_padded_len(payload_len));
+    PacketHeader header;
+    memset(&header, 0, sizeof(header));
+    header.session_id = htonl(session_id);
+    header.seq_num = htonl(session->GetAndIncrementSeq());
+    header.total_fragments = htons(1);
+    header.payload_len = htons(static_cast<uint16_t>(payload_len));
+    memcpy(packet.data(), &header, sizeof(PacketHeader));
+    memcpy(packet.data() + sizeof(PacketHeader), payload, payload_len);
+
+    size_t len = SealInPlace(*session, packet.data(), packet.size());
+    if (len == 0) {
+        throw std::runtime_error("Failed to seal packet");
+    }
+    packet.resize(len);
+    return packet;
+}
+
+bool PacketBuilder::ParsePacket(
+    const sockaddr_in& from,
+    const uint8_t* packet_data,
+    size_t packet_len,
+    PacketHeader& header,
+    vector<uint8_t>& decrypted_payload
+) {
+    if (packet_len < sizeof(PacketHeader)) {
+        return false; //数据包长度不足
+    }
+    decrypted_payload.resize(packet_len - sizeof(PacketHeader));
+    size_t plain_len = OpenPacket(from, packet_data, packet_len, header, decrypted_payload.data());
+    decrypted_payload.resize(plain_len);
+    return plain_len != 0;
+}
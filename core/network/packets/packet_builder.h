@@ -6,6 +6,9 @@
 #include "packet_types.h"
 #include <vector>
 #include <cstdint>
+#include <netinet/in.h>
+
+class SessionContext;
 
 class PacketBuilder {
 public:
@@ -18,8 +21,31 @@ public:
         const uint8_t sm3_salt[32]  // SM3盐值
     );
 
+    // 使用会话当前密钥加密 (会话须已安装密钥)，包头携带密钥epoch位，密钥轮换对调用方透明
+    static std::vector<uint8_t> BuildPacket(
+        uint32_t session_id,
+        const uint8_t* payload,
+        size_t payload_len
+    );
+
+    // 原地封装: buf为包头+明文，返回数据包总长度，失败返回0; 可多线程并发调用
+    // retain为false时不存入重传缓冲区 (发送前还会改写seq的调用方使用)
+    static size_t SealInPlace(SessionContext& session, uint8_t* buf, size_t capacity, bool retain = true);
+
+    // 校验SM3后解密，明文写入out (可与密文原地重合)，header为主机字节序; 返回明文长度，失败返回0
+    // 带PACKET_FLAG_TRACE时密文之后的FrameTrace不参与校验
+    static size_t OpenPacket(const sockaddr_in &from, const uint8_t *packet_data, size_t packet_len,
+                             PacketHeader &header, uint8_t *out);
+
     bool ParsePacket(const uint8_t *packet_data, size_t packet_len, PacketHeader &header, std::vector<uint8_t> &decrypted_payload, const uint8_t sm4_key[16], const uint8_t sm3_salt[32]);
 
+    // 先按来源地址分流: 地址未绑定到包头session_id时直接返回false，不做解密与哈希
+    bool ParsePacket(const sockaddr_in &from, const uint8_t *packet_data, size_t packet_len, PacketHeader &header, std::vector<uint8_t> &decrypted_payload, const uint8_t sm4_key[16], const uint8_t sm3_salt[32]);
+
+    // 按来源地址分流后，用包头epoch位选择会话密钥; 先校验SM3再解密，
+    // 旧epoch的乱序包在宽限期内仍可解密
+    bool ParsePacket(const sockaddr_in &from, const uint8_t *packet_data, size_t packet_len, PacketHeader &header, std::vector<uint8_t> &decrypted_payload);
+
 };
 
 #endif 
\ No newline at end of file
@@ -4,20 +4,97 @@
 #ifndef PACKET_TYPES_H
 #define PACKET_TYPES_H
 
+#include <cstddef>
 #include <cstdint>
 
 
+// 媒体时间戳 (PacketHeader.timestamp) 的时钟频率，音视频统一换算到该时钟
+const uint32_t MEDIA_CLOCK_HZ = 90000;
+
+// PacketHeader.stream_id
+enum MediaStream : uint8_t {
+    MEDIA_STREAM_VIDEO = 0,    // H.264 Annex B
+    MEDIA_STREAM_AUDIO = 1,    // AAC-LC，无ADTS头
+    MEDIA_STREAM_COUNT
+};
+
+// SM3摘要只覆盖盐值、IV与密文: 扇出时按订阅者改写seq不需重算，篡改包头只会造成丢帧
 #pragma pack(push, 1)
 struct PacketHeader {
     uint32_t session_id;
-    uint32_t seq_num;
+    uint32_t seq_num;          // 传输序号: 按实际发出顺序连续编号，ACK与拥塞控制使用
     uint16_t fragment_id;      // 分片序号
     uint16_t total_fragments;  // 总分片数
     uint16_t payload_len;
+    uint8_t flags;             // PACKET_FLAG_*
+    uint8_t stream_id;         // MEDIA_STREAM_*
+    uint32_t stream_seq;       // 流内序号: 各流独立连续编号，接收端按流重组 (帧号 = stream_seq - fragment_id)
+    uint32_t timestamp;        // 媒体时间戳 (MEDIA_CLOCK_HZ)，同一帧的各分片相同
     uint8_t iv[16];         
     uint8_t sm3_digest[32]; 
 };
+
+// PacketHeader.flags
+enum PacketFlags : uint8_t {
+    PACKET_FLAG_KEYFRAME = 0x01,   // 分片属于关键帧 (供接收端在解密前判断)
+    PACKET_FLAG_KEY_EPOCH = 0x02,  // 加密所用会话密钥epoch的最低位
+    PACKET_FLAG_UNIT_END = 0x04,   // 分片结束于NAL边界: 接收端可把到此为止的连续分片先交给解码器
+    PACKET_FLAG_TRACE = 0x08,      // 密文之后附带FrameTrace (只出现在帧的最后一个分片)
+};
+
+// 帧追踪扩展 (网络字节序): 发送端各环节的时刻，CLOCK_MONOTONIC微秒的低32位，0表示未记录。
+// 与包头一样不在SM3摘要范围内，只用于延迟诊断; 封装后才追加，重传缓冲区中的副本不带扩展
+struct FrameTrace {
+    uint32_t capture_us;
+    uint32_t encode_us;
+    uint32_t encrypt_us;
+    uint32_t send_us;
+};
+
+// 控制包: 首4字节为0 (会话ID从1开始分配，不会与数据包冲突)
+enum ControlType : uint8_t {
+    CONTROL_ACK = 1,
+    CONTROL_KEY_EXCHANGE_INIT = 2,     // 接收端 -> 发送端: 发起密钥协商
+    CONTROL_KEY_EXCHANGE_REPLY = 3,    // 发送端 -> 接收端: 分配会话并返回确认值
+    CONTROL_KEYFRAME_REQUEST = 4,      // 接收端 -> 发送端: 参考链断裂，请求尽快编码关键帧
+    CONTROL_GROUP_KEY = 5,             // 发送端 -> 接收端: 用点对点会话密钥包装的组密钥
+};
+
+struct ControlHeader {
+    uint32_t zero;
+    uint8_t type;
+};
+
+// 确认包: ack_delay_us 为接收端从收包到发出ACK的延迟，发送端据此修正RTT样本
+struct AckPacket {
+    ControlHeader ctrl;
+    uint32_t session_id;
+    uint32_t seq_num;
+    uint32_t ack_delay_us;
+};
+
+// 关键帧请求: 发送端按最小间隔限流，重复请求只产生一个关键帧
+struct KeyframeRequestPacket {
+    ControlHeader ctrl;
+    uint32_t session_id;
+};
+// 组密钥: wrapped = SM4-CBC(点对点会话密钥, iv, 组密钥16B || 组盐值32B)，带填充共64B;
+// mac = SM3(点对点会话盐值 || mac之前的所有字段)。接收端之后按group_id解密数据报
+struct GroupKeyPacket {
+    ControlHeader ctrl;
+    uint32_t session_id;        // 接收端的点对点会话
+    uint32_t group_id;
+    uint32_t epoch;             // 组密钥当前epoch，中途加入的接收端从该epoch开始跟随轮换
+    uint8_t iv[16];
+    uint8_t wrapped[64];
+    uint8_t mac[32];
+};
 #pragma pack(pop)
 
+// 数据报总长度: 包头 + 密文 (payload_len为主机字节序) + 可选的追踪扩展
+inline size_t PacketLength(uint16_t payload_len, uint8_t flags) {
+    return sizeof(PacketHeader) + payload_len + ((flags & PACKET_FLAG_TRACE) ? sizeof(FrameTrace) : 0);
+}
+
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,126 @@
+//客户端地址到会话的索引实现
+
+#include "address_index.h"
+#include "epoch_reclaimer.h"
+
+namespace {
+    const size_t kMinCapacity = 64;
+}
+
+AddressIndex::Table::Table(size_t cap) : capacity(cap), used(0), entries(new Entry[cap]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        entries[i].key.store(kEmpty, std::memory_order_relaxed);
+        entries[i].session_id.store(kNotFound, std::memory_order_relaxed);
+    }
+}
+
+AddressIndex::Table::~Table() {
+    delete[] entries;
+}
+
+AddressIndex::AddressIndex(size_t initial_capacity) : size_(0) {
+    size_t capacity = kMinCapacity;
+    while (capacity < initial_capacity) capacity <<= 1;
+    table_.store(new Table(capacity), std::memory_order_release);
+}
+
+AddressIndex::~AddressIndex() {
+    delete table_.load(std::memory_order_acquire);
+}
+
+// 高位置1保证有效键不等于kEmpty
+uint64_t AddressIndex::MakeKey(const sockaddr_in& addr) {
+    return (1ull << 48) |
+           (static_cast<uint64_t>(ntohl(addr.sin_addr.s_addr)) << 16) |
+           ntohs(addr.sin_port);
+}
+
+size_t AddressIndex::Hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+
+uint32_t AddressIndex::Find(const sockaddr_in& addr) const {
+    uint64_t key = MakeKey(addr);
+    EpochReclaimer::Guard guard;
+    const Table* table = table_.load(std::memory_order_acquire);
+    size_t mask = table->capacity - 1;
+    for (size_t i = Hash(key) & mask, n = 0; n < table->capacity; i = (i + 1) & mask, ++n) {
+        uint64_t k = table->entries[i].key.load(std::memory_order_acquire);
+        if (k == kEmpty) break;
+        if (k == key) return table->entries[i].session_id.load(std::memory_order_relaxed);
+    }
+    return kNotFound;
+}
+
+void AddressIndex::InsertLocked(Table* table, uint64_t key, uint32_t session_id) {
+    size_t mask = table->capacity - 1;
+    size_t tombstone = table->capacity;
+    size_t i = Hash(key) & mask;
+    for (size_t n = 0; n < table->capacity; i = (i + 1) & mask, ++n) {
+        uint64_t k = table->entries[i].key.load(std::memory_order_relaxed);
+        if (k == key) {
+            table->entries[i].session_id.store(session_id, std::memory_order_relaxed);
+            return;
+        }
+        if (k == kTombstone && tombstone == table->capacity) tombstone = i;
+        if (k == kEmpty) break;
+    }
+
+    // 优先复用墓碑; 先写值再发布键
+    Entry& e = table->entries[tombstone != table->capacity ? tombstone : i];
+    if (tombstone == table->capacity) ++table->used;
+    e.session_id.store(session_id, std::memory_order_relaxed);
+    e.key.store(key, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AddressIndex::Rehash(size_t capacity) {
+    Table* old = table_.load(std::memory_order_relaxed);
+    Table* table = new Table(capacity);
+    size_.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < old->capacity; ++i) {
+        uint64_t k = old->entries[i].key.load(std::memory_order_relaxed);
+        if (k != kEmpty && k != kTombstone) {
+            InsertLocked(table, k, old->entries[i].session_id.load(std::memory_order_relaxed));
+        }
+    }
+    table_.store(table, std::memory_order_release);
+
+    EpochReclaimer& reclaimer = EpochReclaimer::GetInstance();
+    reclaimer.Retire(old);
+    reclaimer.TryReclaim();
+}
+
+void AddressIndex::Insert(const sockaddr_in& addr, uint32_t session_id) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    Table* table = table_.load(std::memory_order_relaxed);
+
+    // 负载 (含墓碑) 超过1/2时重建，有效项超过1/4时扩容
+    if ((table->used + 1) * 2 > table->capacity) {
+        size_t live = size_.load(std::memory_order_relaxed) + 1;
+        Rehash(live * 4 > table->capacity ? table->capacity * 2 : table->capacity);
+        table = table_.load(std::memory_order_relaxed);
+    }
+    InsertLocked(table, MakeKey(addr), session_id);
+}
+
+bool AddressIndex::Erase(const sockaddr_in& addr, uint32_t session_id) {
+    uint64_t key = MakeKey(addr);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    Table* table = table_.load(std::memory_order_relaxed);
+    size_t mask = table->capacity - 1;
+    for (size_t i = Hash(key) & mask, n = 0; n < table->capacity; i = (i + 1) & mask, ++n) {
+        Entry& e = table->entries[i];
+        uint64_t k = e.key.load(std::memory_order_relaxed);
+        if (k == kEmpty) break;
+        if (k != key) continue;
+        if (e.session_id.load(std::memory_order_relaxed) != session_id) return false;
+        e.key.store(kTombstone, std::memory_order_release);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
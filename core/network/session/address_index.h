@@ -0,0 +1,63 @@
+//客户端地址到会话的索引声明
+
+#ifndef ADDRESS_INDEX_H
+#define ADDRESS_INDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <netinet/in.h>
+
+// (IP, 端口) -> session_id 的开放寻址哈希表 (线性探测)。
+// 读者在epoch临界区内无锁探测; 写者互斥，删除留下墓碑，墓碑过多或负载过高时整表重建并发布。
+class AddressIndex {
+public:
+    static const uint32_t kNotFound = 0;   // session_id从1开始
+
+    explicit AddressIndex(size_t initial_capacity = 1024);
+    ~AddressIndex();
+
+    AddressIndex(const AddressIndex&) = delete;
+    AddressIndex& operator=(const AddressIndex&) = delete;
+
+    // 绑定地址 (已存在则覆盖为新的会话)
+    void Insert(const sockaddr_in& addr, uint32_t session_id);
+
+    // 仅当地址当前绑定到session_id时解除绑定
+    bool Erase(const sockaddr_in& addr, uint32_t session_id);
+
+    uint32_t Find(const sockaddr_in& addr) const;
+
+    size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    static const uint64_t kEmpty = 0;
+    static const uint64_t kTombstone = ~0ull;
+
+    struct Entry {
+        std::atomic<uint64_t> key;        // kEmpty / kTombstone / MakeKey
+        std::atomic<uint32_t> session_id;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity);
+        ~Table();
+        size_t capacity;    // 2的幂
+        size_t used;        // 有效项 + 墓碑
+        Entry* entries;
+    };
+
+    static uint64_t MakeKey(const sockaddr_in& addr);
+    static size_t Hash(uint64_t key);
+
+    // 写锁内调用
+    void InsertLocked(Table* table, uint64_t key, uint32_t session_id);
+    void Rehash(size_t capacity);
+
+    std::atomic<Table*> table_;
+    std::atomic<size_t> size_;
+    std::mutex write_mutex_;
+};
+
+#endif
@@ -0,0 +1,17 @@
+//粗粒度缓存时钟实现
+
+#include "coarse_clock.h"
+#include <chrono>
+
+uint64_t CoarseClock::SteadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::atomic<uint64_t> CoarseClock::now_us_(SteadyMicros());
+
+uint64_t CoarseClock::Update() {
+    uint64_t now = SteadyMicros();
+    now_us_.store(now, std::memory_order_relaxed);
+    return now;
+}
@@ -0,0 +1,26 @@
+//粗粒度缓存时钟声明
+
+#ifndef COARSE_CLOCK_H
+#define COARSE_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+// 由定时线程周期性刷新的steady_clock缓存 (微秒, 与steady_clock::time_since_epoch同基准)。
+// 热路径只做一次relaxed读取，精度取决于刷新周期。
+class CoarseClock {
+public:
+    static uint64_t NowMicros() { return now_us_.load(std::memory_order_relaxed); }
+    static uint64_t NowMillis() { return NowMicros() / 1000; }
+
+    // 读取真实时钟并刷新缓存，返回新的时间
+    static uint64_t Update();
+
+    // 读取真实时钟，不刷新缓存 (定时线程可能未运行、又需要推进状态的路径使用)
+    static uint64_t SteadyMicros();
+
+private:
+    static std::atomic<uint64_t> now_us_;
+};
+
+#endif
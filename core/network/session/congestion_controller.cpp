@@ -0,0 +1,312 @@
+//拥塞控制器实现
+
+#include "congestion_controller.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const uint32_t kMss = 1200;                         // 典型分片大小 (字节)
+    const uint32_t kInitialCwnd = 10 * kMss;            // 初始拥塞窗口
+    const uint32_t kMinCwnd = 4 * kMss;                 // 最小拥塞窗口
+    const uint64_t kInitialBwBps = 1000000;             // 无样本时的初始带宽估计 1Mbit/s
+    const uint32_t kMinRtoUs = 50000;                   // RTO下限 50ms
+    const uint32_t kMaxRtoUs = 2000000;                 // RTO上限 2s
+    const uint32_t kDefaultRtoUs = 500000;              // 无RTT样本时的RTO (与ACK等待超时一致)
+
+    const double kStartupGain = 2.885;                  // 2/ln2, 每轮次带宽翻倍
+    const double kDrainGain = 1.0 / 2.885;
+    const double kCwndGain = 2.0;
+    const double kProbeGains[8] = {1.25, 0.75, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+    const double kTargetHeadroom = 0.95;                // 目标码率留出5%给包头与重传
+    const double kLossThreshold = 0.10;                 // 单轮丢包率超过10%视为过载
+    const double kLossBackoff = 0.85;
+}
+
+CongestionController::CongestionController()
+    : has_sent_(false), scan_seq_(0), next_sent_seq_(0),
+      has_rtt_sample_(false),
+      srtt_us_(0), rttvar_us_(0), min_rtt_us_(0), min_rtt_stamp_us_(0),
+      mode_(Mode::Startup),
+      delivered_bytes_(0), delivered_time_us_(0),
+      round_count_(0), next_round_delivered_(0),
+      full_bw_(0), full_bw_rounds_(0),
+      cycle_index_(0), cycle_stamp_us_(0),
+      round_lost_(0), round_acked_(0),
+      min_bitrate_bps_(100000), max_bitrate_bps_(50000000),
+      btl_bw_bps_(kInitialBwBps),
+      pacing_rate_bps_(static_cast<uint64_t>(kInitialBwBps * kStartupGain)),
+      target_bitrate_bps_(static_cast<uint64_t>(kInitialBwBps * kTargetHeadroom)),
+      cwnd_bytes_(kInitialCwnd),
+      inflight_bytes_(0),
+      last_reported_bitrate_(0) {
+    memset(sent_, 0, sizeof(sent_));
+    memset(bw_samples_, 0, sizeof(bw_samples_));
+}
+
+uint64_t CongestionController::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CongestionController::OnPacketSent(uint32_t seq, size_t bytes, uint64_t now_us) {
+    if (now_us == 0) now_us = NowMicros();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    SentRecord& rec = sent_[seq & (kSentHistory - 1)];
+    if (rec.in_flight) {
+        // 历史环已回绕，旧记录未被确认，按丢失处理
+        inflight_bytes_.fetch_sub(rec.bytes, std::memory_order_relaxed);
+        ++round_lost_;
+    }
+
+    rec.seq = seq;
+    rec.bytes = static_cast<uint32_t>(bytes);
+    rec.send_time_us = now_us;
+    rec.delivered_at_send = delivered_bytes_;
+    rec.delivered_time_at_send = delivered_time_us_ ? delivered_time_us_ : now_us;
+    rec.in_flight = true;
+    rec.retransmitted = false;
+    inflight_bytes_.fetch_add(rec.bytes, std::memory_order_relaxed);
+
+    if (!has_sent_) {
+        scan_seq_ = seq;
+        next_sent_seq_ = seq;
+        has_sent_ = true;
+    }
+    if (static_cast<int32_t>(seq - next_sent_seq_) >= 0) {
+        next_sent_seq_ = seq + 1;
+    }
+    if (next_sent_seq_ - scan_seq_ > kSentHistory) {
+        scan_seq_ = next_sent_seq_ - kSentHistory;  // 更早的记录已被覆盖
+    }
+}
+
+bool CongestionController::OnAck(uint32_t seq, uint32_t ack_delay_us, uint64_t now_us) {
+    if (now_us == 0) now_us = NowMicros();
+    BitrateCallback cb;
+    uint64_t report = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        SentRecord& rec = sent_[seq & (kSentHistory - 1)];
+        if ((!rec.in_flight && !rec.retransmitted) || rec.seq != seq) {
+            return false;  // 重复或过期的ACK
+        }
+        if (rec.in_flight) inflight_bytes_.fetch_sub(rec.bytes, std::memory_order_relaxed);
+        rec.in_flight = false;
+        const bool ambiguous = rec.retransmitted;
+        rec.retransmitted = false;
+
+        // RTT采样: 扣除接收端延迟确认的时间; 重传过的包不采样
+        if (!ambiguous) {
+            uint64_t elapsed = now_us > rec.send_time_us ? now_us - rec.send_time_us : 0;
+            if (ack_delay_us < elapsed) {
+                elapsed -= ack_delay_us;
+            }
+            UpdateRtt(static_cast<uint32_t>(std::min<uint64_t>(elapsed, UINT32_MAX)), now_us);
+        }
+
+        delivered_bytes_ += rec.bytes;
+        delivered_time_us_ = now_us;
+        ++round_acked_;
+
+        // 轮次推进: 该包发送后的数据全部确认即为一个往返
+        const bool round_start = rec.delivered_at_send >= next_round_delivered_;
+        if (round_start) {
+            next_round_delivered_ = delivered_bytes_;
+            ++round_count_;
+
+            uint32_t total = round_acked_ + round_lost_;
+            if (total > 0 && static_cast<double>(round_lost_) / total > kLossThreshold) {
+                // 队列溢出导致的丢包: 下调带宽估计
+                for (int i = 0; i < kBwFilterRounds; ++i) {
+                    bw_samples_[i] = static_cast<uint64_t>(bw_samples_[i] * kLossBackoff);
+                }
+            }
+            round_acked_ = 0;
+            round_lost_ = 0;
+            bw_samples_[round_count_ % kBwFilterRounds] = 0;
+        }
+
+        if (!ambiguous) UpdateBandwidth(rec, now_us);
+        UpdateModel(now_us, round_start);
+        PublishRates();
+
+        uint64_t target = target_bitrate_bps_.load(std::memory_order_relaxed);
+        uint64_t diff = target > last_reported_bitrate_ ? target - last_reported_bitrate_
+                                                        : last_reported_bitrate_ - target;
+        if (bitrate_cb_ && diff * 20 > last_reported_bitrate_) {  // 变化超过5%才通知
+            last_reported_bitrate_ = target;
+            cb = bitrate_cb_;
+            report = target;
+        }
+    }
+    if (cb) cb(report);
+    return true;
+}
+
+void CongestionController::OnPacketLost(uint32_t seq, uint64_t now_us) {
+    (void)now_us;
+    std::lock_guard<std::mutex> lock(mutex_);
+    SentRecord& rec = sent_[seq & (kSentHistory - 1)];
+    if (!rec.in_flight || rec.seq != seq) return;
+    rec.in_flight = false;
+    inflight_bytes_.fetch_sub(rec.bytes, std::memory_order_relaxed);
+    ++round_lost_;
+}
+
+void CongestionController::OnPacketRetransmitted(uint32_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SentRecord& rec = sent_[seq & (kSentHistory - 1)];
+    if (rec.seq != seq) return;   // 历史环已回绕，不再跟踪
+    // 仍在途的包 (未超时即重传) 不重复计入在途量，也不计丢包; 已判丢的包不再计入在途量，
+    // 超时扫描已越过它，计入会一直占用拥塞窗口直到历史环回绕
+    rec.retransmitted = true;
+}
+
+size_t CongestionController::DetectTimeouts(uint64_t now_us, std::vector<uint32_t>* lost) {
+    if (now_us == 0) now_us = NowMicros();
+    uint64_t rto = GetRto();
+    size_t count = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (has_sent_ && scan_seq_ != next_sent_seq_) {
+        SentRecord& rec = sent_[scan_seq_ & (kSentHistory - 1)];
+        if (rec.in_flight && rec.seq == scan_seq_) {
+            if (now_us < rec.send_time_us + rto) break;  // 之后的包发送更晚
+            rec.in_flight = false;
+            inflight_bytes_.fetch_sub(rec.bytes, std::memory_order_relaxed);
+            ++round_lost_;
+            if (lost) lost->push_back(rec.seq);
+            ++count;
+        }
+        ++scan_seq_;
+    }
+    return count;
+}
+
+uint32_t CongestionController::GetRto() const {
+    uint32_t srtt = GetSmoothedRtt();
+    if (srtt == 0) return kDefaultRtoUs;
+    uint64_t rto = static_cast<uint64_t>(srtt) + 4ull * GetRttVar();
+    return static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(rto, kMinRtoUs), kMaxRtoUs));
+}
+
+bool CongestionController::CanSend(size_t bytes) const {
+    return GetBytesInFlight() + bytes <= GetCongestionWindow();
+}
+
+void CongestionController::SetBitrateCallback(BitrateCallback cb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bitrate_cb_ = std::move(cb);
+    last_reported_bitrate_ = target_bitrate_bps_.load(std::memory_order_relaxed);
+}
+
+void CongestionController::SetBitrateLimits(uint64_t min_bps, uint64_t max_bps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    min_bitrate_bps_ = min_bps;
+    max_bitrate_bps_ = std::max(min_bps, max_bps);
+    PublishRates();
+}
+
+void CongestionController::UpdateRtt(uint32_t sample_us, uint64_t now_us) {
+    if (sample_us == 0) sample_us = 1;
+
+    // RFC 6298: SRTT/RTTVAR 指数平滑
+    if (!has_rtt_sample_) {
+        srtt_us_.store(sample_us, std::memory_order_relaxed);
+        rttvar_us_.store(sample_us / 2, std::memory_order_relaxed);
+        has_rtt_sample_ = true;
+    } else {
+        uint32_t srtt = srtt_us_.load(std::memory_order_relaxed);
+        uint32_t rttvar = rttvar_us_.load(std::memory_order_relaxed);
+        uint32_t err = srtt > sample_us ? srtt - sample_us : sample_us - srtt;
+        rttvar = rttvar - rttvar / 4 + err / 4;
+        srtt = srtt - srtt / 8 + sample_us / 8;
+        srtt_us_.store(srtt, std::memory_order_relaxed);
+        rttvar_us_.store(rttvar, std::memory_order_relaxed);
+    }
+
+    // 最小RTT (传播时延) 带过期窗口
+    uint32_t min_rtt = min_rtt_us_.load(std::memory_order_relaxed);
+    if (min_rtt == 0 || sample_us <= min_rtt || now_us - min_rtt_stamp_us_ > kMinRttWindowUs) {
+        min_rtt_us_.store(sample_us, std::memory_order_relaxed);
+        min_rtt_stamp_us_ = now_us;
+    }
+}
+
+void CongestionController::UpdateBandwidth(const SentRecord& rec, uint64_t now_us) {
+    uint64_t interval = now_us - rec.delivered_time_at_send;
+    uint32_t min_rtt = min_rtt_us_.load(std::memory_order_relaxed);
+    if (interval == 0 || interval < min_rtt) {
+        return;  // 采样区间短于一个RTT，速率会被ACK压缩放大
+    }
+
+    uint64_t delivered = delivered_bytes_ - rec.delivered_at_send;
+    uint64_t rate_bps = delivered * 8 * 1000000 / interval;
+    uint64_t& slot = bw_samples_[round_count_ % kBwFilterRounds];
+    slot = std::max(slot, rate_bps);
+}
+
+void CongestionController::UpdateModel(uint64_t now_us, bool round_start) {
+    uint64_t btl_bw = 0;
+    for (int i = 0; i < kBwFilterRounds; ++i) {
+        btl_bw = std::max(btl_bw, bw_samples_[i]);
+    }
+    if (btl_bw == 0) btl_bw = kInitialBwBps;
+    btl_bw_bps_.store(btl_bw, std::memory_order_relaxed);
+
+    uint32_t min_rtt = min_rtt_us_.load(std::memory_order_relaxed);
+    uint64_t bdp = btl_bw / 8 * min_rtt / 1000000;
+
+    switch (mode_) {
+    case Mode::Startup:
+        // 连续3轮带宽增长不足25%，认为管道已满; 每轮只判断一次，不按ACK计数
+        if (!round_start) break;
+        if (btl_bw >= full_bw_ + full_bw_ / 4) {
+            full_bw_ = btl_bw;
+            full_bw_rounds_ = 0;
+        } else if (++full_bw_rounds_ >= 3) {
+            mode_ = Mode::Drain;
+        }
+        break;
+    case Mode::Drain:
+        if (GetBytesInFlight() <= bdp) {
+            mode_ = Mode::ProbeBw;
+            cycle_index_ = 0;
+            cycle_stamp_us_ = now_us;
+        }
+        break;
+    case Mode::ProbeBw:
+        if (now_us - cycle_stamp_us_ > min_rtt) {
+            cycle_index_ = (cycle_index_ + 1) % 8;
+            cycle_stamp_us_ = now_us;
+        }
+        break;
+    }
+}
+
+void CongestionController::PublishRates() {
+    uint64_t btl_bw = btl_bw_bps_.load(std::memory_order_relaxed);
+    double gain = 1.0;
+    switch (mode_) {
+    case Mode::Startup: gain = kStartupGain; break;
+    case Mode::Drain:   gain = kDrainGain; break;
+    case Mode::ProbeBw: gain = kProbeGains[cycle_index_]; break;
+    }
+    pacing_rate_bps_.store(static_cast<uint64_t>(btl_bw * gain), std::memory_order_relaxed);
+
+    uint64_t target = static_cast<uint64_t>(btl_bw * kTargetHeadroom);
+    target = std::min(std::max(target, min_bitrate_bps_), max_bitrate_bps_);
+    target_bitrate_bps_.store(target, std::memory_order_relaxed);
+
+    uint32_t min_rtt = min_rtt_us_.load(std::memory_order_relaxed);
+    uint64_t cwnd = kInitialCwnd;
+    if (has_rtt_sample_) {
+        uint64_t bdp = btl_bw / 8 * min_rtt / 1000000;
+        cwnd = std::max<uint64_t>(static_cast<uint64_t>(bdp * kCwndGain), kMinCwnd);
+    }
+    cwnd_bytes_.store(static_cast<uint32_t>(std::min<uint64_t>(cwnd, UINT32_MAX)),
+                      std::memory_order_relaxed);
+}
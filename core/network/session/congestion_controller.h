@@ -0,0 +1,114 @@
+//拥塞控制器声明 (RTT估计 + 类BBR带宽估计)
+
+#ifndef CONGESTION_CONTROLLER_H
+#define CONGESTION_CONTROLLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class CongestionController {
+public:
+    // 目标码率变化回调 (单位: bit/s)，供编码器调整码率
+    using BitrateCallback = std::function<void(uint64_t target_bitrate_bps)>;
+
+    CongestionController();
+
+    // 发送/确认/丢包事件 (时间单位均为微秒, 0表示取当前时间)
+    void OnPacketSent(uint32_t seq, size_t bytes, uint64_t now_us = 0);
+    bool OnAck(uint32_t seq, uint32_t ack_delay_us, uint64_t now_us = 0);
+    void OnPacketLost(uint32_t seq, uint64_t now_us = 0);
+    // 按原seq重传: 保留首次发送时刻，之后的ACK无法区分对应哪次发送 (Karn)，不产生RTT与带宽样本
+    void OnPacketRetransmitted(uint32_t seq);
+
+    // 重传定时器: 将发送超过RTO仍未确认的包判为丢失并追加到lost，返回个数。
+    // 按seq顺序从上次位置继续扫描，每个包均摊O(1)
+    size_t DetectTimeouts(uint64_t now_us, std::vector<uint32_t>* lost = nullptr);
+
+    // RTT估计 (RFC 6298)
+    uint32_t GetSmoothedRtt() const { return srtt_us_.load(std::memory_order_relaxed); }
+    uint32_t GetRttVar() const { return rttvar_us_.load(std::memory_order_relaxed); }
+    uint32_t GetMinRtt() const { return min_rtt_us_.load(std::memory_order_relaxed); }
+    uint32_t GetRto() const;
+
+    // 带宽估计与速率输出
+    uint64_t GetBottleneckBandwidth() const { return btl_bw_bps_.load(std::memory_order_relaxed); }
+    uint64_t GetPacingRate() const { return pacing_rate_bps_.load(std::memory_order_relaxed); }
+    uint64_t GetTargetBitrate() const { return target_bitrate_bps_.load(std::memory_order_relaxed); }
+    uint32_t GetCongestionWindow() const { return cwnd_bytes_.load(std::memory_order_relaxed); }
+    uint32_t GetBytesInFlight() const { return inflight_bytes_.load(std::memory_order_relaxed); }
+    bool CanSend(size_t bytes) const;
+
+    void SetBitrateCallback(BitrateCallback cb);
+    void SetBitrateLimits(uint64_t min_bps, uint64_t max_bps);
+
+    static uint64_t NowMicros();
+
+private:
+    enum class Mode { Startup, Drain, ProbeBw };
+
+    // 已发送未确认的包记录 (按seq取模索引)
+    struct SentRecord {
+        uint32_t seq;
+        uint32_t bytes;
+        uint64_t send_time_us;
+        uint64_t delivered_at_send;      // 发送时的累计确认字节数
+        uint64_t delivered_time_at_send; // 发送时最近一次确认的时间
+        bool in_flight;
+        bool retransmitted;              // 已按原seq重传，ACK只计投递量
+    };
+
+    static const size_t kSentHistory = 1024;           // 须为2的幂
+    static const int kBwFilterRounds = 10;             // 最大带宽滤波窗口 (轮次)
+    static const uint64_t kMinRttWindowUs = 10000000;  // 最小RTT有效期 10s
+
+    void UpdateRtt(uint32_t sample_us, uint64_t now_us);
+    void UpdateBandwidth(const SentRecord& rec, uint64_t now_us);
+    // round_start: 本次ACK开始了新的往返轮次
+    void UpdateModel(uint64_t now_us, bool round_start);
+    void PublishRates();
+
+    mutable std::mutex mutex_;
+    SentRecord sent_[kSentHistory];
+    bool has_sent_;
+    uint32_t scan_seq_;        // 超时扫描位置 (更早的包已确认或已判丢)
+    uint32_t next_sent_seq_;   // 已发送的最大seq + 1
+
+    // RTT状态
+    bool has_rtt_sample_;
+    std::atomic<uint32_t> srtt_us_;
+    std::atomic<uint32_t> rttvar_us_;
+    std::atomic<uint32_t> min_rtt_us_;
+    uint64_t min_rtt_stamp_us_;
+
+    // 带宽状态
+    Mode mode_;
+    uint64_t delivered_bytes_;
+    uint64_t delivered_time_us_;
+    uint64_t round_count_;
+    uint64_t next_round_delivered_;
+    uint64_t bw_samples_[kBwFilterRounds];  // 每轮次的最大投递速率
+    uint64_t full_bw_;
+    int full_bw_rounds_;
+    int cycle_index_;
+    uint64_t cycle_stamp_us_;
+    uint32_t round_lost_;
+    uint32_t round_acked_;
+
+    uint64_t min_bitrate_bps_;
+    uint64_t max_bitrate_bps_;
+
+    std::atomic<uint64_t> btl_bw_bps_;
+    std::atomic<uint64_t> pacing_rate_bps_;
+    std::atomic<uint64_t> target_bitrate_bps_;
+    std::atomic<uint32_t> cwnd_bytes_;
+    std::atomic<uint32_t> inflight_bytes_;
+
+    uint64_t last_reported_bitrate_;
+    BitrateCallback bitrate_cb_;
+};
+
+#endif
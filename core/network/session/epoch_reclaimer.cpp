@@ -0,0 +1,121 @@
+//基于epoch的延迟回收实现
+
+#include "epoch_reclaimer.h"
+
+namespace {
+
+const uint32_t kSlotRetryInterval = 1024;   // 未分到槽位的线程每隔若干次进入临界区重试一次
+
+}  // namespace
+
+// 线程退出时归还槽位
+struct EpochReclaimer::ThreadState {
+    ThreadSlot* slot = nullptr;
+    uint32_t depth = 0;
+    uint32_t retry = 0;
+    bool overflow = false;   // 本次临界区登记在溢出计数上
+
+    ~ThreadState() {
+        if (slot) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+EpochReclaimer::ThreadState& EpochReclaimer::LocalState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+EpochReclaimer::~EpochReclaimer() {
+    for (const Retired& r : retired_) {
+        r.deleter(r.ptr);
+    }
+}
+
+EpochReclaimer::ThreadSlot* EpochReclaimer::AcquireSlot() {
+    for (size_t i = 0; i < kMaxThreads; ++i) {
+        bool expected = false;
+        if (!slots_[i].in_use.load(std::memory_order_relaxed) &&
+            slots_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return &slots_[i];
+        }
+    }
+    return nullptr;
+}
+
+EpochReclaimer::Guard::Guard() {
+    ThreadState& state = LocalState();
+    if (state.depth++ > 0) return;
+
+    EpochReclaimer& r = EpochReclaimer::GetInstance();
+    if (!state.slot) {
+        if (state.retry == 0) state.slot = r.AcquireSlot();
+        if (!state.slot) {
+            // 槽位用尽: 登记为溢出读者，回收端看到非零计数时不释放任何对象
+            state.retry = state.retry ? state.retry - 1 : kSlotRetryInterval;
+            state.overflow = true;
+            r.overflow_readers_.fetch_add(1, std::memory_order_seq_cst);
+            return;
+        }
+    }
+    // 先公布epoch再读取共享指针 (seq_cst 保证与回收端的扫描有序)
+    state.slot->epoch.store(r.global_epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+EpochReclaimer::Guard::~Guard() {
+    ThreadState& state = LocalState();
+    if (--state.depth > 0) return;
+    if (state.overflow) {
+        state.overflow = false;
+        EpochReclaimer::GetInstance().overflow_readers_.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    state.slot->epoch.store(0, std::memory_order_release);
+}
+
+void EpochReclaimer::Retire(void* ptr, void (*deleter)(void*)) {
+    if (!ptr) return;
+    uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    retired_.push_back(Retired{ptr, deleter, epoch});
+}
+
+size_t EpochReclaimer::TryReclaim() {
+    std::vector<Retired> ready;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        if (retired_.empty()) return 0;
+
+        global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+
+        // 最老的活跃读者epoch; 有溢出读者时无法判断其epoch，本次不释放
+        uint64_t min_active = overflow_readers_.load(std::memory_order_seq_cst) ? 0 : UINT64_MAX;
+        for (size_t i = 0; i < kMaxThreads; ++i) {
+            uint64_t e = slots_[i].epoch.load(std::memory_order_seq_cst);
+            if (e != 0 && e < min_active) min_active = e;
+        }
+
+        size_t keep = 0;
+        for (size_t i = 0; i < retired_.size(); ++i) {
+            if (retired_[i].epoch < min_active) {
+                ready.push_back(retired_[i]);
+            } else {
+                retired_[keep++] = retired_[i];
+            }
+        }
+        retired_.resize(keep);
+    }
+
+    // 在锁外执行析构，析构中可能再次退休对象
+    for (const Retired& r : ready) {
+        r.deleter(r.ptr);
+    }
+    return ready.size();
+}
+
+size_t EpochReclaimer::PendingCount() {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    return retired_.size();
+}
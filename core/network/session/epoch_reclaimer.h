@@ -0,0 +1,74 @@
+//基于epoch的延迟回收声明
+
+#ifndef EPOCH_RECLAIMER_H
+#define EPOCH_RECLAIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 基于epoch的延迟回收: 所有活跃读者的epoch都超过退休epoch时才释放对象
+class EpochReclaimer {
+public:
+    static const size_t kMaxThreads = 256;
+
+    static EpochReclaimer& GetInstance() {
+        static EpochReclaimer instance;
+        return instance;
+    }
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // 读侧临界区 (可嵌套)
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // 退休对象: 在没有读者可能引用它之后调用deleter(ptr)
+    void Retire(void* ptr, void (*deleter)(void*));
+
+    template <typename T>
+    void Retire(T* ptr) {
+        Retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // 推进epoch并释放已安全的对象，返回释放个数
+    size_t TryReclaim();
+
+    size_t PendingCount();
+
+private:
+    EpochReclaimer() : global_epoch_(1) {}
+    ~EpochReclaimer();
+
+    struct alignas(64) ThreadSlot {
+        std::atomic<uint64_t> epoch{0};   // 0表示不在临界区
+        std::atomic<bool> in_use{false};
+    };
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    friend class Guard;
+    struct ThreadState;
+    static ThreadState& LocalState();
+    // 扫描一遍空闲槽位，没有则返回nullptr
+    ThreadSlot* AcquireSlot();
+
+    std::atomic<uint64_t> global_epoch_;
+    ThreadSlot slots_[kMaxThreads];
+    std::atomic<uint64_t> overflow_readers_{0};   // 未分到槽位且在临界区内的读者数
+    std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+};
+
+#endif
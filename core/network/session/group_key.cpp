@@ -0,0 +1,104 @@
+//组密钥下发实现
+
+#include "group_key.h"
+#include "session_manager.h"
+#include "../../security/crypto/random_generator.h"
+#include "../../security/crypto/sm3.h"
+#include "../../security/crypto/sm4.h"
+#include <arpa/inet.h>
+#include <cstring>
+#include <stddef.h>
+
+namespace {
+
+const size_t kMacOffset = offsetof(GroupKeyPacket, mac);
+
+void ComputeMac(const uint8_t salt[32], const GroupKeyPacket& packet, uint8_t mac[32]) {
+    SM3_CTX ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, salt, 32);
+    sm3_update(&ctx, reinterpret_cast<const uint8_t*>(&packet), kMacOffset);
+    sm3_final(&ctx, mac);
+}
+
+}  // namespace
+
+uint32_t GroupKey::CreateGroup() {
+    uint8_t secret[48];
+    if (!utils::SecureRandom::GenerateSecureRandom(secret, sizeof(secret))) return 0;
+
+    SessionManager& manager = SessionManager::GetInstance();
+    uint32_t group_id = manager.CreateGroupSession();
+    SessionHandle group = manager.GetSession(group_id);
+    if (group) group->InstallKeys(secret, secret + 16);
+    memset(secret, 0, sizeof(secret));
+    return group ? group_id : 0;
+}
+
+bool GroupKey::Wrap(SessionContext& group, SessionContext& member, GroupKeyPacket* out) {
+    KeyMaterial group_keys;
+    KeyMaterial member_keys;
+    if (!out || !group.GetKeys().Current(&group_keys)) return false;
+    if (!member.GetKeys().Current(&member_keys)) {
+        memset(&group_keys, 0, sizeof(group_keys));
+        return false;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->ctrl.type = CONTROL_GROUP_KEY;
+    out->session_id = htonl(member.GetSessionId());
+    out->group_id = htonl(group.GetSessionId());
+    out->epoch = htonl(group_keys.epoch);
+    bool ok = utils::SecureRandom::GenerateIV(out->iv);
+    if (ok) {
+        uint8_t secret[48];
+        memcpy(secret, group_keys.key, 16);
+        memcpy(secret + 16, group_keys.salt, 32);
+        memcpy(member_keys.sm4.iv, out->iv, 16);
+        sm4_cbc_encrypt_padded(&member_keys.sm4, secret, sizeof(secret), out->wrapped);
+        memset(secret, 0, sizeof(secret));
+        ComputeMac(member_keys.salt, *out, out->mac);
+    }
+    memset(&group_keys, 0, sizeof(group_keys));
+    memset(&member_keys, 0, sizeof(member_keys));
+    return ok;
+}
+
+uint32_t GroupKey::Unwrap(const sockaddr_in& sender, const uint8_t* data, size_t len) {
+    GroupKeyPacket packet;
+    if (!data || len != sizeof(packet)) return 0;
+    memcpy(&packet, data, sizeof(packet));
+    if (packet.ctrl.zero != 0 || packet.ctrl.type != CONTROL_GROUP_KEY) return 0;
+
+    SessionManager& manager = SessionManager::GetInstance();
+    const uint32_t group_id = ntohl(packet.group_id);
+    if (group_id == 0) return 0;
+    // 发送端会多发几份; 第一份之后地址已改绑到组会话，不再经过点对点会话校验
+    if (manager.HasSession(group_id)) {
+        return manager.Demux(sender, group_id) ? group_id : 0;
+    }
+
+    SessionHandle member = manager.Demux(sender, ntohl(packet.session_id));
+    KeyMaterial keys;
+    if (!member || !member->GetKeys().Current(&keys)) return 0;
+
+    uint8_t mac[32];
+    ComputeMac(keys.salt, packet, mac);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < sizeof(mac); i++) diff |= mac[i] ^ packet.mac[i];
+    uint8_t secret[64];
+    memcpy(keys.sm4.iv, packet.iv, 16);
+    const size_t secret_len = diff == 0 ?
+        sm4_cbc_decrypt_padded(&keys.sm4, packet.wrapped, sizeof(packet.wrapped), secret) : 0;
+    memset(&keys, 0, sizeof(keys));
+
+    uint32_t result = 0;
+    if (secret_len == 48 && manager.CreateSession(sender, group_id)) {
+        if (SessionHandle group = manager.GetSession(group_id)) {
+            group->InstallKeys(secret, secret + 16, ntohl(packet.epoch));
+            result = group_id;
+        }
+    }
+    memset(secret, 0, sizeof(secret));
+    return result;
+}
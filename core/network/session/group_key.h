@@ -0,0 +1,27 @@
+//组密钥下发声明 (一次加密、多接收端)
+
+#ifndef GROUP_KEY_H
+#define GROUP_KEY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <netinet/in.h>
+#include "../packets/packet_types.h"
+
+class SessionContext;
+
+// 组密钥: 数据报只封装一次发给所有订阅者，组密钥经各订阅者的点对点会话包装下发
+class GroupKey {
+public:
+    // 发送端: 创建组会话并安装随机密钥，失败返回0
+    static uint32_t CreateGroup();
+
+    // 发送端: 用成员的点对点会话密钥包装组会话的当前密钥
+    static bool Wrap(SessionContext& group, SessionContext& member, GroupKeyPacket* out);
+
+    // 接收端: 校验并解包，以group_id创建本地组会话并把发送端地址改绑到该会话。
+    // 返回group_id; 重复收到同一组密钥时直接返回，失败返回0
+    static uint32_t Unwrap(const sockaddr_in& sender, const uint8_t* data, size_t len);
+};
+
+#endif
@@ -0,0 +1,92 @@
+//会话握手实现
+
+#include "handshake.h"
+#include "session_manager.h"
+#include <arpa/inet.h>
+#include <cstring>
+
+namespace {
+
+bool ValidPacket(const uint8_t* data, size_t len, uint8_t type, KeyExchangePacket* out) {
+    if (!data || len != sizeof(KeyExchangePacket)) return false;
+    memcpy(out, data, sizeof(KeyExchangePacket));
+    return out->ctrl.zero == 0 && out->ctrl.type == type && out->version == KEY_EXCHANGE_VERSION &&
+           sm2_point_is_valid(out->public_key);
+}
+
+}  // namespace
+
+uint32_t Handshake::Accept(const sockaddr_in& from, const uint8_t* data, size_t len,
+                           KeyExchangePacket* reply) {
+    KeyExchangePacket init;
+    if (!reply || !ValidPacket(data, len, CONTROL_KEY_EXCHANGE_INIT, &init)) return 0;
+
+    KeyExchange exchange;
+    if (!exchange.Generate()) return 0;
+
+    SessionManager& manager = SessionManager::GetInstance();
+    uint32_t session_id = manager.CreateSession(from);
+
+    SessionKeyMaterial keys;
+    memset(reply, 0, sizeof(*reply));
+    if (!exchange.Derive(false, init.public_key, init.nonce, session_id, &keys, reply->confirm)) {
+        manager.RemoveSession(session_id);
+        return 0;
+    }
+
+    SessionHandle session = manager.GetSession(session_id);
+    if (!session) return 0;
+    session->InstallKeys(keys.sm4_key, keys.sm3_salt);
+    memset(&keys, 0, sizeof(keys));
+
+    reply->ctrl.zero = 0;
+    reply->ctrl.type = CONTROL_KEY_EXCHANGE_REPLY;
+    reply->version = KEY_EXCHANGE_VERSION;
+    reply->session_id = htonl(session_id);
+    memcpy(reply->nonce, exchange.Nonce(), KEY_EXCHANGE_NONCE_SIZE);
+    memcpy(reply->public_key, exchange.PublicKey(), SM2_POINT_SIZE);
+    return session_id;
+}
+
+bool Handshake::Start(KeyExchangePacket* init) {
+    if (!init) return false;
+    exchange_.reset(new KeyExchange());
+    if (!exchange_->Generate()) {
+        exchange_.reset();
+        return false;
+    }
+
+    memset(init, 0, sizeof(*init));
+    init->ctrl.type = CONTROL_KEY_EXCHANGE_INIT;
+    init->version = KEY_EXCHANGE_VERSION;
+    memcpy(init->nonce, exchange_->Nonce(), KEY_EXCHANGE_NONCE_SIZE);
+    memcpy(init->public_key, exchange_->PublicKey(), SM2_POINT_SIZE);
+    return true;
+}
+
+uint32_t Handshake::Finish(const sockaddr_in& server, const uint8_t* data, size_t len) {
+    KeyExchangePacket reply;
+    if (!exchange_ || !ValidPacket(data, len, CONTROL_KEY_EXCHANGE_REPLY, &reply)) return 0;
+
+    uint32_t session_id = ntohl(reply.session_id);
+    SessionKeyMaterial keys;
+    uint8_t confirm[KEY_EXCHANGE_CONFIRM_SIZE];
+    bool derived = exchange_->Derive(true, reply.public_key, reply.nonce, session_id, &keys, confirm);
+    exchange_.reset();
+    if (!derived || session_id == 0 ||
+        !KeyExchange::ConstantTimeEqual(confirm, reply.confirm, KEY_EXCHANGE_CONFIRM_SIZE)) {
+        memset(&keys, 0, sizeof(keys));
+        return 0;
+    }
+
+    SessionManager& manager = SessionManager::GetInstance();
+    if (!manager.CreateSession(server, session_id)) {
+        memset(&keys, 0, sizeof(keys));
+        return 0;
+    }
+    if (SessionHandle session = manager.GetSession(session_id)) {
+        session->InstallKeys(keys.sm4_key, keys.sm3_salt);
+    }
+    memset(&keys, 0, sizeof(keys));
+    return session_id;
+}
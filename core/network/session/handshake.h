@@ -0,0 +1,28 @@
+//会话握手声明 (SM2密钥协商 -> 会话密钥)
+
+#ifndef HANDSHAKE_H
+#define HANDSHAKE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <netinet/in.h>
+#include "../packets/key_exchange_packet.h"
+
+class Handshake {
+public:
+    // 发送端: 校验INIT，创建会话并安装协商出的密钥，填充REPLY。失败返回0
+    static uint32_t Accept(const sockaddr_in& from, const uint8_t* data, size_t len,
+                           KeyExchangePacket* reply);
+
+    // 接收端: 生成INIT
+    bool Start(KeyExchangePacket* init);
+
+    // 接收端: 校验REPLY的确认值，以发送端分配的ID在本地创建会话并安装密钥。失败返回0
+    uint32_t Finish(const sockaddr_in& server, const uint8_t* data, size_t len);
+
+private:
+    std::unique_ptr<KeyExchange> exchange_;
+};
+
+#endif
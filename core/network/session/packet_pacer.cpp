@@ -0,0 +1,44 @@
+//发送节奏控制器实现
+
+#include "packet_pacer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+    const uint64_t kSpinThresholdUs = 200;  // 剩余时间小于该值时让出CPU而不睡眠
+    const uint64_t kMaxLagUs = 5000;        // 落后超过该值时不再追赶，避免补发突发
+}
+
+void PacketPacer::BeginFrame(uint32_t fragment_count, uint32_t frame_interval_us, uint64_t now_us) {
+    if (now_us == 0) now_us = CongestionController::NowMicros();
+    if (fragment_count == 0) fragment_count = 1;
+
+    frame_gap_us_ = static_cast<uint64_t>(frame_interval_us * spread_ratio_) / fragment_count;
+    next_send_us_ = std::max(next_send_us_, now_us);
+}
+
+void PacketPacer::WaitForSlot() {
+    uint64_t now_us = CongestionController::NowMicros();
+    while (now_us < next_send_us_) {
+        uint64_t remaining = next_send_us_ - now_us;
+        if (remaining > kSpinThresholdUs) {
+            std::this_thread::sleep_for(std::chrono::microseconds(remaining - kSpinThresholdUs));
+        } else {
+            std::this_thread::yield();
+        }
+        now_us = CongestionController::NowMicros();
+    }
+}
+
+void PacketPacer::OnPacketSent(size_t bytes, uint64_t now_us) {
+    if (now_us == 0) now_us = CongestionController::NowMicros();
+
+    // 间隔取帧内均摊间隔与按发送速率计算间隔中的较大者
+    uint64_t pacing_rate = std::max<uint64_t>(cc_.GetPacingRate(), 1);
+    uint64_t rate_gap_us = bytes * 8 * 1000000 / pacing_rate;
+    uint64_t gap = std::max(frame_gap_us_, rate_gap_us);
+
+    uint64_t base = std::max(next_send_us_, now_us > kMaxLagUs ? now_us - kMaxLagUs : 0);
+    next_send_us_ = base + gap;
+}
@@ -0,0 +1,36 @@
+//发送节奏控制器声明
+
+#ifndef PACKET_PACER_H
+#define PACKET_PACER_H
+
+#include "congestion_controller.h"
+#include <cstdint>
+#include <cstddef>
+
+// 将一帧的分片在帧间隔内均匀发出，避免突发占满瓶颈队列
+// 非线程安全: 每个会话只应由一个发送线程使用
+class PacketPacer {
+public:
+    explicit PacketPacer(const CongestionController& cc, double spread_ratio = 0.8)
+        : cc_(cc), spread_ratio_(spread_ratio), next_send_us_(0), frame_gap_us_(0) {}
+
+    // 开始新的一帧: fragment_count个分片分布在 frame_interval_us * spread_ratio 内
+    void BeginFrame(uint32_t fragment_count, uint32_t frame_interval_us, uint64_t now_us = 0);
+
+    // 下一个包的最早发送时间 (微秒, steady_clock)
+    uint64_t NextSendTime() const { return next_send_us_; }
+
+    // 阻塞直到下一个发送时刻
+    void WaitForSlot();
+
+    // 记录一次发送，推进下一个发送时刻
+    void OnPacketSent(size_t bytes, uint64_t now_us = 0);
+
+private:
+    const CongestionController& cc_;
+    double spread_ratio_;
+    uint64_t next_send_us_;
+    uint64_t frame_gap_us_;
+};
+
+#endif
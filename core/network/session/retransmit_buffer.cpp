@@ -0,0 +1,120 @@
+//发送端重传环形缓冲区实现
+
+#include "retransmit_buffer.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+    size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+}
+
+RetransmitBuffer::RetransmitBuffer(const RetransmitConfig& config)
+    : slot_count_(config.slot_count ? RoundUpPow2(config.slot_count) : 0),
+      slot_size_(config.slot_size),
+      mask_(slot_count_ ? slot_count_ - 1 : 0),
+      max_age_us_(static_cast<uint64_t>(config.max_age_ms) * 1000),
+      slots_(new Slot[slot_count_]),
+      storage_(new uint8_t[slot_count_ * slot_size_]),
+      release_floor_(0) {
+    for (size_t i = 0; i < slot_count_; ++i) {
+        slots_[i].version.store(0, std::memory_order_relaxed);
+        slots_[i].seq.store(0, std::memory_order_relaxed);
+        slots_[i].len.store(0, std::memory_order_relaxed);
+        slots_[i].deadline_us.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t RetransmitBuffer::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 将版本号置为奇数以独占槽位，返回加锁前的版本
+uint32_t RetransmitBuffer::LockSlot(Slot& slot) {
+    for (;;) {
+        uint32_t v = slot.version.load(std::memory_order_relaxed);
+        if (!(v & 1) && slot.version.compare_exchange_weak(v, v + 1, std::memory_order_acquire)) {
+            return v;
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool RetransmitBuffer::Store(uint32_t seq, const uint8_t* packet, size_t len, uint64_t now_us) {
+    return Store(seq, packet, len, nullptr, 0, now_us);
+}
+
+bool RetransmitBuffer::Store(uint32_t seq, const uint8_t* header, size_t header_len,
+                             const uint8_t* body, size_t body_len, uint64_t now_us) {
+    const size_t len = header_len + body_len;
+    if (slot_count_ == 0 || len == 0 || len > slot_size_) return false;
+    if (now_us == 0) now_us = NowMicros();
+
+    Slot& slot = SlotFor(seq);
+    uint32_t v = LockSlot(slot);
+    memcpy(DataFor(seq), header, header_len);
+    if (body_len) memcpy(DataFor(seq) + header_len, body, body_len);
+    slot.seq.store(seq, std::memory_order_relaxed);
+    slot.len.store(static_cast<uint32_t>(len), std::memory_order_relaxed);
+    slot.deadline_us.store(now_us + max_age_us_, std::memory_order_relaxed);
+    slot.version.store(v + 2, std::memory_order_release);
+    return true;
+}
+
+bool RetransmitBuffer::Contains(uint32_t seq, uint64_t now_us) const {
+    if (slot_count_ == 0) return false;
+    if (now_us == 0) now_us = NowMicros();
+    const Slot& slot = SlotFor(seq);
+    return slot.len.load(std::memory_order_relaxed) != 0 &&
+           slot.seq.load(std::memory_order_relaxed) == seq &&
+           slot.deadline_us.load(std::memory_order_relaxed) >= now_us;
+}
+
+void RetransmitBuffer::Invalidate(Slot& slot, uint32_t expected_seq) {
+    if (slot.len.load(std::memory_order_relaxed) == 0 ||
+        slot.seq.load(std::memory_order_relaxed) != expected_seq) {
+        return;
+    }
+    uint32_t v = LockSlot(slot);
+    if (slot.seq.load(std::memory_order_relaxed) == expected_seq) {
+        slot.len.store(0, std::memory_order_relaxed);
+    }
+    slot.version.store(v + 2, std::memory_order_release);
+}
+
+void RetransmitBuffer::Release(uint32_t seq) {
+    if (slot_count_ == 0) return;
+    Invalidate(SlotFor(seq), seq);
+}
+
+void RetransmitBuffer::ReleaseBefore(uint32_t lowest_unacked) {
+    if (slot_count_ == 0) return;
+    uint32_t floor = release_floor_.exchange(lowest_unacked, std::memory_order_relaxed);
+    uint32_t span = lowest_unacked - floor;
+    if (span > (1u << 31)) return;  // 窗口下沿回退 (乱序ACK)，忽略
+    if (span > slot_count_) {
+        floor = lowest_unacked - static_cast<uint32_t>(slot_count_);
+    }
+    for (uint32_t seq = floor; seq != lowest_unacked; ++seq) {
+        Invalidate(SlotFor(seq), seq);
+    }
+}
+
+size_t RetransmitBuffer::AgeOut(uint64_t now_us) {
+    if (now_us == 0) now_us = NowMicros();
+    size_t expired = 0;
+    for (size_t i = 0; i < slot_count_; ++i) {
+        Slot& slot = slots_[i];
+        if (slot.len.load(std::memory_order_relaxed) != 0 &&
+            slot.deadline_us.load(std::memory_order_relaxed) < now_us) {
+            Invalidate(slot, slot.seq.load(std::memory_order_relaxed));
+            ++expired;
+        }
+    }
+    return expired;
+}
@@ -0,0 +1,96 @@
+//发送端重传环形缓冲区声明
+
+#ifndef RETRANSMIT_BUFFER_H
+#define RETRANSMIT_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <sys/types.h>
+
+// 重传缓冲区配置: 每会话内存上限 = slot_count * slot_size (512槽约768KB)。
+// 默认不缓存，需要重传的发送端通过SessionManager::SetRetransmitConfig开启
+struct RetransmitConfig {
+    size_t slot_count = 0;         // 槽位数 (向上取整为2的幂)，0表示禁用
+    size_t slot_size = 1500;       // 单个槽的最大包长
+    uint32_t max_age_ms = 1000;    // 包保留时长，超过后不再重传
+};
+
+// 按seq取模保存已加密的包，重传直接发送原始字节; 槽位以版本号互斥，读者无锁
+class RetransmitBuffer {
+public:
+    explicit RetransmitBuffer(const RetransmitConfig& config);
+
+    RetransmitBuffer(const RetransmitBuffer&) = delete;
+    RetransmitBuffer& operator=(const RetransmitBuffer&) = delete;
+
+    // 保存包，覆盖seq - capacity 的旧包 (按窗口位置淘汰)。包过大返回false
+    bool Store(uint32_t seq, const uint8_t* packet, size_t len, uint64_t now_us = 0);
+    // 包头与包体分两段保存 (发送时才改写包头的调用方使用)，两段总长不超过槽大小
+    bool Store(uint32_t seq, const uint8_t* header, size_t header_len,
+               const uint8_t* body, size_t body_len, uint64_t now_us = 0);
+
+    // 直接以槽内字节调用send(data, len)。包不存在/已过期/发送期间被覆盖时返回false
+    template <typename SendFn>
+    bool Resend(uint32_t seq, SendFn&& send, uint64_t now_us = 0) const;
+
+    bool Contains(uint32_t seq, uint64_t now_us = 0) const;
+
+    // 确认后释放单个包 / 释放窗口下沿之前的全部包
+    void Release(uint32_t seq);
+    void ReleaseBefore(uint32_t lowest_unacked);
+
+    // 按截止时间淘汰，返回淘汰个数
+    size_t AgeOut(uint64_t now_us = 0);
+
+    size_t Capacity() const { return slot_count_; }
+    size_t SlotSize() const { return slot_size_; }
+    size_t MemoryFootprint() const { return slot_count_ * slot_size_; }
+    uint64_t MaxAgeMs() const { return max_age_us_ / 1000; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> version;   // 奇数表示正在写入
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> len;       // 0表示空
+        std::atomic<uint64_t> deadline_us;
+    };
+
+    static uint64_t NowMicros();
+    Slot& SlotFor(uint32_t seq) const { return slots_[seq & mask_]; }
+    uint8_t* DataFor(uint32_t seq) const { return storage_.get() + (seq & mask_) * slot_size_; }
+    uint32_t LockSlot(Slot& slot);
+    void Invalidate(Slot& slot, uint32_t expected_seq);
+
+    size_t slot_count_;
+    size_t slot_size_;
+    size_t mask_;
+    uint64_t max_age_us_;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<uint8_t[]> storage_;
+    std::atomic<uint32_t> release_floor_;
+};
+
+template <typename SendFn>
+bool RetransmitBuffer::Resend(uint32_t seq, SendFn&& send, uint64_t now_us) const {
+    if (slot_count_ == 0) return false;
+    if (now_us == 0) now_us = NowMicros();
+
+    Slot& slot = SlotFor(seq);
+    uint32_t v1 = slot.version.load(std::memory_order_acquire);
+    if (v1 & 1) return false;
+    size_t len = slot.len.load(std::memory_order_relaxed);
+    if (len == 0 || slot.seq.load(std::memory_order_relaxed) != seq ||
+        slot.deadline_us.load(std::memory_order_relaxed) < now_us) {
+        return false;
+    }
+
+    ssize_t sent = send(static_cast<const uint8_t*>(DataFor(seq)), len);
+
+    // 发送期间槽位被改写则本次重传的内容不可信
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sent > 0 && slot.version.load(std::memory_order_relaxed) == v1;
+}
+
+#endif
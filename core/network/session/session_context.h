@@ -8,47 +8,106 @@
 #include <vector>
 #include <netinet/in.h> 
 #include <atomic>
+#include "congestion_controller.h"
+#include "packet_pacer.h"
+#include "retransmit_buffer.h"
+#include "coarse_clock.h"
+#include "session_keys.h"
+#include <memory>
 
 class SessionContext {
 public:
-    SessionContext(uint32_t id, const sockaddr_in& addr) 
+    SessionContext(uint32_t id, const sockaddr_in& addr,
+                   const RetransmitConfig& retransmit_config = RetransmitConfig(),
+                   const KeyRotationConfig& rotation_config = KeyRotationConfig()) 
         : session_id(id), client_addr(addr), 
-          last_active(std::chrono::steady_clock::now()),
+          keys(rotation_config),
+          activity(0),
+          swept_activity(0),
+          last_active_ms(CoarseClock::NowMillis()),
+          expired(false),
           next_seq(0),
-          congestion_window(1),  // 初始拥塞窗口大小
-          rtt(0) {}             // 初始RTT
+          congestion_window(congestion_ctrl.GetCongestionWindow()),  // 初始拥塞窗口 (字节)
+          rtt(0),               // 初始RTT (微秒)
+          pacer(congestion_ctrl),
+          retransmit_buf(retransmit_config.slot_count ? new RetransmitBuffer(retransmit_config) : nullptr) {}
 
     uint32_t GetAndIncrementSeq() {
         return next_seq.fetch_add(1, std::memory_order_relaxed);
     }
 
+    // 热路径只递增活跃计数 (允许并发丢失增量，只需能观察到变化)，由空闲定时器检查
     void UpdateLastActive() { 
-        last_active = std::chrono::steady_clock::now(); 
+        activity.store(activity.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); 
     }
 
     bool IsValid() const {
-        auto now = std::chrono::steady_clock::now();
-        return (now - last_active) <= std::chrono::seconds(30);
+        return !expired.load(std::memory_order_relaxed);
     }
 
     std::chrono::steady_clock::time_point GetLastActive() const { 
-        return last_active; 
+        return std::chrono::steady_clock::time_point(
+            std::chrono::milliseconds(last_active_ms.load(std::memory_order_relaxed))); 
     }
 
-    void AdjustCongestionWindow(bool ack_received);
+    // 空闲定时器: 计数自上次检查后有变化则刷新活跃时间并返回true
+    bool ObserveActivity(uint32_t* snapshot, uint64_t now_ms) {
+        uint32_t current = activity.load(std::memory_order_relaxed);
+        if (current == *snapshot) return false;
+        *snapshot = current;
+        last_active_ms.store(now_ms, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 兜底扫描 (CleanupInactiveSessions): 与空闲定时器分开保存快照，互不干扰
+    bool IsIdle(uint64_t now_ms, uint64_t timeout_ms) {
+        uint32_t snapshot = swept_activity.load(std::memory_order_relaxed);
+        bool active = ObserveActivity(&snapshot, now_ms);
+        swept_activity.store(snapshot, std::memory_order_relaxed);
+        return !active && now_ms - last_active_ms.load(std::memory_order_relaxed) > timeout_ms;
+    }
+
+    void MarkExpired() { expired.store(true, std::memory_order_relaxed); }
+
+    uint32_t GetSessionId() const { return session_id; }
+    const sockaddr_in& GetClientAddr() const { return client_addr; }
+
+    // 拥塞控制事件: 由发送路径和ACK处理路径调用
+    void OnPacketSent(uint32_t seq, size_t bytes);
+    void OnAckReceived(uint32_t seq, uint32_t ack_delay_us);
+    void OnPacketLost(uint32_t seq);
+    void OnPacketRetransmitted(uint32_t seq);
+    // 重传定时器到期: 超过RTO未确认的包判丢并追加到lost
+    size_t OnRetransmitTimer(uint64_t now_us, std::vector<uint32_t>* lost);
+
+    uint32_t GetRtt() const { return rtt.load(std::memory_order_relaxed); }
+    uint32_t GetCongestionWindow() const { return congestion_window.load(std::memory_order_relaxed); }
+    uint64_t GetTargetBitrate() const { return congestion_ctrl.GetTargetBitrate(); }
+
+    CongestionController& GetCongestionController() { return congestion_ctrl; }
+    PacketPacer& GetPacer() { return pacer; }
+
+    // 会话密钥 (握手完成后安装，之后按配置自动轮换)
+    void InstallKeys(const uint8_t key[16], const uint8_t salt[32], uint32_t epoch = 0) { keys.Install(key, salt, epoch); }
+    SessionKeys& GetKeys() { return keys; }
+
+    // 已序列化的加密包缓存，未启用时返回nullptr
+    RetransmitBuffer* GetRetransmitBuffer() { return retransmit_buf.get(); }
 
 private:
     uint32_t session_id;
     sockaddr_in client_addr;
-    uint8_t sm4_key[16];
-    std::chrono::steady_clock::time_point last_active;
+    SessionKeys keys;
+    std::atomic<uint32_t> activity;         // 收发包时递增
+    std::atomic<uint32_t> swept_activity;   // 兜底扫描上次看到的活跃计数
+    std::atomic<uint64_t> last_active_ms;   // 空闲定时器最近一次观察到活动的粗粒度时间
+    std::atomic<bool> expired;
     std::atomic<uint32_t> next_seq;
-    uint32_t congestion_window;
-    uint32_t rtt;
-
-    // 静态常量定义
-    static const uint32_t max_window_size = 65535;  // 最大窗口大小
-    static const uint32_t min_window_size = 1;      // 最小窗口大小
+    CongestionController congestion_ctrl;
+    std::atomic<uint32_t> congestion_window;  // 拥塞窗口 (字节)，由congestion_ctrl更新
+    std::atomic<uint32_t> rtt;                // 平滑RTT (微秒)，由congestion_ctrl更新
+    PacketPacer pacer;
+    std::unique_ptr<RetransmitBuffer> retransmit_buf;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+//会话密钥双缓冲与轮换实现
+
+#include "session_keys.h"
+#include "coarse_clock.h"
+#include "../../security/crypto/sm3.h"
+#include "../../../utils/performance/metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+    const char kRekeyLabel[] = "gulugulu rekey";
+}
+
+SessionKeys::SessionKeys(const KeyRotationConfig& config)
+    : config_(config), installed_(false), epoch_(0), rotated_at_us_(0), packets_(0), rotations_(0),
+      maintenance_(false) {
+    for (Slot& slot : slots_) {
+        slot.version.store(0, std::memory_order_relaxed);
+        memset(&slot.material, 0, sizeof(slot.material));
+    }
+}
+
+void SessionKeys::DeriveNext(const uint8_t key[16], const uint8_t salt[32], uint32_t next_epoch,
+                             uint8_t next_key[16], uint8_t next_salt[32]) {
+    // 输出 = SM3(key || salt || label || epoch || ctr), ctr = 1, 2
+    uint8_t out[64];
+    uint8_t epoch_be[4] = {
+        static_cast<uint8_t>(next_epoch >> 24), static_cast<uint8_t>(next_epoch >> 16),
+        static_cast<uint8_t>(next_epoch >> 8), static_cast<uint8_t>(next_epoch)
+    };
+    for (uint8_t ctr = 1; ctr <= 2; ++ctr) {
+        uint8_t ctr_be[4] = {0, 0, 0, ctr};
+        SM3_CTX ctx;
+        sm3_init(&ctx);
+        sm3_update(&ctx, key, 16);
+        sm3_update(&ctx, salt, 32);
+        sm3_update(&ctx, reinterpret_cast<const uint8_t*>(kRekeyLabel), sizeof(kRekeyLabel) - 1);
+        sm3_update(&ctx, epoch_be, 4);
+        sm3_update(&ctx, ctr_be, 4);
+        sm3_final(&ctx, out + (ctr - 1) * 32);
+    }
+    memcpy(next_key, out, 16);
+    memcpy(next_salt, out + 16, 32);
+    memset(out, 0, sizeof(out));
+}
+
+bool SessionKeys::ReadSlot(uint32_t index, KeyMaterial* out) const {
+    const Slot& slot = slots_[index & 1];
+    for (;;) {
+        uint32_t v = slot.version.load(std::memory_order_acquire);
+        if (v & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(out, &slot.material, sizeof(KeyMaterial));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) == v) {
+            return true;
+        }
+    }
+}
+
+void SessionKeys::WriteSlot(uint32_t index, const uint8_t key[16], const uint8_t salt[32], uint32_t epoch) {
+    // 先在栈上展开，槽位只在memcpy期间处于写入状态
+    KeyMaterial m;
+    sm4_init(&m.sm4, key, 1);
+    memcpy(m.key, key, 16);
+    memcpy(m.salt, salt, 32);
+    m.epoch = epoch;
+
+    Slot& slot = slots_[index & 1];
+    uint32_t v = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.material, &m, sizeof(KeyMaterial));
+    slot.version.store(v + 2, std::memory_order_release);
+    memset(&m, 0, sizeof(m));
+}
+
+void SessionKeys::Install(const uint8_t key[16], const uint8_t salt[32], uint32_t epoch) {
+    bool expected = false;
+    while (!maintenance_.compare_exchange_weak(expected, true, std::memory_order_acquire)) {
+        expected = false;
+        std::this_thread::yield();
+    }
+    WriteSlot(epoch, key, salt, epoch);
+    if (epoch != 0) {
+        // 中途加入时对端随时可能推进到下一epoch，立即展开而不是等宽限期
+        uint8_t next_key[16];
+        uint8_t next_salt[32];
+        DeriveNext(key, salt, epoch + 1, next_key, next_salt);
+        WriteSlot(epoch + 1, next_key, next_salt, epoch + 1);
+        memset(next_key, 0, sizeof(next_key));
+        memset(next_salt, 0, sizeof(next_salt));
+    }
+    epoch_.store(epoch, std::memory_order_release);
+    packets_.store(0, std::memory_order_relaxed);
+    rotated_at_us_.store(CoarseClock::SteadyMicros(), std::memory_order_relaxed);
+    installed_.store(true, std::memory_order_release);
+    maintenance_.store(false, std::memory_order_release);
+}
+
+bool SessionKeys::Current(KeyMaterial* out) const {
+    if (!IsInstalled()) return false;
+    for (;;) {
+        uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        ReadSlot(epoch, out);
+        if (out->epoch == epoch) return true;
+    }
+}
+
+bool SessionKeys::NextReady(uint32_t epoch) const {
+    KeyMaterial m;
+    ReadSlot(epoch + 1, &m);
+    bool ready = m.epoch == epoch + 1;
+    memset(&m, 0, sizeof(m));
+    return ready;
+}
+
+void SessionKeys::MaybeInstallNext(uint32_t epoch, uint64_t now_us) {
+    uint64_t rotated_at = rotated_at_us_.load(std::memory_order_relaxed);
+    if (now_us < rotated_at + static_cast<uint64_t>(config_.grace_ms) * 1000) return;
+
+    bool expected = false;
+    if (!maintenance_.compare_exchange_strong(expected, true, std::memory_order_acquire)) return;
+
+    // 持有维护权后重新确认状态
+    if (epoch_.load(std::memory_order_acquire) == epoch && !NextReady(epoch)) {
+        KeyMaterial current;
+        ReadSlot(epoch, &current);
+        if (current.epoch == epoch) {
+            uint8_t next_key[16];
+            uint8_t next_salt[32];
+            DeriveNext(current.key, current.salt, epoch + 1, next_key, next_salt);
+            WriteSlot(epoch + 1, next_key, next_salt, epoch + 1);
+            memset(next_key, 0, sizeof(next_key));
+            memset(next_salt, 0, sizeof(next_salt));
+        }
+        memset(&current, 0, sizeof(current));
+    }
+    maintenance_.store(false, std::memory_order_release);
+}
+
+bool SessionKeys::AcquireForSend(KeyMaterial* out, uint64_t now_us) {
+    if (!IsInstalled()) return false;
+    if (now_us == 0) now_us = CoarseClock::SteadyMicros();
+
+    uint32_t epoch = epoch_.load(std::memory_order_acquire);
+    MaybeInstallNext(epoch, now_us);
+
+    uint64_t sent = packets_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t age_us = now_us - std::min(now_us, rotated_at_us_.load(std::memory_order_relaxed));
+    bool due = sent >= config_.max_packets || age_us >= static_cast<uint64_t>(config_.max_age_ms) * 1000;
+    if (due && age_us >= 2ull * config_.grace_ms * 1000 && NextReady(epoch) &&
+        epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel)) {
+        // 仅CAS成功的线程重置计数，其他线程继续使用旧epoch直到下一次读取
+        rotated_at_us_.store(now_us, std::memory_order_relaxed);
+        packets_.store(0, std::memory_order_relaxed);
+        rotations_.fetch_add(1, std::memory_order_relaxed);
+        utils::Metrics::Count(utils::Event::KeyRotations);
+        ++epoch;
+    }
+
+    // 读到的槽可能已被后续轮换覆盖，按epoch校验后重试
+    for (;;) {
+        ReadSlot(epoch, out);
+        if (out->epoch == epoch) return true;
+        epoch = epoch_.load(std::memory_order_acquire);
+    }
+}
+
+bool SessionKeys::AcquireForReceive(uint8_t epoch_bit, KeyMaterial* out, uint64_t now_us) {
+    if (!IsInstalled()) return false;
+    if (now_us == 0) now_us = CoarseClock::SteadyMicros();
+
+    uint32_t epoch = epoch_.load(std::memory_order_acquire);
+    MaybeInstallNext(epoch, now_us);
+
+    ReadSlot(epoch_bit, out);
+    // 槽内只可能是 e-1、e 或 e+1 的密钥，其余情况视为无效
+    uint32_t diff = out->epoch - epoch;
+    return (out->epoch & 1) == (epoch_bit & 1) && (diff == 0 || diff == 1 || diff == UINT32_MAX);
+}
+
+void SessionKeys::ConfirmEpoch(uint32_t epoch, uint64_t now_us) {
+    if (now_us == 0) now_us = CoarseClock::SteadyMicros();
+    uint32_t current = epoch_.load(std::memory_order_acquire);
+    if (epoch == current + 1 && epoch_.compare_exchange_strong(current, epoch, std::memory_order_acq_rel)) {
+        rotated_at_us_.store(now_us, std::memory_order_relaxed);
+        packets_.store(0, std::memory_order_relaxed);
+        rotations_.fetch_add(1, std::memory_order_relaxed);   // 跟随对端，不计入埋点
+    }
+}
@@ -0,0 +1,80 @@
+//会话密钥双缓冲与轮换声明
+
+#ifndef SESSION_KEYS_H
+#define SESSION_KEYS_H
+
+#include <atomic>
+#include <cstdint>
+#include "../../security/crypto/sm4.h"
+
+struct KeyRotationConfig {
+    uint64_t max_packets = 1ull << 24;   // 单个密钥最多加密的包数
+    uint32_t max_age_ms = 600000;        // 单个密钥最长使用时间
+    uint32_t grace_ms = 2000;            // 旧密钥保留时长 (须大于最大乱序/抖动窗口)
+};
+
+// 已展开的密钥: SM4轮密钥 + SM3盐值
+struct KeyMaterial {
+    SM4_CTX sm4;             // iv字段不使用，调用方复制后自行设置
+    uint8_t key[16];
+    uint8_t salt[32];
+    uint32_t epoch;
+};
+
+// 每会话两个密钥槽 (epoch & 1 选槽，版本号保护)，旧槽保留e-1供乱序包解密
+// 发送端按包数/时间推进epoch，接收端见到新epoch的合法包后跟随，两端按KDF派生密钥
+class SessionKeys {
+public:
+    explicit SessionKeys(const KeyRotationConfig& config = KeyRotationConfig());
+
+    SessionKeys(const SessionKeys&) = delete;
+    SessionKeys& operator=(const SessionKeys&) = delete;
+
+    // 安装握手得到的初始密钥 (epoch 0)，或中途加入组会话时的当前密钥
+    void Install(const uint8_t key[16], const uint8_t salt[32], uint32_t epoch = 0);
+    bool IsInstalled() const { return installed_.load(std::memory_order_acquire); }
+
+    // 读取当前epoch的密钥，不计入发送包数 (用于向新成员下发组密钥)
+    bool Current(KeyMaterial* out) const;
+
+    // 发送端: 取当前密钥并计数，必要时推进轮换。now_us为0时读取单调时钟
+    // (不用CoarseClock: 定时线程停止时缓存不再前进，轮换会永远不触发)
+    bool AcquireForSend(KeyMaterial* out, uint64_t now_us = 0);
+
+    // 接收端: 按包头的epoch位取密钥
+    bool AcquireForReceive(uint8_t epoch_bit, KeyMaterial* out, uint64_t now_us = 0);
+
+    // 接收端: 用新epoch的密钥成功校验后调用，跟随对端切换
+    void ConfirmEpoch(uint32_t epoch, uint64_t now_us = 0);
+
+    uint32_t GetEpoch() const { return epoch_.load(std::memory_order_acquire); }
+    // 本实例的轮换次数 (发送端发起与接收端跟随各自计数; KeyRotations埋点只计发送端发起的轮换)
+    uint64_t GetRotations() const { return rotations_.load(std::memory_order_relaxed); }
+
+    // 从epoch e的密钥派生e+1的密钥 (SM3计数器模式KDF)
+    static void DeriveNext(const uint8_t key[16], const uint8_t salt[32], uint32_t next_epoch,
+                           uint8_t next_key[16], uint8_t next_salt[32]);
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> version;
+        KeyMaterial material;
+    };
+
+    bool ReadSlot(uint32_t index, KeyMaterial* out) const;
+    void WriteSlot(uint32_t index, const uint8_t key[16], const uint8_t salt[32], uint32_t epoch);
+    // 宽限期结束后预展开下一个密钥
+    void MaybeInstallNext(uint32_t epoch, uint64_t now_us);
+    bool NextReady(uint32_t epoch) const;
+
+    KeyRotationConfig config_;
+    Slot slots_[2];
+    std::atomic<bool> installed_;
+    std::atomic<uint32_t> epoch_;
+    std::atomic<uint64_t> rotated_at_us_;
+    std::atomic<uint64_t> packets_;       // 当前epoch已发送的包数
+    std::atomic<uint64_t> rotations_;
+    std::atomic<bool> maintenance_;       // 同一时刻只允许一个线程写入槽位
+};
+
+#endif
@@ -2,57 +2,345 @@
 
 #include <iostream>
 #include "session_manager.h"
+#include "epoch_reclaimer.h"
+#include "coarse_clock.h"
+#include "../../../utils/performance/metrics.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 using namespace std;
 
+namespace {
+
+bool IdLess(const std::pair<uint32_t, SessionHandle>& entry, uint32_t id) {
+    return entry.first < id;
+}
+
+}  // namespace
+
+SessionManager::SessionManager()
+    : rejected_packets_(0),
+      next_session_id_(1),
+      timers_(CoarseClock::Update() / 1000),
+      idle_timeout_ms_(30000),
+      timer_running_(false),
+      timer_stopped_(false) {
+    // 先于本单例构造，确保进程退出时定时线程停止前回收器仍然存在
+    EpochReclaimer::GetInstance();
+    for (size_t i = 0; i < kShardCount; ++i) {
+        shards_[i].table.store(new SessionTable(), std::memory_order_release);
+    }
+}
+
+SessionManager::~SessionManager() {
+    StopTimerThread();
+    for (size_t i = 0; i < kShardCount; ++i) {
+        delete shards_[i].table.load(std::memory_order_acquire);
+    }
+}
+
+SessionHandle SessionManager::Find(const SessionTable* table, uint32_t session_id) {
+    auto it = std::lower_bound(table->begin(), table->end(), session_id, IdLess);
+    if (it != table->end() && it->first == session_id) {
+        return it->second;
+    }
+    return SessionHandle();
+}
+
+void SessionManager::Publish(Shard& shard, SessionTable* table) {
+    const SessionTable* old = shard.table.exchange(table, std::memory_order_acq_rel);
+    EpochReclaimer& reclaimer = EpochReclaimer::GetInstance();
+    reclaimer.Retire(const_cast<SessionTable*>(old));
+    reclaimer.TryReclaim();
+}
+
+SessionHandle SessionManager::MakeSession(uint32_t session_id, const struct sockaddr_in& addr, bool retransmit) {
+    RetransmitConfig config;
+    KeyRotationConfig rotation;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        if (retransmit) config = retransmit_config_;
+        rotation = rotation_config_;
+    }
+    if (!retransmit) config.slot_count = 0;
+    return std::make_shared<SessionContext>(session_id, addr, config, rotation);
+}
+
+bool SessionManager::InsertSession(SessionHandle session, const struct sockaddr_in& addr, bool bind_address) {
+    uint32_t session_id = session->GetSessionId();
+    RetransmitBuffer* rtx = session->GetRetransmitBuffer();
+    uint64_t max_age_ms = rtx ? rtx->MaxAgeMs() : 0;
+    std::weak_ptr<SessionContext> weak = session;
+    {
+        Shard& shard = ShardFor(session_id);
+        std::lock_guard<std::mutex> lock(shard.write_mutex);
+        const SessionTable* current = shard.table.load(std::memory_order_acquire);
+        auto pos = std::lower_bound(current->begin(), current->end(), session_id, IdLess);
+        if (pos != current->end() && pos->first == session_id) {
+            return false;
+        }
+        SessionTable* table = new SessionTable();
+        table->reserve(current->size() + 1);
+        table->insert(table->end(), current->begin(), pos);
+        table->emplace_back(session_id, std::move(session));
+        table->insert(table->end(), pos, current->end());
+        Publish(shard, table);
+    }
+    if (bind_address) address_index_.Insert(addr, session_id);
+    utils::Metrics::Count(utils::Event::SessionsCreated);
+
+    if (!timer_running_.load(std::memory_order_relaxed) && !timer_stopped_.load(std::memory_order_relaxed)) {
+        StartTimerThread();
+    }
+
+    // 不在分片锁内获取定时器锁 (定时回调会在定时器锁内调用RemoveSession)
+    std::lock_guard<std::recursive_mutex> timer_lock(timer_mutex_);
+    ScheduleIdleCheck(weak, 0);
+    ScheduleRetransmitTimer(weak);
+    if (rtx) {
+        ScheduleAgeOut(weak, std::max<uint64_t>(max_age_ms, 1));
+    }
+    return true;
+}
+
 uint32_t SessionManager::CreateSession(const struct sockaddr_in& client_addr) {
-    std::lock_guard<std::mutex> lock(mutex_);
     uint32_t session_id = GenerateSessionId();
-    
-    auto session = std::make_unique<SessionContext>(session_id, client_addr);
-    sessions_[session_id] = std::move(session);
-    
+    InsertSession(MakeSession(session_id, client_addr), client_addr);
     return session_id;
 }
 
-SessionContext* SessionManager::GetSession(uint32_t session_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = sessions_.find(session_id);
-    if (it != sessions_.end()) {
-        if (it->second->IsValid()) {  // 检查会话是否有效
-            it->second->UpdateLastActive();  // 更新最后活跃时间
-            return it->second.get();
-        } else {
-            sessions_.erase(it);  // 移除无效会话
-            return nullptr;
-        }
+bool SessionManager::CreateSession(const struct sockaddr_in& peer_addr, uint32_t session_id) {
+    if (session_id == 0) return false;
+    // 接收端会话只收不发媒体包，不需要重传缓冲区
+    return InsertSession(MakeSession(session_id, peer_addr, false), peer_addr);
+}
+
+uint32_t SessionManager::CreateGroupSession() {
+    sockaddr_in none;
+    memset(&none, 0, sizeof(none));
+    uint32_t session_id = GenerateSessionId();
+    // 组会话的密文按订阅者改写seq后发出，缓存的副本无法按seq重传
+    InsertSession(MakeSession(session_id, none, false), none, false);
+    return session_id;
+}
+
+SessionHandle SessionManager::GetSession(uint32_t session_id) {
+    SessionHandle session;
+    {
+        EpochReclaimer::Guard guard;
+        session = Find(ShardFor(session_id).table.load(std::memory_order_acquire), session_id);
+    }
+    if (!session || !session->IsValid()) {
+        return SessionHandle();  // 已过期，等待空闲定时器移除
+    }
+    session->UpdateLastActive();  // 更新最后活跃时间
+    return session;
+}
+
+SessionHandle SessionManager::FindSessionByAddress(const struct sockaddr_in& addr) {
+    uint32_t session_id = address_index_.Find(addr);
+    if (session_id == AddressIndex::kNotFound) {
+        return SessionHandle();
+    }
+    return GetSession(session_id);
+}
+
+SessionHandle SessionManager::Demux(const struct sockaddr_in& from, uint32_t session_id) {
+    // 只做一次哈希探测即可拒绝伪造session_id或未建立会话的来源
+    if (session_id == AddressIndex::kNotFound || address_index_.Find(from) != session_id) {
+        rejected_packets_.fetch_add(1, std::memory_order_relaxed);
+        return SessionHandle();
+    }
+    SessionHandle session = GetSession(session_id);
+    if (!session) {
+        rejected_packets_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return session;
+}
+
+bool SessionManager::HasSession(uint32_t session_id) const {
+    EpochReclaimer::Guard guard;
+    const SessionTable* table = ShardFor(session_id).table.load(std::memory_order_acquire);
+    auto it = std::lower_bound(table->begin(), table->end(), session_id, IdLess);
+    return it != table->end() && it->first == session_id;
+}
+
+size_t SessionManager::SessionCount() const {
+    EpochReclaimer::Guard guard;
+    size_t count = 0;
+    for (size_t i = 0; i < kShardCount; ++i) {
+        count += shards_[i].table.load(std::memory_order_acquire)->size();
+    }
+    return count;
+}
+
+bool SessionManager::RemoveSession(uint32_t session_id) {
+    Shard& shard = ShardFor(session_id);
+    std::lock_guard<std::mutex> lock(shard.write_mutex);
+    const SessionTable* current = shard.table.load(std::memory_order_acquire);
+    auto pos = std::lower_bound(current->begin(), current->end(), session_id, IdLess);
+    if (pos == current->end() || pos->first != session_id) {
+        return false;
     }
-    return nullptr;
+    pos->second->MarkExpired();  // 仍持有句柄的使用者随后看到会话失效
+    address_index_.Erase(pos->second->GetClientAddr(), session_id);
+
+    SessionTable* table = new SessionTable();
+    table->reserve(current->size() - 1);
+    table->insert(table->end(), current->begin(), pos);
+    table->insert(table->end(), pos + 1, current->end());
+    Publish(shard, table);
+    utils::Metrics::Count(utils::Event::SessionsRemoved);
+    return true;
+}
+
+void SessionManager::SetRetransmitConfig(const RetransmitConfig& config) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    retransmit_config_ = config;
+}
+
+void SessionManager::SetKeyRotationConfig(const KeyRotationConfig& config) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    rotation_config_ = config;
+}
+
+void SessionManager::SetIdleTimeout(uint64_t timeout_ms) {
+    std::lock_guard<std::recursive_mutex> lock(timer_mutex_);
+    idle_timeout_ms_ = std::max<uint64_t>(timeout_ms, 1);
+}
+
+void SessionManager::SetLossHandler(LossHandler handler) {
+    std::lock_guard<std::recursive_mutex> lock(timer_mutex_);
+    loss_handler_ = std::move(handler);
+}
+
+TimerWheel::TimerId SessionManager::ScheduleTimer(uint64_t delay_ms, TimerWheel::Callback cb) {
+    std::lock_guard<std::recursive_mutex> lock(timer_mutex_);
+    return timers_.Schedule(delay_ms, std::move(cb));
+}
+
+bool SessionManager::CancelTimer(TimerWheel::TimerId id) {
+    std::lock_guard<std::recursive_mutex> lock(timer_mutex_);
+    return timers_.Cancel(id);
+}
+
+size_t SessionManager::ProcessTimers() {
+    uint64_t now_ms = CoarseClock::Update() / 1000;
+    std::lock_guard<std::recursive_mutex> lock(timer_mutex_);
+    return timers_.Advance(now_ms);
+}
+
+void SessionManager::StartTimerThread(uint32_t tick_ms) {
+    timer_stopped_.store(false);
+    if (timer_running_.exchange(true)) return;
+    timer_thread_ = std::thread([this, tick_ms]() {
+        while (timer_running_.load(std::memory_order_relaxed)) {
+            ProcessTimers();
+            std::this_thread::sleep_for(std::chrono::milliseconds(tick_ms));
+        }
+    });
+}
+
+void SessionManager::StopTimerThread() {
+    timer_stopped_.store(true);
+    if (!timer_running_.exchange(false)) return;
+    if (timer_thread_.joinable()) timer_thread_.join();
 }
 
+size_t SessionManager::CleanupInactiveSessions(uint64_t timeout_ms) {
+    const uint64_t now_ms = CoarseClock::Update() / 1000;
+    std::vector<uint32_t> idle;
+    {
+        EpochReclaimer::Guard guard;
+        for (size_t i = 0; i < kShardCount; ++i) {
+            for (const auto& entry : *shards_[i].table.load(std::memory_order_acquire)) {
+                if (entry.second->IsIdle(now_ms, timeout_ms)) idle.push_back(entry.first);
+            }
+        }
+    }
+    size_t removed = 0;
+    for (uint32_t session_id : idle) {
+        if (RemoveSession(session_id)) {
+            utils::Metrics::Count(utils::Event::SessionsExpired);
+            ++removed;
+        }
+    }
+    return removed;
+}
 
+// 每个周期检查一次活跃计数，整周期无变化则判定空闲
+void SessionManager::ScheduleIdleCheck(std::weak_ptr<SessionContext> weak, uint32_t snapshot) {
+    timers_.Schedule(idle_timeout_ms_, [this, weak, snapshot]() mutable {
+        SessionHandle session = weak.lock();
+        if (!session || !session->IsValid()) return;
 
-void SessionManager::CleanupInactiveSessions(uint64_t timeout_ms) {
-    auto now = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    for (auto it = sessions_.begin(); it != sessions_.end();) {
-        // 使用 SessionContext 的 GetLastActive 方法
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - it->second->GetLastActive());
-            
-        if (elapsed.count() > timeout_ms) {
-            it = sessions_.erase(it);
+        if (session->ObserveActivity(&snapshot, CoarseClock::NowMillis())) {
+            ScheduleIdleCheck(weak, snapshot);
         } else {
-            ++it;
+            session->MarkExpired();
+            utils::Metrics::Count(utils::Event::SessionsExpired);
+            RemoveSession(session->GetSessionId());
         }
+    });
+}
+
+// 按当前RTO周期触发，超时未确认的包交给loss_handler_
+void SessionManager::ScheduleRetransmitTimer(std::weak_ptr<SessionContext> weak) {
+    uint64_t delay_ms = 10;
+    if (SessionHandle session = weak.lock()) {
+        delay_ms = std::max<uint64_t>(session->GetCongestionController().GetRto() / 1000, delay_ms);
     }
+    timers_.Schedule(delay_ms, [this, weak]() {
+        SessionHandle session = weak.lock();
+        if (!session || !session->IsValid()) return;
+
+        lost_scratch_.clear();
+        session->OnRetransmitTimer(CoarseClock::NowMicros(), &lost_scratch_);
+        if (!lost_scratch_.empty()) utils::Metrics::Count(utils::Event::PacketsLost, lost_scratch_.size());
+        if (loss_handler_) {
+            for (uint32_t seq : lost_scratch_) loss_handler_(session, seq);
+        }
+        ScheduleRetransmitTimer(weak);
+    });
 }
 
-void SessionContext::AdjustCongestionWindow(bool ack_received) {
-    if (ack_received) {
-        congestion_window = std::min(congestion_window * 2, max_window_size);
-    } else {
-        congestion_window = std::max(congestion_window / 2, min_window_size);
+void SessionManager::ScheduleAgeOut(std::weak_ptr<SessionContext> weak, uint64_t interval_ms) {
+    timers_.Schedule(interval_ms, [this, weak, interval_ms]() {
+        SessionHandle session = weak.lock();
+        if (!session || !session->IsValid()) return;
+        if (RetransmitBuffer* rtx = session->GetRetransmitBuffer()) {
+            rtx->AgeOut(CoarseClock::NowMicros());
+        }
+        ScheduleAgeOut(weak, interval_ms);
+    });
+}
+
+void SessionContext::OnPacketSent(uint32_t seq, size_t bytes) {
+    congestion_ctrl.OnPacketSent(seq, bytes);
+}
+
+void SessionContext::OnAckReceived(uint32_t seq, uint32_t ack_delay_us) {
+    UpdateLastActive();
+    if (retransmit_buf) retransmit_buf->Release(seq);   // 已送达，不会再重传
+    if (congestion_ctrl.OnAck(seq, ack_delay_us)) {
+        rtt.store(congestion_ctrl.GetSmoothedRtt(), std::memory_order_relaxed);
+        congestion_window.store(congestion_ctrl.GetCongestionWindow(), std::memory_order_relaxed);
     }
-}
\ No newline at end of file
+}
+
+void SessionContext::OnPacketLost(uint32_t seq) {
+    congestion_ctrl.OnPacketLost(seq);
+    congestion_window.store(congestion_ctrl.GetCongestionWindow(), std::memory_order_relaxed);
+}
+
+void SessionContext::OnPacketRetransmitted(uint32_t seq) {
+    congestion_ctrl.OnPacketRetransmitted(seq);
+}
+
+size_t SessionContext::OnRetransmitTimer(uint64_t now_us, std::vector<uint32_t>* lost) {
+    size_t count = congestion_ctrl.DetectTimeouts(now_us, lost);
+    if (count) {
+        congestion_window.store(congestion_ctrl.GetCongestionWindow(), std::memory_order_relaxed);
+    }
+    return count;
+}
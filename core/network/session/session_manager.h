@@ -4,15 +4,29 @@
 #define SESSION_MANAGER_H
 
 #include "session_context.h"
-#include <unordered_map>
+#include "timer_wheel.h"
+#include "address_index.h"
+#include <functional>
+#include <thread>
+#include <vector>
+#include <utility>
 #include <mutex>
 #include <atomic>
 #include <chrono>
 #include <netinet/in.h>
 #include <memory>
 
+// 会话句柄: 持有期间会话不会被释放，即使已从表中移除
+using SessionHandle = std::shared_ptr<SessionContext>;
+
+// 会话表按session_id分片、写时复制，读路径无锁; 超时与重传由时间轮驱动
 class SessionManager {
 public:
+    static const size_t kShardCount = 64;
+
+    // 重传定时器判定丢失的包，由传输层决定是否重传
+    using LossHandler = std::function<void(const SessionHandle& session, uint32_t seq)>;
+
     static SessionManager& GetInstance() {
     static SessionManager instance;
     return instance;
@@ -24,32 +38,113 @@ public:
     
     //创建新会话 (返回session_id)
     uint32_t CreateSession(const struct sockaddr_in& client_addr);
+
+    //以对端分配的session_id创建会话 (接收端握手完成后使用)，ID已存在返回false。
+    //地址已绑定到其他会话时改为绑定到该会话 (接收端加入组会话)
+    bool CreateSession(const struct sockaddr_in& peer_addr, uint32_t session_id);
+
+    //创建不绑定地址的组会话 (发送端一次加密、多接收端)，只用于封装，不参与收包分流
+    uint32_t CreateGroupSession();
     
-    //获取会话上下文
-    SessionContext* GetSession(uint32_t session_id);
+    //获取会话上下文 (会话不存在或已过期返回空句柄)
+    SessionHandle GetSession(uint32_t session_id);
     
-    // 清理超时会话
-    void CleanupInactiveSessions(uint64_t timeout_ms = 30000);
+    // 空闲超时: 连续timeout_ms未观察到活动的会话被移除 (实际在 [timeout, 2*timeout) 内)
+    void SetIdleTimeout(uint64_t timeout_ms);
+
+    // 刷新粗粒度时钟并推进时间轮，返回触发的定时器个数。
+    // 定时线程停止后由调用方周期性调用
+    size_t ProcessTimers();
+
+    // 后台定时线程，每tick_ms调用一次ProcessTimers。创建会话时自动以默认周期启动，
+    // 显式调用StopTimerThread后不再自动启动
+    void StartTimerThread(uint32_t tick_ms = 1);
+    void StopTimerThread();
+
+    // 不依赖时间轮的兜底扫描: 移除两次扫描之间活跃计数未变化且超过timeout_ms未观察到活动的会话，
+    // 返回移除个数。全表扫描，只在定时线程停止时由调用方周期性调用
+    size_t CleanupInactiveSessions(uint64_t timeout_ms);
+
+    // 通用定时器 (如分片重组超时)，回调在定时线程中执行，可在回调内再次调度
+    TimerWheel::TimerId ScheduleTimer(uint64_t delay_ms, TimerWheel::Callback cb);
+    bool CancelTimer(TimerWheel::TimerId id);
+
+    void SetLossHandler(LossHandler handler);
+
+    //按来源地址查找会话
+    SessionHandle FindSessionByAddress(const struct sockaddr_in& addr);
+
+    //收包分流: 来源地址必须绑定到包头中的session_id，否则在解密前丢弃
+    SessionHandle Demux(const struct sockaddr_in& from, uint32_t session_id);
+
+    //Demux拒绝的包数 (地址未绑定或与session_id不符)
+    uint64_t GetRejectedPackets() const { return rejected_packets_.load(std::memory_order_relaxed); }
 
     //检查会话是否存在
     bool HasSession(uint32_t session_id) const;
 
+    //当前会话数
+    size_t SessionCount() const;
+
     //移除指定会话
     bool RemoveSession(uint32_t session_id);
 
+    //设置发送端新建会话的重传缓冲区大小 (默认及slot_count为0则不缓存，接收端会话始终不缓存)
+    void SetRetransmitConfig(const RetransmitConfig& config);
+
+    //设置新建会话的密钥轮换策略
+    void SetKeyRotationConfig(const KeyRotationConfig& config);
+
 private:
     //私有构造函数
-    SessionManager() : next_session_id_(1), last_cleanup_(std::chrono::steady_clock::now()) {}
+    SessionManager();
+    ~SessionManager();
     
     //生成唯一会话ID
     uint32_t GenerateSessionId() {
         return next_session_id_.fetch_add(1, std::memory_order_relaxed);
     }
 
-    std::unordered_map<uint32_t, std::unique_ptr<SessionContext>> sessions_;
-    std::mutex mutex_;
+    typedef std::vector<std::pair<uint32_t, SessionHandle>> SessionTable;  // 按id升序
+
+    struct alignas(64) Shard {
+        std::atomic<const SessionTable*> table{nullptr};
+        std::mutex write_mutex;
+    };
+
+    Shard& ShardFor(uint32_t session_id) { return shards_[session_id & (kShardCount - 1)]; }
+    const Shard& ShardFor(uint32_t session_id) const { return shards_[session_id & (kShardCount - 1)]; }
+
+    // retransmit为false时不分配重传缓冲区 (忽略SetRetransmitConfig)
+    SessionHandle MakeSession(uint32_t session_id, const struct sockaddr_in& addr, bool retransmit = true);
+    // 插入分片表、地址索引 (bind_address为false时跳过) 并启动会话定时器
+    bool InsertSession(SessionHandle session, const struct sockaddr_in& addr, bool bind_address = true);
+
+    static SessionHandle Find(const SessionTable* table, uint32_t session_id);
+    // 写锁内调用: 发布新表并退休旧表
+    void Publish(Shard& shard, SessionTable* table);
+
+    // 以下在timer_mutex_内调用
+    void ScheduleIdleCheck(std::weak_ptr<SessionContext> session, uint32_t snapshot);
+    void ScheduleRetransmitTimer(std::weak_ptr<SessionContext> session);
+    void ScheduleAgeOut(std::weak_ptr<SessionContext> session, uint64_t interval_ms);
+
+    Shard shards_[kShardCount];
+    AddressIndex address_index_;
+    std::atomic<uint64_t> rejected_packets_;
+    std::mutex config_mutex_;
     std::atomic<uint32_t> next_session_id_;
-    std::chrono::steady_clock::time_point last_cleanup_;
+    RetransmitConfig retransmit_config_;
+    KeyRotationConfig rotation_config_;
+
+    std::recursive_mutex timer_mutex_;   // 回调中允许重入ScheduleTimer
+    TimerWheel timers_;
+    uint64_t idle_timeout_ms_;
+    LossHandler loss_handler_;
+    std::vector<uint32_t> lost_scratch_;
+    std::thread timer_thread_;
+    std::atomic<bool> timer_running_;
+    std::atomic<bool> timer_stopped_;    // 显式停止后不再自动启动
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+//分层时间轮实现
+
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(uint64_t start_ms)
+    : firing_head_(kNil), now_(start_ms), clock_(start_ms), active_(0) {
+    for (int l = 0; l < kLevels; ++l) {
+        for (uint32_t s = 0; s < kSlots; ++s) {
+            heads_[l][s] = kNil;
+        }
+    }
+}
+
+uint32_t TimerWheel::AllocNode() {
+    if (!free_.empty()) {
+        uint32_t idx = free_.back();
+        free_.pop_back();
+        return idx;
+    }
+    nodes_.push_back(Node());
+    nodes_.back().generation = 0;
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::FreeNode(uint32_t idx) {
+    Node& n = nodes_[idx];
+    n.active = false;
+    n.cb = nullptr;
+    ++n.generation;     // 使旧的TimerId失效
+    free_.push_back(idx);
+}
+
+void TimerWheel::Link(uint32_t idx, uint8_t level, uint8_t slot) {
+    Node& n = nodes_[idx];
+    uint32_t& head = HeadOf(level, slot);
+    n.level = level;
+    n.slot = slot;
+    n.prev = kNil;
+    n.next = head;
+    if (head != kNil) nodes_[head].prev = idx;
+    head = idx;
+}
+
+void TimerWheel::Unlink(uint32_t idx) {
+    Node& n = nodes_[idx];
+    if (n.prev != kNil) {
+        nodes_[n.prev].next = n.next;
+    } else {
+        HeadOf(n.level, n.slot) = n.next;
+    }
+    if (n.next != kNil) nodes_[n.next].prev = n.prev;
+    n.prev = n.next = kNil;
+}
+
+// 按距当前刻度的差值选择层级: 第L层覆盖 [64^L, 64^(L+1)) 个刻度
+void TimerWheel::Place(uint32_t idx) {
+    uint64_t expire = nodes_[idx].expire;
+    if (expire < now_) expire = now_;
+    uint64_t delta = expire - now_;
+
+    const uint64_t max_delta = (1ull << (kSlotBits * kLevels)) - 1;
+    if (delta > max_delta) {
+        expire = now_ + max_delta;  // 超出范围: 放在顶层，下放时按真实到期时间重新定位
+        delta = max_delta;
+    }
+
+    int level = 0;
+    while (level < kLevels - 1 && delta >= (1ull << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    uint8_t slot = static_cast<uint8_t>((expire >> (kSlotBits * level)) & (kSlots - 1));
+    Link(idx, static_cast<uint8_t>(level), slot);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t delay_ms, Callback cb) {
+    uint32_t idx = AllocNode();
+    Node& n = nodes_[idx];
+    // 当前刻度可能正在处理，最早排到下一刻度
+    n.expire = clock_ + (delay_ms > 0 ? delay_ms : 1);
+    n.cb = std::move(cb);
+    n.active = true;
+    Place(idx);
+    ++active_;
+    return (static_cast<uint64_t>(n.generation) << 32) | (idx + 1ull);
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    if (id == 0) return false;
+    uint32_t idx = static_cast<uint32_t>(id & 0xFFFFFFFFu) - 1;
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (idx >= nodes_.size()) return false;
+    Node& n = nodes_[idx];
+    if (!n.active || n.generation != generation) return false;
+    Unlink(idx);
+    FreeNode(idx);
+    --active_;
+    return true;
+}
+
+void TimerWheel::Cascade(int level) {
+    uint8_t slot = static_cast<uint8_t>((now_ >> (kSlotBits * level)) & (kSlots - 1));
+    uint32_t idx = heads_[level][slot];
+    heads_[level][slot] = kNil;
+    while (idx != kNil) {
+        uint32_t next = nodes_[idx].next;
+        Place(idx);
+        idx = next;
+    }
+}
+
+size_t TimerWheel::Advance(uint64_t now_ms) {
+    size_t fired = 0;
+    while (now_ <= now_ms) {
+        if (active_ == 0) {
+            now_ = now_ms + 1;  // 空轮直接跳过
+            break;
+        }
+        clock_ = now_;
+
+        // 低层回绕时从高层下放
+        for (int level = 1; level < kLevels; ++level) {
+            if ((now_ >> (kSlotBits * (level - 1))) & (kSlots - 1)) break;
+            Cascade(level);
+        }
+
+        // 先整体摘下当前槽，回调期间新调度的定时器不会进入该链表
+        uint8_t slot = static_cast<uint8_t>(now_ & (kSlots - 1));
+        uint32_t idx = heads_[0][slot];
+        heads_[0][slot] = kNil;
+        firing_head_ = idx;
+        while (idx != kNil) {
+            nodes_[idx].level = kFiringLevel;
+            idx = nodes_[idx].next;
+        }
+
+        while (firing_head_ != kNil) {
+            idx = firing_head_;
+            Unlink(idx);
+            Callback cb = std::move(nodes_[idx].cb);
+            FreeNode(idx);
+            --active_;
+            ++fired;
+            if (cb) cb();
+        }
+        ++now_;
+    }
+    if (now_ms > clock_) clock_ = now_ms;
+    return fired;
+}
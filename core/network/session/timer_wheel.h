@@ -0,0 +1,69 @@
+//分层时间轮声明
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// 4层 x 64槽的分层时间轮，刻度1ms; 非线程安全
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+    typedef uint64_t TimerId;   // 0 表示无效
+
+    explicit TimerWheel(uint64_t start_ms = 0);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // delay_ms后触发 (至少在下一刻度)
+    TimerId Schedule(uint64_t delay_ms, Callback cb);
+    bool Cancel(TimerId id);
+
+    // 推进到now_ms并执行所有到期回调，返回触发个数
+    size_t Advance(uint64_t now_ms);
+
+    size_t Size() const { return active_; }
+    uint64_t CurrentTick() const { return clock_; }
+
+private:
+    static const int kLevels = 4;
+    static const int kSlotBits = 6;
+    static const uint32_t kSlots = 1u << kSlotBits;
+    static const uint32_t kNil = 0xFFFFFFFFu;
+    static const uint8_t kFiringLevel = kLevels;   // 位于待触发链表
+
+    struct Node {
+        uint64_t expire;
+        Callback cb;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;
+        uint8_t level;
+        uint8_t slot;
+        bool active;
+    };
+
+    uint32_t& HeadOf(uint8_t level, uint8_t slot) {
+        return level == kFiringLevel ? firing_head_ : heads_[level][slot];
+    }
+    void Place(uint32_t idx);
+    void Link(uint32_t idx, uint8_t level, uint8_t slot);
+    void Unlink(uint32_t idx);
+    void Cascade(int level);
+    uint32_t AllocNode();
+    void FreeNode(uint32_t idx);
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    uint32_t heads_[kLevels][kSlots];
+    uint32_t firing_head_;
+    uint64_t now_;          // 下一个待处理的刻度
+    uint64_t clock_;        // 调度的参考时间: 正在处理的刻度或最近一次Advance的时间
+    size_t active_;
+};
+
+#endif
@@ -0,0 +1,30 @@
+//传输层公共类型定义
+
+#ifndef TRANSPORT_TYPES_H
+#define TRANSPORT_TYPES_H
+
+#include <netinet/in.h>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// 收发后端 (运行时选择)
+enum class TransportBackend {
+    Syscall,   // 非阻塞socket + epoll + sendmmsg/recvmmsg
+    IoUring,   // io_uring: 多发recvmsg + 批量sendmsg提交
+};
+
+// 批量发送的单个数据报 (data与header在SendBatch返回前必须有效)。
+// header非空时先发header再发data (两段iovec)，同一份data可配不同的包头发给多个目标
+struct OutgoingPacket {
+    sockaddr_in dest;
+    const void* data;
+    size_t len;
+    const void* header = nullptr;
+    size_t header_len = 0;
+};
+
+// 收包回调: data仅在回调期间有效
+using ReceiveHandler = std::function<void(const uint8_t* data, size_t len, const sockaddr_in& src)>;
+
+#endif
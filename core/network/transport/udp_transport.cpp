@@ -1,24 +1,39 @@
 //udp传输实现
 
 #include "udp_transport.h"
+#include "../packets/packet_types.h"
+#include "../session/session_context.h"
+#include "uring_backend.h"
+#include "../../../utils/logging/logger.h"
+#include "../../../utils/performance/metrics.h"
 #include <stdexcept>
 #include <fcntl.h>
 #include <stdio.h>
 #include <netinet/in.h>  // 定义sockaddr_in和INADDR_ANY
 #include <sys/socket.h>  // 定义socket相关函数
 #include <chrono>
+#include <vector>
+#include <algorithm>
 #include <sys/select.h>
+#include <sys/epoll.h>
 #include <errno.h>
 
-#define LOG_ERROR(fmt, ...) fprintf(stderr, "[ERROR] " fmt "\n", ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)  fprintf(stderr, "[WARN] " fmt "\n", ##__VA_ARGS__)
+namespace {
+    const size_t kMaxBatch = 64;            // 单次sendmmsg/recvmmsg的最大数据报数
+    const size_t kRecvSlotSize = 2048;      // 批量收包的单个槽大小 (大于MTU)
+}
+
+UdpTransport::UdpTransport()
+    : sockfd_(-1), epoll_fd_(-1), backend_(TransportBackend::Syscall), running_(false) {}
 
 UdpTransport::~UdpTransport() {
     StopAckListener();
+    uring_.reset();
+    if (epoll_fd_ != -1) close(epoll_fd_);
     if (sockfd_ != -1) close(sockfd_);
 }
 
-bool UdpTransport::Initialize(uint16_t port) {
+bool UdpTransport::Initialize(uint16_t port, TransportBackend backend) {
     sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd_ == -1) return false;
     
@@ -36,7 +51,131 @@ bool UdpTransport::Initialize(uint16_t port) {
     addr.sin_port = htons(port);
     addr.sin_addr.s_addr = INADDR_ANY;
     
-    return bind(sockfd_, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    if (bind(sockfd_, (struct sockaddr*)&addr, sizeof(addr)) != 0) return false;
+
+    if (backend == TransportBackend::IoUring) {
+        uring_.reset(new UringBackend());
+        if (uring_->Initialize(sockfd_)) {
+            backend_ = TransportBackend::IoUring;
+            return true;
+        }
+        LOG_WARN("io_uring backend unavailable, falling back to epoll");
+        uring_.reset();
+    }
+
+    backend_ = TransportBackend::Syscall;
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1) return false;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = sockfd_;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sockfd_, &ev) == 0;
+}
+
+int UdpTransport::SendBatch(const OutgoingPacket* packets, size_t count) {
+    if (uring_) {
+        utils::StageTimer timer(utils::Stage::Send);
+        int sent = uring_->SendBatch(packets, count);
+        if (sent >= 0) utils::Metrics::Count(utils::Event::PacketsSent, static_cast<uint64_t>(sent));
+        else utils::Metrics::Count(utils::Event::SendErrors);
+        return sent;
+    }
+
+    struct mmsghdr msgs[kMaxBatch];
+    struct iovec iovs[kMaxBatch][2];
+    int sent = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t chunk = std::min(count - i, kMaxBatch);
+        for (size_t k = 0; k < chunk; ++k) {
+            const OutgoingPacket& pkt = packets[i + k];
+            size_t n = 0;
+            if (pkt.header) {
+                iovs[k][n].iov_base = const_cast<void*>(pkt.header);
+                iovs[k][n++].iov_len = pkt.header_len;
+            }
+            iovs[k][n].iov_base = const_cast<void*>(pkt.data);
+            iovs[k][n++].iov_len = pkt.len;
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_name = const_cast<sockaddr_in*>(&pkt.dest);
+            msgs[k].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            msgs[k].msg_hdr.msg_iov = iovs[k];
+            msgs[k].msg_hdr.msg_iovlen = n;
+        }
+        utils::StageTimer timer(utils::Stage::Send);
+        int ret = sendmmsg(sockfd_, msgs, chunk, 0);
+        timer.Stop();
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) LOG_ERROR("sendmmsg failed: %s", strerror(errno));
+            utils::Metrics::Count(utils::Event::SendErrors);
+            return sent > 0 ? sent : -1;
+        }
+        utils::Metrics::Count(utils::Event::PacketsSent, static_cast<uint64_t>(ret));
+        sent += ret;
+        i += ret;
+        if (static_cast<size_t>(ret) < chunk) break;  // 发送缓冲区已满
+    }
+    return sent;
+}
+
+int UdpTransport::PollReceive(int timeout_ms, const ReceiveHandler& handler) {
+    if (uring_) {
+        int delivered = uring_->PollCompletions(timeout_ms, handler);
+        if (delivered > 0) utils::Metrics::Count(utils::Event::PacketsReceived, static_cast<uint64_t>(delivered));
+        return delivered;
+    }
+
+    struct epoll_event ev;
+    int ready = epoll_wait(epoll_fd_, &ev, 1, timeout_ms);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+
+    // 每个线程一份批量收包缓冲区，避免每次调用分配
+    static thread_local std::vector<uint8_t> slab(kMaxBatch * kRecvSlotSize);
+    struct mmsghdr msgs[kMaxBatch];
+    struct iovec iovs[kMaxBatch];
+    sockaddr_in addrs[kMaxBatch];
+
+    int delivered = 0;
+    for (;;) {
+        for (size_t k = 0; k < kMaxBatch; ++k) {
+            iovs[k].iov_base = slab.data() + k * kRecvSlotSize;
+            iovs[k].iov_len = kRecvSlotSize;
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_name = &addrs[k];
+            msgs[k].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            msgs[k].msg_hdr.msg_iov = &iovs[k];
+            msgs[k].msg_hdr.msg_iovlen = 1;
+        }
+        // 只统计收到数据的批次; 每轮末尾返回EAGAIN的那次调用不计入
+        const uint64_t start_ns = utils::Metrics::Enabled() ? utils::Metrics::NowNanos() : 0;
+        int n = recvmmsg(sockfd_, msgs, kMaxBatch, MSG_DONTWAIT, nullptr);
+        if (n <= 0) break;
+        if (start_ns) utils::Metrics::Record(utils::Stage::Receive, utils::Metrics::NowNanos() - start_ns);
+        utils::Metrics::Count(utils::Event::PacketsReceived, static_cast<uint64_t>(n));
+        for (int k = 0; k < n; ++k) {
+            if (msgs[k].msg_hdr.msg_flags & MSG_TRUNC) continue;
+            handler(static_cast<const uint8_t*>(iovs[k].iov_base), msgs[k].msg_len, addrs[k]);
+            ++delivered;
+        }
+        if (static_cast<size_t>(n) < kMaxBatch) break;
+    }
+    return delivered;
+}
+
+int UdpTransport::SetReceiveBuffer(int bytes) {
+    if (sockfd_ == -1 || bytes <= 0) return -1;
+    // 有CAP_NET_ADMIN时用FORCE越过rmem_max，否则退回普通设置
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUFFORCE, &bytes, sizeof(bytes)) != 0 &&
+        setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) != 0) {
+        return -1;
+    }
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    if (getsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &actual, &len) != 0) return -1;
+    return actual;
 }
 
 ssize_t UdpTransport::SendTo(const struct sockaddr_in& dest, const void* data, size_t len) {
@@ -58,6 +197,12 @@ void UdpTransport::StartAckListener() {
             struct timeval tv = {1, 0};
             if (select(sockfd_ + 1, &read_fds, nullptr, nullptr, &tv) > 0) {
                 //处理接收数据或ACK
+                uint8_t buf[256];
+                sockaddr_in src_addr;
+                ssize_t recv_len;
+                while ((recv_len = RecvFrom(buf, sizeof(buf), &src_addr)) > 0) {
+                    HandleAck(buf, recv_len, src_addr, nullptr);
+                }
             }
         }
     }).detach();
@@ -124,13 +269,63 @@ bool UdpTransport::WaitForAck(uint32_t seq_num) {
         }
         
         // 验证ACK包
-        if (recv_len >= sizeof(uint32_t)) {
-            uint32_t recv_seq = ntohl(*reinterpret_cast<uint32_t*>(buf));
-            if (recv_seq == seq_num) {
-                return true;  // 收到正确的ACK
-            }
+        uint32_t recv_seq;
+        if (HandleAck(buf, recv_len, src_addr, &recv_seq) && recv_seq == seq_num) {
+            return true;  // 收到正确的ACK
         }
     }
     
     return false;  // 超时未收到正确的ACK
+}
+
+ssize_t UdpTransport::SendPaced(const sockaddr_in& dest, const void* data, size_t len,
+                                SessionContext& session, uint32_t seq_num) {
+    PacketPacer& pacer = session.GetPacer();
+    pacer.WaitForSlot();
+    ssize_t sent = SendTo(dest, data, len);
+    if (sent > 0) {
+        pacer.OnPacketSent(sent);
+        session.OnPacketSent(seq_num, sent);
+    }
+    return sent;
+}
+
+ssize_t UdpTransport::Retransmit(const sockaddr_in& dest, SessionContext& session, uint32_t seq_num) {
+    RetransmitBuffer* rtx = session.GetRetransmitBuffer();
+    if (!rtx) return -1;
+
+    ssize_t sent = -1;
+    bool ok = rtx->Resend(seq_num, [&](const uint8_t* data, size_t len) {
+        sent = SendTo(dest, data, len);
+        return sent;
+    });
+    if (!ok) return -1;
+    utils::Metrics::Count(utils::Event::Retransmits);
+    session.OnPacketRetransmitted(seq_num);
+    return sent;
+}
+
+ssize_t UdpTransport::SendAck(const sockaddr_in& dest, uint32_t session_id, uint32_t seq_num, uint32_t ack_delay_us) {
+    AckPacket ack;
+    ack.ctrl.zero = 0;
+    ack.ctrl.type = CONTROL_ACK;
+    ack.session_id = htonl(session_id);
+    ack.seq_num = htonl(seq_num);
+    ack.ack_delay_us = htonl(ack_delay_us);
+    return SendTo(dest, &ack, sizeof(ack));
+}
+
+bool UdpTransport::HandleAck(const uint8_t* buf, size_t len, const sockaddr_in& src, uint32_t* seq_num) {
+    if (len < sizeof(AckPacket)) return false;
+
+    AckPacket ack;
+    memcpy(&ack, buf, sizeof(ack));
+    if (ack.ctrl.zero != 0 || ack.ctrl.type != CONTROL_ACK) return false;
+
+    uint32_t seq = ntohl(ack.seq_num);
+    if (seq_num) *seq_num = seq;
+    if (ack_handler_) {
+        ack_handler_(src, ntohl(ack.session_id), seq, ntohl(ack.ack_delay_us));
+    }
+    return true;
 }
\ No newline at end of file
@@ -9,23 +9,58 @@
 #include <atomic>
 #include <unistd.h>
 #include <string.h>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include "transport_types.h"
+
+class SessionContext;
+class UringBackend;
 
 class UdpTransport {
 public:
-    UdpTransport() : sockfd_(-1), running_(false) {}
+    // ACK回调: 收到确认包时调用 (发送端据此做RTT采样与拥塞控制)
+    using AckHandler = std::function<void(const sockaddr_in& src, uint32_t session_id,
+                                          uint32_t seq_num, uint32_t ack_delay_us)>;
+
+    UdpTransport();
     ~UdpTransport();
     
-    bool Initialize(uint16_t port);
+    // 请求IoUring后端但内核或编译环境不支持时，自动回退到Syscall(epoll)后端
+    bool Initialize(uint16_t port, TransportBackend backend = TransportBackend::Syscall);
+    TransportBackend GetBackend() const { return backend_; }
+    // 设置套接字接收缓冲区，返回内核实际生效的大小(受net.core.rmem_max限制)，失败返回-1
+    int SetReceiveBuffer(int bytes);
     ssize_t SendTo(const struct sockaddr_in& dest, const void* data, size_t len);
     ssize_t RecvFrom(void* buf, size_t len, struct sockaddr_in* src_addr);
     ssize_t SendWithAck(const sockaddr_in& dest, const void* data, size_t len, uint32_t seq_num, int max_retries = 3);
     void StartAckListener();
     void StopAckListener() { running_ = false; }
 
+    // 按会话的发送节奏发出数据包，并登记到拥塞控制器
+    ssize_t SendPaced(const sockaddr_in& dest, const void* data, size_t len,
+                      SessionContext& session, uint32_t seq_num);
+    // 从会话重传缓冲区原样重发seq对应的包，包已淘汰时返回-1
+    ssize_t Retransmit(const sockaddr_in& dest, SessionContext& session, uint32_t seq_num);
+    ssize_t SendAck(const sockaddr_in& dest, uint32_t session_id, uint32_t seq_num, uint32_t ack_delay_us);
+    void SetAckHandler(AckHandler handler) { ack_handler_ = std::move(handler); }
+
+    // 批量发送: Syscall后端使用sendmmsg，IoUring后端一次提交多个sendmsg
+    int SendBatch(const OutgoingPacket* packets, size_t count);
+
+    // 完成驱动的收包: 等待最多timeout_ms，把到达的数据报逐个交给handler
+    // 返回分发的数据报数，出错返回-1。使用IoUring后端时应以此代替RecvFrom
+    int PollReceive(int timeout_ms, const ReceiveHandler& handler);
+
 private:
     int sockfd_;
+    int epoll_fd_;
+    TransportBackend backend_;
+    std::unique_ptr<UringBackend> uring_;
     std::atomic_bool running_;
+    AckHandler ack_handler_;
     bool WaitForAck(uint32_t seq_num);
+    bool HandleAck(const uint8_t* buf, size_t len, const sockaddr_in& src, uint32_t* seq_num);
 };
 
 #endif
\ No newline at end of file
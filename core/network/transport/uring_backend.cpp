@@ -0,0 +1,275 @@
+//io_uring收发后端实现
+
+#include "uring_backend.h"
+#include "../../../utils/logging/logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<liburing.h>)
+#define HAVE_LIBURING 1
+#include <liburing.h>
+#endif
+
+#ifdef HAVE_LIBURING
+
+namespace {
+    const int kBufferGroup = 0;      // 接收缓冲区组ID
+    const int kFixedFileIndex = 0;   // 注册后socket在文件表中的下标
+    const uint64_t kRecvTag = 1;
+
+    unsigned RoundUpPow2(unsigned v) {
+        unsigned p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+}
+
+struct UringBackend::Impl {
+    io_uring send_ring;
+    io_uring recv_ring;
+    bool send_ready = false;
+    bool recv_ready = false;
+
+    // 接收缓冲区: 一整块内存切分为固定大小的槽，登记为内核缓冲区组
+    io_uring_buf_ring* buf_ring = nullptr;
+    uint8_t* buf_base = nullptr;
+    unsigned buf_count = 0;
+    unsigned buf_size = 0;
+    msghdr recv_msg;
+
+    unsigned queue_depth = 0;
+    std::vector<msghdr> send_msgs;
+    std::vector<iovec> send_iovs;
+    bool send_failed = false;    // 发送ring出错后可能仍有SQE引用send_msgs，不再使用
+
+    ~Impl() {
+        if (buf_ring) io_uring_free_buf_ring(&recv_ring, buf_ring, buf_count, kBufferGroup);
+        free(buf_base);
+        if (recv_ready) io_uring_queue_exit(&recv_ring);
+        if (send_ready) io_uring_queue_exit(&send_ring);
+    }
+
+    // 提交多发recvmsg: 一次提交持续产生完成事件，直到缓冲区耗尽或出错
+    bool ArmRecv() {
+        io_uring_sqe* sqe = io_uring_get_sqe(&recv_ring);
+        if (!sqe) return false;
+        io_uring_prep_recvmsg_multishot(sqe, kFixedFileIndex, &recv_msg, 0);
+        sqe->flags |= IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        io_uring_sqe_set_data64(sqe, kRecvTag);
+        return io_uring_submit(&recv_ring) >= 0;
+    }
+
+    // 提交并收割pending个发送请求。部分提交时未被内核取走的SQE仍在SQ中，继续提交直到全部完成;
+    // 不可恢复的错误返回false，此时本批可能仍有未完成的SQE
+    bool CompleteSends(unsigned pending, int* sent) {
+        while (pending > 0) {
+            int ret = io_uring_submit_and_wait(&send_ring, pending);
+            if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                LOG_WARN("io_uring_submit_and_wait failed: %s", strerror(-ret));
+                return false;
+            }
+            io_uring_cqe* cqe;
+            unsigned head, seen = 0;
+            io_uring_for_each_cqe(&send_ring, head, cqe) {
+                if (cqe->res >= 0) ++*sent;
+                ++seen;
+            }
+            io_uring_cq_advance(&send_ring, seen);
+            pending -= std::min(seen, pending);
+        }
+        return true;
+    }
+};
+
+UringBackend::UringBackend() {}
+
+UringBackend::~UringBackend() {}
+
+bool UringBackend::IsCompiledIn() {
+    return true;
+}
+
+bool UringBackend::Initialize(int sockfd, unsigned queue_depth,
+                              unsigned recv_buffers, unsigned recv_buffer_size) {
+    std::unique_ptr<Impl> impl(new Impl());
+
+    if (recv_buffer_size < sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + 64) {
+        return false;
+    }
+
+    int ret = io_uring_queue_init(queue_depth, &impl->send_ring, 0);
+    if (ret < 0) {
+        LOG_WARN("io_uring_queue_init failed: %s", strerror(-ret));
+        return false;
+    }
+    impl->send_ready = true;
+
+    ret = io_uring_queue_init(queue_depth, &impl->recv_ring, 0);
+    if (ret < 0) {
+        LOG_WARN("io_uring_queue_init failed: %s", strerror(-ret));
+        return false;
+    }
+    impl->recv_ready = true;
+
+    // 注册socket为固定文件，省去每次提交时的fd查找与引用计数
+    if (io_uring_register_files(&impl->send_ring, &sockfd, 1) < 0 ||
+        io_uring_register_files(&impl->recv_ring, &sockfd, 1) < 0) {
+        LOG_WARN("io_uring_register_files failed");
+        return false;
+    }
+
+    // 注册接收缓冲区组
+    impl->buf_count = RoundUpPow2(recv_buffers);
+    impl->buf_size = recv_buffer_size;
+    if (posix_memalign(reinterpret_cast<void**>(&impl->buf_base), 4096,
+                       static_cast<size_t>(impl->buf_count) * impl->buf_size) != 0) {
+        impl->buf_base = nullptr;
+        return false;
+    }
+    impl->buf_ring = io_uring_setup_buf_ring(&impl->recv_ring, impl->buf_count, kBufferGroup, 0, &ret);
+    if (!impl->buf_ring) {
+        LOG_WARN("io_uring_setup_buf_ring failed: %s", strerror(-ret));
+        return false;
+    }
+    int mask = io_uring_buf_ring_mask(impl->buf_count);
+    for (unsigned i = 0; i < impl->buf_count; ++i) {
+        io_uring_buf_ring_add(impl->buf_ring, impl->buf_base + static_cast<size_t>(i) * impl->buf_size,
+                              impl->buf_size, static_cast<unsigned short>(i), mask, i);
+    }
+    io_uring_buf_ring_advance(impl->buf_ring, impl->buf_count);
+
+    memset(&impl->recv_msg, 0, sizeof(impl->recv_msg));
+    impl->recv_msg.msg_namelen = sizeof(sockaddr_in);
+
+    impl->queue_depth = queue_depth;
+    impl->send_msgs.resize(queue_depth);
+    impl->send_iovs.resize(static_cast<size_t>(queue_depth) * 2);   // 每条消息最多两段 (包头 + 数据)
+
+    if (!impl->ArmRecv()) {
+        LOG_WARN("multishot recvmsg not supported");
+        return false;
+    }
+
+    impl_ = std::move(impl);
+    return true;
+}
+
+int UringBackend::SendBatch(const OutgoingPacket* packets, size_t count) {
+    if (!impl_ || impl_->send_failed) return -1;
+
+    int sent = 0;
+    size_t i = 0;
+    while (i < count) {
+        unsigned chunk = static_cast<unsigned>(std::min<size_t>(count - i, impl_->queue_depth));
+        for (unsigned k = 0; k < chunk; ++k) {
+            const OutgoingPacket& pkt = packets[i + k];
+            iovec* iov = &impl_->send_iovs[k * 2];
+            msghdr& msg = impl_->send_msgs[k];
+            size_t n = 0;
+            if (pkt.header) {
+                iov[n].iov_base = const_cast<void*>(pkt.header);
+                iov[n++].iov_len = pkt.header_len;
+            }
+            iov[n].iov_base = const_cast<void*>(pkt.data);
+            iov[n++].iov_len = pkt.len;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = const_cast<sockaddr_in*>(&pkt.dest);
+            msg.msg_namelen = sizeof(sockaddr_in);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = n;
+
+            io_uring_sqe* sqe = io_uring_get_sqe(&impl_->send_ring);
+            io_uring_prep_sendmsg(sqe, kFixedFileIndex, &msg, 0);
+            sqe->flags |= IOSQE_FIXED_FILE;
+            io_uring_sqe_set_data64(sqe, k);
+        }
+
+        // 一次系统调用提交整批并等待全部完成; 本批SQE全部完成前不能复用send_msgs/send_iovs
+        if (!impl_->CompleteSends(chunk, &sent)) {
+            impl_->send_failed = true;
+            return sent > 0 ? sent : -1;
+        }
+        i += chunk;
+    }
+    return sent;
+}
+
+int UringBackend::PollCompletions(int timeout_ms, const ReceiveHandler& handler) {
+    if (!impl_) return -1;
+
+    io_uring_cqe* cqe;
+    __kernel_timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+    int ret = io_uring_wait_cqe_timeout(&impl_->recv_ring, &cqe, timeout_ms >= 0 ? &ts : nullptr);
+    if (ret == -ETIME || ret == -EINTR) return 0;
+    if (ret < 0) return -1;
+
+    int delivered = 0;
+    int returned = 0;
+    bool rearm = false;
+    int mask = io_uring_buf_ring_mask(impl_->buf_count);
+    unsigned head, seen = 0;
+    io_uring_for_each_cqe(&impl_->recv_ring, head, cqe) {
+        ++seen;
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            rearm = true;  // 多发请求已终止 (如缓冲区耗尽)，需要重新提交
+        }
+        if (cqe->res < 0) {
+            if (cqe->res != -ENOBUFS) LOG_WARN("recvmsg completion failed: %s", strerror(-cqe->res));
+            continue;
+        }
+        if (!(cqe->flags & IORING_CQE_F_BUFFER)) continue;
+
+        unsigned short bid = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t* buf = impl_->buf_base + static_cast<size_t>(bid) * impl_->buf_size;
+        io_uring_recvmsg_out* out = io_uring_recvmsg_validate(buf, cqe->res, &impl_->recv_msg);
+        if (out && !(out->flags & MSG_TRUNC) && out->namelen >= sizeof(sockaddr_in)) {
+            sockaddr_in src;
+            memcpy(&src, io_uring_recvmsg_name(out), sizeof(src));
+            const uint8_t* payload = static_cast<const uint8_t*>(io_uring_recvmsg_payload(out, &impl_->recv_msg));
+            unsigned len = io_uring_recvmsg_payload_length(out, cqe->res, &impl_->recv_msg);
+            handler(payload, len, src);
+            ++delivered;
+        }
+
+        // 回调结束后立即把缓冲区归还给内核
+        io_uring_buf_ring_add(impl_->buf_ring, buf, impl_->buf_size, bid, mask, returned++);
+    }
+    io_uring_buf_ring_advance(impl_->buf_ring, returned);
+    io_uring_cq_advance(&impl_->recv_ring, seen);
+
+    if (rearm && !impl_->ArmRecv()) return -1;
+    return delivered;
+}
+
+#else  // 未找到liburing: 保留接口，Initialize失败后由调用方回退
+
+struct UringBackend::Impl {};
+
+UringBackend::UringBackend() {}
+
+UringBackend::~UringBackend() {}
+
+bool UringBackend::IsCompiledIn() {
+    return false;
+}
+
+bool UringBackend::Initialize(int, unsigned, unsigned, unsigned) {
+    return false;
+}
+
+int UringBackend::SendBatch(const OutgoingPacket*, size_t) {
+    return -1;
+}
+
+int UringBackend::PollCompletions(int, const ReceiveHandler&) {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,36 @@
+//io_uring收发后端声明
+
+#ifndef URING_BACKEND_H
+#define URING_BACKEND_H
+
+#include "transport_types.h"
+#include <memory>
+
+// 发送与接收各一个ring，分别归发送线程与轮询线程所有; 接收侧用缓冲区组 + 多发recvmsg
+class UringBackend {
+public:
+    UringBackend();
+    ~UringBackend();
+
+    UringBackend(const UringBackend&) = delete;
+    UringBackend& operator=(const UringBackend&) = delete;
+
+    // 编译时是否链接了liburing
+    static bool IsCompiledIn();
+
+    // 失败时返回false (内核不支持等)，调用方应回退到syscall后端
+    bool Initialize(int sockfd, unsigned queue_depth = 256,
+                    unsigned recv_buffers = 512, unsigned recv_buffer_size = 2048);
+
+    // 返回成功发送的数据报个数
+    int SendBatch(const OutgoingPacket* packets, size_t count);
+
+    // 等待并分发接收完成事件，返回处理的数据报个数，出错返回-1
+    int PollCompletions(int timeout_ms, const ReceiveHandler& handler);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+#endif
@@ -1,290 +1,194 @@
-#define SDL_MAIN_HANDLED
-#include <SDL2/SDL.h>
-#include <iostream>
-#include <fstream>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-#include <libswresample/swresample.h>
-}
-
-#pragma comment(lib, "ws2_32.lib")
-
-#define PORT 5002
-#define BUFFER_SIZE 65536
-#define DEBUG_SAVE_H264 1
-
-void decrypt(uint8_t* data, int size) {
-    int header_len = (size > 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) ? 3 :
-        (size > 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) ? 4 : 0;
-
-    for (int i = header_len; i < size; i++) {
-        data[i] ^= 0xAA;
-    }
-}
-
-#undef main
-extern "C" int main(int argc, char* argv[]) {
-    // 启用FFmpeg详细日志
-    av_log_set_level(AV_LOG_DEBUG);
-
-    // 初始化网络
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-        std::cerr << "WSAStartup failed: " << WSAGetLastError() << std::endl;
-        return -1;
-    }
-
-    SOCKET sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock == INVALID_SOCKET) {
-        std::cerr << "Socket creation failed: " << WSAGetLastError() << std::endl;
-        WSACleanup();
-        return -1;
-    }
-
-    sockaddr_in recv_addr{};
-    recv_addr.sin_family = AF_INET;
-    recv_addr.sin_port = htons(PORT);
-    recv_addr.sin_addr.s_addr = INADDR_ANY;
-    if (bind(sock, (sockaddr*)&recv_addr, sizeof(recv_addr)) == SOCKET_ERROR) {
-        std::cerr << "Bind failed: " << WSAGetLastError() << std::endl;
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 初始化SDL
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
-        std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 创建窗口前强制测试SDL渲染
-    SDL_Window* window = SDL_CreateWindow("Receiver",
-        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-        640, 480, SDL_WINDOW_SHOWN);
-    if (!window) {
-        std::cerr << "Window creation failed: " << SDL_GetError() << std::endl;
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1,
-        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!renderer) {
-        std::cerr << "Renderer creation failed: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 使用IYUV格式纹理（兼容性更好）
-    SDL_Texture* texture = SDL_CreateTexture(renderer,
-        SDL_PIXELFORMAT_IYUV,
-        SDL_TEXTUREACCESS_STREAMING,
-        640, 480);
-    if (!texture) {
-        std::cerr << "Texture creation failed: " << SDL_GetError() << std::endl;
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 初始化解码器
-    const AVCodec* video_codec = avcodec_find_decoder(AV_CODEC_ID_H264);
-    if (!video_codec) {
-        std::cerr << "H.264 decoder not found" << std::endl;
-        SDL_DestroyTexture(texture);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    AVCodecContext* video_ctx = avcodec_alloc_context3(video_codec);
-    if (!video_ctx) {
-        std::cerr << "Failed to allocate codec context" << std::endl;
-        SDL_DestroyTexture(texture);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 启用低延迟解码模式
-    video_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
-
-    // 正确的参数设置方式
-    AVDictionary** opts = (AVDictionary**)&video_ctx->priv_data;
-    av_dict_set(opts, "tune", "zerolatency", 0);
-    av_dict_set(opts, "preset", "ultrafast", 0);  // 可选的额外参数
-
-
-    if (avcodec_open2(video_ctx, video_codec, nullptr) < 0) {
-        std::cerr << "Failed to open codec" << std::endl;
-        avcodec_free_context(&video_ctx);
-        SDL_DestroyTexture(texture);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        closesocket(sock);
-        WSACleanup();
-        return -1;
-    }
-
-    // 准备资源
-    AVPacket* pkt = av_packet_alloc();
-    AVFrame* frame = av_frame_alloc();
-    SwsContext* sws_ctx = nullptr;
-    uint8_t buffer[BUFFER_SIZE];
-    std::ofstream debug_file;
-
-#if DEBUG_SAVE_H264
-    debug_file.open("received.h264", std::ios::binary);
-    if (!debug_file.is_open()) {
-        std::cerr << "Failed to create debug file" << std::endl;
-    }
-#endif
-
-    // 主循环
-    while (true) {
-        // 接收数据
-        sockaddr_in src_addr;
-        int addr_len = sizeof(src_addr);
-        int recv_len = recvfrom(sock, (char*)buffer, BUFFER_SIZE, 0,
-            (sockaddr*)&src_addr, &addr_len);
-
-        if (recv_len <= 0) {
-            std::cerr << "recvfrom error: " << WSAGetLastError() << std::endl;
-            continue;
-        }
-
-#if DEBUG_SAVE_H264
-        if (debug_file.is_open()) {
-            debug_file.write((char*)buffer, recv_len);
-            debug_file.flush();
-        }
-#endif
-
-        // 打印NAL单元类型（调试用）
-        if (recv_len > 4) {
-            uint8_t nal_type = buffer[4] & 0x1F;
-            std::cout << "Received NAL unit type: " << (int)nal_type
-                << (nal_type == 7 ? " (SPS)" :
-                    nal_type == 8 ? " (PPS)" :
-                    nal_type == 5 ? " (IDR)" : "") << std::endl;
-        }
-
-        // 解密
-        decrypt(buffer, recv_len);
-
-        // 发送到解码器
-        pkt->data = buffer;
-        pkt->size = recv_len;
-        int send_ret = avcodec_send_packet(video_ctx, pkt);
-        if (send_ret < 0) {
-            std::cerr << "Error sending packet: " << av_err2str(send_ret) << std::endl;
-            continue;
-        }
-
-        // 接收解码帧
-        while (true) {
-            int recv_ret = avcodec_receive_frame(video_ctx, frame);
-            if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF) {
-                break;
-            }
-            else if (recv_ret < 0) {
-                std::cerr << "Error receiving frame: " << av_err2str(recv_ret) << std::endl;
-                break;
-            }
-
-            // 初始化转换上下文（如果需要）
-            if (!sws_ctx) {
-                sws_ctx = sws_getContext(
-                    frame->width, frame->height, (AVPixelFormat)frame->format,
-                    frame->width, frame->height, AV_PIX_FMT_YUV420P,
-                    SWS_BILINEAR, nullptr, nullptr, nullptr);
-                if (!sws_ctx) {
-                    std::cerr << "Failed to create SWS context" << std::endl;
-                    break;
-                }
-            }
-
-            // 分配目标帧内存
-            AVFrame* yuv_frame = av_frame_alloc();
-            yuv_frame->format = AV_PIX_FMT_YUV420P;
-            yuv_frame->width = frame->width;
-            yuv_frame->height = frame->height;
-            if (av_frame_get_buffer(yuv_frame, 0) < 0) {
-                std::cerr << "Failed to allocate frame buffer" << std::endl;
-                av_frame_free(&yuv_frame);
-                break;
-            }
-
-            // 转换像素格式
-            sws_scale(sws_ctx,
-                frame->data, frame->linesize,
-                0, frame->height,
-                yuv_frame->data, yuv_frame->linesize);
-
-            // 更新SDL纹理
-            SDL_UpdateYUVTexture(texture, nullptr,
-                yuv_frame->data[0], yuv_frame->linesize[0], // Y
-                yuv_frame->data[1], yuv_frame->linesize[1], // U
-                yuv_frame->data[2], yuv_frame->linesize[2]  // V
-            );
-
-            // 渲染
-            SDL_RenderClear(renderer);
-            SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-            SDL_RenderPresent(renderer);
-
-            av_frame_free(&yuv_frame);
-        }
-
-        // 处理SDL事件
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                goto cleanup;
-            }
-        }
-    }
-
-cleanup:
-    // 释放资源
-#if DEBUG_SAVE_H264
-    if (debug_file.is_open()) {
-        debug_file.close();
-    }
-#endif
-    av_packet_free(&pkt);
-    av_frame_free(&frame);
-    sws_freeContext(sws_ctx);
-    avcodec_free_context(&video_ctx);
-    SDL_DestroyTexture(texture);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
-    closesocket(sock);
-    WSACleanup();
-    return 0;
-}
\ No newline at end of file
+//接收端: 向发送端发起密钥协商后收包、解密、解码并输出 (见 receiver_engine.h)
+//  receiver --port 5002 --sink null   (不带SDL编译时的默认输出)
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "receiver_engine.h"
+#include "../video/decoder/display_sink.h"
+#include "../../utils/logging/logger.h"
+#include "../../utils/performance/metrics.h"
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+std::atomic<bool> g_interrupted(false);
+
+void OnSignal(int) {
+    g_interrupted.store(true);
+}
+
+// "ip:port"
+bool ParseAddress(const char* text, std::string* ip, uint16_t* port) {
+    const char* colon = strrchr(text, ':');
+    if (!colon || colon == text) return false;
+    int value = atoi(colon + 1);
+    if (value <= 0 || value > 65535) return false;
+    ip->assign(text, colon - text);
+    *port = static_cast<uint16_t>(value);
+    return true;
+}
+
+void PrintStats(const ReceiverStats& s, double seconds) {
+    printf("%7.1fs recv %llu (%.2f Mbit/s)  rejected %llu  acks %llu  keyframe req %llu  frames %llu (slices %llu)  lost %llu  "
+           "dropped %llu  decoded %llu (%.1f fps)  bypass %llu  convert %llu  err %llu/%llu  jitter %u us  delay %u us  "
+           "audio %llu lost %llu dropped %llu  av %+d us (drop %llu)  rec %llu (%llu segs, %llu key, %llu unindexed, drop %llu, err %llu)\n",
+           seconds, (unsigned long long)s.datagrams, seconds > 0 ? s.bytes * 8 / seconds / 1e6 : 0.0,
+           (unsigned long long)s.rejected, (unsigned long long)s.acks_sent, (unsigned long long)s.keyframe_requests,
+           (unsigned long long)s.frames_assembled, (unsigned long long)s.slices_delivered,
+           (unsigned long long)s.frames_lost,
+           (unsigned long long)s.frames_dropped, (unsigned long long)s.frames_decoded,
+           seconds > 0 ? s.frames_decoded / seconds : 0.0,
+           (unsigned long long)s.frames_bypassed, (unsigned long long)s.frames_converted,
+           (unsigned long long)s.decode_errors, (unsigned long long)s.sink_errors,
+           s.jitter_us, s.target_delay_us,
+           (unsigned long long)s.audio_frames_decoded, (unsigned long long)s.audio_frames_lost,
+           (unsigned long long)s.audio_frames_dropped, s.av_offset_us, (unsigned long long)s.av_sync_drops,
+           (unsigned long long)s.recorder.records, (unsigned long long)s.recorder.segments,
+           (unsigned long long)s.recorder.keyframes, (unsigned long long)s.recorder.unindexed,
+           (unsigned long long)s.recorder.dropped,
+           (unsigned long long)s.recorder.write_errors);
+    // 帧追踪: 各阶段的 均值/p50/p99 (毫秒)，未统计的阶段不输出
+    if (s.trace.frames + s.trace.incomplete > 0) {
+        printf("         trace frames %llu (incomplete %llu)", (unsigned long long)s.trace.frames,
+               (unsigned long long)s.trace.incomplete);
+        for (size_t i = 0; i < static_cast<size_t>(utils::TraceStage::Count); ++i) {
+            const utils::FrameTraceSummary::Stage& st = s.trace.stages[i];
+            if (st.count == 0) continue;
+            printf("  %s %.2f/%.2f/%.2f", utils::TraceStageName(static_cast<utils::TraceStage>(i)),
+                   st.mean_us / 1000.0, st.p50_us / 1000.0, st.p99_us / 1000.0);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    ReceiverConfig config;
+    std::string sink_type = DisplaySupported() ? "display" : "null";
+    std::string output_path = "-";
+    std::string format;
+    double duration = 0;
+    bool have_record_key = false;
+    utils::MetricsExportConfig metrics;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--port") config.port = static_cast<uint16_t>(atoi(v));
+        else if (a == "--sender" && ParseAddress(v, &config.sender_ip, &config.sender_port)) {}
+        else if (a == "--crypto-threads") config.crypto_workers = static_cast<size_t>(atoi(v));
+        else if (a == "--sink") sink_type = v;
+        else if (a == "--output") output_path = v;
+        else if (a == "--format") format = v;
+        else if (a == "--threads") config.decoder_threads = atoi(v);
+        else if (a == "--low-delay") config.low_delay = atoi(v) != 0;
+        else if (a == "--dump") config.dump_path = v;
+        else if (a == "--record") config.record.directory = v;
+        else if (a == "--record-key" && ParseStorageKey(v, config.record.storage_key)) have_record_key = true;
+        else if (a == "--av-sync") config.av_sync = atoi(v) != 0;
+        else if (a == "--slice-decode") config.slice_decode = atoi(v) != 0;
+        else if (a == "--duration") duration = atof(v);
+        else if (a == "--log" && utils::Logger::Instance().SetOutput(v)) {}
+        else if (a == "--trace-loopback") config.trace_single_clock = atoi(v) != 0;
+        else if (a == "--trace-output") config.trace_path = v;
+        else if (a == "--metrics") metrics.path = v;
+        else if (a == "--metrics-socket") metrics.socket_path = v;
+        else if (a == "--metrics-interval") metrics.interval_ms = static_cast<uint32_t>(atoi(v));
+        else if (a == "--backend") config.backend = strcmp(v, "uring") == 0 ? TransportBackend::IoUring : TransportBackend::Syscall;
+        else {
+            fprintf(stderr,
+                    "usage: %s [--port N] [--sender ip:port] [--sink display|null|file|checksum] [--output path]\n"
+                    "          [--format native|pixfmt] [--threads N] [--low-delay 0|1] [--slice-decode 0|1] [--dump file]\n"
+                    "          [--duration sec] [--crypto-threads N] [--av-sync 0|1] [--backend syscall|uring]\n"
+                    "          [--record dir --record-key hex32] [--log file] [--trace-loopback 0|1] [--trace-output csv]\n"
+                    "          [--metrics file | --metrics-socket path] [--metrics-interval ms]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (!config.record.directory.empty() && !have_record_key) {
+        fprintf(stderr, "[ERROR] --record requires --record-key (32 hex chars)\n");
+        return 1;
+    }
+
+    // 显示固定用IYUV纹理; 无界面模式默认保持解码器输出格式
+    std::unique_ptr<FrameSink> sink;
+    DisplaySink* display = nullptr;
+    if (sink_type == "display") {
+        std::unique_ptr<DisplaySink> window = CreateDisplaySink();
+        if (!window) {
+            fprintf(stderr, "[ERROR] Built without SDL, use --sink null|file|checksum\n");
+            return 1;
+        }
+        display = window.get();
+        sink = std::move(window);
+        config.output_format = AV_PIX_FMT_YUV420P;
+    } else {
+        sink = CreateFrameSink(sink_type, output_path);
+        if (!sink) {
+            fprintf(stderr, "[ERROR] Unknown sink %s or output not writable\n", sink_type.c_str());
+            return 1;
+        }
+        if (!format.empty() && format != "native") {
+            config.output_format = av_get_pix_fmt(format.c_str());
+            if (config.output_format == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "[ERROR] Unknown pixel format %s\n", format.c_str());
+                return 1;
+            }
+        }
+    }
+
+    // 不指定导出目标时埋点保持关闭
+    if ((!metrics.path.empty() || !metrics.socket_path.empty()) && !utils::Metrics::Instance().StartExport(metrics)) {
+        fprintf(stderr, "[ERROR] Failed to open metrics output\n");
+        return 1;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    ReceiverEngine engine(config, sink.get());
+    if (!engine.Start()) {
+        fprintf(stderr, "[ERROR] Failed to start receiver\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&start] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    int ret = 0;
+    if (display) {
+        ret = display->Run(g_interrupted);
+    } else {
+        double next_report = 1.0;
+        while (!g_interrupted.load() && (duration <= 0 || elapsed() < duration)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (elapsed() >= next_report) {
+                PrintStats(engine.GetStats(), elapsed());
+                next_report += 1.0;
+            }
+        }
+    }
+
+    engine.Stop();
+    utils::Metrics::Instance().StopExport();
+    sink->Finish();
+    PrintStats(engine.GetStats(), elapsed());
+    std::string summary = sink->Summary();
+    if (!summary.empty()) printf("%s\n", summary.c_str());
+    return ret;
+}
@@ -0,0 +1,606 @@
+//接收引擎实现
+
+#include "receiver_engine.h"
+#include "../network/packets/key_exchange_packet.h"
+#include "../network/packets/packet_builder.h"
+#include "../network/session/group_key.h"
+#include "../network/session/handshake.h"
+#include "../../utils/logging/logger.h"
+#include "../../utils/performance/metrics.h"
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+const int kMaxWaitMs = 10;      // 无帧到期时的最长等待时间
+const int kHandshakeRetryMs = 200;
+// 丢帧后重复请求关键帧的最小间隔 (抖动缓冲区的截止超时请求自带限流)
+const uint64_t kKeyframeRequestIntervalUs = 200000;
+const int kAacFrameSamples = 1024;
+const size_t kMaxAudioFragments = 16;
+// 音视频同步: 视频最多等待这么久 (更早的帧按此时长输出)，落后超过kMaxVideoLagUs的帧不再输出;
+// 音频时钟超过kAudioClockStaleUs未更新 (音频中断或未启用) 时视频不做同步
+const int64_t kMaxSyncWaitUs = 100000;
+const int64_t kMaxVideoLagUs = 90000;
+const uint32_t kAudioClockStaleUs = 500000;
+
+uint64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SameAddress(const sockaddr_in& a, const sockaddr_in& b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+// JPEG色域变体与普通YUV的内存布局相同，输出端按普通格式处理即可
+AVPixelFormat LayoutOf(int format) {
+    switch (format) {
+    case AV_PIX_FMT_YUVJ420P: return AV_PIX_FMT_YUV420P;
+    case AV_PIX_FMT_YUVJ422P: return AV_PIX_FMT_YUV422P;
+    case AV_PIX_FMT_YUVJ444P: return AV_PIX_FMT_YUV444P;
+    default: return static_cast<AVPixelFormat>(format);
+    }
+}
+
+// 音频帧小且间隔固定: 沿用视频的延迟范围，按AAC帧长估计抖动，分片槽位按帧长缩小
+JitterBufferConfig AudioJitterConfig(const ReceiverConfig& config) {
+    JitterBufferConfig jitter = config.jitter;
+    jitter.frame_interval_us = static_cast<uint32_t>(
+        static_cast<uint64_t>(kAacFrameSamples) * 1000000 / std::max(config.audio_sample_rate, 1));
+    jitter.max_fragments_per_frame = kMaxAudioFragments;
+    jitter.fragment_slots = jitter.frame_slots * 2;
+    return jitter;
+}
+
+// 裸AAC流没有ADTS头，解码器从AudioSpecificConfig取得采样率与声道: 对象类型(5位) 采样率下标(4位) 声道(4位)
+bool BuildAacConfig(int sample_rate, int channels, uint8_t out[2]) {
+    static const int kRates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+                                 16000, 12000, 11025, 8000, 7350};
+    const int count = static_cast<int>(sizeof(kRates) / sizeof(kRates[0]));
+    int index = 0;
+    while (index < count && kRates[index] != sample_rate) index++;
+    if (index == count || channels < 1 || channels > 7) return false;
+    const uint16_t asc = static_cast<uint16_t>((2 << 11) | (index << 7) | (channels << 3));   // AAC-LC
+    out[0] = static_cast<uint8_t>(asc >> 8);
+    out[1] = static_cast<uint8_t>(asc & 0xFF);
+    return true;
+}
+
+}  // namespace
+
+ReceiverEngine::ReceiverEngine(const ReceiverConfig& config, FrameSink* sink)
+    : config_(config), sink_(sink), session_id_(0), jitter_(config.jitter),
+      audio_jitter_(AudioJitterConfig(config)), resync_(false),
+      decoder_(nullptr), audio_decoder_(nullptr), sws_ctx_(nullptr), dump_file_(nullptr),
+      tracer_(config.trace_single_clock), datagram_slab_(config.datagram_slots), in_flight_(0),
+      // 每个线程的队列都能容纳全部槽位，提交不会因轮转到的队列满而失败
+      crypto_(config.crypto_workers, config.datagram_slots, [this](Datagram*& dg) { Open(dg); }),
+      last_keyframe_request_us_(0),
+      frames_(config.frame_queue_depth), audio_frames_(config.frame_queue_depth), audio_clock_(0), stop_(false),
+      datagrams_(0), bytes_(0), malformed_(0), rejected_(0), acks_sent_(0), keyframe_requests_(0),
+      frames_assembled_(0), slices_delivered_(0), frames_lost_(0),
+      frames_dropped_(0), frames_decoded_(0), frames_converted_(0), frames_bypassed_(0),
+      decode_errors_(0), sink_errors_(0), audio_frames_decoded_(0), audio_frames_lost_(0),
+      audio_frames_dropped_(0), av_sync_drops_(0), av_offset_us_(0), jitter_us_(0), target_delay_us_(0) {}
+
+ReceiverEngine::~ReceiverEngine() {
+    Stop();
+    sws_freeContext(sws_ctx_);
+    avcodec_free_context(&decoder_);
+    avcodec_free_context(&audio_decoder_);
+    if (dump_file_) fclose(dump_file_);
+}
+
+bool ReceiverEngine::Start() {
+    if (!sink_ || receive_thread_.joinable()) return false;
+
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    if (!codec) {
+        LOG_ERROR("H.264 decoder not found");
+        return false;
+    }
+    decoder_ = avcodec_alloc_context3(codec);
+    decoder_->thread_count = config_.decoder_threads;
+    if (config_.low_delay) {
+        // 帧级多线程每个线程都会多缓存一帧，低延迟模式只用片级多线程
+        decoder_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        decoder_->thread_type = FF_THREAD_SLICE;
+    } else {
+        decoder_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+    // 输入可能在切片边界截断，解码器在最后一个宏块行解码完成时输出该帧
+    if (config_.slice_decode) decoder_->flags2 |= AV_CODEC_FLAG2_CHUNKS;
+    if (avcodec_open2(decoder_, codec, nullptr) < 0) {
+        LOG_ERROR("Failed to open H.264 decoder");
+        return false;
+    }
+    if (!OpenAudioDecoder()) LOG_WARN("AAC decoder unavailable, audio will be discarded");
+
+    if (!config_.dump_path.empty()) {
+        dump_file_ = fopen(config_.dump_path.c_str(), "wb");
+        if (!dump_file_) LOG_WARN("Could not open dump file %s", config_.dump_path.c_str());
+    }
+
+    if (!config_.trace_path.empty() && !tracer_.SetOutput(config_.trace_path)) {
+        LOG_ERROR("Could not open trace output %s", config_.trace_path.c_str());
+        return false;
+    }
+
+    if (!config_.record.directory.empty()) {
+        recorder_.reset(new SegmentRecorder(config_.record));
+        if (!recorder_->Start()) {
+            LOG_ERROR("Failed to start recorder in %s", config_.record.directory.c_str());
+            recorder_.reset();
+            return false;
+        }
+    }
+
+    if (!transport_.Initialize(config_.port, config_.backend)) {
+        LOG_ERROR("Failed to bind UDP port %u", config_.port);
+        return false;
+    }
+
+    jitter_.SetKeyframeRequestHandler([this]() { RequestKeyframe(); });
+
+    free_datagrams_.clear();
+    for (Datagram& dg : datagram_slab_) free_datagrams_.push_back(&dg);
+    pending_acks_.reserve(config_.datagram_slots);
+    stop_.store(false);
+    crypto_.Start();
+    if (!Connect()) {
+        crypto_.Stop();
+        return false;
+    }
+
+    decode_thread_ = std::thread(&ReceiverEngine::DecodeLoop, this);
+    if (audio_decoder_) audio_thread_ = std::thread(&ReceiverEngine::AudioDecodeLoop, this);
+    receive_thread_ = std::thread(&ReceiverEngine::ReceiveLoop, this);
+    return true;
+}
+
+void ReceiverEngine::Stop() {
+    stop_.store(true);
+    if (receive_thread_.joinable()) receive_thread_.join();
+    if (decode_thread_.joinable()) decode_thread_.join();
+    if (audio_thread_.joinable()) audio_thread_.join();
+    crypto_.Stop();
+    if (recorder_) recorder_->Stop();   // 写完已提交的记录
+    in_flight_ = 0;
+    AVPacket* pkt = nullptr;
+    while (frames_.TryPop(&pkt)) packet_pool_.Release(&pkt);
+    while (audio_frames_.TryPop(&pkt)) packet_pool_.Release(&pkt);
+}
+
+bool ReceiverEngine::OpenAudioDecoder() {
+    uint8_t asc[2];
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_AAC);
+    if (!codec || !BuildAacConfig(config_.audio_sample_rate, config_.audio_channels, asc)) return false;
+    audio_decoder_ = avcodec_alloc_context3(codec);
+    audio_decoder_->sample_rate = config_.audio_sample_rate;
+    av_channel_layout_default(&audio_decoder_->ch_layout, config_.audio_channels);
+    audio_decoder_->extradata = static_cast<uint8_t*>(av_mallocz(sizeof(asc) + AV_INPUT_BUFFER_PADDING_SIZE));
+    if (audio_decoder_->extradata) {
+        memcpy(audio_decoder_->extradata, asc, sizeof(asc));
+        audio_decoder_->extradata_size = sizeof(asc);
+    }
+    audio_decoder_->pkt_timebase = {1, static_cast<int>(MEDIA_CLOCK_HZ)};
+    if (!audio_decoder_->extradata || avcodec_open2(audio_decoder_, codec, nullptr) < 0) {
+        avcodec_free_context(&audio_decoder_);
+        return false;
+    }
+    return true;
+}
+
+bool ReceiverEngine::Connect() {
+    memset(&sender_addr_, 0, sizeof(sender_addr_));
+    sender_addr_.sin_family = AF_INET;
+    sender_addr_.sin_port = htons(config_.sender_port);
+    if (inet_pton(AF_INET, config_.sender_ip.c_str(), &sender_addr_.sin_addr) != 1) {
+        LOG_ERROR("Invalid sender address %s", config_.sender_ip.c_str());
+        return false;
+    }
+
+    // 重发时沿用同一份请求: 发送端只应答第一份，换新密钥对会使之后的回复无法确认
+    Handshake handshake;
+    KeyExchangePacket init;
+    if (!handshake.Start(&init)) {
+        LOG_ERROR("Failed to generate key exchange");
+        return false;
+    }
+    OutgoingPacket out;
+    out.dest = sender_addr_;
+    out.data = &init;
+    out.len = sizeof(init);
+
+    const ReceiveHandler handler = [&](const uint8_t* data, size_t len, const sockaddr_in& from) {
+        if (session_id_ == 0) {
+            if (SameAddress(from, sender_addr_)) session_id_ = handshake.Finish(from, data, len);
+            return;
+        }
+        OnDatagram(data, len, from);   // 同一批中紧随回复到达的数据报
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(config_.handshake_timeout_ms);
+    auto next_send = start;
+    while (session_id_ == 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (stop_.load() || now >= deadline) {
+            LOG_ERROR("Key exchange with %s:%u timed out", config_.sender_ip.c_str(), config_.sender_port);
+            return false;
+        }
+        if (now >= next_send) {
+            transport_.SendBatch(&out, 1);
+            next_send = now + std::chrono::milliseconds(kHandshakeRetryMs);
+        }
+        if (transport_.PollReceive(kMaxWaitMs, handler) < 0) {
+            LOG_ERROR("Receive failed during key exchange");
+            return false;
+        }
+    }
+    CollectDatagrams(in_flight_);
+    FlushAcks();
+    return true;
+}
+
+void ReceiverEngine::ReceiveLoop() {
+    const ReceiveHandler handler = [this](const uint8_t* data, size_t len, const sockaddr_in& from) {
+        OnDatagram(data, len, from);
+    };
+    while (!stop_.load(std::memory_order_relaxed)) {
+        // 等待数据，最长等到两路流中下一帧的播放时间
+        uint64_t now = NowMicros();
+        uint64_t deadline = std::min(jitter_.NextDeadline(), audio_jitter_.NextDeadline());
+        int wait_ms = kMaxWaitMs;
+        if (deadline != UINT64_MAX) {
+            wait_ms = deadline > now ? static_cast<int>(std::min<uint64_t>((deadline - now + 999) / 1000, kMaxWaitMs)) : 0;
+        }
+        if (transport_.PollReceive(wait_ms, handler) < 0) {
+            LOG_ERROR("Receive failed");
+            std::this_thread::sleep_for(std::chrono::milliseconds(kMaxWaitMs));
+        }
+
+        // 本批数据报全部校验解密并按到达顺序进入抖动缓冲区后再出帧
+        CollectDatagrams(in_flight_);
+        FlushAcks();
+        audio_jitter_.SetDelayFloor(jitter_.GetTargetDelay());
+        DeliverFrames(NowMicros());
+        frames_lost_.store(jitter_.GetLostFrames(), std::memory_order_relaxed);
+        audio_frames_lost_.store(audio_jitter_.GetLostFrames(), std::memory_order_relaxed);
+        jitter_us_.store(jitter_.GetJitter(), std::memory_order_relaxed);
+        target_delay_us_.store(jitter_.GetTargetDelay(), std::memory_order_relaxed);
+    }
+}
+
+void ReceiverEngine::OnDatagram(const uint8_t* data, size_t len, const sockaddr_in& from) {
+    datagrams_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(len, std::memory_order_relaxed);
+    if (len < sizeof(PacketHeader) || len > kMaxDatagram) {
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    PacketHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.session_id == 0) {
+        // 控制包不进入抖动缓冲区; 扇出模式的发送端在握手回复后下发组密钥，之后的数据报按组会话解密
+        if (len == sizeof(GroupKeyPacket) && SameAddress(from, sender_addr_) &&
+            GroupKey::Unwrap(from, data, len) == 0) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (PacketLength(ntohs(header.payload_len), header.flags) != len) {
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (free_datagrams_.empty()) CollectDatagrams(1);  // 槽位用尽，先等最早提交的结果
+    if (free_datagrams_.empty()) {
+        utils::Metrics::Count(utils::Event::ReceiveDrops);   // 正在停止，未等到归还的槽位
+        return;
+    }
+    Datagram* dg = free_datagrams_.back();
+    free_datagrams_.pop_back();
+    dg->from = from;
+    dg->arrival_us = NowMicros();
+    dg->len = len;
+    memcpy(dg->data, data, len);
+    if (!crypto_.TrySubmit(dg)) {
+        free_datagrams_.push_back(dg);
+        utils::Metrics::Count(utils::Event::ReceiveDrops);
+        return;
+    }
+    in_flight_++;
+}
+
+void ReceiverEngine::Open(Datagram* dg) {
+    dg->plain_len = PacketBuilder::OpenPacket(dg->from, dg->data, dg->len, dg->header, dg->plain);
+    if (dg->plain_len != 0 && (dg->header.flags & PACKET_FLAG_TRACE)) dg->verify_us = utils::FrameTracer::NowMicros();
+}
+
+void ReceiverEngine::CollectDatagrams(size_t min_count) {
+    Datagram* dg = nullptr;
+    while (in_flight_ > 0) {
+        if (min_count > 0) {
+            if (!crypto_.Collect(&dg, stop_)) return;
+            min_count--;
+        } else if (!crypto_.TryCollect(&dg)) {
+            return;
+        }
+        in_flight_--;
+        if (dg->plain_len == 0) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            LOG_DEBUG("Rejected datagram of %zu bytes from port %u", dg->len, ntohs(dg->from.sin_port));
+        } else if (dg->header.stream_id >= MEDIA_STREAM_COUNT) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // 各流按流内seq重组; ACK仍按传输seq确认，拥塞控制看到的是全部数据报
+            JitterBuffer& jitter = dg->header.stream_id == MEDIA_STREAM_AUDIO ? audio_jitter_ : jitter_;
+            jitter.Insert(dg->header.stream_seq, dg->header.fragment_id, dg->header.total_fragments,
+                          (dg->header.flags & PACKET_FLAG_KEYFRAME) != 0,
+                          (dg->header.flags & PACKET_FLAG_UNIT_END) != 0, dg->header.timestamp,
+                          dg->plain, dg->plain_len, dg->arrival_us);
+            pending_acks_.push_back({dg->header.seq_num, dg->arrival_us});
+            if ((dg->header.flags & PACKET_FLAG_TRACE) && dg->header.stream_id == MEDIA_STREAM_VIDEO) TraceFrame(*dg);
+            // 只录制通过校验的数据报，按到达顺序; 写线程跟不上时丢弃记录而不阻塞收包
+            if (recorder_) recorder_->Append(dg->data, dg->len, dg->arrival_us);
+        }
+        free_datagrams_.push_back(dg);
+    }
+}
+
+// 帧的最后一个分片带有发送端时刻: 补上到达与校验时刻后登记，解码线程输出该帧时补齐
+void ReceiverEngine::TraceFrame(const Datagram& dg) {
+    FrameTrace trace;
+    memcpy(&trace, dg.data + sizeof(PacketHeader) + dg.header.payload_len, sizeof(trace));
+    utils::FrameTimeline timeline;
+    timeline.capture_us = ntohl(trace.capture_us);
+    timeline.encode_us = ntohl(trace.encode_us);
+    timeline.encrypt_us = ntohl(trace.encrypt_us);
+    timeline.send_us = ntohl(trace.send_us);
+    timeline.receive_us = static_cast<uint32_t>(dg.arrival_us);   // steady_clock即CLOCK_MONOTONIC
+    timeline.verify_us = dg.verify_us;
+    timeline.decode_us = 0;
+    timeline.present_us = 0;
+    tracer_.OnReceived(dg.header.timestamp, timeline);
+}
+
+// 一批数据报的ACK合并成一次sendmmsg; 只确认通过校验的数据报，伪造包不会影响发送端的估计
+void ReceiverEngine::FlushAcks() {
+    if (pending_acks_.empty()) return;
+    const uint64_t now = NowMicros();
+    ack_packets_.resize(pending_acks_.size());
+    ack_out_.resize(pending_acks_.size());
+    for (size_t i = 0; i < pending_acks_.size(); i++) {
+        AckPacket& ack = ack_packets_[i];
+        memset(&ack, 0, sizeof(ack));
+        ack.ctrl.type = CONTROL_ACK;
+        ack.session_id = htonl(session_id_);
+        ack.seq_num = htonl(pending_acks_[i].seq);
+        ack.ack_delay_us = htonl(static_cast<uint32_t>(now - pending_acks_[i].arrival_us));
+        ack_out_[i].dest = sender_addr_;
+        ack_out_[i].data = &ack;
+        ack_out_[i].len = sizeof(ack);
+    }
+
+    // 发送缓冲区满时丢弃剩余的ACK，发送端按超时判丢，视同拥塞
+    size_t sent = 0;
+    while (sent < ack_out_.size()) {
+        int ret = transport_.SendBatch(ack_out_.data() + sent, ack_out_.size() - sent);
+        if (ret <= 0) break;
+        sent += ret;
+    }
+    acks_sent_.fetch_add(sent, std::memory_order_relaxed);
+    pending_acks_.clear();
+}
+
+void ReceiverEngine::RequestKeyframe() {
+    const uint64_t now = NowMicros();
+    if (session_id_ == 0 || now - last_keyframe_request_us_ < kKeyframeRequestIntervalUs) return;
+    last_keyframe_request_us_ = now;
+
+    KeyframeRequestPacket request;
+    memset(&request, 0, sizeof(request));
+    request.ctrl.type = CONTROL_KEYFRAME_REQUEST;
+    request.session_id = htonl(session_id_);
+    OutgoingPacket out;
+    out.dest = sender_addr_;
+    out.data = &request;
+    out.len = sizeof(request);
+    if (transport_.SendBatch(&out, 1) == 1) keyframe_requests_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 按播放时钟取出已到期的帧 (已是明文) 交给解码线程; 逐片解码时切片一到就交出，一帧可能分几段
+void ReceiverEngine::DeliverFrames(uint64_t now_us) {
+    JitterFrame jframe;
+    while (config_.slice_decode ? jitter_.PopSlices(now_us, &jframe) : jitter_.PopFrame(now_us, &jframe)) {
+        if (jframe.conceal) {
+            // 帧已丢失: 不送入解码器，由H.264解码器对后续帧的缺失参考做错误隐藏
+            continue;
+        }
+        if (jframe.frame_end) frames_assembled_.fetch_add(1, std::memory_order_relaxed);
+        // 重组耗时: 首个分片到达至出队，包含抖动缓冲的等待
+        if (jframe.frame_start && now_us > jframe.arrival_us) {
+            utils::Metrics::Record(utils::Stage::Reassembly, (now_us - jframe.arrival_us) * 1000);
+        }
+        if (config_.slice_decode) slices_delivered_.fetch_add(1, std::memory_order_relaxed);
+        // 重同步只能从关键帧的开头开始，丢掉的关键帧的后续切片不算
+        if (resync_ && !(jframe.keyframe && jframe.frame_start)) {
+            if (jframe.frame_start) frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+            RequestKeyframe();   // 按间隔重复请求，防止关键帧请求或关键帧本身丢失
+            continue;
+        }
+
+        AVPacket* pkt = packet_pool_.AcquireData(static_cast<int>(jframe.size));
+        if (pkt) {
+            memcpy(pkt->data, jframe.data, jframe.size);
+            pkt->pts = jframe.timestamp;
+            if (jframe.keyframe) pkt->flags |= AV_PKT_FLAG_KEY;
+            if (frames_.TryPush(pkt)) {
+                resync_ = false;
+                continue;
+            }
+            packet_pool_.Release(&pkt);
+        }
+        // 丢掉一帧后其后的参考链已断，直到关键帧前都不再送解码
+        frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+        resync_ = true;
+        RequestKeyframe();
+    }
+
+    // AAC帧各自独立解码: 丢失的帧直接跳过，不请求关键帧也不等待重同步
+    while (audio_jitter_.PopFrame(now_us, &jframe)) {
+        if (jframe.conceal) continue;
+        AVPacket* pkt = audio_decoder_ ? packet_pool_.AcquireData(static_cast<int>(jframe.size)) : nullptr;
+        if (pkt) {
+            memcpy(pkt->data, jframe.data, jframe.size);
+            pkt->pts = jframe.timestamp;
+            if (audio_frames_.TryPush(pkt)) continue;
+            packet_pool_.Release(&pkt);
+        }
+        audio_frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ReceiverEngine::DecodeLoop() {
+    AVFrame* frame = frame_pool_.Acquire();
+    AVPacket* pkt = nullptr;
+    while (frames_.Pop(&pkt, stop_)) {
+        if (dump_file_) fwrite(pkt->data, 1, pkt->size, dump_file_);
+        utils::StageTimer timer(utils::Stage::Decode);
+        int ret = avcodec_send_packet(decoder_, pkt);
+        packet_pool_.Release(&pkt);
+        if (ret < 0) {
+            decode_errors_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        while (avcodec_receive_frame(decoder_, frame) == 0) {
+            timer.Stop();
+            frames_decoded_.fetch_add(1, std::memory_order_relaxed);
+            // 解码器透传包的pts (媒体时间戳)，据此匹配收包线程登记的追踪记录
+            const bool traced = tracer_.HasPending() && frame->pts != AV_NOPTS_VALUE;
+            const uint32_t decode_us = traced ? utils::FrameTracer::NowMicros() : 0;
+            bool presented = false;
+            if (!SyncToAudio(frame)) {
+                av_sync_drops_.fetch_add(1, std::memory_order_relaxed);
+            } else if (!Output(frame)) {
+                sink_errors_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                presented = true;
+            }
+            if (traced) {
+                tracer_.OnOutput(static_cast<uint32_t>(frame->pts), decode_us,
+                                 presented ? utils::FrameTracer::NowMicros() : 0);
+            }
+            av_frame_unref(frame);
+        }
+    }
+    frame_pool_.Release(&frame);
+}
+
+void ReceiverEngine::AudioDecodeLoop() {
+    AVFrame* frame = frame_pool_.Acquire();
+    AVPacket* pkt = nullptr;
+    while (audio_frames_.Pop(&pkt, stop_)) {
+        const uint32_t timestamp = static_cast<uint32_t>(pkt->pts);
+        int ret = avcodec_send_packet(audio_decoder_, pkt);
+        packet_pool_.Release(&pkt);
+        if (ret < 0) {
+            decode_errors_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        bool output = false;
+        while (avcodec_receive_frame(audio_decoder_, frame) == 0) {
+            audio_frames_decoded_.fetch_add(1, std::memory_order_relaxed);
+            if (!sink_->ConsumeAudio(frame)) sink_errors_.fetch_add(1, std::memory_order_relaxed);
+            av_frame_unref(frame);
+            output = true;
+        }
+        if (output) {
+            const uint32_t now = static_cast<uint32_t>(NowMicros());
+            audio_clock_.store(static_cast<uint64_t>(timestamp) << 32 | now, std::memory_order_release);
+        }
+    }
+    frame_pool_.Release(&frame);
+}
+
+// 音频是主时钟: 由最近输出的音频时间戳与其输出后经过的时间推算当前音频位置，
+// 视频帧早于该位置则等待，晚得太多则丢弃 (解码已完成，参考链不受影响)
+bool ReceiverEngine::SyncToAudio(const AVFrame* frame) {
+    const uint64_t clock = audio_clock_.load(std::memory_order_acquire);
+    if (!config_.av_sync || clock == 0 || frame->pts == AV_NOPTS_VALUE) return true;
+    const uint32_t elapsed = static_cast<uint32_t>(NowMicros()) - static_cast<uint32_t>(clock);
+    if (elapsed > kAudioClockStaleUs) return true;
+
+    // 时间戳按32位回绕比较
+    const int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(frame->pts) - static_cast<uint32_t>(clock >> 32));
+    const int64_t ahead = static_cast<int64_t>(delta) * 1000000 / MEDIA_CLOCK_HZ - elapsed;
+    av_offset_us_.store(static_cast<int32_t>(std::min<int64_t>(std::max<int64_t>(ahead, INT32_MIN), INT32_MAX)),
+                        std::memory_order_relaxed);
+    if (ahead > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(ahead, kMaxSyncWaitUs)));
+        return true;
+    }
+    return -ahead <= kMaxVideoLagUs;
+}
+
+bool ReceiverEngine::Output(AVFrame* frame) {
+    const AVPixelFormat target = config_.output_format;
+    if (target == AV_PIX_FMT_NONE || LayoutOf(frame->format) == LayoutOf(target)) {
+        // 格式已匹配: 解码帧直接交给输出端，省去一次整帧转换与拷贝
+        frames_bypassed_.fetch_add(1, std::memory_order_relaxed);
+        return sink_->Consume(frame);
+    }
+
+    sws_ctx_ = sws_getCachedContext(sws_ctx_,
+        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+        frame->width, frame->height, target,
+        SWS_BILINEAR, nullptr, nullptr, nullptr);
+    AVFrame* out = sws_ctx_ ? frame_pool_.AcquireVideo(target, frame->width, frame->height) : nullptr;
+    if (!out) return false;
+    sws_scale(sws_ctx_, frame->data, frame->linesize, 0, frame->height, out->data, out->linesize);
+    out->pts = frame->pts;
+    frames_converted_.fetch_add(1, std::memory_order_relaxed);
+    bool ok = sink_->Consume(out);
+    frame_pool_.Release(&out);
+    return ok;
+}
+
+ReceiverStats ReceiverEngine::GetStats() const {
+    ReceiverStats s;
+    s.datagrams = datagrams_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.malformed = malformed_.load(std::memory_order_relaxed);
+    s.rejected = rejected_.load(std::memory_order_relaxed);
+    s.acks_sent = acks_sent_.load(std::memory_order_relaxed);
+    s.keyframe_requests = keyframe_requests_.load(std::memory_order_relaxed);
+    s.frames_assembled = frames_assembled_.load(std::memory_order_relaxed);
+    s.slices_delivered = slices_delivered_.load(std::memory_order_relaxed);
+    s.frames_lost = frames_lost_.load(std::memory_order_relaxed);
+    s.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    s.frames_decoded = frames_decoded_.load(std::memory_order_relaxed);
+    s.frames_converted = frames_converted_.load(std::memory_order_relaxed);
+    s.frames_bypassed = frames_bypassed_.load(std::memory_order_relaxed);
+    s.decode_errors = decode_errors_.load(std::memory_order_relaxed);
+    s.sink_errors = sink_errors_.load(std::memory_order_relaxed);
+    s.audio_frames_decoded = audio_frames_decoded_.load(std::memory_order_relaxed);
+    s.audio_frames_lost = audio_frames_lost_.load(std::memory_order_relaxed);
+    s.audio_frames_dropped = audio_frames_dropped_.load(std::memory_order_relaxed);
+    s.av_sync_drops = av_sync_drops_.load(std::memory_order_relaxed);
+    s.av_offset_us = av_offset_us_.load(std::memory_order_relaxed);
+    s.jitter_us = jitter_us_.load(std::memory_order_relaxed);
+    s.target_delay_us = target_delay_us_.load(std::memory_order_relaxed);
+    s.frame_pool = frame_pool_.GetStats();
+    s.packet_pool = packet_pool_.GetStats();
+    if (recorder_) s.recorder = recorder_->GetStats();
+    else memset(&s.recorder, 0, sizeof(s.recorder));
+    tracer_.Summarize(&s.trace);
+    return s;
+}
@@ -0,0 +1,207 @@
+//接收引擎声明 (收包/重组与音视频解码分线程)
+
+#ifndef RECEIVER_ENGINE_H
+#define RECEIVER_ENGINE_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include "../network/packets/packet_types.h"
+#include "../network/transport/udp_transport.h"
+#include "../storage/segment_recorder.h"
+#include "../video/decoder/frame_sink.h"
+#include "../video/decoder/jitter_buffer.h"
+#include "../video/processing/frame_pool.h"
+#include "../../utils/concurrency/ordered_worker_pool.h"
+#include "../../utils/concurrency/spsc_queue.h"
+#include "../../utils/performance/frame_trace.h"
+
+struct ReceiverConfig {
+    uint16_t port = 5002;
+    TransportBackend backend = TransportBackend::Syscall;
+    JitterBufferConfig jitter;
+
+    // 发送端地址: 启动时向其发起SM2密钥协商，之后只接受该地址发来的数据报
+    std::string sender_ip = "127.0.0.1";
+    uint16_t sender_port = 5003;
+    uint32_t handshake_timeout_ms = 10000;
+    size_t crypto_workers = 0;      // 校验解密线程数，0为按核心数选择
+    size_t datagram_slots = 1024;   // 收包线程 -> 校验解密线程的在途数据报上限
+
+    // 交给输出端的像素格式; AV_PIX_FMT_NONE表示保持解码器输出格式 (从不转换)。
+    // 解码器输出已是该格式时直接交付解码帧，不经过sws_scale
+    AVPixelFormat output_format = AV_PIX_FMT_NONE;
+    int decoder_threads = 0;        // 0为自动; 同机运行大量接收端时设为1
+    bool low_delay = true;          // 片级多线程 + LOW_DELAY，不引入帧级线程的延迟
+    // 逐片解码: 帧内连续到达的切片立即送解码器 (AV_CODEC_FLAG2_CHUNKS)，不等整帧到齐与播放时间;
+    // 抖动缓冲区只用于判定丢失，输出节奏由音视频同步决定
+    bool slice_decode = false;
+    size_t frame_queue_depth = 32;  // 收包线程 -> 解码线程的已重组帧
+    std::string dump_path;          // 非空时把解密后的视频码流写入该文件 (调试)
+    // record.directory非空时把通过校验的数据报以密文原样录制成分段文件 (写线程异步批量写入)
+    RecorderConfig record;
+
+    // 发送端开启帧追踪时按阶段统计延迟; trace_single_clock表示两端在同一台机器上 (共用CLOCK_MONOTONIC)，
+    // 此时另外统计网络与端到端延迟。trace_path非空时每帧写一行各环节时刻 (CSV)
+    bool trace_single_clock = false;
+    std::string trace_path;
+
+    // 音频为不带ADTS头的AAC-LC裸流，须与发送端编码参数一致
+    int audio_sample_rate = 44100;
+    int audio_channels = 2;
+    bool av_sync = true;            // 视频按音频时钟输出: 提前则等待，落后过多则丢弃
+};
+
+struct ReceiverStats {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t malformed;             // 长度与包头不符
+    uint64_t rejected;              // 来源地址不符、SM3校验失败或填充不合法
+    uint64_t acks_sent;             // 每个通过校验的数据报回一个ACK，发送端据此估计RTT/带宽/丢包
+    uint64_t keyframe_requests;
+    uint64_t frames_assembled;
+    uint64_t slices_delivered;      // 逐片解码时送入解码器的切片段数
+    uint64_t frames_lost;           // 抖动缓冲区判定丢失
+    uint64_t frames_dropped;        // 解码跟不上，队列满被丢弃 (之后等待关键帧)
+    uint64_t frames_decoded;
+    uint64_t frames_converted;
+    uint64_t frames_bypassed;       // 格式一致，未经sws_scale
+    uint64_t decode_errors;
+    uint64_t sink_errors;
+    uint64_t audio_frames_decoded;
+    uint64_t audio_frames_lost;     // 音频抖动缓冲区判定丢失 (直接跳过，不做隐藏)
+    uint64_t audio_frames_dropped;  // 音频解码跟不上或解码器不可用
+    uint64_t av_sync_drops;         // 视频落后音频过多而未输出
+    int32_t av_offset_us;           // 最近一帧视频相对音频的提前量 (负为落后)
+    uint32_t jitter_us;
+    uint32_t target_delay_us;
+    PoolStats frame_pool;
+    PoolStats packet_pool;
+    RecorderStats recorder;
+    utils::FrameTraceSummary trace;
+};
+
+// 接收端: 收包线程做并行解密与按流重组，音视频各一个解码线程; 收包线程不阻塞在解码上，队列满时丢到下一个关键帧
+// ACK与关键帧请求由收包线程发出
+class ReceiverEngine {
+public:
+    ReceiverEngine(const ReceiverConfig& config, FrameSink* sink);
+    ~ReceiverEngine();
+
+    ReceiverEngine(const ReceiverEngine&) = delete;
+    ReceiverEngine& operator=(const ReceiverEngine&) = delete;
+
+    bool Start();
+    void Stop();
+
+    ReceiverStats GetStats() const;
+
+private:
+    static constexpr size_t kMaxDatagram = 1500;
+
+    // 收包线程复制进来，校验解密线程解密到plain; data保持密文，录制时原样写出
+    struct Datagram {
+        sockaddr_in from;
+        uint64_t arrival_us;
+        size_t len;
+        size_t plain_len;           // 解密后的明文长度，0表示校验失败
+        uint32_t verify_us;         // 带追踪扩展时: 校验解密完成的时刻
+        PacketHeader header;        // 主机字节序
+        uint8_t data[kMaxDatagram];
+        uint8_t plain[kMaxDatagram];
+    };
+
+    // 向发送端发起密钥协商，成功后会话已安装密钥
+    bool Connect();
+    void ReceiveLoop();
+    void DecodeLoop();
+    void AudioDecodeLoop();
+    void OnDatagram(const uint8_t* data, size_t len, const sockaddr_in& from);
+    void Open(Datagram* dg);                // 校验解密线程
+    // 按提交顺序取回: 先等待最早的min_count个，再取走所有已完成的
+    void CollectDatagrams(size_t min_count);
+    void TraceFrame(const Datagram& dg);
+    void DeliverFrames(uint64_t now_us);
+    void FlushAcks();
+    void RequestKeyframe();
+    bool OpenAudioDecoder();
+    // 返回false表示视频帧落后音频过多，不再输出
+    bool SyncToAudio(const AVFrame* frame);
+    bool Output(AVFrame* frame);
+
+    ReceiverConfig config_;
+    FrameSink* sink_;
+    FramePool frame_pool_;
+    PacketPool packet_pool_;
+    UdpTransport transport_;
+    sockaddr_in sender_addr_;
+    uint32_t session_id_;               // 点对点会话，握手完成前为0; 扇出模式下数据报改用组会话解密
+    JitterBuffer jitter_;               // 仅收包线程使用
+    JitterBuffer audio_jitter_;         // 仅收包线程使用
+    bool resync_;                       // 仅收包线程使用: 丢帧后等待关键帧
+
+    AVCodecContext* decoder_;
+    AVCodecContext* audio_decoder_;     // 仅音频解码线程使用，不可用时丢弃音频
+    SwsContext* sws_ctx_;               // 仅解码线程使用
+    FILE* dump_file_;                   // 仅解码线程使用
+    std::unique_ptr<SegmentRecorder> recorder_;   // 收包线程提交
+    utils::FrameTracer tracer_;                   // 收包线程登记，解码线程补齐
+
+    std::vector<Datagram> datagram_slab_;
+    std::vector<Datagram*> free_datagrams_;     // 仅收包线程使用
+    size_t in_flight_;                          // 仅收包线程使用
+    utils::OrderedWorkerPool<Datagram*> crypto_;
+
+    // 仅收包线程使用: 待发送的ACK (到达时间用于计算ack_delay_us)
+    struct PendingAck {
+        uint32_t seq;
+        uint64_t arrival_us;
+    };
+    std::vector<PendingAck> pending_acks_;
+    std::vector<AckPacket> ack_packets_;
+    std::vector<OutgoingPacket> ack_out_;
+    uint64_t last_keyframe_request_us_;
+
+    utils::SpscQueue<AVPacket*> frames_;
+    utils::SpscQueue<AVPacket*> audio_frames_;
+    std::thread receive_thread_;
+    std::thread decode_thread_;
+    std::thread audio_thread_;
+    // 音频时钟: 高32位为最近输出的音频时间戳，低32位为输出时刻 (微秒，截断); 0表示尚无音频
+    std::atomic<uint64_t> audio_clock_;
+    std::atomic<bool> stop_;
+
+    std::atomic<uint64_t> datagrams_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> malformed_;
+    std::atomic<uint64_t> rejected_;
+    std::atomic<uint64_t> acks_sent_;
+    std::atomic<uint64_t> keyframe_requests_;
+    std::atomic<uint64_t> frames_assembled_;
+    std::atomic<uint64_t> slices_delivered_;
+    std::atomic<uint64_t> frames_lost_;
+    std::atomic<uint64_t> frames_dropped_;
+    std::atomic<uint64_t> frames_decoded_;
+    std::atomic<uint64_t> frames_converted_;
+    std::atomic<uint64_t> frames_bypassed_;
+    std::atomic<uint64_t> decode_errors_;
+    std::atomic<uint64_t> sink_errors_;
+    std::atomic<uint64_t> audio_frames_decoded_;
+    std::atomic<uint64_t> audio_frames_lost_;
+    std::atomic<uint64_t> audio_frames_dropped_;
+    std::atomic<uint64_t> av_sync_drops_;
+    std::atomic<int32_t> av_offset_us_;
+    std::atomic<uint32_t> jitter_us_;
+    std::atomic<uint32_t> target_delay_us_;
+};
+
+#endif
@@ -0,0 +1,1261 @@
+//流水线发送引擎实现
+
+#include "sender_engine.h"
+#include "../network/packets/key_exchange_packet.h"
+#include "../network/packets/packet_builder.h"
+#include "../network/session/group_key.h"
+#include "../network/session/handshake.h"
+#include "../../utils/logging/logger.h"
+#include "../../utils/performance/frame_trace.h"
+#include "../../utils/performance/metrics.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+const int kHandshakePollMs = 100;
+const int kReplyCopies = 3;      // 握手回复的发送份数
+const int kFeedbackPollMs = 10;
+const uint64_t kAbrIntervalUs = 200000;   // 汇总一次网络反馈并更新目标码率的周期
+const size_t kMaxPendingLosses = 65536;   // 反馈线程退出后不再取走，超出部分丢弃
+const size_t kMaxSimulcastLayers = 3;
+const uint64_t kPacingBurstUs = 20000;    // 发送预算最多累积这么长时间的量
+
+// from起下一个Annex B起始码 (00 00 01，前面多一个0时按四字节起始码) 的位置，没有时返回size
+size_t NextStartCode(const uint8_t* data, size_t size, size_t from) {
+    for (size_t i = from; i + 2 < size; i++) {
+        if (data[i + 2] > 1) {
+            i += 2;   // data[i+2]不可能是起始码中的任何一个字节
+        } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return data[i - 1] == 0 ? i - 1 : i;
+        }
+    }
+    return size;
+}
+// 低延迟档位的VBV容量 (帧间隔数): 单帧 (含关键帧) 在瓶颈上排队不超过这么多帧间隔
+const int kLowLatencyVbvFrames = 4;
+
+// 缩放与编码线程都按这两个常量工作，不读取会被重建的编码器上下文
+const AVPixelFormat kEncoderFormat = AV_PIX_FMT_YUV420P;
+// 输入时间戳原样换算，不按帧号重排; 与包头媒体时钟相同，视频时间戳可直接写入包头
+const AVRational kEncoderTimeBase = {1, static_cast<int>(MEDIA_CLOCK_HZ)};
+
+uint32_t PackSize(int width, int height) {
+    return static_cast<uint32_t>(width) << 16 | static_cast<uint32_t>(height);
+}
+
+AbrConfig MakeAbrConfig(const SenderConfig& config) {
+    AbrConfig abr;
+    abr.min_bitrate = std::min(config.min_video_bitrate, config.video_bitrate);
+    abr.max_bitrate = config.video_bitrate;
+    abr.max_width = config.width;
+    abr.max_height = config.height;
+    abr.fps = config.fps;
+    abr.adapt_resolution = config.adaptive;
+    return abr;
+}
+
+// 同播各层的分辨率与码率: 每层宽高减半、码率按像素数降为1/4，但不低于最低码率
+int LayerCount(const SenderConfig& config) {
+    return static_cast<int>(std::min(std::max<size_t>(config.simulcast_layers, 1), kMaxSimulcastLayers));
+}
+
+int64_t LayerBitrate(const SenderConfig& config, int layer) {
+    const int64_t floor = std::min(config.min_video_bitrate, config.video_bitrate);
+    return std::max(config.video_bitrate >> (2 * layer), floor);
+}
+
+int LayerDimension(int full, int layer) {
+    return std::max(2, (full >> layer) & ~1);
+}
+
+bool SameAddress(const sockaddr_in& a, const sockaddr_in& b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+// 帧追踪: 采集与编码完成时刻 (各32位) 打包在AVPacket/AVFrame的opaque中，随帧经过解码、缩放与编码。
+// 编解码器设置AV_CODEC_FLAG_COPY_OPAQUE后由libavcodec原样传递; 旧版本没有该标志时采集时刻缺失
+static_assert(sizeof(uintptr_t) >= 8, "trace stamps are packed into a pointer");
+
+void* PackTraceStamps(uint32_t capture_us, uint32_t encode_us) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(encode_us) << 32 | capture_us);
+}
+
+uint32_t CaptureStamp(const void* opaque) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(opaque));
+}
+
+uint32_t EncodeStamp(const void* opaque) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(opaque) >> 32);
+}
+
+AVCodecContext* OpenDecoder(AVStream* stream) {
+    const AVCodec* decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!decoder) return nullptr;
+
+    AVCodecContext* codec_ctx = avcodec_alloc_context3(decoder);
+    avcodec_parameters_to_context(codec_ctx, stream->codecpar);
+    codec_ctx->pkt_timebase = stream->time_base;
+    codec_ctx->thread_count = 0;  // 按核心数自动开启帧/片级多线程
+#ifdef AV_CODEC_FLAG_COPY_OPAQUE
+    codec_ctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+#endif
+    if (avcodec_open2(codec_ctx, decoder, nullptr) < 0) {
+        avcodec_free_context(&codec_ctx);
+        return nullptr;
+    }
+    return codec_ctx;
+}
+
+}  // namespace
+
+SenderEngine::VideoLayer::VideoLayer(const SenderConfig& config, int64_t bitrate, int width, int height)
+    : max_bitrate(bitrate), encoder(nullptr), sws_ctx(nullptr),
+      last_pts(AV_NOPTS_VALUE), last_keyframe_us(0),
+      target_bitrate(bitrate), target_size(PackSize(width, height)), keyframe_requested(false),
+      decoded(config.frame_queue_depth),
+      scaled(config.frame_queue_depth),
+      encoded(config.packet_queue_depth) {}
+
+SenderEngine::SenderEngine(const SenderConfig& config)
+    : config_(config),
+      video_decoder_(nullptr), audio_decoder_(nullptr), audio_encoder_(nullptr),
+      swr_ctx_(nullptr), audio_fifo_(nullptr), resample_frame_(nullptr),
+      audio_next_pts_(AV_NOPTS_VALUE),
+      abr_(MakeAbrConfig(config)), subscriber_abr_(MakeAbrConfig(config)),
+      srtt_us_(0), loss_(0),
+      video_packets_(config.packet_queue_depth),
+      audio_packets_(config.packet_queue_depth),
+      encoded_audio_(config.packet_queue_depth),
+      // 每个加密线程的队列都能容纳全部槽位 (另留一格给结束标记)，轮转分配不会因单个队列满而阻塞
+      crypto_(config.crypto_workers, config.datagram_slots + 1, [this](Datagram*& dg) { Seal(dg); }),
+      audio_datagrams_(config.datagram_slots),
+      free_datagrams_(config.datagram_slots),
+      datagram_slab_(config.datagram_slots),
+      stop_(false), finished_(false),
+      packets_read_(0), video_frames_decoded_(0), video_frames_encoded_(0),
+      audio_frames_encoded_(0), frames_dropped_(0), datagrams_sealed_(0), datagrams_sent_(0),
+      bytes_sent_(0), send_errors_(0), crypto_errors_(0), send_waits_(0),
+      acks_received_(0), retransmits_(0), keyframe_requests_(0), keyframes_forced_(0), encoder_reopens_(0),
+      layer_switches_(0), subscriber_count_(0) {
+    memset(&target_addr_, 0, sizeof(target_addr_));
+
+    const int layers = LayerCount(config);
+    if (layers == 1) {
+        const EncoderTarget& target = abr_.Target();
+        layers_.emplace_back(new VideoLayer(config, target.bitrate, target.width, target.height));
+        return;
+    }
+    for (int i = 0; i < layers; i++) {
+        layers_.emplace_back(new VideoLayer(config, LayerBitrate(config, i),
+                                            LayerDimension(config.width, i), LayerDimension(config.height, i)));
+    }
+    // 订阅者的目标码率在最高层与最低层之间调整，分辨率由所选的层决定
+    subscriber_abr_.max_bitrate = layers_.front()->max_bitrate;
+    subscriber_abr_.min_bitrate = layers_.back()->max_bitrate;
+    subscriber_abr_.adapt_resolution = false;
+}
+
+SenderEngine::~SenderEngine() {
+    Stop();
+    CloseCodecs();
+}
+
+bool SenderEngine::Start() {
+    if (!threads_.empty()) return false;
+    if (!source_.Open(config_.source) || !OpenCodecs()) return false;
+
+    if (!transport_.Initialize(config_.local_port, config_.backend)) {
+        LOG_ERROR("Failed to initialize UDP transport on port %u", config_.local_port);
+        return false;
+    }
+    target_addr_.sin_family = AF_INET;
+    target_addr_.sin_port = htons(config_.target_port);
+    if (!config_.fan_out && inet_pton(AF_INET, config_.target_ip.c_str(), &target_addr_.sin_addr) != 1) {
+        LOG_ERROR("Invalid target address %s", config_.target_ip.c_str());
+        return false;
+    }
+    stop_.store(false);
+    // 握手时为订阅者创建会话，重传缓冲区大小须在此之前设好; 槽位至少容纳一个完整数据报
+    RetransmitConfig rtx = config_.retransmit;
+    rtx.slot_size = std::max(rtx.slot_size, sizeof(Datagram::data));
+    SessionManager::GetInstance().SetRetransmitConfig(rtx);
+    if (!AcceptHandshake()) return false;
+
+    // 线程启动前由当前线程填充空闲槽位，之后只有发送线程归还
+    for (Datagram& dg : datagram_slab_) free_datagrams_.TryPush(&dg);
+
+    finished_.store(false);
+    // 超时检测由会话管理器的定时线程完成 (每个会话只报告一次)，这里只登记，由反馈线程计入订阅者
+    SessionManager::GetInstance().SetLossHandler([this](const SessionHandle& session, uint32_t seq) {
+        std::lock_guard<std::mutex> lock(lost_mutex_);
+        if (lost_packets_.size() < kMaxPendingLosses) lost_packets_.emplace_back(session->GetSessionId(), seq);
+    });
+    crypto_.Start();
+    threads_.emplace_back(&SenderEngine::FeedbackLoop, this);
+    threads_.emplace_back(&SenderEngine::SendLoop, this);
+    threads_.emplace_back(&SenderEngine::PacketizeLoop, this);
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        threads_.emplace_back(&SenderEngine::VideoEncodeLoop, this, layer.get());
+        threads_.emplace_back(&SenderEngine::ScaleLoop, this, layer.get());
+    }
+    threads_.emplace_back(&SenderEngine::VideoDecodeLoop, this);
+    if (audio_encoder_) threads_.emplace_back(&SenderEngine::AudioLoop, this);
+    threads_.emplace_back(&SenderEngine::CaptureLoop, this);
+    return true;
+}
+
+void SenderEngine::Stop() {
+    stop_.store(true);
+    JoinThreads();
+    SessionManager::GetInstance().SetLossHandler(nullptr);
+    crypto_.Stop();
+    DrainQueues();
+}
+
+void SenderEngine::Wait() {
+    JoinThreads();
+    SessionManager::GetInstance().SetLossHandler(nullptr);
+    crypto_.Stop();
+    DrainQueues();
+}
+
+bool SenderEngine::AcceptHandshake() {
+    if (config_.fan_out && !session_) {
+        session_ = SessionManager::GetInstance().GetSession(GroupKey::CreateGroup());
+        if (!session_) {
+            LOG_ERROR("Failed to create group session");
+            return false;
+        }
+    }
+
+    const ReceiveHandler handler = [this](const uint8_t* data, size_t len, const sockaddr_in& from) {
+        OnControlPacket(data, len, from);
+    };
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(config_.handshake_timeout_ms);
+    while (subscribers_.empty()) {
+        if (stop_.load() || std::chrono::steady_clock::now() >= deadline) {
+            if (config_.fan_out) LOG_ERROR("No subscriber on port %u", config_.local_port);
+            else LOG_ERROR("No key exchange from %s:%u", config_.target_ip.c_str(), config_.target_port);
+            return false;
+        }
+        if (transport_.PollReceive(kHandshakePollMs, handler) < 0) {
+            LOG_ERROR("Receive failed while waiting for key exchange");
+            return false;
+        }
+    }
+    return session_ != nullptr;
+}
+
+SenderEngine::Subscriber* SenderEngine::FindSubscriber(const sockaddr_in& addr) {
+    for (Subscriber& sub : subscribers_) {
+        if (SameAddress(sub.addr, addr)) return &sub;
+    }
+    return nullptr;
+}
+
+void SenderEngine::AddSubscriber(const sockaddr_in& from, const uint8_t* data, size_t len) {
+    // 已订阅地址的重复请求 (回复在途时接收端的重发) 不再应答，否则会为同一地址建两个会话
+    if (FindSubscriber(from)) return;
+    if (config_.fan_out ? subscribers_.size() >= config_.max_subscribers : !SameAddress(from, target_addr_)) return;
+
+    KeyExchangePacket reply;
+    SessionManager& manager = SessionManager::GetInstance();
+    const uint32_t session_id = Handshake::Accept(from, data, len, &reply);
+    SessionHandle member = session_id ? manager.GetSession(session_id) : SessionHandle();
+    if (!member) return;
+
+    GroupKeyPacket group_key;
+    if (config_.fan_out && !GroupKey::Wrap(*session_, *member, &group_key)) {
+        manager.RemoveSession(session_id);
+        return;
+    }
+
+    // 接收端重发的请求不再回复，因此多发几份; 多余的副本被当作控制包忽略。
+    // 组密钥紧随回复发出，先于发给该订阅者的第一个数据报到达
+    OutgoingPacket out[2];
+    out[0].dest = from;
+    out[0].data = &reply;
+    out[0].len = sizeof(reply);
+    out[1].dest = from;
+    out[1].data = &group_key;
+    out[1].len = sizeof(group_key);
+    for (int i = 0; i < kReplyCopies; i++) transport_.SendBatch(out, config_.fan_out ? 2 : 1);
+
+    if (!config_.fan_out) session_ = member;
+    std::shared_ptr<DestinationState> state = std::make_shared<DestinationState>();
+    subscribers_.push_back({from, member, CongestionController::NowMicros(), 0, 0,
+                            AbrController(subscriber_abr_), state});
+    PublishDestinations();
+    RequestKeyframe(state->requested.load(std::memory_order_relaxed));   // 中途加入的订阅者从关键帧开始解码
+}
+
+void SenderEngine::ExpireSubscribers(uint64_t now_us) {
+    const uint64_t timeout = static_cast<uint64_t>(config_.subscriber_timeout_ms) * 1000;
+    auto expired = std::remove_if(subscribers_.begin(), subscribers_.end(), [&](const Subscriber& sub) {
+        if (now_us - sub.last_feedback_us < timeout) return false;
+        SessionManager::GetInstance().RemoveSession(sub.session->GetSessionId());
+        return true;
+    });
+    if (expired == subscribers_.end()) return;
+    subscribers_.erase(expired, subscribers_.end());
+    PublishDestinations();
+}
+
+void SenderEngine::PublishDestinations() {
+    std::shared_ptr<Destinations> destinations = std::make_shared<Destinations>();
+    destinations->reserve(subscribers_.size());
+    for (const Subscriber& sub : subscribers_) destinations->push_back({sub.addr, sub.session, sub.state});
+    std::atomic_store(&destinations_, std::shared_ptr<const Destinations>(std::move(destinations)));
+    subscriber_count_.store(subscribers_.size(), std::memory_order_relaxed);
+}
+
+void SenderEngine::JoinThreads() {
+    for (std::thread& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    threads_.clear();
+}
+
+void SenderEngine::DrainQueues() {
+    AVPacket* pkt = nullptr;
+    for (PacketQueue* q : {&video_packets_, &audio_packets_, &encoded_audio_}) {
+        while (q->TryPop(&pkt)) packet_pool_.Release(&pkt);
+    }
+    Datagram* dg = nullptr;
+    while (audio_datagrams_.TryPop(&dg)) {}   // 槽位在下次Start时重新填充
+    AVFrame* frame = nullptr;
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        while (layer->encoded.TryPop(&pkt)) packet_pool_.Release(&pkt);
+        for (FrameQueue* q : {&layer->decoded, &layer->scaled}) {
+            while (q->TryPop(&frame)) frame_pool_.Release(&frame);
+        }
+    }
+}
+
+bool SenderEngine::OpenCodecs() {
+    video_decoder_ = OpenDecoder(source_.VideoStream());
+    if (!video_decoder_) {
+        LOG_ERROR("Could not open video decoder");
+        return false;
+    }
+
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        const uint32_t size = layer->target_size.load(std::memory_order_relaxed);
+        layer->encoder = OpenVideoEncoder(static_cast<int>(size >> 16), static_cast<int>(size & 0xffff),
+                                          layer->target_bitrate.load(std::memory_order_relaxed));
+        if (!layer->encoder) {
+            LOG_ERROR("Could not open H.264 encoder");
+            return false;
+        }
+    }
+
+    if (!config_.enable_audio || !source_.AudioStream()) return true;
+
+    // 音频不可用时只发视频
+    audio_decoder_ = OpenDecoder(source_.AudioStream());
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!audio_decoder_ || !codec) {
+        LOG_WARN("Audio codec unavailable, sending video only");
+        avcodec_free_context(&audio_decoder_);
+        return true;
+    }
+    if (audio_decoder_->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+        int channels = audio_decoder_->ch_layout.nb_channels;
+        av_channel_layout_uninit(&audio_decoder_->ch_layout);
+        av_channel_layout_default(&audio_decoder_->ch_layout, channels);
+    }
+
+    audio_encoder_ = avcodec_alloc_context3(codec);
+    audio_encoder_->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    audio_encoder_->bit_rate = config_.audio_bitrate;
+    audio_encoder_->sample_rate = config_.audio_sample_rate;
+    audio_encoder_->time_base = {1, config_.audio_sample_rate};
+    AVChannelLayout layout = AV_CHANNEL_LAYOUT_STEREO;
+    av_channel_layout_copy(&audio_encoder_->ch_layout, &layout);
+    packet_pool_.AttachEncoder(audio_encoder_);
+
+    int ret = avcodec_open2(audio_encoder_, codec, nullptr);
+    if (ret >= 0) {
+        ret = swr_alloc_set_opts2(&swr_ctx_,
+                                  &audio_encoder_->ch_layout, audio_encoder_->sample_fmt, audio_encoder_->sample_rate,
+                                  &audio_decoder_->ch_layout, audio_decoder_->sample_fmt, audio_decoder_->sample_rate,
+                                  0, nullptr);
+    }
+    if (ret >= 0) ret = swr_init(swr_ctx_);
+    if (ret < 0) {
+        LOG_WARN("Could not set up audio encoding, sending video only");
+        swr_free(&swr_ctx_);
+        avcodec_free_context(&audio_encoder_);
+        avcodec_free_context(&audio_decoder_);
+        return true;
+    }
+    audio_fifo_ = av_audio_fifo_alloc(audio_encoder_->sample_fmt, audio_encoder_->ch_layout.nb_channels,
+                                      std::max(audio_encoder_->frame_size, 1024) * 2);
+    resample_frame_ = av_frame_alloc();
+    return true;
+}
+
+AVCodecContext* SenderEngine::OpenVideoEncoder(int width, int height, int64_t bitrate) {
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec) return nullptr;
+
+    const bool low_latency = config_.profile == EncoderProfile::LowLatency;
+    AVCodecContext* encoder = avcodec_alloc_context3(codec);
+    encoder->width = width;
+    encoder->height = height;
+    encoder->pix_fmt = kEncoderFormat;
+    encoder->time_base = kEncoderTimeBase;
+    encoder->framerate = {config_.fps, 1};
+    encoder->thread_count = 0;
+    if (config_.video_slices > 0) encoder->slices = config_.video_slices;
+#ifdef AV_CODEC_FLAG_COPY_OPAQUE
+    encoder->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+#endif
+    SetRateControl(encoder, bitrate);
+
+    const std::string preset = !config_.preset.empty() ? config_.preset : low_latency ? "veryfast" : "medium";
+    av_opt_set(encoder->priv_data, "preset", preset.c_str(), 0);
+    // 按需关键帧必须是IDR，接收端才能从该帧起独立解码
+    av_opt_set(encoder->priv_data, "forced-idr", "1", 0);
+    if (low_latency) {
+        // zerolatency关闭前瞻与帧级线程; 丢包由关键帧请求恢复，周期关键帧只作兜底
+        av_opt_set(encoder->priv_data, "tune", "zerolatency", 0);
+        encoder->max_b_frames = 0;
+        encoder->gop_size = std::max(config_.fps, 1) * 4;
+    }
+    packet_pool_.AttachEncoder(encoder);
+    if (avcodec_open2(encoder, codec, nullptr) < 0) {
+        avcodec_free_context(&encoder);
+        return nullptr;
+    }
+    return encoder;
+}
+
+// libx264在下一次send_frame时检测到这些字段变化并重新配置码控，无需重建编码器
+void SenderEngine::SetRateControl(AVCodecContext* encoder, int64_t bitrate) const {
+    encoder->bit_rate = bitrate;
+    if (config_.profile != EncoderProfile::LowLatency) return;
+    encoder->rc_max_rate = bitrate;
+    encoder->rc_buffer_size = static_cast<int>(bitrate * kLowLatencyVbvFrames / std::max(config_.fps, 1));
+}
+
+bool SenderEngine::ReopenVideoEncoder(VideoLayer& layer, int width, int height) {
+    // 先取出旧编码器中缓存的帧 (低延迟档位下没有)，已编码数据按序发出
+    avcodec_send_frame(layer.encoder, nullptr);
+    if (!DrainEncoder(layer.encoder, layer.encoded, video_frames_encoded_)) return false;
+
+    AVCodecContext* encoder = OpenVideoEncoder(width, height, layer.target_bitrate.load(std::memory_order_relaxed));
+    if (!encoder) {
+        LOG_ERROR("Could not reopen H.264 encoder at %dx%d", width, height);
+        return false;
+    }
+    avcodec_free_context(&layer.encoder);
+    layer.encoder = encoder;
+    encoder_reopens_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SenderEngine::ApplyEncoderTarget(VideoLayer& layer, AVFrame* frame) {
+    const int64_t bitrate = layer.target_bitrate.load(std::memory_order_relaxed);
+    if (bitrate != layer.encoder->bit_rate) SetRateControl(layer.encoder, bitrate);
+
+    if (!layer.keyframe_requested.exchange(false, std::memory_order_relaxed)) return;
+    // 同一次丢包会触发多个请求，按最小间隔和RTT限流: 上一个关键帧到达接收端之前的请求直接忽略，
+    // 接收端仍未恢复时会再次请求
+    const uint64_t now = CongestionController::NowMicros();
+    const uint64_t interval = std::max<uint64_t>(static_cast<uint64_t>(config_.min_keyframe_interval_ms) * 1000,
+                                                 2ull * srtt_us_.load(std::memory_order_relaxed));
+    if (layer.last_keyframe_us != 0 && now - layer.last_keyframe_us < interval) return;
+    layer.last_keyframe_us = now;
+    frame->pict_type = AV_PICTURE_TYPE_I;
+    keyframes_forced_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SenderEngine::RequestKeyframe(int layer) {
+    layers_[static_cast<size_t>(layer)]->keyframe_requested.store(true, std::memory_order_relaxed);
+}
+
+void SenderEngine::CloseCodecs() {
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        sws_freeContext(layer->sws_ctx);
+        layer->sws_ctx = nullptr;
+        avcodec_free_context(&layer->encoder);
+    }
+    swr_free(&swr_ctx_);
+    if (audio_fifo_) av_audio_fifo_free(audio_fifo_);
+    audio_fifo_ = nullptr;
+    av_frame_free(&resample_frame_);
+    avcodec_free_context(&video_decoder_);
+    avcodec_free_context(&audio_decoder_);
+    avcodec_free_context(&audio_encoder_);
+    source_.Close();
+}
+
+bool SenderEngine::ForwardPacket(PacketQueue& q, AVPacket* pkt, bool droppable) {
+    if (pkt && droppable) {
+        if (!q.TryPush(pkt)) {
+            packet_pool_.Release(&pkt);
+            frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return !stop_.load(std::memory_order_relaxed);
+    }
+    if (q.Push(pkt, stop_)) return true;
+    packet_pool_.Release(&pkt);
+    return false;
+}
+
+bool SenderEngine::ForwardFrame(FrameQueue& q, AVFrame* frame, bool droppable) {
+    if (frame && droppable) {
+        if (!q.TryPush(frame)) {
+            frame_pool_.Release(&frame);
+            frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return !stop_.load(std::memory_order_relaxed);
+    }
+    if (q.Push(frame, stop_)) return true;
+    frame_pool_.Release(&frame);
+    return false;
+}
+
+bool SenderEngine::DrainEncoder(AVCodecContext* encoder, PacketQueue& out, std::atomic<uint64_t>& counter) {
+    while (true) {
+        AVPacket* pkt = packet_pool_.Acquire();
+        if (avcodec_receive_packet(encoder, pkt) < 0) {
+            packet_pool_.Release(&pkt);
+            return true;
+        }
+        counter.fetch_add(1, std::memory_order_relaxed);
+        if (config_.frame_trace) pkt->opaque = PackTraceStamps(CaptureStamp(pkt->opaque), utils::FrameTracer::NowMicros());
+        if (!out.Push(pkt, stop_)) {
+            packet_pool_.Release(&pkt);
+            return false;
+        }
+    }
+}
+
+void SenderEngine::CaptureLoop() {
+    const bool live = source_.IsLive();
+    while (!stop_.load(std::memory_order_relaxed)) {
+        AVPacket* pkt = packet_pool_.Acquire();
+        const uint64_t start_ns = utils::Metrics::Enabled() ? utils::Metrics::NowNanos() : 0;
+        int ret = source_.ReadPacket(pkt);
+        if (start_ns && ret >= 0) utils::Metrics::Record(utils::Stage::Capture, utils::Metrics::NowNanos() - start_ns);
+        if (ret == AVERROR(EAGAIN)) {
+            packet_pool_.Release(&pkt);
+            continue;
+        }
+        if (ret < 0) {
+            packet_pool_.Release(&pkt);
+            if (ret != AVERROR_EOF) LOG_ERROR("Failed to read input: %d", ret);
+            break;
+        }
+        packets_read_.fetch_add(1, std::memory_order_relaxed);
+
+        bool ok = true;
+        if (pkt->stream_index == source_.VideoIndex()) {
+            if (config_.frame_trace) pkt->opaque = PackTraceStamps(utils::FrameTracer::NowMicros(), 0);
+            ok = ForwardPacket(video_packets_, pkt, live);
+        } else if (audio_encoder_) {
+            ok = ForwardPacket(audio_packets_, pkt, false);
+        } else {
+            packet_pool_.Release(&pkt);
+        }
+        if (!ok) return;
+    }
+    video_packets_.Push(nullptr, stop_);
+    if (audio_encoder_) audio_packets_.Push(nullptr, stop_);
+}
+
+void SenderEngine::VideoDecodeLoop() {
+    const bool live = source_.IsLive();
+    AVPacket* pkt = nullptr;
+    while (video_packets_.Pop(&pkt, stop_)) {
+        const bool eos = pkt == nullptr;
+        // pkt为nullptr时进入冲刷模式
+        int ret = avcodec_send_packet(video_decoder_, pkt);
+        packet_pool_.Release(&pkt);
+        if (ret < 0 && ret != AVERROR_EOF) LOG_WARN("Video decode error: %d", ret);
+
+        while (true) {
+            AVFrame* frame = frame_pool_.Acquire();
+            if (avcodec_receive_frame(video_decoder_, frame) < 0) {
+                frame_pool_.Release(&frame);
+                break;
+            }
+            video_frames_decoded_.fetch_add(1, std::memory_order_relaxed);
+            // 同播: 其余各层拿到同一解码帧的引用，不复制像素，各自的缩放线程并行转换
+            for (size_t i = 1; i < layers_.size(); i++) {
+                AVFrame* ref = frame_pool_.Acquire();
+                if (av_frame_ref(ref, frame) < 0) {
+                    frame_pool_.Release(&ref);
+                    continue;
+                }
+                if (!ForwardFrame(layers_[i]->decoded, ref, live)) {
+                    frame_pool_.Release(&frame);
+                    return;
+                }
+            }
+            if (!ForwardFrame(layers_[0]->decoded, frame, live)) return;
+        }
+        if (eos) {
+            for (const std::unique_ptr<VideoLayer>& layer : layers_) layer->decoded.Push(nullptr, stop_);
+            return;
+        }
+    }
+}
+
+void SenderEngine::ScaleLoop(VideoLayer* layer) {
+    const bool live = source_.IsLive();
+    const AVRational in_tb = source_.VideoStream()->time_base;
+    AVFrame* frame = nullptr;
+    while (layer->decoded.Pop(&frame, stop_)) {
+        if (!frame) {
+            layer->scaled.Push(nullptr, stop_);
+            return;
+        }
+
+        // 目标分辨率由反馈线程给出，编码线程看到帧尺寸变化后重建编码器
+        const uint32_t size = layer->target_size.load(std::memory_order_relaxed);
+        const int width = static_cast<int>(size >> 16);
+        const int height = static_cast<int>(size & 0xffff);
+        const int64_t ts = frame->best_effort_timestamp;
+        AVFrame* out = frame;
+        if (frame->format != kEncoderFormat || frame->width != width || frame->height != height) {
+            // 输入或目标分辨率中途变化时重建转换上下文
+            layer->sws_ctx = sws_getCachedContext(layer->sws_ctx,
+                frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                width, height, kEncoderFormat,
+                SWS_BILINEAR, nullptr, nullptr, nullptr);
+            out = layer->sws_ctx ? frame_pool_.AcquireVideo(kEncoderFormat, width, height) : nullptr;
+            if (!out) {
+                LOG_ERROR("Failed to convert video frame");
+                frame_pool_.Release(&frame);
+                continue;
+            }
+            sws_scale(layer->sws_ctx, frame->data, frame->linesize, 0, frame->height, out->data, out->linesize);
+            out->opaque = frame->opaque;
+            frame_pool_.Release(&frame);
+        } else {
+            // 已是编码器格式: 解码帧直接交给编码器，省去一次整帧拷贝
+            out->pict_type = AV_PICTURE_TYPE_NONE;
+        }
+        out->pts = ts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE : av_rescale_q(ts, in_tb, kEncoderTimeBase);
+        if (!ForwardFrame(layer->scaled, out, live)) return;
+    }
+}
+
+void SenderEngine::VideoEncodeLoop(VideoLayer* layer) {
+    const int64_t frame_ticks = kEncoderTimeBase.den / std::max(config_.fps, 1);
+    AVFrame* frame = nullptr;
+    bool failed = false;
+    while (layer->scaled.Pop(&frame, stop_)) {
+        const bool eos = frame == nullptr;
+        if (failed) {
+            // 编码器已不可用: 继续取走输入直到结束，缩放线程不会阻塞在满队列上
+            frame_pool_.Release(&frame);
+            if (eos) return;
+            continue;
+        }
+        if (frame) {
+            // 编码器要求时间戳严格递增 (循环播放、丢帧或缺失时间戳时修正)
+            if (layer->last_pts != AV_NOPTS_VALUE &&
+                (frame->pts == AV_NOPTS_VALUE || frame->pts <= layer->last_pts)) {
+                frame->pts = frame->pts == AV_NOPTS_VALUE ? layer->last_pts + frame_ticks : layer->last_pts + 1;
+            } else if (frame->pts == AV_NOPTS_VALUE) {
+                frame->pts = 0;
+            }
+            layer->last_pts = frame->pts;
+
+            if ((frame->width != layer->encoder->width || frame->height != layer->encoder->height) &&
+                !ReopenVideoEncoder(*layer, frame->width, frame->height)) {
+                // 先发结束标记，打包线程不再等待该层
+                frame_pool_.Release(&frame);
+                layer->encoded.Push(nullptr, stop_);
+                failed = true;
+                continue;
+            }
+            ApplyEncoderTarget(*layer, frame);
+        }
+
+        utils::StageTimer timer(utils::Stage::Encode);
+        int ret = avcodec_send_frame(layer->encoder, frame);
+        timer.Stop();
+        frame_pool_.Release(&frame);
+        if (ret < 0 && ret != AVERROR_EOF) LOG_WARN("Video encode error: %d", ret);
+        if (!DrainEncoder(layer->encoder, layer->encoded, video_frames_encoded_) || eos) {
+            layer->encoded.Push(nullptr, stop_);
+            return;
+        }
+    }
+}
+
+void SenderEngine::AudioLoop() {
+    const AVRational in_tb = source_.AudioStream()->time_base;
+    AVFrame* decoded = frame_pool_.Acquire();
+    AVPacket* pkt = nullptr;
+    bool ok = true;
+    bool finished = false;   // 已发出结束标记
+    while (audio_packets_.Pop(&pkt, stop_)) {
+        const bool eos = pkt == nullptr;
+        if (!ok) {
+            // 编码已失败: 继续取走输入直到结束，采集线程不会阻塞在满队列上
+            packet_pool_.Release(&pkt);
+            if (eos) break;
+            continue;
+        }
+        int ret = avcodec_send_packet(audio_decoder_, pkt);
+        packet_pool_.Release(&pkt);
+        if (ret < 0 && ret != AVERROR_EOF) LOG_WARN("Audio decode error: %d", ret);
+
+        while (ok && avcodec_receive_frame(audio_decoder_, decoded) == 0) {
+            // 输出时间戳按样本数连续递增，起点取首帧时间戳
+            if (audio_next_pts_ == AV_NOPTS_VALUE) {
+                audio_next_pts_ = decoded->best_effort_timestamp == AV_NOPTS_VALUE ? 0 :
+                    av_rescale_q(decoded->best_effort_timestamp, in_tb, audio_encoder_->time_base);
+            }
+            ok = EncodeAudio(decoded);
+            av_frame_unref(decoded);
+        }
+        if (eos) {
+            if (ok && !EncodeAudio(nullptr)) LOG_WARN("Failed to flush audio encoder");
+            break;
+        }
+        if (!ok && !finished) {
+            // 打包线程见到结束标记后只继续发送视频
+            if (!stop_.load()) LOG_ERROR("Audio encoding failed, audio stream ends here");
+            encoded_audio_.Push(nullptr, stop_);
+            finished = true;
+        }
+    }
+    // 无论编码结果如何都发出结束标记，否则打包线程一直等待音频，Wait()不返回
+    if (!finished) encoded_audio_.Push(nullptr, stop_);
+    frame_pool_.Release(&decoded);
+}
+
+bool SenderEngine::EncodeAudio(AVFrame* frame) {
+    // 重采样到编码器格式后写入FIFO; frame为nullptr时取出重采样器中剩余的样本
+    const int in_samples = frame ? frame->nb_samples : 0;
+    const int max_out = swr_get_out_samples(swr_ctx_, in_samples);
+    if (max_out > 0) {
+        if (resample_frame_->nb_samples < max_out) {
+            av_frame_unref(resample_frame_);
+            resample_frame_->format = audio_encoder_->sample_fmt;
+            resample_frame_->sample_rate = audio_encoder_->sample_rate;
+            resample_frame_->nb_samples = max_out;
+            av_channel_layout_copy(&resample_frame_->ch_layout, &audio_encoder_->ch_layout);
+            if (av_frame_get_buffer(resample_frame_, 0) < 0) return false;
+        }
+        int converted = swr_convert(swr_ctx_, resample_frame_->data, max_out,
+                                    frame ? (const uint8_t**)frame->extended_data : nullptr, in_samples);
+        if (converted > 0 &&
+            av_audio_fifo_write(audio_fifo_, (void**)resample_frame_->data, converted) < converted) {
+            return false;
+        }
+    }
+
+    // 编码器每次只接受frame_size个样本 (最后一帧可以不足)
+    const bool flush = frame == nullptr;
+    const int frame_size = audio_encoder_->frame_size > 0 ? audio_encoder_->frame_size : 1024;
+    while (av_audio_fifo_size(audio_fifo_) >= frame_size || (flush && av_audio_fifo_size(audio_fifo_) > 0)) {
+        AVFrame* chunk = frame_pool_.AcquireAudio(audio_encoder_->sample_fmt, audio_encoder_->ch_layout,
+                                                  audio_encoder_->sample_rate,
+                                                  std::min(av_audio_fifo_size(audio_fifo_), frame_size));
+        if (!chunk) return false;
+        av_audio_fifo_read(audio_fifo_, (void**)chunk->data, chunk->nb_samples);
+        chunk->pts = audio_next_pts_;
+        audio_next_pts_ += chunk->nb_samples;
+
+        int ret = avcodec_send_frame(audio_encoder_, chunk);
+        frame_pool_.Release(&chunk);
+        if (ret < 0) {
+            LOG_ERROR("Audio encode error: %d", ret);
+            return false;
+        }
+        if (!DrainEncoder(audio_encoder_, encoded_audio_, audio_frames_encoded_)) return false;
+    }
+    if (flush) {
+        avcodec_send_frame(audio_encoder_, nullptr);
+        return DrainEncoder(audio_encoder_, encoded_audio_, audio_frames_encoded_);
+    }
+    return true;
+}
+
+void SenderEngine::PacketizeLoop() {
+    const size_t layer_count = layers_.size();
+    bool video_done[kMaxSimulcastLayers] = {};
+    size_t video_open = layer_count;
+    size_t next_layer = 0;
+    bool audio_done = audio_encoder_ == nullptr;
+    utils::Backoff backoff;
+    while (video_open > 0 || !audio_done) {
+        if (stop_.load(std::memory_order_relaxed)) return;
+
+        // 音频包小且对延迟敏感，优先于视频; 同播各层轮流取，一个包的分片连续提交
+        AVPacket* pkt = nullptr;
+        int layer = kAllLayers;
+        if (!audio_done && encoded_audio_.TryPop(&pkt)) {
+            if (!pkt) {
+                audio_done = true;
+                continue;
+            }
+        } else {
+            for (size_t n = 0; n < layer_count; n++) {
+                const size_t i = (next_layer + n) % layer_count;
+                if (video_done[i] || !layers_[i]->encoded.TryPop(&pkt)) continue;
+                layer = static_cast<int>(i);
+                break;
+            }
+            if (layer == kAllLayers) {
+                backoff.Pause();
+                continue;
+            }
+            next_layer = static_cast<size_t>(layer) + 1;
+            if (!pkt) {
+                video_done[layer] = true;
+                video_open--;
+                continue;
+            }
+        }
+        backoff.Reset();
+
+        bool ok = Packetize(pkt, layer);
+        packet_pool_.Release(&pkt);
+        if (!ok) return;
+    }
+    crypto_.Submit(nullptr, stop_);
+}
+
+// 按PacketHeader分片，接收端按流分别用抖动缓冲区排序重组。
+// 这里只写明文与包头模板 (seq仅作重传缓冲区的键，传输seq与流内seq由发送线程按订阅者改写);
+// 视频在线程池中加密、发送顺序不变，音频在本线程直接封装后进入高优先级队列
+bool SenderEngine::Packetize(AVPacket* pkt, int layer) {
+    if (pkt->size <= 0) return true;
+
+    const bool audio = layer == kAllLayers;
+    SplitFragments(pkt->data, static_cast<size_t>(pkt->size), !audio, &fragments_);
+    const uint16_t total = static_cast<uint16_t>(fragments_.size());
+    const bool keyframe = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+    int64_t pts = pkt->pts == AV_NOPTS_VALUE ? 0 : pkt->pts;
+    if (audio) pts = av_rescale_q(pts, audio_encoder_->time_base, kEncoderTimeBase);
+    for (uint16_t i = 0; i < total; i++) {
+        // 空闲槽位耗尽说明发送跟不上，在此等待而不是分配新内存
+        Datagram* dg = nullptr;
+        if (!free_datagrams_.TryPop(&dg)) {
+            send_waits_.fetch_add(1, std::memory_order_relaxed);
+            if (!free_datagrams_.Pop(&dg, stop_)) return false;
+        }
+
+        const FragmentSpan& span = fragments_[i];
+        const size_t len = span.len;
+        PacketHeader header;
+        memset(&header, 0, sizeof(header));
+        header.session_id = htonl(session_->GetSessionId());
+        header.seq_num = htonl(session_->GetAndIncrementSeq());
+        header.fragment_id = htons(i);
+        header.total_fragments = htons(total);
+        header.payload_len = htons(static_cast<uint16_t>(len));
+        header.flags = (keyframe ? PACKET_FLAG_KEYFRAME : 0) | (span.unit_end ? PACKET_FLAG_UNIT_END : 0);
+        header.stream_id = audio ? MEDIA_STREAM_AUDIO : MEDIA_STREAM_VIDEO;
+        header.timestamp = htonl(static_cast<uint32_t>(pts));
+        memcpy(dg->data, &header, sizeof(header));
+        memcpy(dg->data + sizeof(header), pkt->data + span.offset, len);
+        dg->len = sizeof(header) + len;
+        dg->layer = layer;
+        dg->keyframe_start = keyframe && i == 0;
+        dg->traced = config_.frame_trace && !audio && i + 1 == total;
+        if (dg->traced) {
+            dg->trace.capture_us = htonl(CaptureStamp(pkt->opaque));
+            dg->trace.encode_us = htonl(EncodeStamp(pkt->opaque));
+            dg->trace.encrypt_us = 0;
+            dg->trace.send_us = 0;
+        }
+        if (audio) {
+            // 封装失败的也交给发送线程归还槽位 (空闲队列只能由发送线程写入)
+            Seal(dg);
+            if (!audio_datagrams_.Push(dg, stop_)) return false;
+        } else if (!crypto_.Submit(dg, stop_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SenderEngine::SplitFragments(const uint8_t* data, size_t size, bool annexb, std::vector<FragmentSpan>* out) {
+    out->clear();
+    size_t fragment_start = 0;
+    size_t unit_start = 0;
+    while (unit_start < size) {
+        const size_t unit_end = annexb ? NextStartCode(data, size, unit_start + 3) : size;
+        if (unit_end - fragment_start > kFragmentPayload) {
+            // 当前分片放不下这个NAL: 先在NAL边界处结束已有内容，超长的NAL再按分片长度切开
+            if (unit_start > fragment_start) {
+                out->push_back({fragment_start, unit_start - fragment_start, true});
+                fragment_start = unit_start;
+            }
+            while (unit_end - fragment_start > kFragmentPayload) {
+                out->push_back({fragment_start, kFragmentPayload, false});
+                fragment_start += kFragmentPayload;
+            }
+        }
+        unit_start = unit_end;
+    }
+    if (size > fragment_start) out->push_back({fragment_start, size - fragment_start, true});
+}
+
+void SenderEngine::Seal(Datagram* dg) {
+    if (!dg) return;  // 结束标记原样传给发送线程
+    // 发送线程按订阅者重写seq，封装时的seq不会出现在网络上，不存入重传缓冲区
+    dg->len = PacketBuilder::SealInPlace(*session_, dg->data, sizeof(dg->data) - sizeof(FrameTrace), false);
+    if (dg->len == 0) {
+        crypto_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    datagrams_sealed_.fetch_add(1, std::memory_order_relaxed);
+    if (dg->traced) {
+        // 追踪扩展在封装之后追加，不在摘要范围内
+        dg->trace.encrypt_us = htonl(utils::FrameTracer::NowMicros());
+        memcpy(dg->data + dg->len, &dg->trace, sizeof(FrameTrace));
+        dg->data[offsetof(PacketHeader, flags)] |= PACKET_FLAG_TRACE;
+        dg->len += sizeof(FrameTrace);
+    }
+}
+
+int64_t SenderEngine::VideoBitrate() const {
+    int64_t bitrate = 0;
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        bitrate += layer->target_bitrate.load(std::memory_order_relaxed);
+    }
+    return bitrate;
+}
+
+void SenderEngine::SendLoop() {
+    // 严格优先级: 每轮先发完已封装的音频，再按发送预算取视频。
+    // 预算按编码码率的pacing_gain倍累积、最多积累kPacingBurstUs，关键帧的几百个分片被摊到
+    // 若干毫秒内发出，内核发送队列里始终只有少量视频，随后到达的音频不必排在整个关键帧之后
+    const double gain = config_.pacing_gain;
+    Datagram* batch[kSendBatch];
+    double budget = 0;   // 字节，可短暂为负 (按数据报整体扣除)
+    uint64_t last_us = CongestionController::NowMicros();
+    utils::Backoff idle;
+    bool eos = false;
+    while (!eos && !stop_.load(std::memory_order_relaxed)) {
+        Datagram* dg = nullptr;
+        size_t audio = 0;
+        while (audio < kSendBatch && audio_datagrams_.TryPop(&dg)) batch[audio++] = dg;
+        if (audio > 0) Transmit(batch, audio);
+
+        const uint64_t now = CongestionController::NowMicros();
+        if (gain > 0) {
+            const double rate = gain * static_cast<double>(VideoBitrate()) / 8e6;   // 字节/微秒
+            budget = std::min(budget + rate * static_cast<double>(now - last_us), rate * kPacingBurstUs);
+        }
+        last_us = now;
+
+        // 把已按序加密完成的视频数据报凑成一批，一次sendmmsg发出
+        size_t video = 0;
+        while (video < kSendBatch && (gain <= 0 || budget > 0) && crypto_.TryCollect(&dg)) {
+            if (!dg) {
+                eos = true;
+                break;
+            }
+            budget -= static_cast<double>(dg->len);   // 扇出不重复计费: 预算限制的是编码输出的摊开速度
+            batch[video++] = dg;
+        }
+        if (video > 0) Transmit(batch, video);
+
+        if (audio > 0 || video > 0) idle.Reset();
+        else idle.Pause();
+    }
+    if (eos) {
+        // 分片线程在结束标记之前已放入全部音频
+        Datagram* dg = nullptr;
+        size_t count = 0;
+        while (audio_datagrams_.TryPop(&dg)) {
+            batch[count++] = dg;
+            if (count == kSendBatch) {
+                Transmit(batch, count);
+                count = 0;
+            }
+        }
+        if (count > 0) Transmit(batch, count);
+    }
+    finished_.store(true, std::memory_order_release);
+}
+
+void SenderEngine::Transmit(Datagram* const* batch, size_t count) {
+    // 同一份密文发给每个订阅者，包头seq按订阅者重新编号 (包头不在SM3摘要范围内)
+    const std::shared_ptr<const Destinations> destinations = std::atomic_load(&destinations_);
+    const size_t fan = destinations ? destinations->size() : 0;
+    if (send_out_.size() < count * fan) {
+        send_out_.resize(count * fan);
+        send_headers_.resize(count * fan);
+        send_records_.resize(count * fan);
+    }
+    size_t total = 0;
+    uint32_t send_us = 0;
+    for (size_t i = 0; i < count; i++) {
+        Datagram* d = batch[i];
+        if (d->len == 0) continue;   // 封装失败
+        if (d->traced) {
+            // 扩展不在摘要范围内，可直接改写; 扇出时各订阅者共用同一发送时刻
+            if (!send_us) send_us = htonl(utils::FrameTracer::NowMicros());
+            memcpy(d->data + d->len - sizeof(FrameTrace) + offsetof(FrameTrace, send_us), &send_us, sizeof(send_us));
+        }
+        PacketHeader header;
+        memcpy(&header, d->data, sizeof(header));
+        const uint8_t stream = header.stream_id;   // 分片线程写入，总是有效
+        for (size_t j = 0; j < fan; j++) {
+            const Destination& dest = (*destinations)[j];
+            DestinationState& state = *dest.state;
+            if (d->layer != kAllLayers) {
+                // 换层只能从新层的关键帧开始，此前继续发旧层
+                const int requested = state.requested.load(std::memory_order_relaxed);
+                if (d->keyframe_start && d->layer == requested) {
+                    state.active.store(requested, std::memory_order_relaxed);
+                }
+                if (d->layer != state.active.load(std::memory_order_relaxed)) continue;
+            }
+            const uint32_t seq = state.next_seq++;
+            PacketHeader& rewritten = send_headers_[total];
+            rewritten = header;
+            rewritten.seq_num = htonl(seq);
+            rewritten.stream_seq = htonl(state.next_stream_seq[stream]++);
+            OutgoingPacket& o = send_out_[total];
+            o.dest = dest.addr;
+            o.header = &rewritten;
+            o.header_len = sizeof(PacketHeader);
+            o.data = d->data + sizeof(PacketHeader);
+            o.len = d->len - sizeof(PacketHeader);
+            send_records_[total++] = {dest.session.get(), seq};
+        }
+    }
+
+    size_t sent = 0;
+    utils::Backoff backoff;
+    while (sent < total && !stop_.load(std::memory_order_relaxed)) {
+        int ret = transport_.SendBatch(send_out_.data() + sent, total - sent);
+        if (ret > 0) {
+            sent += ret;
+            backoff.Reset();
+            continue;
+        }
+        if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            send_errors_.fetch_add(total - sent, std::memory_order_relaxed);
+            break;
+        }
+        backoff.Pause();  // 套接字发送缓冲区已满
+    }
+
+    // 各订阅者的拥塞控制器记录发送时刻，ACK到达时据此计算RTT与投递速率;
+    // 开启重传的订阅者按其seq保存实际发出的字节
+    uint64_t bytes = 0;
+    for (size_t k = 0; k < sent; k++) {
+        const OutgoingPacket& o = send_out_[k];
+        const size_t len = o.header_len + o.len;
+        SessionContext* session = send_records_[k].session;
+        if (RetransmitBuffer* rtx = session->GetRetransmitBuffer()) {
+            rtx->Store(send_records_[k].seq, static_cast<const uint8_t*>(o.header), o.header_len,
+                       static_cast<const uint8_t*>(o.data), o.len);
+        }
+        session->OnPacketSent(send_records_[k].seq, len);
+        bytes += len;
+    }
+    datagrams_sent_.fetch_add(sent, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) free_datagrams_.TryPush(batch[i]);
+}
+
+void SenderEngine::OnControlPacket(const uint8_t* data, size_t len, const sockaddr_in& from) {
+    ControlHeader ctrl;
+    if (len < sizeof(ctrl)) return;
+    memcpy(&ctrl, data, sizeof(ctrl));
+    if (ctrl.zero != 0) return;
+    if (ctrl.type == CONTROL_KEY_EXCHANGE_INIT) {
+        AddSubscriber(from, data, len);
+        return;
+    }
+
+    Subscriber* sub = FindSubscriber(from);
+    if (!sub) return;
+    const uint32_t session_id = sub->session->GetSessionId();
+    if (ctrl.type == CONTROL_ACK && len == sizeof(AckPacket)) {
+        AckPacket ack;
+        memcpy(&ack, data, sizeof(ack));
+        if (ntohl(ack.session_id) != session_id) return;
+        sub->session->OnAckReceived(ntohl(ack.seq_num), ntohl(ack.ack_delay_us));
+        sub->last_feedback_us = CongestionController::NowMicros();
+        sub->acked++;
+        acks_received_.fetch_add(1, std::memory_order_relaxed);
+    } else if (ctrl.type == CONTROL_KEYFRAME_REQUEST && len == sizeof(KeyframeRequestPacket)) {
+        KeyframeRequestPacket request;
+        memcpy(&request, data, sizeof(request));
+        if (ntohl(request.session_id) != session_id) return;
+        keyframe_requests_.fetch_add(1, std::memory_order_relaxed);
+        RequestKeyframe(sub->state->requested.load(std::memory_order_relaxed));
+    }
+}
+
+// 单个订阅者本周期的反馈; 取走后清零确认/丢包计数
+NetworkFeedback SenderEngine::SubscriberFeedback(Subscriber& sub, uint64_t now_us) {
+    NetworkFeedback feedback;
+    memset(&feedback, 0, sizeof(feedback));
+    feedback.now_us = now_us;
+    feedback.acked = sub.acked;
+    feedback.lost = sub.lost;
+    sub.acked = sub.lost = 0;
+
+    CongestionController& cc = sub.session->GetCongestionController();
+    const uint32_t srtt = cc.GetSmoothedRtt();
+    if (srtt == 0) return feedback;   // 尚无RTT样本，带宽估计只是初始值
+    feedback.srtt_us = srtt;
+    feedback.min_rtt_us = std::min(cc.GetMinRtt(), srtt);
+    feedback.bandwidth_bps = cc.GetBottleneckBandwidth();
+    return feedback;
+}
+
+// 同播: 订阅者按自己的反馈调整目标码率，选码率不超过目标的最高一层 (都超过时取最低层)
+void SenderEngine::SelectLayer(Subscriber& sub, const NetworkFeedback& feedback) {
+    sub.abr.Update(feedback);
+    const int64_t target = sub.abr.Target().bitrate;
+    int layer = 0;
+    while (layer + 1 < static_cast<int>(layers_.size()) && layers_[layer]->max_bitrate > target) layer++;
+
+    DestinationState& state = *sub.state;
+    if (state.requested.exchange(layer, std::memory_order_relaxed) != layer) {
+        layer_switches_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 新层的关键帧到达前每个周期重新请求一次 (编码线程按最小间隔限流)
+    if (state.active.load(std::memory_order_relaxed) != layer) RequestKeyframe(layer);
+}
+
+// 只编码一路码流时按最差的订阅者调整: 丢包率取最高者，RTT取排队时延最大者，带宽取最小者。
+// 同播时各订阅者先按自己的反馈选层，汇总结果只用于统计
+NetworkFeedback SenderEngine::CollectFeedback(uint64_t now_us) {
+    NetworkFeedback feedback;
+    memset(&feedback, 0, sizeof(feedback));
+    feedback.now_us = now_us;
+    double worst_loss = -1;
+    for (Subscriber& sub : subscribers_) {
+        const NetworkFeedback fb = SubscriberFeedback(sub, now_us);
+        if (layers_.size() > 1 && config_.adaptive) SelectLayer(sub, fb);
+
+        const uint32_t total = fb.acked + fb.lost;
+        const double loss = total ? static_cast<double>(fb.lost) / total : 0;
+        if (total && loss > worst_loss) {
+            worst_loss = loss;
+            feedback.acked = fb.acked;
+            feedback.lost = fb.lost;
+        }
+        if (fb.srtt_us == 0) continue;
+        if (feedback.srtt_us == 0 || fb.srtt_us - fb.min_rtt_us > feedback.srtt_us - feedback.min_rtt_us) {
+            feedback.srtt_us = fb.srtt_us;
+            feedback.min_rtt_us = fb.min_rtt_us;
+        }
+        if (feedback.bandwidth_bps == 0 || fb.bandwidth_bps < feedback.bandwidth_bps) {
+            feedback.bandwidth_bps = fb.bandwidth_bps;
+        }
+    }
+    return feedback;
+}
+
+// 把定时线程报告的丢包计入对应订阅者 (已移除的订阅者忽略)，开启重传时从缓冲区原样重发
+void SenderEngine::CollectLosses() {
+    lost_scratch_.clear();
+    {
+        std::lock_guard<std::mutex> lock(lost_mutex_);
+        lost_scratch_.swap(lost_packets_);
+    }
+    for (const LostPacket& loss : lost_scratch_) {
+        for (Subscriber& sub : subscribers_) {
+            if (sub.session->GetSessionId() != loss.first) continue;
+            sub.lost++;
+            if (sub.session->GetRetransmitBuffer() && transport_.Retransmit(sub.addr, *sub.session, loss.second) > 0) {
+                retransmits_.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+    }
+}
+
+// 每个轮询周期取走各订阅者超时未确认的包，每kAbrIntervalUs把确认/丢包计数与拥塞控制器的
+// RTT、带宽估计交给AbrController，目标变化时发布给缩放与编码线程
+void SenderEngine::FeedbackLoop() {
+    const ReceiveHandler handler = [this](const uint8_t* data, size_t len, const sockaddr_in& from) {
+        OnControlPacket(data, len, from);
+    };
+    uint64_t next_update = CongestionController::NowMicros() + kAbrIntervalUs;
+    while (!stop_.load(std::memory_order_relaxed) && !finished_.load(std::memory_order_acquire)) {
+        if (transport_.PollReceive(kFeedbackPollMs, handler) < 0) {
+            LOG_ERROR("Receive failed, adaptive bitrate disabled");
+            return;
+        }
+        CollectLosses();
+        const uint64_t now = CongestionController::NowMicros();
+        if (now < next_update) continue;
+        next_update = now + kAbrIntervalUs;
+
+        if (config_.fan_out) ExpireSubscribers(now);
+        const NetworkFeedback feedback = CollectFeedback(now);
+        if (config_.adaptive && layers_.size() == 1 && abr_.Update(feedback)) {
+            const EncoderTarget& target = abr_.Target();
+            layers_[0]->target_bitrate.store(target.bitrate, std::memory_order_relaxed);
+            layers_[0]->target_size.store(PackSize(target.width, target.height), std::memory_order_relaxed);
+        }
+        srtt_us_.store(feedback.srtt_us, std::memory_order_relaxed);
+        loss_.store(abr_.LastLoss(), std::memory_order_relaxed);
+    }
+}
+
+SenderStats SenderEngine::GetStats() const {
+    SenderStats s;
+    s.packets_read = packets_read_.load(std::memory_order_relaxed);
+    s.video_frames_decoded = video_frames_decoded_.load(std::memory_order_relaxed);
+    s.video_frames_encoded = video_frames_encoded_.load(std::memory_order_relaxed);
+    s.audio_frames_encoded = audio_frames_encoded_.load(std::memory_order_relaxed);
+    s.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    s.datagrams_sealed = datagrams_sealed_.load(std::memory_order_relaxed);
+    s.datagrams_sent = datagrams_sent_.load(std::memory_order_relaxed);
+    s.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    s.send_errors = send_errors_.load(std::memory_order_relaxed);
+    s.crypto_errors = crypto_errors_.load(std::memory_order_relaxed);
+    s.decode_waits = video_packets_.FullWaits() + audio_packets_.FullWaits();
+    s.scale_waits = 0;
+    s.encode_waits = 0;
+    s.packetize_waits = encoded_audio_.FullWaits();
+    for (const std::unique_ptr<VideoLayer>& layer : layers_) {
+        s.scale_waits += layer->decoded.FullWaits();
+        s.encode_waits += layer->scaled.FullWaits();
+        s.packetize_waits += layer->encoded.FullWaits();
+    }
+    s.crypto_waits = crypto_.SubmitWaits();
+    s.send_waits = send_waits_.load(std::memory_order_relaxed);
+    const uint32_t size = layers_[0]->target_size.load(std::memory_order_relaxed);
+    s.target_bitrate = layers_[0]->target_bitrate.load(std::memory_order_relaxed);
+    s.encode_width = static_cast<int>(size >> 16);
+    s.encode_height = static_cast<int>(size & 0xffff);
+    s.srtt_us = srtt_us_.load(std::memory_order_relaxed);
+    s.loss = loss_.load(std::memory_order_relaxed);
+    s.acks_received = acks_received_.load(std::memory_order_relaxed);
+    s.retransmits = retransmits_.load(std::memory_order_relaxed);
+    s.keyframe_requests = keyframe_requests_.load(std::memory_order_relaxed);
+    s.keyframes_forced = keyframes_forced_.load(std::memory_order_relaxed);
+    s.encoder_reopens = encoder_reopens_.load(std::memory_order_relaxed);
+    s.layer_switches = layer_switches_.load(std::memory_order_relaxed);
+    s.subscribers = subscriber_count_.load(std::memory_order_relaxed);
+    s.frame_pool = frame_pool_.GetStats();
+    s.packet_pool = packet_pool_.GetStats();
+    return s;
+}
@@ -0,0 +1,332 @@
+//流水线发送引擎声明
+
+#ifndef SENDER_ENGINE_H
+#define SENDER_ENGINE_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/audio_fifo.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include "../network/packets/packet_types.h"
+#include "../network/session/session_manager.h"
+#include "../network/transport/udp_transport.h"
+#include "../video/capture/media_source.h"
+#include "../video/encoder/abr_controller.h"
+#include "../video/processing/frame_pool.h"
+#include "../../utils/concurrency/ordered_worker_pool.h"
+#include "../../utils/concurrency/spsc_queue.h"
+
+// 编码档位: 低延迟为x264 zerolatency (无B帧、无前瞻、片级多线程、小VBV)，每输入一帧立即输出;
+// 画质档位保留前瞻与B帧，适合对延迟不敏感的点播
+enum class EncoderProfile { LowLatency, Quality };
+
+struct SenderConfig {
+    MediaSourceConfig source;
+    std::string target_ip = "127.0.0.1";
+    uint16_t target_port = 5002;
+    uint16_t local_port = 5003;        // 接收端向此端口发起密钥协商
+    TransportBackend backend = TransportBackend::Syscall;
+    uint32_t handshake_timeout_ms = 30000;   // 等待第一个接收端
+
+    // 扇出模式: 接受任意地址的订阅 (不限于target_ip)，数据报用组密钥加密一次后发给所有订阅者;
+    // 加密开销与订阅者数量无关，每个订阅者只多占一份发送与ACK处理
+    bool fan_out = false;
+    size_t max_subscribers = 64;
+    uint32_t subscriber_timeout_ms = 5000;   // 扇出模式下持续无反馈的订阅者被移除
+
+    int width = 1280;
+    int height = 720;
+    int fps = 30;
+    int64_t video_bitrate = 2500000;   // 码率上限; 开启自适应时在[min_video_bitrate, video_bitrate]内调整
+    int64_t min_video_bitrate = 300000;
+    bool adaptive = true;              // 按接收端ACK反馈调整码率与分辨率 (width/height为最高档)
+    EncoderProfile profile = EncoderProfile::LowLatency;
+    std::string preset;                // 空为按档位选择 (低延迟: veryfast, 画质: medium)
+    uint32_t min_keyframe_interval_ms = 500;   // 关键帧请求的最小响应间隔
+    // 每帧切片数 (0为编码器默认): 低延迟档位下各切片由切片线程并行编码; 分片按NAL边界切分，
+    // 接收端开启逐片解码时收到一个切片就可以开始解码，不必等整帧到齐
+    int video_slices = 0;
+
+    // 同播层数 (1~3): 按 1, 1/2, 1/4 分辨率各编码一路，订阅者按拥塞状态选层
+    size_t simulcast_layers = 1;
+
+    bool enable_audio = true;
+    int audio_sample_rate = 44100;
+    int64_t audio_bitrate = 128000;
+
+    size_t packet_queue_depth = 64;    // 压缩包队列 (采集->解码, 编码->分片)
+    size_t frame_queue_depth = 8;      // 原始帧队列 (解码->缩放->编码)，每帧约1.4MB
+    size_t datagram_slots = 4096;      // 预分配数据报槽位 (分片->加密->发送)
+    size_t crypto_workers = 0;         // 加密线程数，0为按核心数选择
+    // 视频发送速率上限 = pacing_gain * 编码码率 (0为不限速): 关键帧的突发被摊开，
+    // 内核发送队列保持很短，音频与控制包不会排在整个关键帧之后
+    double pacing_gain = 2.5;
+    // 每个订阅者的重传缓冲区 (slot_count为0则不重传): 发出的数据报连同改写后的包头一起保存，
+    // 重传定时器判定丢失后原样重发一次，不重新加密、不占用新seq
+    RetransmitConfig retransmit;
+    // 帧追踪: 每个视频帧的最后一个分片附带FrameTrace (采集、编码、加密、发送时刻)，接收端据此按阶段统计延迟
+    bool frame_trace = false;
+};
+
+// 各级计数; *_waits 为生产者因下游队列满而等待的次数，持续增长的一级之后就是瓶颈
+struct SenderStats {
+    uint64_t packets_read;
+    uint64_t video_frames_decoded;
+    uint64_t video_frames_encoded;
+    uint64_t audio_frames_encoded;
+    uint64_t frames_dropped;           // 设备输入时下游跟不上而丢弃的帧
+    uint64_t datagrams_sealed;         // 加密的数据报数 (扇出时每个数据报只加密一次)
+    uint64_t datagrams_sent;           // 实际发出的数据报数 (每个订阅者各计一次)
+    uint64_t bytes_sent;
+    uint64_t send_errors;
+    uint64_t crypto_errors;            // 封装失败 (会话密钥不可用等)，该数据报被丢弃
+    uint64_t decode_waits;
+    uint64_t scale_waits;
+    uint64_t encode_waits;
+    uint64_t packetize_waits;
+    uint64_t crypto_waits;             // 加密线程输入队列满 (加密跟不上)
+    uint64_t send_waits;               // 数据报槽位耗尽 (发送跟不上)
+    int64_t target_bitrate;            // 当前编码码率 (同播时为最高层)
+    int encode_width;
+    int encode_height;
+    uint32_t srtt_us;
+    double loss;                       // 最近一个反馈周期的丢包率
+    uint64_t acks_received;
+    uint64_t retransmits;
+    uint64_t keyframe_requests;
+    uint64_t keyframes_forced;
+    uint64_t encoder_reopens;          // 分辨率切换导致的编码器重建
+    uint64_t layer_switches;           // 同播: 订阅者换层次数
+    size_t subscribers;
+    PoolStats frame_pool;
+    PoolStats packet_pool;
+};
+
+// 发送端分级流水线: 采集/解码/缩放/编码/分片/发送各占一个线程，级间为有界SPSC队列，加密走保序线程池
+// 反馈线程处理ACK、关键帧请求与新订阅者握手，驱动拥塞控制与码率调整
+class SenderEngine {
+public:
+    explicit SenderEngine(const SenderConfig& config);
+    ~SenderEngine();
+
+    SenderEngine(const SenderEngine&) = delete;
+    SenderEngine& operator=(const SenderEngine&) = delete;
+
+    // 打开输入、编解码器与网络并启动各级线程
+    bool Start();
+    // 请求各级立即退出并回收队列中剩余的数据
+    void Stop();
+    // 等待输入播放完毕且所有数据报发出 (文件输入)
+    void Wait();
+    bool IsFinished() const { return finished_.load(std::memory_order_acquire); }
+
+    SenderStats GetStats() const;
+
+private:
+    static constexpr size_t kFragmentPayload = 1200;
+    static constexpr size_t kSendBatch = 64;
+    static constexpr int kAllLayers = -1;   // 音频数据报发给所有订阅者
+
+    // 一个分片在压缩包中的范围; unit_end表示分片结束于NAL边界
+    struct FragmentSpan {
+        size_t offset;
+        size_t len;
+        bool unit_end;
+    };
+
+    // 分片线程写入包头与明文，加密线程原地封装，len随之从明文包长变为密文包长 (0表示封装失败)
+    struct Datagram {
+        size_t len;
+        int layer;                     // 所属同播层，音频为kAllLayers
+        bool keyframe_start;           // 关键帧的第一个分片，订阅者可在此切换到该层
+        bool traced;                   // 封装后追加trace，发送线程填入发送时刻
+        FrameTrace trace;              // 网络字节序; 分片线程填入采集与编码时刻
+        uint8_t data[sizeof(PacketHeader) + kFragmentPayload + 16 + sizeof(FrameTrace)];   // 留出CBC填充与追踪扩展
+    };
+
+    using PacketQueue = utils::SpscQueue<AVPacket*>;
+    using FrameQueue = utils::SpscQueue<AVFrame*>;
+    using DatagramQueue = utils::SpscQueue<Datagram*>;
+    using CryptoPool = utils::OrderedWorkerPool<Datagram*>;
+
+    // 一路视频编码 (解码 -> 缩放 -> 编码 -> 分片); 不开同播时只有一层，由全局AbrController驱动
+    struct VideoLayer {
+        VideoLayer(const SenderConfig& config, int64_t bitrate, int width, int height);
+
+        int64_t max_bitrate;           // 同播时为本层的固定码率
+        AVCodecContext* encoder;       // 仅编码线程使用 (启动前由OpenCodecs创建)
+        SwsContext* sws_ctx;           // 仅缩放线程使用
+        int64_t last_pts;              // 仅编码线程使用
+        uint64_t last_keyframe_us;     // 仅编码线程使用: 上次强制关键帧的时间
+
+        // 反馈线程写，缩放/编码线程读; 分辨率按 (宽 << 16 | 高) 打包，保证两者同时更新
+        std::atomic<int64_t> target_bitrate;
+        std::atomic<uint32_t> target_size;
+        std::atomic<bool> keyframe_requested;
+
+        FrameQueue decoded;
+        FrameQueue scaled;
+        PacketQueue encoded;
+    };
+
+    // 发给一个订阅者的状态: 反馈线程写requested，发送线程在该层关键帧的第一个分片处切换active。
+    // 传输seq与各流的流内seq都由发送线程按订阅者实际收到的数据报连续分配
+    struct DestinationState {
+        std::atomic<int> requested{0};
+        std::atomic<int> active{-1};   // -1表示尚未收到任何一层的关键帧
+        uint32_t next_seq = 0;         // 以下仅发送线程使用
+        uint32_t next_stream_seq[MEDIA_STREAM_COUNT] = {};
+    };
+
+    // 等待第一个订阅者完成密钥协商，成功后session_可用
+    bool AcceptHandshake();
+    bool OpenCodecs();
+    AVCodecContext* OpenVideoEncoder(int width, int height, int64_t bitrate);
+    void SetRateControl(AVCodecContext* encoder, int64_t bitrate) const;
+    // 编码线程: 冲刷旧编码器后按新分辨率重建
+    bool ReopenVideoEncoder(VideoLayer& layer, int width, int height);
+    // 编码线程: 应用反馈线程给出的码率，处理关键帧请求
+    void ApplyEncoderTarget(VideoLayer& layer, AVFrame* frame);
+    void RequestKeyframe(int layer);
+    void CloseCodecs();
+    void JoinThreads();
+    void DrainQueues();
+
+    // 设备输入且item非结束标记时不阻塞，队列满则丢弃
+    bool ForwardPacket(PacketQueue& q, AVPacket* pkt, bool droppable);
+    bool ForwardFrame(FrameQueue& q, AVFrame* frame, bool droppable);
+
+    void CaptureLoop();
+    void VideoDecodeLoop();
+    void ScaleLoop(VideoLayer* layer);
+    void VideoEncodeLoop(VideoLayer* layer);
+    void AudioLoop();
+    void PacketizeLoop();
+    void SendLoop();
+    void Transmit(Datagram* const* batch, size_t count);   // 发送线程
+    int64_t VideoBitrate() const;
+    void FeedbackLoop();
+    void OnControlPacket(const uint8_t* data, size_t len, const sockaddr_in& from);
+
+    // 以下仅反馈线程使用 (AcceptHandshake在各线程启动前调用)
+    struct Subscriber;
+    Subscriber* FindSubscriber(const sockaddr_in& addr);
+    void AddSubscriber(const sockaddr_in& from, const uint8_t* data, size_t len);
+    void ExpireSubscribers(uint64_t now_us);
+    void PublishDestinations();
+    NetworkFeedback CollectFeedback(uint64_t now_us);
+    NetworkFeedback SubscriberFeedback(Subscriber& sub, uint64_t now_us);
+    void SelectLayer(Subscriber& sub, const NetworkFeedback& feedback);
+    void CollectLosses();
+
+    bool DrainEncoder(AVCodecContext* encoder, PacketQueue& out, std::atomic<uint64_t>& counter);
+    bool EncodeAudio(AVFrame* frame);
+    bool Packetize(AVPacket* pkt, int layer);
+    // Annex B码流按NAL单元装入分片，放不下的NAL按分片长度切开; 非Annex B数据按固定长度切分
+    static void SplitFragments(const uint8_t* data, size_t size, bool annexb, std::vector<FragmentSpan>* out);
+    void Seal(Datagram* dg);           // 加密线程
+
+    SenderConfig config_;
+    // 各级的AVFrame/AVPacket都从池中取用、用完归还; 须在编解码器之后析构
+    FramePool frame_pool_;
+    PacketPool packet_pool_;
+    MediaSource source_;
+    UdpTransport transport_;
+    sockaddr_in target_addr_;
+    // 封装数据报的会话: 扇出模式为组会话，否则为唯一接收端的点对点会话
+    SessionHandle session_;
+
+    // 点对点会话只用于ACK、RTT与丢包统计; 数据报的seq由session_统一分配 (同播时由发送线程按订阅者改写)
+    struct Subscriber {
+        sockaddr_in addr;
+        SessionHandle session;
+        uint64_t last_feedback_us;
+        uint32_t acked;                // 本反馈周期
+        uint32_t lost;
+        AbrController abr;             // 同播: 该订阅者的目标码率，据此选层
+        std::shared_ptr<DestinationState> state;
+    };
+    struct Destination {
+        sockaddr_in addr;
+        SessionHandle session;
+        std::shared_ptr<DestinationState> state;
+    };
+    using Destinations = std::vector<Destination>;
+    std::vector<Subscriber> subscribers_;
+    // 反馈线程在成员变化时整体替换，发送线程每批读取一次 (std::atomic_load/atomic_store)
+    std::shared_ptr<const Destinations> destinations_;
+
+    AVCodecContext* video_decoder_;
+    AVCodecContext* audio_decoder_;
+    AVCodecContext* audio_encoder_;
+    SwrContext* swr_ctx_;
+    AVAudioFifo* audio_fifo_;
+    AVFrame* resample_frame_;          // 重采样输出缓冲，按需增长
+    int64_t audio_next_pts_;           // 仅音频线程使用
+    AbrController abr_;                // 仅反馈线程使用
+    AbrConfig subscriber_abr_;         // 同播: 各订阅者AbrController的配置 (码率范围为各层码率)
+
+    std::vector<std::unique_ptr<VideoLayer>> layers_;   // 启动前建好，之后不增删
+    std::atomic<uint32_t> srtt_us_;
+    std::atomic<double> loss_;
+
+    PacketQueue video_packets_;
+    PacketQueue audio_packets_;
+    PacketQueue encoded_audio_;
+    CryptoPool crypto_;                // 分片线程提交，发送线程按提交顺序取回
+    DatagramQueue audio_datagrams_;    // 分片线程封装好的音频，发送线程优先取用
+    DatagramQueue free_datagrams_;     // 发送线程归还，分片线程取用
+    std::vector<Datagram> datagram_slab_;
+    std::vector<FragmentSpan> fragments_;   // 仅分片线程使用
+
+    // 仅发送线程使用: 每批按订阅者展开后的数据报、改写后的包头与发送记录
+    struct SentRecord {
+        SessionContext* session;
+        uint32_t seq;
+    };
+    std::vector<OutgoingPacket> send_out_;
+    std::vector<PacketHeader> send_headers_;
+    std::vector<SentRecord> send_records_;
+
+    // 定时线程判定丢失的包 (会话ID, seq)，反馈线程每个轮询周期取走后计入对应订阅者并按需重传
+    using LostPacket = std::pair<uint32_t, uint32_t>;
+    std::mutex lost_mutex_;
+    std::vector<LostPacket> lost_packets_;
+    std::vector<LostPacket> lost_scratch_;   // 仅反馈线程使用
+
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> finished_;
+
+    std::atomic<uint64_t> packets_read_;
+    std::atomic<uint64_t> video_frames_decoded_;
+    std::atomic<uint64_t> video_frames_encoded_;
+    std::atomic<uint64_t> audio_frames_encoded_;
+    std::atomic<uint64_t> frames_dropped_;
+    std::atomic<uint64_t> datagrams_sealed_;
+    std::atomic<uint64_t> datagrams_sent_;
+    std::atomic<uint64_t> bytes_sent_;
+    std::atomic<uint64_t> send_errors_;
+    std::atomic<uint64_t> crypto_errors_;
+    std::atomic<uint64_t> send_waits_;
+    std::atomic<uint64_t> acks_received_;
+    std::atomic<uint64_t> retransmits_;
+    std::atomic<uint64_t> keyframe_requests_;
+    std::atomic<uint64_t> keyframes_forced_;
+    std::atomic<uint64_t> encoder_reopens_;
+    std::atomic<uint64_t> layer_switches_;
+    std::atomic<size_t> subscriber_count_;
+};
+
+#endif
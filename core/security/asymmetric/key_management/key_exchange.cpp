@@ -0,0 +1,116 @@
+//SM2临时密钥协商实现
+
+#include "key_exchange.h"
+#include "../../crypto/random_generator.h"
+#include "../../crypto/sm3.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    const char kConfirmLabel[] = "gulugulu key confirm";
+
+    void Wipe(void* p, size_t len) {
+        volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+        for (size_t i = 0; i < len; ++i) v[i] = 0;
+    }
+}
+
+KeyExchange::KeyExchange() : ready_(false) {
+    memset(&key_pair_, 0, sizeof(key_pair_));
+    memset(nonce_, 0, sizeof(nonce_));
+}
+
+KeyExchange::~KeyExchange() {
+    KeyGenerator::Wipe(&key_pair_);
+}
+
+bool KeyExchange::Generate() {
+    ready_ = KeyGenerator::GenerateSm2KeyPair(&key_pair_) &&
+             utils::SecureRandom::GenerateSecureRandom(nonce_, sizeof(nonce_));
+    return ready_;
+}
+
+void KeyExchange::Kdf(const uint8_t* z, size_t z_len, uint8_t* out, size_t out_len) {
+    uint32_t ct = 1;
+    uint8_t block[32];
+    while (out_len > 0) {
+        uint8_t ct_be[4] = {
+            static_cast<uint8_t>(ct >> 24), static_cast<uint8_t>(ct >> 16),
+            static_cast<uint8_t>(ct >> 8), static_cast<uint8_t>(ct)
+        };
+        SM3_CTX ctx;
+        sm3_init(&ctx);
+        sm3_update(&ctx, z, z_len);
+        sm3_update(&ctx, ct_be, 4);
+        sm3_final(&ctx, block);
+
+        size_t n = out_len < sizeof(block) ? out_len : sizeof(block);
+        memcpy(out, block, n);
+        out += n;
+        out_len -= n;
+        ++ct;
+    }
+    Wipe(block, sizeof(block));
+}
+
+bool KeyExchange::ConstantTimeEqual(const uint8_t* a, const uint8_t* b, size_t len) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+bool KeyExchange::Derive(bool is_initiator,
+                         const uint8_t peer_public[SM2_POINT_SIZE],
+                         const uint8_t peer_nonce[KEY_EXCHANGE_NONCE_SIZE],
+                         uint32_t session_id,
+                         SessionKeyMaterial* keys,
+                         uint8_t confirm[KEY_EXCHANGE_CONFIRM_SIZE]) {
+    if (!ready_ || !peer_public || !peer_nonce || !keys || !confirm) return false;
+
+    uint8_t shared[SM2_POINT_SIZE];
+    if (!sm2_mul_point(key_pair_.private_key, peer_public, shared)) {
+        return false;  // 对端公钥不在曲线上
+    }
+
+    // 握手摘要: 发起方在前，双方得到相同的顺序
+    const uint8_t* init_nonce = is_initiator ? nonce_ : peer_nonce;
+    const uint8_t* resp_nonce = is_initiator ? peer_nonce : nonce_;
+    const uint8_t* init_pub = is_initiator ? key_pair_.public_key : peer_public;
+    const uint8_t* resp_pub = is_initiator ? peer_public : key_pair_.public_key;
+    uint8_t sid_be[4] = {
+        static_cast<uint8_t>(session_id >> 24), static_cast<uint8_t>(session_id >> 16),
+        static_cast<uint8_t>(session_id >> 8), static_cast<uint8_t>(session_id)
+    };
+    uint8_t transcript[32];
+    SM3_CTX ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, init_nonce, KEY_EXCHANGE_NONCE_SIZE);
+    sm3_update(&ctx, resp_nonce, KEY_EXCHANGE_NONCE_SIZE);
+    sm3_update(&ctx, init_pub, SM2_POINT_SIZE);
+    sm3_update(&ctx, resp_pub, SM2_POINT_SIZE);
+    sm3_update(&ctx, sid_be, 4);
+    sm3_final(&ctx, transcript);
+
+    // Z = x || y || 握手摘要 -> sm4_key(16) || sm3_salt(32) || confirm_key(32)
+    uint8_t z[64 + 32];
+    memcpy(z, shared + 1, 64);
+    memcpy(z + 64, transcript, 32);
+    uint8_t okm[16 + 32 + 32];
+    Kdf(z, sizeof(z), okm, sizeof(okm));
+    memcpy(keys->sm4_key, okm, 16);
+    memcpy(keys->sm3_salt, okm + 16, 32);
+
+    sm3_init(&ctx);
+    sm3_update(&ctx, okm + 48, 32);
+    sm3_update(&ctx, reinterpret_cast<const uint8_t*>(kConfirmLabel), sizeof(kConfirmLabel) - 1);
+    sm3_update(&ctx, transcript, 32);
+    sm3_final(&ctx, confirm);
+
+    Wipe(shared, sizeof(shared));
+    Wipe(z, sizeof(z));
+    Wipe(okm, sizeof(okm));
+    // 临时私钥只使用一次
+    KeyGenerator::Wipe(&key_pair_);
+    ready_ = false;
+    return true;
+}
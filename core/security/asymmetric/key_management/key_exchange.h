@@ -0,0 +1,53 @@
+//SM2临时密钥协商声明
+
+#ifndef KEY_EXCHANGE_H
+#define KEY_EXCHANGE_H
+
+#include <cstdint>
+#include "key_generator.h"
+
+#define KEY_EXCHANGE_NONCE_SIZE 16
+#define KEY_EXCHANGE_CONFIRM_SIZE 32
+
+// 握手派生出的会话密钥
+struct SessionKeyMaterial {
+    uint8_t sm4_key[16];
+    uint8_t sm3_salt[32];
+};
+
+// 临时SM2密钥交换: 共享点与握手摘要经SM3-KDF派生会话密钥，应答方发出确认值
+class KeyExchange {
+public:
+    KeyExchange();
+    ~KeyExchange();
+
+    KeyExchange(const KeyExchange&) = delete;
+    KeyExchange& operator=(const KeyExchange&) = delete;
+
+    // 生成临时密钥对和随机数
+    bool Generate();
+
+    const uint8_t* PublicKey() const { return key_pair_.public_key; }
+    const uint8_t* Nonce() const { return nonce_; }
+
+    // 发起方 is_initiator=true。peer_public须已通过曲线校验 (内部会再次校验)
+    bool Derive(bool is_initiator,
+                const uint8_t peer_public[SM2_POINT_SIZE],
+                const uint8_t peer_nonce[KEY_EXCHANGE_NONCE_SIZE],
+                uint32_t session_id,
+                SessionKeyMaterial* keys,
+                uint8_t confirm[KEY_EXCHANGE_CONFIRM_SIZE]);
+
+    // SM3计数器模式KDF (GB/T 32918.4)
+    static void Kdf(const uint8_t* z, size_t z_len, uint8_t* out, size_t out_len);
+
+    // 常量时间比较
+    static bool ConstantTimeEqual(const uint8_t* a, const uint8_t* b, size_t len);
+
+private:
+    Sm2KeyPair key_pair_;
+    uint8_t nonce_[KEY_EXCHANGE_NONCE_SIZE];
+    bool ready_;
+};
+
+#endif
@@ -0,0 +1,27 @@
+//SM2密钥对生成实现
+
+#include "key_generator.h"
+#include "../../crypto/random_generator.h"
+#include <cstring>
+
+bool KeyGenerator::GenerateSm2KeyPair(Sm2KeyPair* key_pair) {
+    if (!key_pair) return false;
+
+    // n 接近 2^256，拒绝概率约 2^-32
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        if (!utils::SecureRandom::GenerateSecureRandom(key_pair->private_key, SM2_SCALAR_SIZE)) {
+            return false;
+        }
+        if (sm2_scalar_is_valid(key_pair->private_key)) {
+            return sm2_mul_base(key_pair->private_key, key_pair->public_key);
+        }
+    }
+    Wipe(key_pair);
+    return false;
+}
+
+void KeyGenerator::Wipe(Sm2KeyPair* key_pair) {
+    if (!key_pair) return;
+    volatile uint8_t* p = key_pair->private_key;
+    for (size_t i = 0; i < SM2_SCALAR_SIZE; ++i) p[i] = 0;
+}
@@ -0,0 +1,23 @@
+//SM2密钥对生成声明
+
+#ifndef KEY_GENERATOR_H
+#define KEY_GENERATOR_H
+
+#include <cstdint>
+#include "../sm2_curve.h"
+
+struct Sm2KeyPair {
+    uint8_t private_key[SM2_SCALAR_SIZE];
+    uint8_t public_key[SM2_POINT_SIZE];   // 未压缩编码
+};
+
+class KeyGenerator {
+public:
+    // 私钥在 [1, n-1] 内均匀选取 (拒绝采样)，公钥 = d * G
+    static bool GenerateSm2KeyPair(Sm2KeyPair* key_pair);
+
+    // 清除私钥
+    static void Wipe(Sm2KeyPair* key_pair);
+};
+
+#endif
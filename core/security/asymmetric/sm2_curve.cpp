@@ -0,0 +1,489 @@
+
+#include "sm2_curve.h"
+#include <string.h>
+#include <mutex>
+
+// 域元素: 4个64位limb (小端)，运算中保持Montgomery形式 (aR mod p)
+// 所有涉及秘密标量的分支均以掩码选择代替
+namespace {
+
+typedef unsigned __int128 u128;
+typedef uint64_t fe[4];
+
+const fe P = {0xffffffffffffffffULL, 0xffffffff00000000ULL, 0xffffffffffffffffULL, 0xfffffffeffffffffULL};
+const fe N = {0x53bbf40939d54123ULL, 0x7203df6b21c6052bULL, 0xffffffffffffffffULL, 0xfffffffeffffffffULL};
+const fe R2 = {0x0000000200000003ULL, 0x00000002ffffffffULL, 0x0000000100000001ULL, 0x0000000400000002ULL};
+const fe ONE = {0x0000000000000001ULL, 0x00000000ffffffffULL, 0x0000000000000000ULL, 0x0000000100000000ULL};
+const fe B_MONT = {0x90d230632bc0dd42ULL, 0x71cf379ae9b537abULL, 0x527981505ea51c3cULL, 0x240fe188ba20e2c8ULL};
+const uint64_t N0 = 1;   // -p^-1 mod 2^64
+
+const uint8_t GX[32] = {
+    0x32, 0xC4, 0xAE, 0x2C, 0x1F, 0x19, 0x81, 0x19, 0x5F, 0x99, 0x04, 0x46, 0x6A, 0x39, 0xC9, 0x94,
+    0x8F, 0xE3, 0x0B, 0xBF, 0xF2, 0x66, 0x0B, 0xE1, 0x71, 0x5A, 0x45, 0x89, 0x33, 0x4C, 0x74, 0xC7};
+const uint8_t GY[32] = {
+    0xBC, 0x37, 0x36, 0xA2, 0xF4, 0xF6, 0x77, 0x9C, 0x59, 0xBD, 0xCE, 0xE3, 0x6B, 0x69, 0x21, 0x53,
+    0xD0, 0xA9, 0x87, 0x7C, 0xC6, 0x2A, 0x47, 0x40, 0x02, 0xDF, 0x32, 0xE5, 0x21, 0x39, 0xF0, 0xA0};
+
+//------------------- 域运算 -------------------
+inline void fe_copy(fe r, const fe a) {
+    r[0] = a[0]; r[1] = a[1]; r[2] = a[2]; r[3] = a[3];
+}
+
+// mask为全1时 r = a
+inline void fe_cmov(fe r, const fe a, uint64_t mask) {
+    for (int i = 0; i < 4; ++i) r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+inline uint64_t fe_is_zero(const fe a) {
+    uint64_t t = a[0] | a[1] | a[2] | a[3];
+    return ((t | (0 - t)) >> 63) - 1;   // 为0时返回全1
+}
+
+inline uint64_t fe_equal(const fe a, const fe b) {
+    fe t = {a[0] ^ b[0], a[1] ^ b[1], a[2] ^ b[2], a[3] ^ b[3]};
+    return fe_is_zero(t);
+}
+
+// r = t - m，返回借位
+inline uint64_t sub4(fe r, const uint64_t t[4], const fe m) {
+    u128 d;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        d = (u128)t[i] - m[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return borrow;
+}
+
+void fe_add(fe r, const fe a, const fe b) {
+    uint64_t t[4];
+    u128 c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += (u128)a[i] + b[i];
+        t[i] = (uint64_t)c;
+        c >>= 64;
+    }
+    uint64_t carry = (uint64_t)c;
+    fe s;
+    uint64_t borrow = sub4(s, t, P);
+    // 无进位且减p借位时保留t
+    uint64_t keep = 0 - ((carry ^ 1) & borrow);
+    for (int i = 0; i < 4; ++i) r[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+void fe_sub(fe r, const fe a, const fe b) {
+    uint64_t borrow = sub4(r, a, b);
+    uint64_t mask = 0 - borrow;
+    u128 c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += (u128)r[i] + (P[i] & mask);
+        r[i] = (uint64_t)c;
+        c >>= 64;
+    }
+}
+
+// Montgomery乘法 (CIOS): r = a * b * R^-1 mod p
+void fe_mul(fe r, const fe a, const fe b) {
+    uint64_t t[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        u128 c = 0;
+        for (int j = 0; j < 4; ++j) {
+            c += (u128)a[j] * b[i] + t[j];
+            t[j] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[4];
+        t[4] = (uint64_t)c;
+        t[5] = (uint64_t)(c >> 64);
+
+        uint64_t m = t[0] * N0;
+        c = (u128)m * P[0] + t[0];
+        c >>= 64;
+        for (int j = 1; j < 4; ++j) {
+            c += (u128)m * P[j] + t[j];
+            t[j - 1] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[4];
+        t[3] = (uint64_t)c;
+        t[4] = t[5] + (uint64_t)(c >> 64);
+    }
+
+    fe s;
+    uint64_t borrow = sub4(s, t, P);
+    uint64_t keep = 0 - ((t[4] ^ 1) & borrow);
+    for (int i = 0; i < 4; ++i) r[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+inline void fe_sqr(fe r, const fe a) { fe_mul(r, a, a); }
+
+inline void fe_to_mont(fe r, const fe a) { fe_mul(r, a, R2); }
+
+inline void fe_from_mont(fe r, const fe a) {
+    const fe one = {1, 0, 0, 0};
+    fe_mul(r, a, one);
+}
+
+// r = a^(p-2)，指数公开，运算序列固定
+void fe_inv(fe r, const fe a) {
+    fe e;
+    const fe two = {2, 0, 0, 0};
+    sub4(e, P, two);
+    fe acc;
+    fe_copy(acc, ONE);
+    for (int i = 255; i >= 0; --i) {
+        fe_sqr(acc, acc);
+        if ((e[i / 64] >> (i % 64)) & 1) fe_mul(acc, acc, a);
+    }
+    fe_copy(r, acc);
+}
+
+void fe_from_bytes(fe r, const uint8_t b[32]) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; ++j) v = (v << 8) | b[(3 - i) * 8 + j];
+        r[i] = v;
+    }
+}
+
+void fe_to_bytes(uint8_t b[32], const fe a) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) b[(3 - i) * 8 + j] = (uint8_t)(a[i] >> (56 - 8 * j));
+    }
+}
+
+// a < m (公开数据，可分支)
+bool less_than(const fe a, const fe m) {
+    fe t;
+    return sub4(t, a, m) == 1;
+}
+
+//------------------- 点运算 (Jacobian坐标, a = -3) -------------------
+struct JacPoint { fe X, Y, Z; };   // Z = 0 表示无穷远点
+struct AffPoint { fe x, y; };
+
+void point_cmov(JacPoint* r, const JacPoint* a, uint64_t mask) {
+    fe_cmov(r->X, a->X, mask);
+    fe_cmov(r->Y, a->Y, mask);
+    fe_cmov(r->Z, a->Z, mask);
+}
+
+// dbl-2001-b
+void point_double(JacPoint* r, const JacPoint* p) {
+    fe delta, gamma, beta, alpha, t0, t1;
+    fe_sqr(delta, p->Z);
+    fe_sqr(gamma, p->Y);
+    fe_mul(beta, p->X, gamma);
+    fe_sub(t0, p->X, delta);
+    fe_add(t1, p->X, delta);
+    fe_mul(alpha, t0, t1);
+    fe_add(t0, alpha, alpha);
+    fe_add(alpha, t0, alpha);
+
+    fe_add(t0, p->Y, p->Z);          // Z3 = (Y+Z)^2 - gamma - delta
+    fe_sqr(t0, t0);
+    fe_sub(t0, t0, gamma);
+    fe_sub(r->Z, t0, delta);
+
+    fe_add(t0, beta, beta);          // 4beta
+    fe_add(t0, t0, t0);
+    fe_add(t1, t0, t0);              // 8beta
+    fe X3;
+    fe_sqr(X3, alpha);
+    fe_sub(X3, X3, t1);
+
+    fe_sub(t0, t0, X3);
+    fe_mul(t0, alpha, t0);
+    fe_sqr(gamma, gamma);            // 8gamma^2
+    fe_add(gamma, gamma, gamma);
+    fe_add(gamma, gamma, gamma);
+    fe_add(gamma, gamma, gamma);
+    fe_sub(r->Y, t0, gamma);
+    fe_copy(r->X, X3);
+}
+
+// add-2007-bl; 输入相等时结果错误 (调用方保证不会出现或自行处理)
+void point_add(JacPoint* r, const JacPoint* p, const JacPoint* q) {
+    fe z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+    fe_sqr(z1z1, p->Z);
+    fe_sqr(z2z2, q->Z);
+    fe_mul(u1, p->X, z2z2);
+    fe_mul(u2, q->X, z1z1);
+    fe_mul(s1, p->Y, q->Z);
+    fe_mul(s1, s1, z2z2);
+    fe_mul(s2, q->Y, p->Z);
+    fe_mul(s2, s2, z1z1);
+    fe_sub(h, u2, u1);
+    fe_add(i, h, h);
+    fe_sqr(i, i);
+    fe_mul(j, h, i);
+    fe_sub(rr, s2, s1);
+    fe_add(rr, rr, rr);
+    fe_mul(v, u1, i);
+
+    JacPoint out;
+    fe_sqr(out.X, rr);
+    fe_sub(out.X, out.X, j);
+    fe_sub(out.X, out.X, v);
+    fe_sub(out.X, out.X, v);
+
+    fe_sub(t, v, out.X);
+    fe_mul(out.Y, rr, t);
+    fe_mul(t, s1, j);
+    fe_add(t, t, t);
+    fe_sub(out.Y, out.Y, t);
+
+    fe_add(t, p->Z, q->Z);
+    fe_sqr(t, t);
+    fe_sub(t, t, z1z1);
+    fe_sub(t, t, z2z2);
+    fe_mul(out.Z, t, h);
+
+    // 任一输入为无穷远点时返回另一个
+    point_cmov(&out, q, fe_is_zero(p->Z));
+    point_cmov(&out, p, fe_is_zero(q->Z));
+    *r = out;
+}
+
+// madd-2007-bl: q为仿射点
+void point_add_affine(JacPoint* r, const JacPoint* p, const AffPoint* q) {
+    fe z1z1, u2, s2, h, hh, i, j, rr, v, t;
+    fe_sqr(z1z1, p->Z);
+    fe_mul(u2, q->x, z1z1);
+    fe_mul(s2, q->y, p->Z);
+    fe_mul(s2, s2, z1z1);
+    fe_sub(h, u2, p->X);
+    fe_sqr(hh, h);
+    fe_add(i, hh, hh);
+    fe_add(i, i, i);
+    fe_mul(j, h, i);
+    fe_sub(rr, s2, p->Y);
+    fe_add(rr, rr, rr);
+    fe_mul(v, p->X, i);
+
+    JacPoint out;
+    fe_sqr(out.X, rr);
+    fe_sub(out.X, out.X, j);
+    fe_sub(out.X, out.X, v);
+    fe_sub(out.X, out.X, v);
+
+    fe_sub(t, v, out.X);
+    fe_mul(out.Y, rr, t);
+    fe_mul(t, p->Y, j);
+    fe_add(t, t, t);
+    fe_sub(out.Y, out.Y, t);
+
+    fe_add(t, p->Z, h);
+    fe_sqr(t, t);
+    fe_sub(t, t, z1z1);
+    fe_sub(out.Z, t, hh);
+
+    JacPoint qj;
+    fe_copy(qj.X, q->x);
+    fe_copy(qj.Y, q->y);
+    fe_copy(qj.Z, ONE);
+    point_cmov(&out, &qj, fe_is_zero(p->Z));
+    *r = out;
+}
+
+// 仅用于公开数据 (预计算表): 处理相等输入
+void point_add_public(JacPoint* r, const JacPoint* p, const JacPoint* q) {
+    fe z1z1, z2z2, u1, u2, s1, s2;
+    fe_sqr(z1z1, p->Z);
+    fe_sqr(z2z2, q->Z);
+    fe_mul(u1, p->X, z2z2);
+    fe_mul(u2, q->X, z1z1);
+    fe_mul(s1, p->Y, q->Z);
+    fe_mul(s1, s1, z2z2);
+    fe_mul(s2, q->Y, p->Z);
+    fe_mul(s2, s2, z1z1);
+    if (!fe_is_zero(p->Z) && !fe_is_zero(q->Z) && fe_equal(u1, u2) && fe_equal(s1, s2)) {
+        point_double(r, p);
+        return;
+    }
+    point_add(r, p, q);
+}
+
+void point_to_affine(AffPoint* r, const JacPoint* p) {
+    fe zinv, zinv2;
+    fe_inv(zinv, p->Z);
+    fe_sqr(zinv2, zinv);
+    fe_mul(r->x, p->X, zinv2);
+    fe_mul(zinv2, zinv2, zinv);
+    fe_mul(r->y, p->Y, zinv2);
+}
+
+bool point_decode(AffPoint* r, const uint8_t in[SM2_POINT_SIZE]) {
+    if (in[0] != 0x04) return false;
+    fe x, y;
+    fe_from_bytes(x, in + 1);
+    fe_from_bytes(y, in + 33);
+    if (!less_than(x, P) || !less_than(y, P)) return false;
+    fe_to_mont(r->x, x);
+    fe_to_mont(r->y, y);
+
+    // y^2 = x^3 - 3x + b
+    fe lhs, rhs, t;
+    fe_sqr(lhs, r->y);
+    fe_sqr(rhs, r->x);
+    fe_mul(rhs, rhs, r->x);
+    fe_add(t, r->x, r->x);
+    fe_add(t, t, r->x);
+    fe_sub(rhs, rhs, t);
+    fe_add(rhs, rhs, B_MONT);
+    return fe_equal(lhs, rhs) != 0;
+}
+
+void point_encode(uint8_t out[SM2_POINT_SIZE], const AffPoint* p) {
+    fe x, y;
+    fe_from_mont(x, p->x);
+    fe_from_mont(y, p->y);
+    out[0] = 0x04;
+    fe_to_bytes(out + 1, x);
+    fe_to_bytes(out + 33, y);
+}
+
+// 标量的第i个4比特窗口 (0为最低位)
+inline uint32_t scalar_digit(const uint8_t k[32], int i) {
+    uint8_t byte = k[31 - i / 2];
+    return (i & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+inline uint64_t digit_equal(uint32_t a, uint32_t b) {
+    uint64_t t = a ^ b;
+    return ((t | (0 - t)) >> 63) - 1;
+}
+
+//------------------- 固定基预计算表 -------------------
+// table[i][j] = (j+1) * 16^i * G，共64行x15列仿射点
+const int kWindows = 64;
+const int kWindowSize = 15;
+AffPoint g_base_table[kWindows][kWindowSize];
+std::once_flag g_table_once;
+
+void build_base_table() {
+    AffPoint g;
+    uint8_t enc[SM2_POINT_SIZE];
+    enc[0] = 0x04;
+    memcpy(enc + 1, GX, 32);
+    memcpy(enc + 33, GY, 32);
+    point_decode(&g, enc);
+
+    static JacPoint jac[kWindows * kWindowSize];
+    JacPoint base;
+    fe_copy(base.X, g.x);
+    fe_copy(base.Y, g.y);
+    fe_copy(base.Z, ONE);
+    for (int i = 0; i < kWindows; ++i) {
+        jac[i * kWindowSize] = base;
+        for (int j = 1; j < kWindowSize; ++j) {
+            point_add_public(&jac[i * kWindowSize + j], &jac[i * kWindowSize + j - 1], &base);
+        }
+        for (int d = 0; d < 4; ++d) point_double(&base, &base);
+    }
+
+    // 批量求逆 (Montgomery技巧): 一次求逆换算全部Z
+    const int total = kWindows * kWindowSize;
+    static fe prefix[kWindows * kWindowSize];
+    fe_copy(prefix[0], jac[0].Z);
+    for (int i = 1; i < total; ++i) fe_mul(prefix[i], prefix[i - 1], jac[i].Z);
+    fe inv;
+    fe_inv(inv, prefix[total - 1]);
+    for (int i = total - 1; i >= 0; --i) {
+        fe zinv, zinv2;
+        if (i > 0) {
+            fe_mul(zinv, inv, prefix[i - 1]);
+            fe_mul(inv, inv, jac[i].Z);
+        } else {
+            fe_copy(zinv, inv);
+        }
+        AffPoint* out = &g_base_table[i / kWindowSize][i % kWindowSize];
+        fe_sqr(zinv2, zinv);
+        fe_mul(out->x, jac[i].X, zinv2);
+        fe_mul(zinv2, zinv2, zinv);
+        fe_mul(out->y, jac[i].Y, zinv2);
+    }
+}
+
+bool finish(uint8_t out[SM2_POINT_SIZE], const JacPoint* r) {
+    if (fe_is_zero(r->Z)) return false;
+    AffPoint a;
+    point_to_affine(&a, r);
+    point_encode(out, &a);
+    return true;
+}
+
+}  // namespace
+
+//------------------- 接口函数 -------------------
+bool sm2_scalar_is_valid(const uint8_t k[SM2_SCALAR_SIZE]) {
+    fe s;
+    fe_from_bytes(s, k);
+    return !fe_is_zero(s) && less_than(s, N);
+}
+
+bool sm2_point_is_valid(const uint8_t point[SM2_POINT_SIZE]) {
+    AffPoint p;
+    return point && point_decode(&p, point);
+}
+
+void sm2_precompute(void) {
+    std::call_once(g_table_once, build_base_table);
+}
+
+bool sm2_mul_base(const uint8_t k[SM2_SCALAR_SIZE], uint8_t out[SM2_POINT_SIZE]) {
+    if (!k || !out || !sm2_scalar_is_valid(k)) return false;
+    sm2_precompute();
+
+    // k < n 时各窗口的部分和互不相等，混合加法不会遇到倍点情形
+    JacPoint r;
+    memset(&r, 0, sizeof(r));
+    for (int i = 0; i < kWindows; ++i) {
+        uint32_t d = scalar_digit(k, i);
+        AffPoint sel;
+        memset(&sel, 0, sizeof(sel));
+        for (int j = 0; j < kWindowSize; ++j) {
+            uint64_t m = digit_equal(d, (uint32_t)(j + 1));
+            fe_cmov(sel.x, g_base_table[i][j].x, m);
+            fe_cmov(sel.y, g_base_table[i][j].y, m);
+        }
+        JacPoint sum;
+        point_add_affine(&sum, &r, &sel);
+        point_cmov(&r, &sum, ~digit_equal(d, 0));
+    }
+    return finish(out, &r);
+}
+
+bool sm2_mul_point(const uint8_t k[SM2_SCALAR_SIZE], const uint8_t point[SM2_POINT_SIZE],
+                   uint8_t out[SM2_POINT_SIZE]) {
+    if (!k || !point || !out || !sm2_scalar_is_valid(k)) return false;
+    AffPoint p;
+    if (!point_decode(&p, point)) return false;
+
+    // table[j] = (j+1) * P
+    JacPoint table[kWindowSize];
+    fe_copy(table[0].X, p.x);
+    fe_copy(table[0].Y, p.y);
+    fe_copy(table[0].Z, ONE);
+    for (int j = 1; j < kWindowSize; ++j) {
+        point_add_public(&table[j], &table[j - 1], &table[0]);
+    }
+
+    JacPoint r;
+    memset(&r, 0, sizeof(r));
+    for (int i = kWindows - 1; i >= 0; --i) {
+        for (int d = 0; d < 4; ++d) point_double(&r, &r);
+
+        uint32_t d = scalar_digit(k, i);
+        JacPoint sel;
+        memset(&sel, 0, sizeof(sel));
+        for (int j = 0; j < kWindowSize; ++j) {
+            point_cmov(&sel, &table[j], digit_equal(d, (uint32_t)(j + 1)));
+        }
+        JacPoint sum;
+        point_add(&sum, &r, &sel);
+        point_cmov(&r, &sum, ~digit_equal(d, 0));
+    }
+    return finish(out, &r);
+}
@@ -0,0 +1,36 @@
+#ifndef SM2_CURVE_H
+#define SM2_CURVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SM2 推荐曲线 (sm2p256v1) 上的标量乘法
+// 点编码: 未压缩格式 04 || X(32字节) || Y(32字节)，标量为32字节大端
+#define SM2_POINT_SIZE 65
+#define SM2_SCALAR_SIZE 32
+
+// 标量是否在 [1, n-1] 内
+bool sm2_scalar_is_valid(const uint8_t k[SM2_SCALAR_SIZE]);
+
+// 点是否为曲线上的有限点 (对端公钥必须先校验)
+bool sm2_point_is_valid(const uint8_t point[SM2_POINT_SIZE]);
+
+// out = k * G，使用固定基预计算表 (首次调用时构建，约64KB)
+bool sm2_mul_base(const uint8_t k[SM2_SCALAR_SIZE], uint8_t out[SM2_POINT_SIZE]);
+
+// out = k * P，4比特固定窗口; 两种乘法的执行路径与访存模式均不依赖k
+bool sm2_mul_point(const uint8_t k[SM2_SCALAR_SIZE], const uint8_t point[SM2_POINT_SIZE],
+                   uint8_t out[SM2_POINT_SIZE]);
+
+// 提前构建固定基预计算表，避免首个握手承担建表开销
+void sm2_precompute(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
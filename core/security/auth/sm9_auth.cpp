@@ -0,0 +1,468 @@
+//SM9标识签名实现
+
+#include "sm9_auth.h"
+#include "sm9_pairing.h"
+#include "../crypto/random_generator.h"
+#include "../crypto/sm3.h"
+#include <string.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char kHexP[] = "B640000002A3A6F1D603AB4FF58EC74521F2934B1A7AEEDBE56F9B27E351457D";
+const char kHexN[] = "B640000002A3A6F1D603AB4FF58EC74449F2934B18EA8BEEE56EE19CD69ECF25";
+const char kHexGx[] = "93DE051D62BF718FF5ED0704487D01D6E1E4086909DC3280E8C4E4817C66DDDD";
+const char kHexGy[] = "21FE8DDA4F21E607631065125C395BBC1C1C00CBFA6024350C464CD70A3EA616";
+
+// GM/T 0044-2016 第5部分 A.1 签名示例
+const char kKatMasterPriv[] = "000130E78459D78545CB54C587E02CF480CE0B66340F319F348A1D5B1F2DC5F4";
+const char kKatMasterPub[] =
+    "9F64080B3084F733E48AFF4B41B565011CE0711C5E392CFB0AB1B6791B94C408"
+    "29DBA116152D1F786CE843ED24A3B573414D2177386A92DD8F14D65696EA5E32"
+    "69850938ABEA0112B57329F447E3A0CBAD3E2FDB1A77F335E89E1408D0EF1C25"
+    "41E00A53DDA532DA1A7CE027B7A46F741006E85F5CDFF0730E75C05FB4E3216D";
+const char kKatId[] = "Alice";
+const char kKatMsg[] = "Chinese IBS standard";
+const char kKatUserPriv[] =
+    "A5702F05CF1315305E2D6EB64B0DEB923DB1A0BCF0CAFF90523AC8754AA69820"
+    "78559A844411F9825C109F5EE3F52D720DD01785392A727BB1556952B2B013D3";
+const char kKatNonce[] = "00033C8616B06704813203DFD00965022ED15975C662337AED648835DC4B1CBE";
+const char kKatH[] = "823C4B21E4BD2DFE1ED92C606653E996668563152FC33F55D7BFBB9BD9705ADB";
+const char kKatS[] =
+    "73BF96923CE58B6AD0E13E9643A406D8EB98417C50EF1B29CEF9ADB48B6D598C"
+    "856712F1C2E0968AB7769F42A99586AED139D5B8B3E15891827CC2ACED9BAA05";
+
+const size_t kMaxMasters = 8;   // 每个主公钥的表约370KB
+
+void Wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    for (size_t i = 0; i < len; ++i) v[i] = 0;
+}
+
+// 十六进制串解码为 prefix || bytes，prefix < 0 时不加前缀
+void HexDecode(const char* hex, int prefix, uint8_t* out) {
+    size_t pos = 0;
+    if (prefix >= 0) out[pos++] = static_cast<uint8_t>(prefix);
+    for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+        char byte[3] = {hex[i], hex[i + 1], 0};
+        out[pos++] = static_cast<uint8_t>(strtoul(byte, NULL, 16));
+    }
+}
+
+const BIGNUM* Order() {
+    static BIGNUM* n = [] {
+        BIGNUM* v = NULL;
+        BN_hex2bn(&v, kHexN);
+        return v;
+    }();
+    return n;
+}
+
+// 主公钥上下文: Ppub-s 与 g = e(P1, Ppub-s) 的固定底数表
+struct MasterContext {
+    sm9::G2Point ppub;
+    sm9::GtTable g_table;
+};
+
+class Sm9Cache {
+public:
+    static Sm9Cache& GetInstance() {
+        static Sm9Cache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const MasterContext> GetMaster(const uint8_t pub[SM9_G2_POINT_SIZE]);
+    std::shared_ptr<const sm9::G2Prepared> GetIdentity(const MasterContext& master,
+                                                       const uint8_t pub[SM9_G2_POINT_SIZE],
+                                                       const uint8_t* id, size_t id_len);
+    void SetCapacity(size_t entries);
+    void Clear();
+
+private:
+    typedef std::pair<std::string, std::shared_ptr<const sm9::G2Prepared>> Entry;
+
+    Sm9Cache() : capacity_(1024) {}
+
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const MasterContext>> masters_;
+    size_t capacity_;
+    std::list<Entry> lru_;   // 表头为最近使用
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+// H1/H2: Ha = SM3(prefix || Z || ct) 拼接取前 hlen = 320 比特，h = (Ha mod (n-1)) + 1
+bool HashToRange(uint8_t prefix, const uint8_t* z1, size_t z1_len,
+                 const uint8_t* z2, size_t z2_len, uint8_t out[SM9_SCALAR_SIZE]) {
+    uint8_t ha[64];
+    for (uint32_t ct = 1; ct <= 2; ++ct) {
+        uint8_t ct_be[4] = {
+            static_cast<uint8_t>(ct >> 24), static_cast<uint8_t>(ct >> 16),
+            static_cast<uint8_t>(ct >> 8), static_cast<uint8_t>(ct)
+        };
+        SM3_CTX ctx;
+        sm3_init(&ctx);
+        sm3_update(&ctx, &prefix, 1);
+        if (z1_len) sm3_update(&ctx, z1, z1_len);
+        if (z2_len) sm3_update(&ctx, z2, z2_len);
+        sm3_update(&ctx, ct_be, 4);
+        sm3_final(&ctx, ha + 32 * (ct - 1));
+    }
+
+    BN_CTX* bn_ctx = BN_CTX_new();
+    BIGNUM* h = BN_bin2bn(ha, 40, NULL);
+    BIGNUM* n1 = BN_dup(Order());
+    bool ok = bn_ctx && h && n1 && BN_sub_word(n1, 1) && BN_mod(h, h, n1, bn_ctx) &&
+              BN_add_word(h, 1) && BN_bn2binpad(h, out, SM9_SCALAR_SIZE) == SM9_SCALAR_SIZE;
+    BN_free(n1);
+    BN_free(h);
+    BN_CTX_free(bn_ctx);
+    return ok;
+}
+
+bool HashIdentity(const uint8_t* id, size_t id_len, uint8_t out[SM9_SCALAR_SIZE]) {
+    const uint8_t hid = SM9_HID_SIGN;
+    return HashToRange(0x01, id, id_len, &hid, 1, out);
+}
+
+bool HashMessage(const uint8_t* msg, size_t msg_len, const sm9::Fp12& w, uint8_t out[SM9_SCALAR_SIZE]) {
+    uint8_t wb[sm9::kGtSize];
+    sm9::gt_to_bytes(wb, w);
+    return HashToRange(0x02, msg, msg_len, wb, sizeof(wb), out);
+}
+
+// [1, n-1] 内均匀取值 (拒绝采样，n接近2^256)
+bool RandomScalar(uint8_t k[SM9_SCALAR_SIZE]) {
+    BIGNUM* v = BN_new();
+    bool ok = false;
+    for (int attempt = 0; v && attempt < 16 && !ok; ++attempt) {
+        if (!utils::SecureRandom::GenerateSecureRandom(k, SM9_SCALAR_SIZE)) break;
+        ok = BN_bin2bn(k, SM9_SCALAR_SIZE, v) && !BN_is_zero(v) && BN_cmp(v, Order()) < 0;
+    }
+    BN_clear_free(v);
+    return ok;
+}
+
+bool ScalarInRange(const uint8_t k[SM9_SCALAR_SIZE]) {
+    BIGNUM* v = BN_bin2bn(k, SM9_SCALAR_SIZE, NULL);
+    bool ok = v && !BN_is_zero(v) && BN_cmp(v, Order()) < 0;
+    BN_free(v);
+    return ok;
+}
+
+std::shared_ptr<const MasterContext> Sm9Cache::GetMaster(const uint8_t pub[SM9_G2_POINT_SIZE]) {
+    std::string key(reinterpret_cast<const char*>(pub), SM9_G2_POINT_SIZE);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = masters_.find(key);
+        if (it != masters_.end()) return it->second;
+    }
+
+    // 配对与建表约十毫秒，在锁外完成; 并发未命中时重复计算一次无妨
+    std::shared_ptr<MasterContext> ctx = std::make_shared<MasterContext>();
+    if (!sm9::g2_decode(&ctx->ppub, pub)) return nullptr;
+    sm9::Fp12 g;
+    sm9::pairing(&g, sm9::g1_generator(), ctx->ppub);
+    sm9::gt_precompute(&ctx->g_table, g);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (masters_.size() >= kMaxMasters) masters_.erase(masters_.begin());
+    return masters_.emplace(key, ctx).first->second;
+}
+
+std::shared_ptr<const sm9::G2Prepared> Sm9Cache::GetIdentity(const MasterContext& master,
+                                                            const uint8_t pub[SM9_G2_POINT_SIZE],
+                                                            const uint8_t* id, size_t id_len) {
+    std::string key(reinterpret_cast<const char*>(pub), SM9_G2_POINT_SIZE);
+    key.append(reinterpret_cast<const char*>(id), id_len);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+    }
+
+    // P = [H1(ID||hid)]P2 + Ppub-s
+    uint8_t h1[SM9_SCALAR_SIZE];
+    sm9::G2Point p;
+    if (!HashIdentity(id, id_len, h1) || !sm9::g2_mul(&p, h1, sm9::g2_generator()) ||
+        !sm9::g2_add(&p, p, master.ppub)) {
+        return nullptr;
+    }
+    std::shared_ptr<sm9::G2Prepared> prepared = std::make_shared<sm9::G2Prepared>();
+    sm9::g2_prepare(prepared.get(), p);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0 || index_.count(key)) return prepared;
+    lru_.emplace_front(key, prepared);
+    index_[key] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return prepared;
+}
+
+void Sm9Cache::SetCapacity(size_t entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = entries;
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+void Sm9Cache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    masters_.clear();
+    lru_.clear();
+    index_.clear();
+}
+
+// 验签中配对之前的部分: 校验 h、S，算出 t = g^h 与 Miller循环值
+struct PendingVerify {
+    sm9::Fp12 t;
+    sm9::Fp12 f;
+};
+
+bool BeginVerify(const MasterContext& master, const uint8_t pub[SM9_G2_POINT_SIZE],
+                 const uint8_t* id, size_t id_len, const SM9_SIGNATURE* sig, PendingVerify* out) {
+    if (!id || id_len == 0 || !sig || !ScalarInRange(sig->h)) return false;
+    sm9::G1Point s;
+    if (!sm9::g1_decode(&s, sig->s)) return false;
+    std::shared_ptr<const sm9::G2Prepared> prepared =
+        Sm9Cache::GetInstance().GetIdentity(master, pub, id, id_len);
+    if (!prepared) return false;
+
+    sm9::gt_pow(&out->t, master.g_table, sig->h);
+    sm9::miller_loop(&out->f, s, *prepared);
+    return true;
+}
+
+// u = e(S, P) 已完成最终幂; w' = u * t，比较 H2(M || w') 与 h
+bool FinishVerify(const PendingVerify& pending, const sm9::Fp12& u,
+                  const uint8_t* msg, size_t msg_len, const SM9_SIGNATURE* sig) {
+    sm9::Fp12 w;
+    sm9::gt_mul(&w, u, pending.t);
+    uint8_t h2[SM9_SCALAR_SIZE];
+    if (!HashMessage(msg, msg_len, w, h2)) return false;
+    return memcmp(h2, sig->h, SM9_SCALAR_SIZE) == 0;
+}
+
+// w = g^r，h = H2(M || w)，l = (r - h) mod n，S = [l]dsA; 成功返回1，l = 0 需换r时返回0，出错返回-1
+int SignWithNonce(const MasterContext& master, const sm9::G1Point& ds,
+                  const uint8_t* msg, size_t msg_len,
+                  const uint8_t r[SM9_SCALAR_SIZE], SM9_SIGNATURE* sig) {
+    sm9::Fp12 w;
+    sm9::gt_pow(&w, master.g_table, r);
+    if (!HashMessage(msg, msg_len, w, sig->h)) return -1;
+
+    uint8_t l_bytes[SM9_SCALAR_SIZE];
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* l = BN_secure_new();
+    BIGNUM* h = BN_new();
+    int ok = -1;
+    if (ctx && l && h && BN_bin2bn(r, SM9_SCALAR_SIZE, l) && BN_bin2bn(sig->h, SM9_SCALAR_SIZE, h)) {
+        BN_set_flags(l, BN_FLG_CONSTTIME);
+        sm9::G1Point s;
+        if (!BN_mod_sub(l, l, h, Order(), ctx)) {
+            ok = -1;
+        } else if (BN_is_zero(l)) {
+            ok = 0;
+        } else if (BN_bn2binpad(l, l_bytes, SM9_SCALAR_SIZE) == SM9_SCALAR_SIZE && sm9::g1_mul(&s, l_bytes, ds)) {
+            sm9::g1_encode(sig->s, s);
+            ok = 1;
+        }
+    }
+    BN_free(h);
+    BN_clear_free(l);
+    BN_CTX_free(ctx);
+    Wipe(l_bytes, sizeof(l_bytes));
+    return ok;
+}
+
+}  // namespace
+
+void sm9_init(SM9_EC_PARAMS* params) {
+    if (!params) return;
+    params->p = NULL;
+    params->n = NULL;
+    params->gx = NULL;
+    params->gy = NULL;
+    BN_hex2bn(&params->p, kHexP);
+    BN_hex2bn(&params->n, kHexN);
+    BN_hex2bn(&params->gx, kHexGx);
+    BN_hex2bn(&params->gy, kHexGy);
+    params->a = BN_new();
+    params->b = BN_new();
+    params->h = BN_new();
+    BN_zero(params->a);
+    BN_set_word(params->b, 5);
+    BN_one(params->h);
+}
+
+void sm9_cleanup_params(SM9_EC_PARAMS* params) {
+    if (params) {
+        BN_free(params->p);
+        BN_free(params->a);
+        BN_free(params->b);
+        BN_free(params->n);
+        BN_free(params->h);
+        BN_free(params->gx);
+        BN_free(params->gy);
+        memset(params, 0, sizeof(*params));
+    }
+    Sm9Cache::GetInstance().Clear();
+}
+
+void sm9_set_identity_cache_capacity(size_t entries) {
+    Sm9Cache::GetInstance().SetCapacity(entries);
+}
+
+int sm9_generate_master_key(SM9_MASTER_KEY* master_key) {
+    if (!master_key) return 0;
+    sm9::G2Point ppub;
+    if (!RandomScalar(master_key->master_priv) ||
+        !sm9::g2_mul(&ppub, master_key->master_priv, sm9::g2_generator())) {
+        Wipe(master_key->master_priv, SM9_SCALAR_SIZE);
+        return 0;
+    }
+    sm9::g2_encode(master_key->master_pub, ppub);
+    return 1;
+}
+
+int sm9_generate_user_key(const SM9_MASTER_KEY* master,
+    const uint8_t* id, size_t id_len,
+    SM9_USER_KEY* user_key) {
+    if (!master || !id || id_len == 0 || id_len > SM9_MAX_ID_LEN || !user_key) return 0;
+
+    // t1 = H1(ID||hid) + ks，t2 = ks * t1^-1，dsA = [t2]P1
+    uint8_t h1[SM9_SCALAR_SIZE];
+    uint8_t t2_bytes[SM9_SCALAR_SIZE];
+    if (!HashIdentity(id, id_len, h1)) return 0;
+
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* ks = BN_secure_new();
+    BIGNUM* t1 = BN_secure_new();
+    BIGNUM* t2 = BN_secure_new();
+    bool ok = ctx && ks && t1 && t2 &&
+              BN_bin2bn(master->master_priv, SM9_SCALAR_SIZE, ks) &&
+              BN_bin2bn(h1, SM9_SCALAR_SIZE, t1);
+    if (ok) {
+        BN_set_flags(ks, BN_FLG_CONSTTIME);
+        BN_set_flags(t1, BN_FLG_CONSTTIME);
+        ok = BN_mod_add(t1, t1, ks, Order(), ctx) && !BN_is_zero(t1) &&
+             BN_mod_inverse(t2, t1, Order(), ctx) &&
+             BN_mod_mul(t2, t2, ks, Order(), ctx) &&
+             BN_bn2binpad(t2, t2_bytes, SM9_SCALAR_SIZE) == SM9_SCALAR_SIZE;
+    }
+    BN_clear_free(t2);
+    BN_clear_free(t1);
+    BN_clear_free(ks);
+    BN_CTX_free(ctx);
+
+    sm9::G1Point ds;
+    ok = ok && sm9::g1_mul(&ds, t2_bytes, sm9::g1_generator());
+    Wipe(t2_bytes, sizeof(t2_bytes));
+    if (!ok) return 0;
+
+    memset(user_key->id, 0, sizeof(user_key->id));
+    memcpy(user_key->id, id, id_len);
+    user_key->id_len = id_len;
+    sm9::g1_encode(user_key->priv_key, ds);
+    memcpy(user_key->master_pub, master->master_pub, SM9_G2_POINT_SIZE);
+    return 1;
+}
+
+int sm9_sign(const SM9_USER_KEY* user_key,
+             const uint8_t* msg, size_t msg_len,
+             SM9_SIGNATURE* sig) {
+    if (!user_key || (!msg && msg_len) || !sig) return 0;
+    std::shared_ptr<const MasterContext> master = Sm9Cache::GetInstance().GetMaster(user_key->master_pub);
+    sm9::G1Point ds;
+    if (!master || !sm9::g1_decode(&ds, user_key->priv_key)) return 0;
+
+    uint8_t r[SM9_SCALAR_SIZE];
+    int ok = 0;
+    for (int attempt = 0; attempt < 16 && ok == 0; ++attempt) {
+        if (!RandomScalar(r)) {
+            ok = -1;
+            break;
+        }
+        ok = SignWithNonce(*master, ds, msg, msg_len, r, sig);
+    }
+    Wipe(r, sizeof(r));
+    Wipe(&ds, sizeof(ds));
+    return ok > 0 ? 1 : 0;
+}
+
+int sm9_verify(const SM9_MASTER_KEY* master,
+              const uint8_t* id, size_t id_len,
+              const uint8_t* msg, size_t msg_len,
+              const SM9_SIGNATURE* sig) {
+    if (!master || (!msg && msg_len)) return 0;
+    std::shared_ptr<const MasterContext> ctx = Sm9Cache::GetInstance().GetMaster(master->master_pub);
+    PendingVerify pending;
+    if (!ctx || !BeginVerify(*ctx, master->master_pub, id, id_len, sig, &pending)) return 0;
+
+    sm9::Fp12 u;
+    sm9::final_exponentiation(&u, pending.f);
+    return FinishVerify(pending, u, msg, msg_len, sig) ? 1 : 0;
+}
+
+int sm9_self_test(void) {
+    SM9_MASTER_KEY master;
+    memset(&master, 0, sizeof(master));
+    HexDecode(kKatMasterPriv, -1, master.master_priv);
+    HexDecode(kKatMasterPub, 0x04, master.master_pub);
+
+    // Ppub-s = [ks]P2
+    sm9::G2Point ppub;
+    uint8_t ppub_bytes[SM9_G2_POINT_SIZE];
+    if (!sm9::g2_mul(&ppub, master.master_priv, sm9::g2_generator())) return 0;
+    sm9::g2_encode(ppub_bytes, ppub);
+    if (memcmp(ppub_bytes, master.master_pub, SM9_G2_POINT_SIZE) != 0) return 0;
+
+    // dsA
+    const uint8_t* id = reinterpret_cast<const uint8_t*>(kKatId);
+    const size_t id_len = sizeof(kKatId) - 1;
+    SM9_USER_KEY user;
+    uint8_t expected_ds[SM9_G1_POINT_SIZE];
+    HexDecode(kKatUserPriv, 0x04, expected_ds);
+    if (!sm9_generate_user_key(&master, id, id_len, &user) ||
+        memcmp(user.priv_key, expected_ds, SM9_G1_POINT_SIZE) != 0) {
+        return 0;
+    }
+
+    // 以示例中的r签名，(h, S) 须与标准一致
+    const uint8_t* msg = reinterpret_cast<const uint8_t*>(kKatMsg);
+    const size_t msg_len = sizeof(kKatMsg) - 1;
+    SM9_SIGNATURE expected;
+    HexDecode(kKatH, -1, expected.h);
+    HexDecode(kKatS, 0x04, expected.s);
+    uint8_t r[SM9_SCALAR_SIZE];
+    HexDecode(kKatNonce, -1, r);
+    std::shared_ptr<const MasterContext> ctx = Sm9Cache::GetInstance().GetMaster(master.master_pub);
+    sm9::G1Point ds;
+    SM9_SIGNATURE sig;
+    if (!ctx || !sm9::g1_decode(&ds, user.priv_key) ||
+        SignWithNonce(*ctx, ds, msg, msg_len, r, &sig) != 1 ||
+        memcmp(&sig, &expected, sizeof(sig)) != 0) {
+        return 0;
+    }
+
+    // 验签方只持主公钥
+    SM9_MASTER_KEY verifier;
+    memset(&verifier, 0, sizeof(verifier));
+    memcpy(verifier.master_pub, master.master_pub, SM9_G2_POINT_SIZE);
+    if (sm9_verify(&verifier, id, id_len, msg, msg_len, &expected) != 1) return 0;
+    expected.h[SM9_SCALAR_SIZE - 1] ^= 1;
+    return sm9_verify(&verifier, id, id_len, msg, msg_len, &expected) == 0 ? 1 : 0;
+}
@@ -6,6 +6,13 @@
 
 #include <openssl/bn.h> // For BIGNUM type
 
+// SM9 标识密码签名 (GM/T 0044-2016 第2部分)，BN256曲线
+#define SM9_SCALAR_SIZE 32
+#define SM9_G1_POINT_SIZE 65     // 04 || x || y
+#define SM9_G2_POINT_SIZE 129    // 04 || x1 || x0 || y1 || y0
+#define SM9_MAX_ID_LEN 64
+#define SM9_HID_SIGN 0x01        // 签名私钥生成函数识别符
+
  //椭圆曲线参数
 typedef struct {
     BIGNUM *p;     // 素数域
@@ -18,42 +25,51 @@ typedef struct {
 
 //签名结构体
 typedef struct {
-    uint8_t r[32];         // 签名值R
-    uint8_t s[32];         // 签名值S
+    uint8_t h[SM9_SCALAR_SIZE];    // 签名值h
+    uint8_t s[SM9_G1_POINT_SIZE];  // 签名值S (G1点)
 } SM9_SIGNATURE;
 
 //主密钥对
 typedef struct {
-    uint64_t master_priv;  // 主公钥参数 (实际应为大整数)
+    uint8_t master_priv[SM9_SCALAR_SIZE];     // 签名主私钥ks，验签方可全零
+    uint8_t master_pub[SM9_G2_POINT_SIZE];    // 签名主公钥 Ppub-s = [ks]P2
     SM9_EC_PARAMS* params; // 曲线参数
 } SM9_MASTER_KEY;
-void sm9_generate_master_key(SM9_MASTER_KEY* master_key);
+int sm9_generate_master_key(SM9_MASTER_KEY* master_key);
 
 
 
 typedef struct {
-    uint8_t id[64];        // 用户标识 (如邮箱)
-    uint64_t priv_key[4];  // 用户私钥 (大整数存储)
+    uint8_t id[SM9_MAX_ID_LEN];   // 用户标识 (如邮箱)
+    size_t id_len;
+    uint8_t priv_key[SM9_G1_POINT_SIZE];      // 用户签名私钥 dsA (G1点)
+    uint8_t master_pub[SM9_G2_POINT_SIZE];    // 签名时需要主公钥
 } SM9_USER_KEY;
 
 //初始化SM9系统 (加载曲线参数)
 void sm9_init(SM9_EC_PARAMS* params);
-//签名函数
-void sm9_sign(const SM9_USER_KEY* user_key,
+//签名函数，成功返回1
+int sm9_sign(const SM9_USER_KEY* user_key,
              const uint8_t* msg, size_t msg_len,
              SM9_SIGNATURE* sig);
 
-//验证签名
+//验证签名，通过返回1
+// g = e(P1, Ppub-s) 按主公钥缓存; 标识对应的 [H1(ID||hid)]P2 + Ppub-s 及其Miller循环直线按标识缓存
 int sm9_verify(const SM9_MASTER_KEY* master,
-              const uint8_t* id,
+              const uint8_t* id, size_t id_len,
               const uint8_t* msg, size_t msg_len,
               const SM9_SIGNATURE* sig);
 
-
-//为用户生成私钥
-void sm9_generate_user_key(const SM9_MASTER_KEY* master, 
-    const uint8_t* id, 
+//为用户生成私钥，成功返回1 (t1 = 0 时需更换主密钥)
+int sm9_generate_user_key(const SM9_MASTER_KEY* master,
+    const uint8_t* id, size_t id_len,
     SM9_USER_KEY* user_key);
 
-    void sm9_cleanup_params();
-#endif
\ No newline at end of file
+//已知答案测试: GM/T 0044-2016 第5部分 A.1 示例的主公钥、用户私钥、签名 (h, S) 与验签，全部一致返回1
+int sm9_self_test(void);
+
+//标识缓存容量 (每项约16KB)，0表示关闭缓存
+void sm9_set_identity_cache_capacity(size_t entries);
+
+    void sm9_cleanup_params(SM9_EC_PARAMS* params);
+#endif
@@ -0,0 +1,962 @@
+//SM9双线性对实现
+
+#include "sm9_pairing.h"
+#include <string.h>
+
+namespace sm9 {
+namespace {
+
+typedef unsigned __int128 u128;
+
+const Fp P = {{0xe56f9b27e351457dULL, 0x21f2934b1a7aeedbULL, 0xd603ab4ff58ec745ULL, 0xb640000002a3a6f1ULL}};
+const Fp N = {{0xe56ee19cd69ecf25ULL, 0x49f2934b18ea8beeULL, 0xd603ab4ff58ec744ULL, 0xb640000002a3a6f1ULL}};
+const Fp R2 = {{0x27dea312b417e2d2ULL, 0x88f8105fae1a5d3fULL, 0xe479b522d6706e7bULL, 0x2ea795a656f62fbdULL}};
+const Fp ONE = {{0x1a9064d81caeba83ULL, 0xde0d6cb4e5851124ULL, 0x29fc54b00a7138baULL, 0x49bffffffd5c590eULL}};
+const Fp ZERO = {{0, 0, 0, 0}};
+const Fp B_MONT = {{0xb9f2c1e8c8c71995ULL, 0x125df8f246a377fcULL, 0x25e650d049188d1cULL, 0x043fffffed866f63ULL}};
+const uint64_t N0 = 0x892bc42c2f2ee42bULL;   // -p^-1 mod 2^64
+
+// BN参数 t 与 R-ate 循环长度 a = 6t+2 (66比特)
+const uint64_t kT = 0x600000000058F98AULL;
+const uint64_t kLoopHi = 0x2;
+const uint64_t kLoopLo = 0x400000000215d93eULL;
+
+// Frobenius常数: w^(p^j) = w * u^((p^j-1)/6)，该值及其幂均落在Fp中
+// FROBj[k] = u^(k(p^j-1)/6)
+const Fp FROB1[6] = {
+    {{0x1a9064d81caeba83ULL, 0xde0d6cb4e5851124ULL, 0x29fc54b00a7138baULL, 0x49bffffffd5c590eULL}},
+    {{0x1a98dfbd4575299fULL, 0x9ec8547b245c54fdULL, 0xf51f5eac13df846cULL, 0x9ef74015d5a16393ULL}},
+    {{0xb626197dce4736caULL, 0x08296b3557ed0186ULL, 0x9c705db2fd91512aULL, 0x1c753e748601c992ULL}},
+    {{0x39b4ef0f3ee72529ULL, 0xdb043bf508582782ULL, 0xb8554ab054ac91e3ULL, 0x9848eec25498cab5ULL}},
+    {{0x81054fcd94e9c1c4ULL, 0x4c0e91cb8ce2df3eULL, 0x4877b452e8aedfb4ULL, 0x88f53e748b491776ULL}},
+    {{0x048baa79dcc34107ULL, 0x5e2e7ac4fe76c161ULL, 0x99399754365bd4bcULL, 0xaf91aeac819b0e13ULL}}};
+const Fp FROB2[6] = {
+    {{0x1a9064d81caeba83ULL, 0xde0d6cb4e5851124ULL, 0x29fc54b00a7138baULL, 0x49bffffffd5c590eULL}},
+    {{0xb626197dce4736caULL, 0x08296b3557ed0186ULL, 0x9c705db2fd91512aULL, 0x1c753e748601c992ULL}},
+    {{0x81054fcd94e9c1c4ULL, 0x4c0e91cb8ce2df3eULL, 0x4877b452e8aedfb4ULL, 0x88f53e748b491776ULL}},
+    {{0xcadf364fc6a28afaULL, 0x43e5269634f5ddb7ULL, 0xac07569feb1d8e8aULL, 0x6c80000005474de3ULL}},
+    {{0x2f4981aa150a0eb3ULL, 0x19c92815c28ded55ULL, 0x39934d9cf7fd761bULL, 0x99cac18b7ca1dd5fULL}},
+    {{0x646a4b5a4e6783b9ULL, 0xd5e4017f8d980f9dULL, 0x8d8bf6fd0cdfe790ULL, 0x2d4ac18b775a8f7bULL}}};
+
+// 扭曲线上的Frobenius: pi(x, y) = (conj(x)*FX, conj(y)*FY)，-pi^2(x, y) = (x*FX2, y)
+const Fp FX = {{0x646a4b5a4e6783b9ULL, 0xd5e4017f8d980f9dULL, 0x8d8bf6fd0cdfe790ULL, 0x2d4ac18b775a8f7bULL}};
+const Fp FY = {{0xabbaac18a46a2054ULL, 0x46ee57561222c759ULL, 0x1dae609fa0e23561ULL, 0x1df7113dae0adc3cULL}};
+const Fp FX2 = {{0x2f4981aa150a0eb3ULL, 0x19c92815c28ded55ULL, 0x39934d9cf7fd761bULL, 0x99cac18b7ca1dd5fULL}};
+
+const G1Point G1_GEN = {
+    {{0x22e935e29860501bULL, 0xa946fd5e0073282cULL, 0xefd0cec817a649beULL, 0x5129787c869140b5ULL}},
+    {{0xee779649eb87f7c7ULL, 0x15563cbdec30a576ULL, 0x326353912824efbfULL, 0x7215717763c39828ULL}}};
+const G2Point G2_GEN = {
+    {{{0x260226a68ce2da8fULL, 0x7ee5645edbf6c06bULL, 0xf8f57c82b1495444ULL, 0x61fcf018bc47c4d1ULL}},
+     {{0xdb6db4822750a8a6ULL, 0x84c6135a5121f134ULL, 0x1874032f88791d41ULL, 0x905112f2b85f3a37ULL}}},
+    {{{0xc03f138f9171c24aULL, 0x92fbab45a15a3ca7ULL, 0x2445561e2ff77cdbULL, 0x108495e0c0f62eceULL}},
+     {{0xf7b82dac4c89bfbbULL, 0x3706f3f6a49dc12fULL, 0x1e29de93d3eef769ULL, 0x81e448c3c76a5d53ULL}}}};
+
+//------------------- 通用: 按字掩码选择 -------------------
+template <class T>
+inline void cmov(T& r, const T& a, uint64_t mask) {
+    uint64_t* rw = reinterpret_cast<uint64_t*>(&r);
+    const uint64_t* aw = reinterpret_cast<const uint64_t*>(&a);
+    for (size_t i = 0; i < sizeof(T) / 8; ++i) rw[i] ^= mask & (rw[i] ^ aw[i]);
+}
+
+template <class T>
+inline uint64_t is_zero(const T& a) {
+    const uint64_t* w = reinterpret_cast<const uint64_t*>(&a);
+    uint64_t t = 0;
+    for (size_t i = 0; i < sizeof(T) / 8; ++i) t |= w[i];
+    return ((t | (0 - t)) >> 63) - 1;   // 为0时返回全1
+}
+
+template <class T>
+inline uint64_t equal(const T& a, const T& b) {
+    const uint64_t* aw = reinterpret_cast<const uint64_t*>(&a);
+    const uint64_t* bw = reinterpret_cast<const uint64_t*>(&b);
+    uint64_t t = 0;
+    for (size_t i = 0; i < sizeof(T) / 8; ++i) t |= aw[i] ^ bw[i];
+    return ((t | (0 - t)) >> 63) - 1;
+}
+
+//------------------- Fp -------------------
+// r = a - m，返回借位
+inline uint64_t sub4(uint64_t r[4], const uint64_t a[4], const uint64_t m[4]) {
+    u128 d;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        d = (u128)a[i] - m[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return borrow;
+}
+
+inline bool less_than(const Fp& a, const Fp& m) {
+    uint64_t t[4];
+    return sub4(t, a.v, m.v) == 1;
+}
+
+void add(Fp& r, const Fp& a, const Fp& b) {
+    uint64_t t[4];
+    u128 c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += (u128)a.v[i] + b.v[i];
+        t[i] = (uint64_t)c;
+        c >>= 64;
+    }
+    uint64_t carry = (uint64_t)c;
+    uint64_t s[4];
+    uint64_t borrow = sub4(s, t, P.v);
+    uint64_t keep = 0 - ((carry ^ 1) & borrow);
+    for (int i = 0; i < 4; ++i) r.v[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+void sub(Fp& r, const Fp& a, const Fp& b) {
+    uint64_t borrow = sub4(r.v, a.v, b.v);
+    uint64_t mask = 0 - borrow;
+    u128 c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += (u128)r.v[i] + (P.v[i] & mask);
+        r.v[i] = (uint64_t)c;
+        c >>= 64;
+    }
+}
+
+inline void dbl(Fp& r, const Fp& a) { add(r, a, a); }
+inline void neg(Fp& r, const Fp& a) { sub(r, ZERO, a); }
+
+// Montgomery乘法 (CIOS)
+void mul(Fp& r, const Fp& a, const Fp& b) {
+    uint64_t t[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        u128 c = 0;
+        for (int j = 0; j < 4; ++j) {
+            c += (u128)a.v[j] * b.v[i] + t[j];
+            t[j] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[4];
+        t[4] = (uint64_t)c;
+        t[5] = (uint64_t)(c >> 64);
+
+        uint64_t m = t[0] * N0;
+        c = (u128)m * P.v[0] + t[0];
+        c >>= 64;
+        for (int j = 1; j < 4; ++j) {
+            c += (u128)m * P.v[j] + t[j];
+            t[j - 1] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[4];
+        t[3] = (uint64_t)c;
+        t[4] = t[5] + (uint64_t)(c >> 64);
+    }
+
+    uint64_t s[4];
+    uint64_t borrow = sub4(s, t, P.v);
+    uint64_t keep = 0 - ((t[4] ^ 1) & borrow);
+    for (int i = 0; i < 4; ++i) r.v[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+inline void sqr(Fp& r, const Fp& a) { mul(r, a, a); }
+
+// r = a^(p-2)，指数公开，运算序列固定
+void inv(Fp& r, const Fp& a) {
+    Fp e;
+    const uint64_t two[4] = {2, 0, 0, 0};
+    sub4(e.v, P.v, two);
+    Fp acc = ONE;
+    for (int i = 255; i >= 0; --i) {
+        sqr(acc, acc);
+        if ((e.v[i / 64] >> (i % 64)) & 1) mul(acc, acc, a);
+    }
+    r = acc;
+}
+
+bool fp_from_bytes(Fp& r, const uint8_t b[32]) {
+    Fp t;
+    for (int i = 0; i < 4; ++i) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; ++j) v = (v << 8) | b[(3 - i) * 8 + j];
+        t.v[i] = v;
+    }
+    if (!less_than(t, P)) return false;
+    mul(r, t, R2);
+    return true;
+}
+
+void fp_to_bytes(uint8_t b[32], const Fp& a) {
+    Fp t;
+    const Fp one = {{1, 0, 0, 0}};
+    mul(t, a, one);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) b[(3 - i) * 8 + j] = (uint8_t)(t.v[i] >> (56 - 8 * j));
+    }
+}
+
+//------------------- Fp2 -------------------
+inline void add(Fp2& r, const Fp2& a, const Fp2& b) { add(r.c0, a.c0, b.c0); add(r.c1, a.c1, b.c1); }
+inline void sub(Fp2& r, const Fp2& a, const Fp2& b) { sub(r.c0, a.c0, b.c0); sub(r.c1, a.c1, b.c1); }
+inline void dbl(Fp2& r, const Fp2& a) { dbl(r.c0, a.c0); dbl(r.c1, a.c1); }
+inline void neg(Fp2& r, const Fp2& a) { neg(r.c0, a.c0); neg(r.c1, a.c1); }
+inline void conj(Fp2& r, const Fp2& a) { r.c0 = a.c0; neg(r.c1, a.c1); }
+inline void mul(Fp2& r, const Fp2& a, const Fp& s) { mul(r.c0, a.c0, s); mul(r.c1, a.c1, s); }
+
+// Karatsuba: 3次Fp乘法
+void mul(Fp2& r, const Fp2& a, const Fp2& b) {
+    Fp t0, t1, t2, t3;
+    mul(t0, a.c0, b.c0);
+    mul(t1, a.c1, b.c1);
+    add(t2, a.c0, a.c1);
+    add(t3, b.c0, b.c1);
+    mul(t2, t2, t3);
+    sub(t2, t2, t0);
+    sub(r.c1, t2, t1);
+    dbl(t1, t1);
+    sub(r.c0, t0, t1);   // u^2 = -2
+}
+
+// (a0 + a1)(a0 - 2a1) + a0a1 = a0^2 - 2a1^2
+void sqr(Fp2& r, const Fp2& a) {
+    Fp t0, t1, t2;
+    mul(t0, a.c0, a.c1);
+    add(t1, a.c0, a.c1);
+    dbl(t2, a.c1);
+    sub(t2, a.c0, t2);
+    mul(t1, t1, t2);
+    add(r.c0, t1, t0);
+    dbl(r.c1, t0);
+}
+
+// r = a * u
+inline void mul_u(Fp2& r, const Fp2& a) {
+    Fp t;
+    dbl(t, a.c1);
+    neg(t, t);
+    r.c1 = a.c0;
+    r.c0 = t;
+}
+
+void inv(Fp2& r, const Fp2& a) {
+    Fp t0, t1;
+    sqr(t0, a.c0);
+    sqr(t1, a.c1);
+    dbl(t1, t1);
+    add(t0, t0, t1);
+    inv(t0, t0);
+    mul(r.c0, a.c0, t0);
+    mul(t1, a.c1, t0);
+    neg(r.c1, t1);
+}
+
+//------------------- Fp4 -------------------
+inline void add(Fp4& r, const Fp4& a, const Fp4& b) { add(r.c0, a.c0, b.c0); add(r.c1, a.c1, b.c1); }
+inline void sub(Fp4& r, const Fp4& a, const Fp4& b) { sub(r.c0, a.c0, b.c0); sub(r.c1, a.c1, b.c1); }
+inline void dbl(Fp4& r, const Fp4& a) { dbl(r.c0, a.c0); dbl(r.c1, a.c1); }
+inline void conj(Fp4& r, const Fp4& a) { r.c0 = a.c0; neg(r.c1, a.c1); }   // v -> -v (p^2次幂)
+inline void mul(Fp4& r, const Fp4& a, const Fp2& s) { mul(r.c0, a.c0, s); mul(r.c1, a.c1, s); }
+
+void mul(Fp4& r, const Fp4& a, const Fp4& b) {
+    Fp2 t0, t1, t2, t3;
+    mul(t0, a.c0, b.c0);
+    mul(t1, a.c1, b.c1);
+    add(t2, a.c0, a.c1);
+    add(t3, b.c0, b.c1);
+    mul(t2, t2, t3);
+    sub(t2, t2, t0);
+    sub(r.c1, t2, t1);
+    mul_u(t1, t1);
+    add(r.c0, t0, t1);
+}
+
+void sqr(Fp4& r, const Fp4& a) {
+    Fp2 t0, t1, t2;
+    sqr(t0, a.c0);
+    sqr(t1, a.c1);
+    mul(t2, a.c0, a.c1);
+    mul_u(t1, t1);
+    add(r.c0, t0, t1);
+    dbl(r.c1, t2);
+}
+
+// r = a * v
+inline void mul_v(Fp4& r, const Fp4& a) {
+    Fp2 t;
+    mul_u(t, a.c1);
+    r.c1 = a.c0;
+    r.c0 = t;
+}
+
+//------------------- Fp12 -------------------
+void mul(Fp12& r, const Fp12& a, const Fp12& b) {
+    Fp4 v0, v1, v2, t0, t1;
+    mul(v0, a.c0, b.c0);
+    mul(v1, a.c1, b.c1);
+    mul(v2, a.c2, b.c2);
+
+    Fp12 out;
+    add(t0, a.c1, a.c2);
+    add(t1, b.c1, b.c2);
+    mul(t0, t0, t1);
+    sub(t0, t0, v1);
+    sub(t0, t0, v2);
+    mul_v(t0, t0);
+    add(out.c0, t0, v0);
+
+    add(t0, a.c0, a.c1);
+    add(t1, b.c0, b.c1);
+    mul(t0, t0, t1);
+    sub(t0, t0, v0);
+    sub(t0, t0, v1);
+    mul_v(t1, v2);
+    add(out.c1, t0, t1);
+
+    add(t0, a.c0, a.c2);
+    add(t1, b.c0, b.c2);
+    mul(t0, t0, t1);
+    sub(t0, t0, v0);
+    sub(t0, t0, v2);
+    add(out.c2, t0, v1);
+    r = out;
+}
+
+// Chung-Hasan SQR2
+void sqr(Fp12& r, const Fp12& a) {
+    Fp4 s0, s1, s2, s3, s4, t;
+    sqr(s0, a.c0);
+    mul(s1, a.c0, a.c1);
+    dbl(s1, s1);
+    sub(t, a.c0, a.c1);
+    add(t, t, a.c2);
+    sqr(s2, t);
+    mul(s3, a.c1, a.c2);
+    dbl(s3, s3);
+    sqr(s4, a.c2);
+
+    mul_v(t, s3);
+    add(r.c0, s0, t);
+    mul_v(t, s4);
+    Fp4 c2;
+    add(c2, s1, s2);
+    add(c2, c2, s3);
+    sub(c2, c2, s0);
+    sub(c2, c2, s4);
+    add(r.c1, s1, t);
+    r.c2 = c2;
+}
+
+// 分圆子群内平方 (Granger-Scott): 把Fp12视为Fp4上的三次扩张，q = p^2
+// c0 = 3a0^2 - 2conj(a0), c1 = 3v*a2^2 + 2conj(a1), c2 = 3a1^2 - 2conj(a2)
+void cyclotomic_sqr(Fp12& r, const Fp12& a) {
+    Fp4 t0, t1, t2, c;
+    sqr(t0, a.c0);
+    sqr(t1, a.c1);
+    sqr(t2, a.c2);
+
+    Fp12 out;
+    conj(c, a.c0);
+    sub(out.c0, t0, c);
+    dbl(out.c0, out.c0);
+    add(out.c0, out.c0, t0);
+
+    mul_v(t2, t2);
+    conj(c, a.c1);
+    add(out.c1, t2, c);
+    dbl(out.c1, out.c1);
+    add(out.c1, out.c1, t2);
+
+    conj(c, a.c2);
+    sub(out.c2, t1, c);
+    dbl(out.c2, out.c2);
+    add(out.c2, out.c2, t1);
+    r = out;
+}
+
+// p^6次幂: w^k 的系数乘以 (-1)^k；分圆子群中即为求逆
+void conj6(Fp12& r, const Fp12& a) {
+    r.c0.c0 = a.c0.c0;
+    neg(r.c0.c1, a.c0.c1);
+    neg(r.c1.c0, a.c1.c0);
+    r.c1.c1 = a.c1.c1;
+    r.c2.c0 = a.c2.c0;
+    neg(r.c2.c1, a.c2.c1);
+}
+
+// w^k (k = i + 3j) 的系数为 a.ci.cj
+inline Fp2& coeff(Fp12& a, int k) {
+    Fp4* c = (k % 3 == 0) ? &a.c0 : (k % 3 == 1) ? &a.c1 : &a.c2;
+    return (k < 3) ? c->c0 : c->c1;
+}
+
+void frobenius(Fp12& r, const Fp12& a, int power) {
+    Fp12 in = a;
+    for (int k = 0; k < 6; ++k) {
+        Fp2 c = coeff(in, k);
+        if (power == 1) {
+            conj(c, c);
+            mul(coeff(r, k), c, FROB1[k]);
+        } else {
+            mul(coeff(r, k), c, FROB2[k]);
+        }
+    }
+}
+
+// 逆元所需的中间量: 在Fp4上的范数d及其在Fp2、Fp上的范数
+struct InvState { Fp4 t0, t1, t2, d; Fp2 e; Fp n; };
+
+void inv_prepare(InvState& s, const Fp12& a) {
+    Fp4 x;
+    sqr(s.t0, a.c0);
+    mul(x, a.c1, a.c2);
+    mul_v(x, x);
+    sub(s.t0, s.t0, x);
+
+    sqr(s.t1, a.c2);
+    mul_v(s.t1, s.t1);
+    mul(x, a.c0, a.c1);
+    sub(s.t1, s.t1, x);
+
+    sqr(s.t2, a.c1);
+    mul(x, a.c0, a.c2);
+    sub(s.t2, s.t2, x);
+
+    mul(s.d, a.c2, s.t1);
+    mul(x, a.c1, s.t2);
+    add(s.d, s.d, x);
+    mul_v(s.d, s.d);
+    mul(x, a.c0, s.t0);
+    add(s.d, s.d, x);
+
+    Fp2 y;
+    sqr(s.e, s.d.c0);
+    sqr(y, s.d.c1);
+    mul_u(y, y);
+    sub(s.e, s.e, y);
+
+    Fp z;
+    sqr(s.n, s.e.c0);
+    sqr(z, s.e.c1);
+    dbl(z, z);
+    add(s.n, s.n, z);
+}
+
+// ninv为 s.n 的逆
+void inv_finish(Fp12& r, const InvState& s, const Fp& ninv) {
+    Fp2 einv;
+    mul(einv.c0, s.e.c0, ninv);
+    mul(einv.c1, s.e.c1, ninv);
+    neg(einv.c1, einv.c1);
+
+    Fp4 dinv;
+    mul(dinv.c0, s.d.c0, einv);
+    mul(dinv.c1, s.d.c1, einv);
+    Fp2 t;
+    neg(t, dinv.c1);
+    dinv.c1 = t;
+
+    mul(r.c0, s.t0, dinv);
+    mul(r.c1, s.t1, dinv);
+    mul(r.c2, s.t2, dinv);
+}
+
+void inv(Fp12& r, const Fp12& a) {
+    InvState s;
+    inv_prepare(s, a);
+    Fp ninv;
+    inv(ninv, s.n);
+    inv_finish(r, s, ninv);
+}
+
+void set_one(Fp12& r) {
+    memset(&r, 0, sizeof(r));
+    r.c0.c0.c0 = ONE;
+}
+
+// 指数t (公开常数) 的分圆幂
+void pow_t(Fp12& r, const Fp12& a) {
+    Fp12 acc = a;   // t的最高位为第62位
+    for (int i = 61; i >= 0; --i) {
+        cyclotomic_sqr(acc, acc);
+        if ((kT >> i) & 1) mul(acc, acc, a);
+    }
+    r = acc;
+}
+
+// 困难部分 (p^4 - p^2 + 1)/n，按 Scott 等人针对BN曲线的加法链
+void final_exp_hard(Fp12& r, const Fp12& f) {
+    Fp12 fp, fp2, fp3, fu, fu2, fu3, t;
+    Fp12 y0, y1, y2, y3, y4, y5, y6, t0, t1;
+
+    frobenius(fp, f, 1);
+    frobenius(fp2, f, 2);
+    frobenius(fp3, fp2, 1);
+    pow_t(fu, f);
+    pow_t(fu2, fu);
+    pow_t(fu3, fu2);
+
+    mul(y0, fp, fp2);
+    mul(y0, y0, fp3);
+    conj6(y1, f);
+    frobenius(y2, fu2, 2);
+    frobenius(y3, fu, 1);
+    conj6(y3, y3);
+    frobenius(t, fu2, 1);
+    mul(y4, fu, t);
+    conj6(y4, y4);
+    conj6(y5, fu2);
+    frobenius(t, fu3, 1);
+    mul(y6, fu3, t);
+    conj6(y6, y6);
+
+    cyclotomic_sqr(t0, y6);
+    mul(t0, t0, y4);
+    mul(t0, t0, y5);
+    mul(t1, y3, y5);
+    mul(t1, t1, t0);
+    mul(t0, t0, y2);
+    cyclotomic_sqr(t1, t1);
+    mul(t1, t1, t0);
+    cyclotomic_sqr(t1, t1);
+    mul(t0, t1, y1);
+    mul(t1, t1, y0);
+    cyclotomic_sqr(t0, t0);
+    mul(r, t1, t0);
+}
+
+// 简单部分 f^((p^6-1)(p^2+1))，finv为f的逆
+void final_exp_easy(Fp12& r, const Fp12& f, const Fp12& finv) {
+    Fp12 t0, t1;
+    conj6(t0, f);
+    mul(t0, t0, finv);
+    frobenius(t1, t0, 2);
+    mul(r, t1, t0);
+}
+
+//------------------- 群运算 (Jacobian坐标, a = 0) -------------------
+template <class F>
+struct JacPoint { F X, Y, Z; };   // Z = 0 表示无穷远点
+
+inline void set_one(Fp& r) { r = ONE; }
+inline void set_one(Fp2& r) { r.c0 = ONE; r.c1 = ZERO; }
+
+// dbl-2009-l
+template <class F>
+void point_double(JacPoint<F>& r, const JacPoint<F>& p) {
+    F a, b, c, d, e, f, t;
+    sqr(a, p.X);
+    sqr(b, p.Y);
+    sqr(c, b);
+    add(t, p.X, b);
+    sqr(t, t);
+    sub(t, t, a);
+    sub(t, t, c);
+    dbl(d, t);
+    dbl(e, a);
+    add(e, e, a);
+    sqr(f, e);
+
+    JacPoint<F> out;
+    mul(out.Z, p.Y, p.Z);
+    dbl(out.Z, out.Z);
+    dbl(t, d);
+    sub(out.X, f, t);
+    sub(t, d, out.X);
+    mul(out.Y, e, t);
+    dbl(c, c);
+    dbl(c, c);
+    dbl(c, c);
+    sub(out.Y, out.Y, c);
+    r = out;
+}
+
+// add-2007-bl; 输入相等时结果错误 (调用方保证不会出现或自行处理)
+template <class F>
+void point_add(JacPoint<F>& r, const JacPoint<F>& p, const JacPoint<F>& q) {
+    F z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+    sqr(z1z1, p.Z);
+    sqr(z2z2, q.Z);
+    mul(u1, p.X, z2z2);
+    mul(u2, q.X, z1z1);
+    mul(s1, p.Y, q.Z);
+    mul(s1, s1, z2z2);
+    mul(s2, q.Y, p.Z);
+    mul(s2, s2, z1z1);
+    sub(h, u2, u1);
+    dbl(i, h);
+    sqr(i, i);
+    mul(j, h, i);
+    sub(rr, s2, s1);
+    dbl(rr, rr);
+    mul(v, u1, i);
+
+    JacPoint<F> out;
+    sqr(out.X, rr);
+    sub(out.X, out.X, j);
+    sub(out.X, out.X, v);
+    sub(out.X, out.X, v);
+
+    sub(t, v, out.X);
+    mul(out.Y, rr, t);
+    mul(t, s1, j);
+    dbl(t, t);
+    sub(out.Y, out.Y, t);
+
+    add(t, p.Z, q.Z);
+    sqr(t, t);
+    sub(t, t, z1z1);
+    sub(t, t, z2z2);
+    mul(out.Z, t, h);
+
+    cmov(out, q, is_zero(p.Z));
+    cmov(out, p, is_zero(q.Z));
+    r = out;
+}
+
+template <class F>
+void to_jacobian(JacPoint<F>& r, const AffinePoint<F>& a) {
+    r.X = a.x;
+    r.Y = a.y;
+    set_one(r.Z);
+}
+
+template <class F>
+bool to_affine(AffinePoint<F>& r, const JacPoint<F>& p) {
+    if (is_zero(p.Z)) return false;
+    F zinv, zinv2;
+    inv(zinv, p.Z);
+    sqr(zinv2, zinv);
+    mul(r.x, p.X, zinv2);
+    mul(zinv2, zinv2, zinv);
+    mul(r.y, p.Y, zinv2);
+    return true;
+}
+
+// 标量的第i个4比特窗口 (0为最低位)
+inline uint32_t scalar_digit(const uint8_t k[32], int i) {
+    uint8_t byte = k[31 - i / 2];
+    return (i & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+inline uint64_t digit_equal(uint32_t a, uint32_t b) {
+    uint64_t t = a ^ b;
+    return ((t | (0 - t)) >> 63) - 1;
+}
+
+bool scalar_is_valid(const uint8_t k[32]) {
+    Fp s;
+    for (int i = 0; i < 4; ++i) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; ++j) v = (v << 8) | k[(3 - i) * 8 + j];
+        s.v[i] = v;
+    }
+    return !is_zero(s) && less_than(s, N);
+}
+
+// 4比特固定窗口; k < n 且p阶为n时累加过程中不会出现相等输入
+template <class F>
+bool scalar_mul(AffinePoint<F>& r, const uint8_t k[32], const AffinePoint<F>& p) {
+    if (!scalar_is_valid(k)) return false;
+    JacPoint<F> table[15];
+    to_jacobian(table[0], p);
+    point_double(table[1], table[0]);
+    for (int j = 2; j < 15; ++j) point_add(table[j], table[j - 1], table[0]);
+
+    JacPoint<F> acc;
+    memset(&acc, 0, sizeof(acc));
+    for (int i = 63; i >= 0; --i) {
+        for (int d = 0; d < 4; ++d) point_double(acc, acc);
+        uint32_t d = scalar_digit(k, i);
+        JacPoint<F> sel;
+        memset(&sel, 0, sizeof(sel));
+        for (int j = 0; j < 15; ++j) cmov(sel, table[j], digit_equal(d, (uint32_t)(j + 1)));
+        JacPoint<F> sum;
+        point_add(sum, acc, sel);
+        cmov(acc, sum, ~digit_equal(d, 0));
+    }
+    return to_affine(r, acc);
+}
+
+//------------------- Miller循环 -------------------
+inline int loop_bit(int i) {
+    return (int)((i >= 64 ? (kLoopHi >> (i - 64)) : (kLoopLo >> i)) & 1);
+}
+
+// T = 2T，同时给出切线系数 (乘以2YZ^3后): c0 = 3X^3 - 2Y^2, cy = 2YZ^3, cx = -3X^2Z^2
+void double_step(LineCoeff& l, JacPoint<Fp2>& T) {
+    Fp2 a, b, c, d, e, f, t, zz;
+    sqr(a, T.X);
+    sqr(b, T.Y);
+    sqr(c, b);
+    sqr(zz, T.Z);
+    add(t, T.X, b);
+    sqr(t, t);
+    sub(t, t, a);
+    sub(t, t, c);
+    dbl(d, t);
+    dbl(e, a);
+    add(e, e, a);
+    sqr(f, e);
+
+    mul(l.c0, e, T.X);
+    dbl(t, b);
+    sub(l.c0, l.c0, t);
+    mul(l.cx, e, zz);
+    neg(l.cx, l.cx);
+
+    JacPoint<Fp2> out;
+    mul(out.Z, T.Y, T.Z);
+    dbl(out.Z, out.Z);
+    mul(l.cy, out.Z, zz);
+    dbl(t, d);
+    sub(out.X, f, t);
+    sub(t, d, out.X);
+    mul(out.Y, e, t);
+    dbl(c, c);
+    dbl(c, c);
+    dbl(c, c);
+    sub(out.Y, out.Y, c);
+    T = out;
+}
+
+// T = T + Q (Q仿射)，割线系数 (乘以Z*H后): c0 = r*xQ - Z3*yQ, cy = Z3, cx = -r
+void add_step(LineCoeff& l, JacPoint<Fp2>& T, const G2Point& q) {
+    Fp2 z1z1, u2, s2, h, r, hh, hhh, v, t;
+    sqr(z1z1, T.Z);
+    mul(u2, q.x, z1z1);
+    mul(s2, q.y, T.Z);
+    mul(s2, s2, z1z1);
+    sub(h, u2, T.X);
+    sub(r, s2, T.Y);
+    sqr(hh, h);
+    mul(hhh, h, hh);
+    mul(v, T.X, hh);
+
+    JacPoint<Fp2> out;
+    sqr(out.X, r);
+    sub(out.X, out.X, hhh);
+    sub(out.X, out.X, v);
+    sub(out.X, out.X, v);
+    sub(t, v, out.X);
+    mul(out.Y, r, t);
+    mul(t, T.Y, hhh);
+    sub(out.Y, out.Y, t);
+    mul(out.Z, T.Z, h);
+
+    mul(l.c0, r, q.x);
+    mul(t, out.Z, q.y);
+    sub(l.c0, l.c0, t);
+    l.cy = out.Z;
+    neg(l.cx, r);
+    T = out;
+}
+
+// f = f * l(P)，直线只占 w^0、w^3、w^2 三个系数
+void mul_by_line(Fp12& f, const LineCoeff& l, const G1Point& p) {
+    Fp4 l0;
+    Fp2 l2;
+    l0.c0 = l.c0;
+    mul(l0.c1, l.cy, p.y);
+    mul(l2, l.cx, p.x);
+
+    Fp4 a, b;
+    Fp12 out;
+    mul(a, f.c0, l0);
+    mul(b, f.c1, l2);
+    mul_v(b, b);
+    add(out.c0, a, b);
+
+    mul(a, f.c1, l0);
+    mul(b, f.c2, l2);
+    mul_v(b, b);
+    add(out.c1, a, b);
+
+    mul(a, f.c2, l0);
+    mul(b, f.c0, l2);
+    add(out.c2, a, b);
+    f = out;
+}
+
+}  // namespace
+
+//------------------- 编解码 -------------------
+bool g1_decode(G1Point* r, const uint8_t in[kG1Size]) {
+    if (in[0] != 0x04) return false;
+    if (!fp_from_bytes(r->x, in + 1) || !fp_from_bytes(r->y, in + 33)) return false;
+    Fp lhs, rhs;
+    sqr(lhs, r->y);
+    sqr(rhs, r->x);
+    mul(rhs, rhs, r->x);
+    add(rhs, rhs, B_MONT);
+    return equal(lhs, rhs) != 0;   // 余因子为1，曲线上的点即属于G1
+}
+
+void g1_encode(uint8_t out[kG1Size], const G1Point& p) {
+    out[0] = 0x04;
+    fp_to_bytes(out + 1, p.x);
+    fp_to_bytes(out + 33, p.y);
+}
+
+bool g2_decode(G2Point* r, const uint8_t in[kG2Size]) {
+    if (in[0] != 0x04) return false;
+    if (!fp_from_bytes(r->x.c1, in + 1) || !fp_from_bytes(r->x.c0, in + 33) ||
+        !fp_from_bytes(r->y.c1, in + 65) || !fp_from_bytes(r->y.c0, in + 97)) {
+        return false;
+    }
+    Fp2 lhs, rhs, b;
+    sqr(lhs, r->y);
+    sqr(rhs, r->x);
+    mul(rhs, rhs, r->x);
+    b.c0 = ZERO;
+    b.c1 = B_MONT;
+    add(rhs, rhs, b);
+    if (!equal(lhs, rhs)) return false;
+
+    // 扭曲线余因子不为1: 校验 (n-1)Q = -Q
+    uint8_t n1[32];
+    Fp nm1;
+    const uint64_t one[4] = {1, 0, 0, 0};
+    sub4(nm1.v, N.v, one);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) n1[(3 - i) * 8 + j] = (uint8_t)(nm1.v[i] >> (56 - 8 * j));
+    }
+    G2Point t;
+    if (!scalar_mul(t, n1, *r)) return false;
+    Fp2 ny;
+    neg(ny, r->y);
+    return equal(t.x, r->x) && equal(t.y, ny);
+}
+
+void g2_encode(uint8_t out[kG2Size], const G2Point& p) {
+    out[0] = 0x04;
+    fp_to_bytes(out + 1, p.x.c1);
+    fp_to_bytes(out + 33, p.x.c0);
+    fp_to_bytes(out + 65, p.y.c1);
+    fp_to_bytes(out + 97, p.y.c0);
+}
+
+void gt_to_bytes(uint8_t out[kGtSize], const Fp12& a) {
+    const Fp4* parts[3] = {&a.c2, &a.c1, &a.c0};
+    for (int i = 0; i < 3; ++i) {
+        fp_to_bytes(out, parts[i]->c1.c1);
+        fp_to_bytes(out + 32, parts[i]->c1.c0);
+        fp_to_bytes(out + 64, parts[i]->c0.c1);
+        fp_to_bytes(out + 96, parts[i]->c0.c0);
+        out += 128;
+    }
+}
+
+const G1Point& g1_generator() { return G1_GEN; }
+const G2Point& g2_generator() { return G2_GEN; }
+
+//------------------- 群运算接口 -------------------
+bool g1_mul(G1Point* r, const uint8_t k[32], const G1Point& p) {
+    return scalar_mul(*r, k, p);
+}
+
+bool g2_mul(G2Point* r, const uint8_t k[32], const G2Point& q) {
+    return scalar_mul(*r, k, q);
+}
+
+// 仅用于公开点
+bool g2_add(G2Point* r, const G2Point& a, const G2Point& b) {
+    JacPoint<Fp2> ja, jb, out;
+    to_jacobian(ja, a);
+    to_jacobian(jb, b);
+    if (equal(a.x, b.x)) {
+        if (!equal(a.y, b.y)) return false;   // a = -b
+        point_double(out, ja);
+    } else {
+        point_add(out, ja, jb);
+    }
+    return to_affine(*r, out);
+}
+
+//------------------- 配对 -------------------
+void g2_prepare(G2Prepared* out, const G2Point& q) {
+    out->lines.clear();
+    out->lines.reserve(84);
+    JacPoint<Fp2> T;
+    to_jacobian(T, q);
+    LineCoeff l;
+    for (int i = 64; i >= 0; --i) {
+        double_step(l, T);
+        out->lines.push_back(l);
+        if (loop_bit(i)) {
+            add_step(l, T, q);
+            out->lines.push_back(l);
+        }
+    }
+
+    G2Point q1, q2;
+    conj(q1.x, q.x);
+    mul(q1.x, q1.x, FX);
+    conj(q1.y, q.y);
+    mul(q1.y, q1.y, FY);
+    mul(q2.x, q.x, FX2);
+    q2.y = q.y;
+    add_step(l, T, q1);
+    out->lines.push_back(l);
+    add_step(l, T, q2);
+    out->lines.push_back(l);
+}
+
+void miller_loop(Fp12* f, const G1Point& p, const G2Prepared& q) {
+    Fp12 acc;
+    set_one(acc);
+    size_t idx = 0;
+    for (int i = 64; i >= 0; --i) {
+        if (i != 64) sqr(acc, acc);
+        mul_by_line(acc, q.lines[idx++], p);
+        if (loop_bit(i)) mul_by_line(acc, q.lines[idx++], p);
+    }
+    mul_by_line(acc, q.lines[idx++], p);
+    mul_by_line(acc, q.lines[idx++], p);
+    *f = acc;
+}
+
+void final_exponentiation(Fp12* r, const Fp12& f) {
+    Fp12 finv, t;
+    inv(finv, f);
+    final_exp_easy(t, f, finv);
+    final_exp_hard(*r, t);
+}
+
+void pairing(Fp12* r, const G1Point& p, const G2Point& q) {
+    G2Prepared prepared;
+    g2_prepare(&prepared, q);
+    Fp12 f;
+    miller_loop(&f, p, prepared);
+    final_exponentiation(r, f);
+}
+
+//------------------- Gt幂 -------------------
+void gt_precompute(GtTable* t, const Fp12& g) {
+    Fp12 base = g;
+    for (int i = 0; i < 64; ++i) {
+        t->table[i][0] = base;
+        for (int j = 1; j < 15; ++j) mul(t->table[i][j], t->table[i][j - 1], base);
+        for (int d = 0; d < 4; ++d) cyclotomic_sqr(base, base);
+    }
+}
+
+void gt_pow(Fp12* r, const GtTable& t, const uint8_t e[32]) {
+    Fp12 acc;
+    set_one(acc);
+    for (int i = 0; i < 64; ++i) {
+        uint32_t d = scalar_digit(e, i);
+        Fp12 sel;
+        set_one(sel);
+        for (int j = 0; j < 15; ++j) cmov(sel, t.table[i][j], digit_equal(d, (uint32_t)(j + 1)));
+        mul(acc, acc, sel);
+    }
+    *r = acc;
+}
+
+void gt_mul(Fp12* r, const Fp12& a, const Fp12& b) {
+    mul(*r, a, b);
+}
+
+bool gt_equal(const Fp12& a, const Fp12& b) {
+    return equal(a, b) != 0;
+}
+
+}  // namespace sm9
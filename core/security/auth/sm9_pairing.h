@@ -0,0 +1,66 @@
+//SM9 BN曲线上的域塔、群运算与R-ate双线性对 (内部接口)
+
+#ifndef SM9_PAIRING_H
+#define SM9_PAIRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// 域塔: Fp2 = Fp[u]/(u^2+2), Fp4 = Fp2[v]/(v^2-u), Fp12 = Fp4[w]/(w^3-v)
+// 所有域元素保持Montgomery形式; G1 = E(Fp): y^2 = x^3+5, G2 = E'(Fp2): y^2 = x^3+5u
+namespace sm9 {
+
+struct Fp { uint64_t v[4]; };
+struct Fp2 { Fp c0, c1; };     // c0 + c1*u
+struct Fp4 { Fp2 c0, c1; };    // c0 + c1*v
+struct Fp12 { Fp4 c0, c1, c2; };  // c0 + c1*w + c2*w^2
+
+// 仿射坐标 (不含无穷远点)
+template <class F>
+struct AffinePoint { F x, y; };
+typedef AffinePoint<Fp> G1Point;
+typedef AffinePoint<Fp2> G2Point;
+
+const size_t kG1Size = 65;     // 04 || x || y
+const size_t kG2Size = 129;    // 04 || x1 || x0 || y1 || y0 (高次系数在前)
+const size_t kGtSize = 384;    // GM/T 0044 的Fp12字节串顺序
+
+// Miller循环中的一条直线 (已乘以子域因子): l(P) = c0 + (cy*yP)*w^3 + (cx*xP)*w^2
+struct LineCoeff { Fp2 c0, cy, cx; };
+
+// G2点的R-ate预计算: Miller循环只依赖Q，直线系数可一次算好，之后每次配对仅需代入P
+struct G2Prepared { std::vector<LineCoeff> lines; };
+
+// Gt固定底数表: table[i][j] = g^((j+1) * 16^i)，幂运算只做64次乘法、无平方
+struct GtTable { Fp12 table[64][15]; };
+
+// 编解码 (解码时校验坐标范围与曲线方程; G2另做子群校验)
+bool g1_decode(G1Point* r, const uint8_t in[kG1Size]);
+void g1_encode(uint8_t out[kG1Size], const G1Point& p);
+bool g2_decode(G2Point* r, const uint8_t in[kG2Size]);
+void g2_encode(uint8_t out[kG2Size], const G2Point& p);
+void gt_to_bytes(uint8_t out[kGtSize], const Fp12& a);
+
+const G1Point& g1_generator();
+const G2Point& g2_generator();
+
+// 标量为32字节大端、已约减到 [1, n-1]; 路径与访存不依赖标量
+bool g1_mul(G1Point* r, const uint8_t k[32], const G1Point& p);
+bool g2_mul(G2Point* r, const uint8_t k[32], const G2Point& q);
+bool g2_add(G2Point* r, const G2Point& a, const G2Point& b);
+
+void g2_prepare(G2Prepared* out, const G2Point& q);
+void miller_loop(Fp12* f, const G1Point& p, const G2Prepared& q);
+void final_exponentiation(Fp12* r, const Fp12& f);
+void pairing(Fp12* r, const G1Point& p, const G2Point& q);
+
+void gt_precompute(GtTable* t, const Fp12& g);
+void gt_pow(Fp12* r, const GtTable& t, const uint8_t e[32]);
+
+void gt_mul(Fp12* r, const Fp12& a, const Fp12& b);
+bool gt_equal(const Fp12& a, const Fp12& b);
+
+}  // namespace sm9
+
+#endif
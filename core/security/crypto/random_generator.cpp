@@ -1,30 +1,42 @@
 #include "random_generator.h"
+
+#if defined(__APPLE__)
 #include <Security/Security.h>
+#else
+#include <sys/random.h>
+#include <errno.h>
+#endif
 
 namespace utils {
-namespace crypto {
 
-class SecureRandom {
-public:
-    static bool GenerateBytes(uint8_t* buffer, size_t length);
-    static bool GenerateIV(uint8_t iv[16]);
-    static bool GenerateSalt(uint8_t* salt, size_t length);
-};
+bool SecureRandom::InitializeSecureRandom() {
+    // 系统熵源无需显式初始化，保留接口以便替换为DRBG实现
+    return true;
+}
 
-bool SecureRandom::GenerateBytes(uint8_t* buffer, size_t length) {
+bool SecureRandom::GenerateSecureRandom(uint8_t* buffer, size_t length) {
     if (!buffer || length == 0) {
         return false;
     }
+#if defined(__APPLE__)
     return SecRandomCopyBytes(kSecRandomDefault, length, buffer) == errSecSuccess;
+#else
+    // getrandom 单次最多返回32MB，且可能被信号中断
+    size_t filled = 0;
+    while (filled < length) {
+        ssize_t n = getrandom(buffer + filled, length - filled, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        filled += static_cast<size_t>(n);
+    }
+    return true;
+#endif
 }
 
 bool SecureRandom::GenerateIV(uint8_t iv[16]) {
-    return GenerateBytes(iv, 16);
-}
-
-bool SecureRandom::GenerateSalt(uint8_t* salt, size_t length) {
-    return GenerateBytes(salt, length);
+    return GenerateSecureRandom(iv, 16);
 }
 
-} // namespace crypto
-} // namespace utils
\ No newline at end of file
+} // namespace utils
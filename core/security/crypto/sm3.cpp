@@ -7,7 +7,8 @@ using namespace std;
 
 //------------------- 工具函数 -------------------
 static inline uint32_t rotl32(uint32_t x, int n) {
-    return (x << n) | (x >> (32 - n));
+    n &= 31;
+    return n ? (x << n) | (x >> (32 - n)) : x;
 }
 
 static inline uint32_t P0(uint32_t x) {
@@ -105,7 +106,8 @@ void sm3_update(SM3_CTX* ctx, const uint8_t* data, size_t len) {
 
         memcpy(&ctx->buffer[index], data, copy_len);
         
-        if (copy_len < 64) {
+        // 缓冲区未填满时等待后续数据
+        if (index + copy_len < 64) {
             index += copy_len;
             break;
         }
@@ -128,6 +130,7 @@ void sm3_final(SM3_CTX* ctx, uint8_t digest[32]) {
         sm3_compress(ctx);
         index = 0;
     }
+    memset(&ctx->buffer[index], 0, 56 - index);
 
     uint64_t be_len = __builtin_bswap64(bit_len);
     memcpy(ctx->buffer + 56, &be_len, 8);
@@ -19,10 +19,20 @@ typedef struct {
 // 初始化上下文
 bool sm4_init(SM4_CTX* ctx, const uint8_t key[16], int mode);
 
-// CBC 模式加密/解密
+// CBC 模式加密/解密 (len须为16的倍数，in与out可以相同)
 void sm4_crypt_cbc(SM4_CTX* ctx, int encrypt,
                    const uint8_t* in, uint8_t* out, size_t len);
 
+// PKCS#7填充后的密文长度 (总会补1~16字节)
+size_t sm4_cbc_padded_len(size_t len);
+
+// CBC + PKCS#7: out至少 sm4_cbc_padded_len(len) 字节，可与in相同。返回密文长度，失败返回0
+size_t sm4_cbc_encrypt_padded(SM4_CTX* ctx, const uint8_t* in, size_t len, uint8_t* out);
+
+// 解密并去除填充: out至少len字节，可与in相同。返回明文长度，填充不合法返回0
+// (明文为空时也返回0，调用方须先用完整性校验拒绝伪造包，避免填充预言)
+size_t sm4_cbc_decrypt_padded(SM4_CTX* ctx, const uint8_t* in, size_t len, uint8_t* out);
+
 #ifdef __cplusplus
 }
 #endif
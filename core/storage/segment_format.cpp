@@ -0,0 +1,77 @@
+//录制分段文件格式实现 (会话密钥包装)
+
+#include "segment_format.h"
+#include "../security/crypto/random_generator.h"
+#include "../security/crypto/sm3.h"
+#include "../security/crypto/sm4.h"
+#include <cstring>
+#include <stddef.h>
+
+namespace {
+
+const size_t kMacOffset = offsetof(SegmentHeader, mac);
+
+void ComputeMac(const uint8_t storage_key[16], const SegmentHeader& header, uint8_t mac[32]) {
+    SM3_CTX ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, storage_key, 16);
+    sm3_update(&ctx, reinterpret_cast<const uint8_t*>(&header), kMacOffset);
+    sm3_final(&ctx, mac);
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+}  // namespace
+
+bool SealSegmentKeys(SegmentHeader* header, const uint8_t storage_key[16], const KeyMaterial& keys) {
+    SM4_CTX ctx;
+    if (!header || !sm4_init(&ctx, storage_key, 1) || !utils::SecureRandom::GenerateIV(header->key_iv)) {
+        return false;
+    }
+    uint8_t secret[48];
+    memcpy(secret, keys.key, 16);
+    memcpy(secret + 16, keys.salt, 32);
+    memcpy(ctx.iv, header->key_iv, 16);
+    sm4_cbc_encrypt_padded(&ctx, secret, sizeof(secret), header->wrapped_key);
+    memset(secret, 0, sizeof(secret));
+    memset(&ctx, 0, sizeof(ctx));
+    header->key_epoch = keys.epoch;
+    ComputeMac(storage_key, *header, header->mac);
+    return true;
+}
+
+bool OpenSegmentKeys(const SegmentHeader& header, const uint8_t storage_key[16], uint8_t key[16], uint8_t salt[32]) {
+    uint8_t mac[32];
+    ComputeMac(storage_key, header, mac);
+    if (memcmp(mac, header.mac, sizeof(mac)) != 0) return false;
+
+    SM4_CTX ctx;
+    if (!sm4_init(&ctx, storage_key, 1)) return false;
+    uint8_t secret[sizeof(header.wrapped_key)];
+    memcpy(ctx.iv, header.key_iv, 16);
+    const size_t len = sm4_cbc_decrypt_padded(&ctx, header.wrapped_key, sizeof(header.wrapped_key), secret);
+    const bool ok = len == 48;
+    if (ok) {
+        memcpy(key, secret, 16);
+        memcpy(salt, secret + 16, 32);
+    }
+    memset(secret, 0, sizeof(secret));
+    memset(&ctx, 0, sizeof(ctx));
+    return ok;
+}
+
+bool ParseStorageKey(const char* hex, uint8_t key[16]) {
+    if (!hex || strlen(hex) != 32) return false;
+    for (size_t i = 0; i < 16; ++i) {
+        const int hi = HexValue(hex[2 * i]);
+        const int lo = HexValue(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        key[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
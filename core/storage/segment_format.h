@@ -0,0 +1,60 @@
+//录制分段文件格式
+
+#ifndef SEGMENT_FORMAT_H
+#define SEGMENT_FORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include "../network/session/session_keys.h"
+
+// 分段文件: [SegmentHeader] [RecordHeader + 原样数据报] [IndexEntry数组]，定位帧不需要解密
+const char SEGMENT_MAGIC[8] = {'G', 'L', 'U', 'R', 'E', 'C', '0', '1'};
+const uint32_t SEGMENT_VERSION = 1;
+const size_t SEGMENT_HEADER_SIZE = 4096;
+const size_t SEGMENT_MAX_RECORD = 1500;
+
+#pragma pack(push, 1)
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;       // 数据区起点
+    uint64_t segment_size;
+    uint64_t index_offset;      // 索引区起点，也是数据区的上限
+    uint32_t index_capacity;
+    uint32_t sequence;          // 分段序号，文件名与之对应
+    uint32_t session_id;        // 本段所有数据报所属的会话
+    uint32_t key_epoch;         // wrapped_key对应的epoch
+    uint8_t key_iv[16];
+    uint8_t wrapped_key[64];    // SM4-CBC(存储密钥, key || salt)
+    uint8_t mac[32];            // SM3(存储密钥 || 以上字段)
+    // 以下由写线程经mmap随写入推进，不在MAC范围内
+    uint64_t data_end;          // 已写入数据的末尾 (此前的记录都完整)
+    uint32_t index_count;
+    uint32_t sealed;            // 1表示分段已正常关闭
+};
+
+struct RecordHeader {
+    uint32_t len;               // 数据报长度
+    uint32_t reserved;
+    uint64_t arrival_us;        // 接收端收到该数据报的时刻 (单调时钟)
+};
+
+// 关键帧索引: pts为展开32位回绕后的64位90kHz视频时间戳 (低32位等于包头时间戳)，
+// 在段内与跨段都严格递增; 时间戳回退的关键帧不编入索引
+struct IndexEntry {
+    uint64_t pts;
+    uint64_t offset;            // 该关键帧最先到达的分片所在记录的文件偏移
+    uint64_t arrival_us;
+};
+#pragma pack(pop)
+
+// 写入分段头的密钥字段并计算MAC
+bool SealSegmentKeys(SegmentHeader* header, const uint8_t storage_key[16], const KeyMaterial& keys);
+
+// 校验MAC并解出会话密钥; 存储密钥错误或分段头被改动时返回false
+bool OpenSegmentKeys(const SegmentHeader& header, const uint8_t storage_key[16], uint8_t key[16], uint8_t salt[32]);
+
+// 命令行给出的存储密钥: 32个十六进制字符
+bool ParseStorageKey(const char* hex, uint8_t key[16]);
+
+#endif
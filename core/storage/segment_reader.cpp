@@ -0,0 +1,193 @@
+//录制分段读取实现
+
+#include "segment_reader.h"
+#include "../security/crypto/sm3.h"
+#include "../security/crypto/sm4.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+
+SegmentReader::SegmentReader() : base_(nullptr), size_(0), header_(nullptr), index_(nullptr) {}
+
+SegmentReader::~SegmentReader() {
+    Close();
+}
+
+bool SegmentReader::Open(const std::string& path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= SEGMENT_HEADER_SIZE) {
+        base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);   // 映射不依赖文件描述符
+    if (base == MAP_FAILED) return false;
+    base_ = static_cast<const uint8_t*>(base);
+    size_ = static_cast<size_t>(st.st_size);
+    header_ = reinterpret_cast<const SegmentHeader*>(base_);
+
+    const SegmentHeader& h = *header_;
+    const bool valid = memcmp(h.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0 && h.version == SEGMENT_VERSION &&
+                       h.header_size >= sizeof(SegmentHeader) && h.header_size <= h.index_offset &&
+                       h.index_offset + static_cast<uint64_t>(h.index_capacity) * sizeof(IndexEntry) <= size_;
+    if (!valid) {
+        Close();
+        return false;
+    }
+    index_ = reinterpret_cast<const IndexEntry*>(base_ + h.index_offset);
+    return true;
+}
+
+void SegmentReader::Close() {
+    if (base_) munmap(const_cast<uint8_t*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    index_ = nullptr;
+}
+
+size_t SegmentReader::KeyframeCount() const {
+    return std::min<size_t>(header_->index_count, header_->index_capacity);
+}
+
+size_t SegmentReader::FindKeyframe(uint64_t pts) const {
+    const size_t count = KeyframeCount();
+    if (count == 0) return SIZE_MAX;
+    const IndexEntry* end = index_ + count;
+    const IndexEntry* it = std::upper_bound(index_, end, pts,
+                                            [](uint64_t value, const IndexEntry& entry) { return value < entry.pts; });
+    return it == index_ ? 0 : static_cast<size_t>(it - index_) - 1;
+}
+
+bool SegmentReader::ReadRecord(uint64_t offset, SegmentRecord* out) const {
+    const uint64_t end = std::min(header_->data_end, header_->index_offset);
+    if (offset < header_->header_size || offset + sizeof(RecordHeader) > end) return false;
+    RecordHeader record;
+    memcpy(&record, base_ + offset, sizeof(record));
+    if (record.len > SEGMENT_MAX_RECORD || offset + sizeof(record) + record.len > end) return false;
+    out->arrival_us = record.arrival_us;
+    out->data = base_ + offset + sizeof(record);
+    out->len = record.len;
+    out->next_offset = offset + sizeof(record) + record.len;
+    return true;
+}
+
+bool Recording::Open(const std::string& directory) {
+    segments_.clear();
+    keyed_.clear();
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return false;
+    std::vector<std::pair<uint32_t, std::string>> names;
+    while (dirent* entry = readdir(dir)) {
+        unsigned int sequence = 0;
+        char suffix[8] = {0};
+        if (sscanf(entry->d_name, "segment_%8u.%7s", &sequence, suffix) == 2 && strcmp(suffix, "seg") == 0) {
+            names.emplace_back(sequence, entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    uint64_t last_pts = 0;
+    for (const auto& name : names) {
+        std::unique_ptr<SegmentReader> reader(new SegmentReader());
+        if (!reader->Open(directory + "/" + name.second)) continue;   // 损坏或未初始化的分段
+        // 二分查找要求pts在段内与跨段都递增，不满足的分段 (旧写入器在回绕处写出的回退pts) 只顺序读取，不参与定位
+        const size_t count = reader->KeyframeCount();
+        bool increasing = count > 0 && (keyed_.empty() || reader->Keyframe(0).pts > last_pts);
+        for (size_t i = 1; increasing && i < count; ++i) {
+            increasing = reader->Keyframe(i).pts > reader->Keyframe(i - 1).pts;
+        }
+        if (increasing) {
+            keyed_.push_back(segments_.size());
+            last_pts = reader->Keyframe(count - 1).pts;
+        }
+        segments_.push_back(std::move(reader));
+    }
+    return !segments_.empty();
+}
+
+bool Recording::Seek(uint64_t pts, size_t* segment, uint64_t* offset) const {
+    if (keyed_.empty()) return false;
+    auto it = std::upper_bound(keyed_.begin(), keyed_.end(), pts,
+                               [this](uint64_t value, size_t i) { return value < segments_[i]->Keyframe(0).pts; });
+    const size_t chosen = it == keyed_.begin() ? keyed_.front() : *(it - 1);
+    const SegmentReader& reader = *segments_[chosen];
+    *segment = chosen;
+    *offset = reader.Keyframe(reader.FindKeyframe(pts)).offset;
+    return true;
+}
+
+RecordDecryptor::RecordDecryptor() : epoch_(0), loaded_(false) {
+    memset(keys_, 0, sizeof(keys_));
+}
+
+RecordDecryptor::~RecordDecryptor() {
+    memset(keys_, 0, sizeof(keys_));
+}
+
+bool RecordDecryptor::Load(const SegmentHeader& header, const uint8_t storage_key[16]) {
+    KeyMaterial& current = keys_[header.key_epoch & 1];
+    loaded_ = OpenSegmentKeys(header, storage_key, current.key, current.salt) && sm4_init(&current.sm4, current.key, 1);
+    if (!loaded_) return false;
+    current.epoch = header.key_epoch;
+    epoch_ = header.key_epoch;
+    InstallNext();
+    return true;
+}
+
+void RecordDecryptor::InstallNext() {
+    const KeyMaterial& current = keys_[epoch_ & 1];
+    KeyMaterial& next = keys_[(epoch_ + 1) & 1];
+    SessionKeys::DeriveNext(current.key, current.salt, epoch_ + 1, next.key, next.salt);
+    sm4_init(&next.sm4, next.key, 1);
+    next.epoch = epoch_ + 1;
+}
+
+size_t RecordDecryptor::Open(const uint8_t* data, size_t len, PacketHeader* header, uint8_t* out) {
+    if (!loaded_ || len < sizeof(PacketHeader)) return 0;
+    memcpy(header, data, sizeof(PacketHeader));
+    header->session_id = ntohl(header->session_id);
+    header->seq_num = ntohl(header->seq_num);
+    header->fragment_id = ntohs(header->fragment_id);
+    header->stream_seq = ntohl(header->stream_seq);
+    header->timestamp = ntohl(header->timestamp);
+    header->total_fragments = ntohs(header->total_fragments);
+    header->payload_len = ntohs(header->payload_len);
+    if (len != PacketLength(header->payload_len, header->flags)) return 0;
+
+    // 早于分段起始epoch的包 (轮换宽限期内的乱序包) 无法反推密钥，按校验失败处理
+    KeyMaterial keys = keys_[(header->flags & PACKET_FLAG_KEY_EPOCH) ? 1 : 0];
+    const uint8_t* ciphertext = data + sizeof(PacketHeader);
+    SM3_CTX ctx;
+    uint8_t digest[32];
+    sm3_init(&ctx);
+    sm3_update(&ctx, keys.salt, 32);
+    sm3_update(&ctx, header->iv, 16);
+    sm3_update(&ctx, ciphertext, header->payload_len);
+    sm3_final(&ctx, digest);
+    if (memcmp(digest, header->sm3_digest, 32) != 0) {
+        memset(&keys, 0, sizeof(keys));
+        return 0;
+    }
+
+    // 对端已切换到下一个epoch: 跟随并预先派生再下一个
+    if (keys.epoch == epoch_ + 1) {
+        epoch_ = keys.epoch;
+        InstallNext();
+    }
+    memcpy(keys.sm4.iv, header->iv, 16);
+    const size_t plain_len = sm4_cbc_decrypt_padded(&keys.sm4, ciphertext, header->payload_len, out);
+    memset(&keys, 0, sizeof(keys));
+    return plain_len;
+}
@@ -0,0 +1,88 @@
+//录制分段读取声明 (mmap索引定位与回放解密)
+
+#ifndef SEGMENT_READER_H
+#define SEGMENT_READER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "segment_format.h"
+#include "../network/packets/packet_types.h"
+
+// 指向映射内存的一条记录 (原始数据报，包头为网络字节序)
+struct SegmentRecord {
+    uint64_t arrival_us;
+    const uint8_t* data;
+    size_t len;
+    uint64_t next_offset;       // 下一条记录的偏移
+};
+
+// 只读映射一个分段文件。写入中的分段同样可读: 只读到分段头中data_end与index_count为止
+class SegmentReader {
+public:
+    SegmentReader();
+    ~SegmentReader();
+
+    SegmentReader(const SegmentReader&) = delete;
+    SegmentReader& operator=(const SegmentReader&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const SegmentHeader& Header() const { return *header_; }
+    uint64_t DataBegin() const { return header_->header_size; }
+    size_t KeyframeCount() const;
+    const IndexEntry& Keyframe(size_t i) const { return index_[i]; }
+
+    // pts不晚于给定值的最后一个关键帧 (二分查找); 早于第一个关键帧时返回0，没有关键帧返回SIZE_MAX
+    size_t FindKeyframe(uint64_t pts) const;
+
+    // 读offset处的记录; 越过data_end或记录不完整时返回false
+    bool ReadRecord(uint64_t offset, SegmentRecord* out) const;
+
+private:
+    const uint8_t* base_;
+    size_t size_;
+    const SegmentHeader* header_;
+    const IndexEntry* index_;
+};
+
+// 一个录制目录下的全部分段，按序号排列
+class Recording {
+public:
+    bool Open(const std::string& directory);
+
+    size_t SegmentCount() const { return segments_.size(); }
+    const SegmentReader& Segment(size_t i) const { return *segments_[i]; }
+
+    // 定位到pts不晚于给定值的最后一个关键帧: 先按各段首个关键帧二分选段，再在段内二分
+    bool Seek(uint64_t pts, size_t* segment, uint64_t* offset) const;
+
+private:
+    std::vector<std::unique_ptr<SegmentReader>> segments_;
+    std::vector<size_t> keyed_;     // 可定位的分段下标: 索引非空，pts在段内与跨段都递增
+};
+
+// 回放时校验并解密记录。会话密钥按包头epoch位选择，对端轮换后从当前epoch派生下一个
+class RecordDecryptor {
+public:
+    RecordDecryptor();
+    ~RecordDecryptor();
+
+    // 用存储密钥解出分段头中的会话密钥
+    bool Load(const SegmentHeader& header, const uint8_t storage_key[16]);
+
+    // SM3校验后解密到out (至少len字节)，header转为主机字节序; 校验失败返回0
+    size_t Open(const uint8_t* data, size_t len, PacketHeader* header, uint8_t* out);
+
+private:
+    void InstallNext();
+
+    KeyMaterial keys_[2];       // epoch & 1 选择槽位: 当前epoch与其下一个
+    uint32_t epoch_;
+    bool loaded_;
+};
+
+#endif
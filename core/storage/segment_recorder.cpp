@@ -0,0 +1,354 @@
+//加密录制写入器实现
+
+#include "segment_recorder.h"
+#include "../network/packets/packet_types.h"
+#include "../network/session/session_manager.h"
+#include "../../utils/logging/logger.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace {
+
+const size_t kPageSize = 4096;
+
+uint64_t RoundUp(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+// 目录中已有分段的下一个序号，新录制不覆盖旧文件
+uint32_t NextSequence(const std::string& directory) {
+    uint32_t next = 0;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return next;
+    while (dirent* entry = readdir(dir)) {
+        unsigned int sequence = 0;
+        char suffix[8] = {0};
+        if (sscanf(entry->d_name, "segment_%8u.%7s", &sequence, suffix) == 2 && strcmp(suffix, "seg") == 0) {
+            next = std::max<uint32_t>(next, sequence + 1);
+        }
+    }
+    closedir(dir);
+    return next;
+}
+
+// 短写时推进iovec继续写 (普通文件上极少发生)
+bool WriteFully(int fd, iovec* iov, size_t count, uint64_t offset) {
+    while (count > 0) {
+        const int n = static_cast<int>(std::min<size_t>(count, IOV_MAX));
+        ssize_t ret = pwritev(fd, iov, n, static_cast<off_t>(offset));
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        offset += static_cast<uint64_t>(ret);
+        size_t done = static_cast<size_t>(ret);
+        while (count > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+SegmentRecorder::SegmentRecorder(const RecorderConfig& config)
+    : config_(config), index_offset_(0), index_bytes_(0),
+      slab_(config.record_slots), pending_(config.record_slots), free_(config.record_slots),
+      append_keyed_(false), append_session_(0), append_epoch_bit_(0), fd_(-1), header_(nullptr), index_(nullptr), sequence_(0), session_id_(0),
+      write_offset_(0), flushed_offset_(0), pending_index_(0),
+      have_timestamp_(false), last_timestamp_(0), timestamp_ext_(0),
+      have_index_pts_(false), last_index_pts_(0),
+      have_keyframe_(false), last_keyframe_(0), stop_(false),
+      records_(0), bytes_(0), dropped_(0), segments_(0), keyframes_(0), unindexed_(0), write_errors_(0) {
+    config_.index_capacity = std::max<uint32_t>(config_.index_capacity, 1);
+    index_bytes_ = RoundUp(static_cast<uint64_t>(config_.index_capacity) * sizeof(IndexEntry), kPageSize);
+    config_.segment_size = RoundUp(config_.segment_size, kPageSize);
+    // 数据区至少能放下一批记录
+    const uint64_t min_size = SEGMENT_HEADER_SIZE + index_bytes_ + kWriteBatch * (sizeof(RecordHeader) + SEGMENT_MAX_RECORD);
+    config_.segment_size = std::max(config_.segment_size, RoundUp(min_size, kPageSize));
+    index_offset_ = config_.segment_size - index_bytes_;
+    memset(keys_, 0, sizeof(keys_));
+    memset(keys_session_, 0, sizeof(keys_session_));
+    memset(keys_valid_, 0, sizeof(keys_valid_));
+    iov_.reserve(kWriteBatch * 2);
+    record_headers_.resize(kWriteBatch);
+}
+
+SegmentRecorder::~SegmentRecorder() {
+    Stop();
+}
+
+bool SegmentRecorder::Start() {
+    if (config_.directory.empty() || thread_.joinable()) return false;
+    if (mkdir(config_.directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOG_ERROR("Could not create recording directory %s: %s", config_.directory.c_str(), strerror(errno));
+        return false;
+    }
+    sequence_ = NextSequence(config_.directory);
+
+    Record* record = nullptr;
+    while (free_.TryPop(&record)) {}
+    while (pending_.TryPop(&record)) {}
+    for (Record& r : slab_) free_.TryPush(&r);
+    append_keyed_ = false;
+    stop_.store(false);
+    thread_ = std::thread(&SegmentRecorder::WriteLoop, this);
+    return true;
+}
+
+void SegmentRecorder::Stop() {
+    stop_.store(true);
+    if (thread_.joinable()) thread_.join();
+    memset(keys_, 0, sizeof(keys_));
+    memset(keys_valid_, 0, sizeof(keys_valid_));
+}
+
+bool SegmentRecorder::Append(const uint8_t* data, size_t len, uint64_t arrival_us) {
+    if (len < sizeof(PacketHeader) || len > SEGMENT_MAX_RECORD) return false;
+    Record* record = nullptr;
+    if (!free_.TryPop(&record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    record->arrival_us = arrival_us;
+    record->len = static_cast<uint32_t>(len);
+    memcpy(record->data, data, len);
+
+    // 写线程可能落后较多，开段时会话的密钥槽已轮换; 因此在收包线程按数据报的epoch位取密钥快照，
+    // 只在会话或epoch位变化时取一次
+    PacketHeader header;
+    memcpy(&header, data, sizeof(header));
+    const uint32_t session_id = ntohl(header.session_id);
+    const uint8_t epoch_bit = (header.flags & PACKET_FLAG_KEY_EPOCH) ? 1 : 0;
+    record->has_keys = false;
+    if (!append_keyed_ || session_id != append_session_ || epoch_bit != append_epoch_bit_) {
+        SessionHandle session = SessionManager::GetInstance().GetSession(session_id);
+        record->has_keys = session && session->GetKeys().AcquireForReceive(epoch_bit, &record->keys);
+        append_keyed_ = record->has_keys;   // 失败时下一条记录重试
+        append_session_ = session_id;
+        append_epoch_bit_ = epoch_bit;
+    }
+    pending_.TryPush(record);   // 队列容量与槽位数相同，不会满
+    return true;
+}
+
+void SegmentRecorder::WriteLoop() {
+    Record* batch[kWriteBatch];
+    Record* record = nullptr;
+    // stop置位后仍取完队列中的记录
+    while (pending_.Pop(&record, stop_)) {
+        size_t count = 0;
+        batch[count++] = record;
+        while (count < kWriteBatch && pending_.TryPop(&record)) batch[count++] = record;
+        WriteBatch(batch, count);
+        for (size_t i = 0; i < count; i++) {
+            if (batch[i]->has_keys) memset(&batch[i]->keys, 0, sizeof(batch[i]->keys));
+            free_.TryPush(batch[i]);
+        }
+    }
+    CloseSegment();
+}
+
+void SegmentRecorder::WriteBatch(Record* const* batch, size_t count) {
+    const uint64_t data_limit = index_offset_;
+    const uint64_t roll_threshold = SEGMENT_HEADER_SIZE + (data_limit - SEGMENT_HEADER_SIZE) / 8 * 7;
+    for (size_t i = 0; i < count; i++) {
+        const Record* record = batch[i];
+        PacketHeader header;
+        memcpy(&header, record->data, sizeof(header));
+        const uint32_t session_id = ntohl(header.session_id);
+        const bool video = header.stream_id == MEDIA_STREAM_VIDEO;
+        const uint32_t timestamp = ntohl(header.timestamp);
+        const uint32_t frame = ntohl(header.stream_seq) - ntohs(header.fragment_id);
+        const bool keyframe_start = video && (header.flags & PACKET_FLAG_KEYFRAME) != 0 &&
+                                    (!have_keyframe_ || frame != last_keyframe_);
+        const uint64_t need = sizeof(RecordHeader) + record->len;
+        const uint8_t epoch_bit = (header.flags & PACKET_FLAG_KEY_EPOCH) ? 1 : 0;
+        if (record->has_keys) {
+            keys_[epoch_bit] = record->keys;
+            keys_session_[epoch_bit] = session_id;
+            keys_valid_[epoch_bit] = true;
+        }
+
+        const bool index_full = header_ && header_->index_count + pending_index_ >= config_.index_capacity;
+        const bool roll = fd_ < 0 || session_id != session_id_ || write_offset_ + need > data_limit ||
+                          (keyframe_start && (index_full || write_offset_ >= roll_threshold));
+        if (roll) {
+            CloseSegment();
+            if (!OpenSegment(session_id, epoch_bit)) {
+                write_errors_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
+
+        const uint64_t pts = video ? UnwrapTimestamp(timestamp) : 0;
+        // 读者按pts二分查找，跨段也要求递增: 时间戳回退的关键帧照常写入，但不编入索引
+        const bool indexed = keyframe_start && (!have_index_pts_ || pts > last_index_pts_);
+        if (keyframe_start && !indexed) unindexed_.fetch_add(1, std::memory_order_relaxed);
+        if (keyframe_start) {
+            have_keyframe_ = true;
+            last_keyframe_ = frame;
+        }
+        if (indexed) {
+            IndexEntry& entry = index_[header_->index_count + pending_index_];
+            entry.pts = pts;
+            entry.offset = write_offset_;
+            entry.arrival_us = record->arrival_us;
+            pending_index_++;
+            have_index_pts_ = true;
+            last_index_pts_ = pts;
+        }
+
+        RecordHeader& record_header = record_headers_[iov_.size() / 2];
+        record_header.len = record->len;
+        record_header.reserved = 0;
+        record_header.arrival_us = record->arrival_us;
+        iov_.push_back({&record_header, sizeof(RecordHeader)});
+        iov_.push_back({const_cast<uint8_t*>(record->data), record->len});
+        write_offset_ += need;
+    }
+    Flush();
+}
+
+// 数据写入文件后才推进分段头中的data_end与index_count，读者看到的索引总指向完整的记录
+bool SegmentRecorder::Flush() {
+    if (iov_.empty()) return true;
+    const size_t records = iov_.size() / 2;
+    const bool ok = WriteFully(fd_, iov_.data(), iov_.size(), flushed_offset_);
+    iov_.clear();
+    if (!ok) {
+        LOG_WARN("Recording write failed: %s", strerror(errno));
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+        // 写入位置不再可信，下一条记录起换新段
+        pending_index_ = 0;
+        CloseSegment();
+        return false;
+    }
+    records_.fetch_add(records, std::memory_order_relaxed);
+    bytes_.fetch_add(write_offset_ - flushed_offset_, std::memory_order_relaxed);
+    keyframes_.fetch_add(pending_index_, std::memory_order_relaxed);
+    flushed_offset_ = write_offset_;
+    header_->index_count += pending_index_;
+    pending_index_ = 0;
+    header_->data_end = flushed_offset_;
+    return true;
+}
+
+// 分段头包装首条记录所用的密钥 (Append时的快照)，回放从它派生后续epoch
+bool SegmentRecorder::OpenSegment(uint32_t session_id, uint8_t epoch_bit) {
+    if (!keys_valid_[epoch_bit] || keys_session_[epoch_bit] != session_id) return false;
+    KeyMaterial keys = keys_[epoch_bit];
+
+    char name[32];
+    snprintf(name, sizeof(name), "segment_%08u.seg", sequence_);
+    const std::string path = config_.directory + "/" + name;
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = fd_ >= 0 && ftruncate(fd_, static_cast<off_t>(config_.segment_size)) == 0;
+    if (ok) {
+        void* header = mmap(nullptr, SEGMENT_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        void* index = mmap(nullptr, index_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                           static_cast<off_t>(index_offset_));
+        header_ = header == MAP_FAILED ? nullptr : static_cast<SegmentHeader*>(header);
+        index_ = index == MAP_FAILED ? nullptr : static_cast<IndexEntry*>(index);
+        ok = header_ && index_;
+    }
+    if (ok) {
+        memset(header_, 0, sizeof(SegmentHeader));
+        memcpy(header_->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+        header_->version = SEGMENT_VERSION;
+        header_->header_size = SEGMENT_HEADER_SIZE;
+        header_->segment_size = config_.segment_size;
+        header_->index_offset = index_offset_;
+        header_->index_capacity = config_.index_capacity;
+        header_->sequence = sequence_;
+        header_->session_id = session_id;
+        header_->data_end = SEGMENT_HEADER_SIZE;
+        ok = SealSegmentKeys(header_, config_.storage_key, keys);
+    }
+    memset(&keys, 0, sizeof(keys));
+    if (!ok) {
+        LOG_WARN("Could not create recording segment %s", path.c_str());
+        CloseSegment();
+        unlink(path.c_str());
+        return false;
+    }
+
+    sequence_++;
+    session_id_ = session_id;
+    write_offset_ = SEGMENT_HEADER_SIZE;
+    flushed_offset_ = SEGMENT_HEADER_SIZE;
+    pending_index_ = 0;
+    segments_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SegmentRecorder::CloseSegment() {
+    if (fd_ >= 0 && header_ && index_) {
+        Flush();
+    }
+    if (header_) {
+        header_->sealed = 1;
+        msync(header_, SEGMENT_HEADER_SIZE, MS_SYNC);
+        munmap(header_, SEGMENT_HEADER_SIZE);
+        header_ = nullptr;
+    }
+    if (index_) {
+        msync(index_, index_bytes_, MS_SYNC);
+        munmap(index_, index_bytes_);
+        index_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        fdatasync(fd_);
+        close(fd_);
+        fd_ = -1;
+    }
+    iov_.clear();
+    pending_index_ = 0;
+}
+
+// 32位90kHz时间戳约13小时回绕一次: 按与最新时间戳的有符号差展开为64位 (低32位仍等于原值)。
+// 乱序或B帧的较早时间戳，包括跨回绕点的，得到较小的值且不推进基准
+uint64_t SegmentRecorder::UnwrapTimestamp(uint32_t timestamp) {
+    if (!have_timestamp_) {
+        have_timestamp_ = true;
+        last_timestamp_ = timestamp;
+        timestamp_ext_ = timestamp;
+        return timestamp_ext_;
+    }
+    const int32_t delta = static_cast<int32_t>(timestamp - last_timestamp_);
+    if (delta < 0) {
+        const uint64_t back = static_cast<uint64_t>(-static_cast<int64_t>(delta));
+        return timestamp_ext_ >= back ? timestamp_ext_ - back : 0;
+    }
+    last_timestamp_ = timestamp;
+    timestamp_ext_ += static_cast<uint64_t>(delta);
+    return timestamp_ext_;
+}
+
+RecorderStats SegmentRecorder::GetStats() const {
+    RecorderStats s;
+    s.records = records_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.segments = segments_.load(std::memory_order_relaxed);
+    s.keyframes = keyframes_.load(std::memory_order_relaxed);
+    s.unindexed = unindexed_.load(std::memory_order_relaxed);
+    s.write_errors = write_errors_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,115 @@
+//加密录制写入器声明 (异步批量写分段文件)
+
+#ifndef SEGMENT_RECORDER_H
+#define SEGMENT_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+#include "segment_format.h"
+#include "../../utils/concurrency/spsc_queue.h"
+
+struct RecorderConfig {
+    std::string directory;              // 空表示不录制
+    uint8_t storage_key[16] = {};       // 包装会话密钥; 回放时须提供同一密钥
+    uint64_t segment_size = 64ull << 20;
+    uint32_t index_capacity = 8192;     // 每段最多索引的关键帧数，写满则换段
+    size_t record_slots = 4096;         // 收包线程 -> 写线程的在途记录
+};
+
+struct RecorderStats {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t dropped;           // 写线程跟不上，槽位用尽
+    uint64_t segments;
+    uint64_t keyframes;
+    uint64_t unindexed;         // 时间戳不晚于上一个已索引关键帧 (发送端重启等) 而未编入索引的关键帧
+    uint64_t write_errors;
+};
+
+// 收包线程Append只做内存复制，写线程攒批pwritev并更新关键帧索引; 换段优先在关键帧处
+class SegmentRecorder {
+public:
+    explicit SegmentRecorder(const RecorderConfig& config);
+    ~SegmentRecorder();
+
+    SegmentRecorder(const SegmentRecorder&) = delete;
+    SegmentRecorder& operator=(const SegmentRecorder&) = delete;
+
+    bool Start();
+    // 写完已提交的记录并关闭当前分段
+    void Stop();
+
+    // 仅一个线程调用。槽位用尽时丢弃并返回false
+    bool Append(const uint8_t* data, size_t len, uint64_t arrival_us);
+
+    RecorderStats GetStats() const;
+
+private:
+    static constexpr size_t kWriteBatch = 256;   // 每条记录两段iovec，不超过IOV_MAX
+
+    struct Record {
+        uint64_t arrival_us;
+        uint32_t len;
+        bool has_keys;                    // 会话或epoch位变化后的第一条记录附带密钥快照
+        KeyMaterial keys;
+        uint8_t data[SEGMENT_MAX_RECORD];
+    };
+
+    void WriteLoop();
+    void WriteBatch(Record* const* batch, size_t count);
+    bool Flush();
+    bool OpenSegment(uint32_t session_id, uint8_t epoch_bit);
+    void CloseSegment();
+    uint64_t UnwrapTimestamp(uint32_t timestamp);
+
+    RecorderConfig config_;
+    uint64_t index_offset_;
+    size_t index_bytes_;
+    std::vector<Record> slab_;
+    utils::SpscQueue<Record*> pending_;   // Append -> 写线程
+    utils::SpscQueue<Record*> free_;      // 写线程 -> Append
+
+    // 以下仅Append线程使用
+    bool append_keyed_;
+    uint32_t append_session_;
+    uint8_t append_epoch_bit_;
+
+    // 以下仅写线程使用
+    int fd_;
+    SegmentHeader* header_;               // 映射的分段头
+    IndexEntry* index_;                   // 映射的索引区
+    uint32_t sequence_;
+    uint32_t session_id_;
+    KeyMaterial keys_[2];                 // 按epoch位保存的最新密钥快照
+    uint32_t keys_session_[2];
+    bool keys_valid_[2];
+    uint64_t write_offset_;               // 已提交到iovec的末尾
+    uint64_t flushed_offset_;             // 已写入文件的末尾
+    uint32_t pending_index_;              // 已写入索引区、待数据落盘后计入index_count的条目
+    std::vector<iovec> iov_;
+    std::vector<RecordHeader> record_headers_;
+    bool have_timestamp_;
+    uint32_t last_timestamp_;
+    uint64_t timestamp_ext_;              // last_timestamp_展开后的64位值
+    bool have_index_pts_;
+    uint64_t last_index_pts_;             // 最近编入索引的关键帧pts，索引只接受更晚的pts
+    bool have_keyframe_;
+    uint32_t last_keyframe_;              // 最近索引的关键帧号 (stream_seq - fragment_id)
+
+    std::thread thread_;
+    std::atomic<bool> stop_;
+
+    std::atomic<uint64_t> records_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> segments_;
+    std::atomic<uint64_t> keyframes_;
+    std::atomic<uint64_t> unindexed_;
+    std::atomic<uint64_t> write_errors_;
+};
+
+#endif
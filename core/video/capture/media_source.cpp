@@ -0,0 +1,144 @@
+//媒体输入源实现
+
+#include "media_source.h"
+#include "../../../utils/logging/logger.h"
+
+extern "C" {
+#include <libavdevice/avdevice.h>
+#include <libavutil/time.h>
+}
+
+#include <stdio.h>
+#include <mutex>
+
+namespace {
+
+std::once_flag g_device_once;
+
+int64_t ToMicros(int64_t ts, AVRational time_base) {
+    return av_rescale_q(ts, time_base, AV_TIME_BASE_Q);
+}
+
+}  // namespace
+
+MediaSource::MediaSource()
+    : ctx_(nullptr), live_(false), video_index_(-1), audio_index_(-1),
+      loops_done_(0), loop_offset_us_(0), loop_end_us_(AV_NOPTS_VALUE),
+      start_pts_us_(AV_NOPTS_VALUE), start_wall_us_(0) {}
+
+MediaSource::~MediaSource() {
+    Close();
+}
+
+bool MediaSource::Open(const MediaSourceConfig& config) {
+    Close();
+    config_ = config;
+    std::call_once(g_device_once, [] { avdevice_register_all(); });
+
+    // 设备节点未指定格式时按V4L2打开
+    std::string format = config.format;
+    if (format.empty() && config.url.compare(0, 10, "/dev/video") == 0) format = "v4l2";
+
+    const AVInputFormat* input_fmt = nullptr;
+    if (!format.empty()) {
+        const char* name = format == "v4l2" ? "video4linux2" : format.c_str();
+        input_fmt = av_find_input_format(name);
+        if (!input_fmt) {
+            LOG_ERROR("Unknown input format %s", name);
+            return false;
+        }
+    }
+
+    AVDictionary* options = nullptr;
+    if (!config.video_size.empty()) av_dict_set(&options, "video_size", config.video_size.c_str(), 0);
+    if (!config.framerate.empty()) av_dict_set(&options, "framerate", config.framerate.c_str(), 0);
+    int ret = avformat_open_input(&ctx_, config.url.c_str(), input_fmt, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        LOG_ERROR("Could not open input %s", config.url.c_str());
+        return false;
+    }
+    if (avformat_find_stream_info(ctx_, nullptr) < 0) {
+        LOG_ERROR("Could not read stream info from %s", config.url.c_str());
+        Close();
+        return false;
+    }
+
+    video_index_ = av_find_best_stream(ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    audio_index_ = av_find_best_stream(ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (video_index_ < 0) {
+        LOG_ERROR("No video stream in %s", config.url.c_str());
+        Close();
+        return false;
+    }
+    if (audio_index_ < 0) audio_index_ = -1;
+
+    // 采集设备的demuxer不经过AVIOContext
+    live_ = (ctx_->iformat->flags & AVFMT_NOFILE) != 0;
+    return true;
+}
+
+void MediaSource::Close() {
+    if (ctx_) avformat_close_input(&ctx_);
+    video_index_ = audio_index_ = -1;
+    loops_done_ = 0;
+    loop_offset_us_ = 0;
+    loop_end_us_ = AV_NOPTS_VALUE;
+    start_pts_us_ = AV_NOPTS_VALUE;
+}
+
+bool MediaSource::Rewind() {
+    if (live_ || (config_.loop >= 0 && loops_done_ >= config_.loop)) return false;
+    if (loop_end_us_ == AV_NOPTS_VALUE) return false;  // 空文件
+    if (av_seek_frame(ctx_, -1, ctx_->start_time != AV_NOPTS_VALUE ? ctx_->start_time : 0,
+                      AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+    }
+    int64_t first_us = ctx_->start_time != AV_NOPTS_VALUE ? ctx_->start_time : 0;
+    loop_offset_us_ += loop_end_us_ - first_us;
+    loop_end_us_ = AV_NOPTS_VALUE;
+    ++loops_done_;
+    return true;
+}
+
+void MediaSource::Pace(const AVPacket* pkt) {
+    if (pkt->pts == AV_NOPTS_VALUE) return;
+    int64_t pts_us = ToMicros(pkt->pts, ctx_->streams[pkt->stream_index]->time_base);
+    if (start_pts_us_ == AV_NOPTS_VALUE) {
+        start_pts_us_ = pts_us;
+        start_wall_us_ = av_gettime_relative();
+        return;
+    }
+    int64_t wait_us = (pts_us - start_pts_us_) - (av_gettime_relative() - start_wall_us_);
+    if (wait_us > 0) av_usleep(static_cast<unsigned>(wait_us));
+}
+
+int MediaSource::ReadPacket(AVPacket* pkt) {
+    while (true) {
+        int ret = av_read_frame(ctx_, pkt);
+        if (ret == AVERROR_EOF) {
+            if (Rewind()) continue;
+            return AVERROR_EOF;
+        }
+        if (ret < 0) return ret;
+
+        if (pkt->stream_index != video_index_ && pkt->stream_index != audio_index_) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        AVRational tb = ctx_->streams[pkt->stream_index]->time_base;
+        int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        if (ts != AV_NOPTS_VALUE) {
+            int64_t end_us = ToMicros(ts + pkt->duration, tb);
+            if (loop_end_us_ == AV_NOPTS_VALUE || end_us > loop_end_us_) loop_end_us_ = end_us;
+        }
+        if (loop_offset_us_ != 0) {
+            int64_t offset = av_rescale_q(loop_offset_us_, AV_TIME_BASE_Q, tb);
+            if (pkt->pts != AV_NOPTS_VALUE) pkt->pts += offset;
+            if (pkt->dts != AV_NOPTS_VALUE) pkt->dts += offset;
+        }
+        if (config_.realtime && !live_) Pace(pkt);
+        return 0;
+    }
+}
@@ -0,0 +1,59 @@
+//媒体输入源声明 (文件或V4L2设备)
+
+#ifndef MEDIA_SOURCE_H
+#define MEDIA_SOURCE_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <string>
+
+struct MediaSourceConfig {
+    std::string url;            // 文件路径，或设备节点如 /dev/video0
+    std::string format;         // 输入格式，空表示按url自动探测; 设备填 "v4l2"
+    std::string video_size;     // 设备采集分辨率，如 "1280x720"
+    std::string framerate;      // 设备采集帧率，如 "30"
+    bool realtime = false;      // 文件输入按时间戳节奏读取，模拟实时设备
+    int loop = 0;               // 文件输入额外循环次数，-1表示无限循环
+};
+
+// 解复用/采集: 只在采集线程中使用
+class MediaSource {
+public:
+    MediaSource();
+    ~MediaSource();
+
+    bool Open(const MediaSourceConfig& config);
+    void Close();
+
+    // 读取下一个压缩包，返回0成功，AVERROR_EOF表示输入结束，其他负值为错误。
+    // 循环播放时时间戳单调递增 (跨轮次加上前几轮的时长)
+    int ReadPacket(AVPacket* pkt);
+
+    // 设备输入: 采集跟不上时应丢帧而不是阻塞 (文件输入可以等下游)
+    bool IsLive() const { return live_; }
+
+    int VideoIndex() const { return video_index_; }
+    int AudioIndex() const { return audio_index_; }
+    AVStream* VideoStream() const { return video_index_ >= 0 ? ctx_->streams[video_index_] : nullptr; }
+    AVStream* AudioStream() const { return audio_index_ >= 0 ? ctx_->streams[audio_index_] : nullptr; }
+
+private:
+    bool Rewind();
+    void Pace(const AVPacket* pkt);
+
+    AVFormatContext* ctx_;
+    MediaSourceConfig config_;
+    bool live_;
+    int video_index_;
+    int audio_index_;
+    int loops_done_;
+    int64_t loop_offset_us_;    // 已完成轮次的累计时长
+    int64_t loop_end_us_;       // 本轮读到的最大结束时间
+    int64_t start_pts_us_;      // 首包时间戳 (节奏基准)
+    int64_t start_wall_us_;
+};
+
+#endif
@@ -0,0 +1,129 @@
+//窗口显示输出端实现
+
+#include "display_sink.h"
+
+#if !defined(NO_SDL) && __has_include(<SDL2/SDL.h>)
+#define HAVE_SDL 1
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef HAVE_SDL
+
+#include <stdio.h>
+#include <mutex>
+
+namespace {
+
+class SdlDisplaySink : public DisplaySink {
+public:
+    SdlDisplaySink() : pending_(av_frame_alloc()), has_frame_(false) {}
+    ~SdlDisplaySink() override { av_frame_free(&pending_); }
+
+    bool Consume(const AVFrame* frame) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        av_frame_unref(pending_);
+        has_frame_ = av_frame_ref(pending_, frame) == 0;
+        return has_frame_;
+    }
+
+    int Run(const std::atomic<bool>& stop) override;
+
+private:
+    // 取出最新帧，没有新帧时返回false
+    bool Take(AVFrame* out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_frame_) return false;
+        av_frame_unref(out);
+        av_frame_move_ref(out, pending_);
+        has_frame_ = false;
+        return true;
+    }
+
+    std::mutex mutex_;
+    AVFrame* pending_;
+    bool has_frame_;
+};
+
+int SdlDisplaySink::Run(const std::atomic<bool>& stop) {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "[ERROR] SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("Receiver",
+        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+        640, 480, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1,
+        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC) : nullptr;
+    if (!renderer) {
+        fprintf(stderr, "[ERROR] Window/renderer creation failed: %s\n", SDL_GetError());
+        if (window) SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+
+    // 纹理按实际帧尺寸创建，分辨率变化时重建
+    SDL_Texture* texture = nullptr;
+    int tex_w = 0, tex_h = 0;
+    AVFrame* frame = av_frame_alloc();
+    bool running = true;
+    while (running && !stop.load()) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) running = false;
+        }
+
+        if (!Take(frame)) {
+            SDL_Delay(2);
+            continue;
+        }
+        if (!texture || tex_w != frame->width || tex_h != frame->height) {
+            if (texture) SDL_DestroyTexture(texture);
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STREAMING,
+                                        frame->width, frame->height);
+            if (!texture) {
+                fprintf(stderr, "[ERROR] Texture creation failed: %s\n", SDL_GetError());
+                break;
+            }
+            tex_w = frame->width;
+            tex_h = frame->height;
+        }
+        SDL_UpdateYUVTexture(texture, nullptr,
+            frame->data[0], frame->linesize[0],
+            frame->data[1], frame->linesize[1],
+            frame->data[2], frame->linesize[2]);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+        SDL_RenderPresent(renderer);
+        av_frame_unref(frame);
+    }
+
+    av_frame_free(&frame);
+    if (texture) SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
+
+}  // namespace
+
+bool DisplaySupported() {
+    return true;
+}
+
+std::unique_ptr<DisplaySink> CreateDisplaySink() {
+    return std::unique_ptr<DisplaySink>(new SdlDisplaySink());
+}
+
+#else  // HAVE_SDL
+
+bool DisplaySupported() {
+    return false;
+}
+
+std::unique_ptr<DisplaySink> CreateDisplaySink() {
+    return nullptr;
+}
+
+#endif
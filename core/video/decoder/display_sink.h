@@ -0,0 +1,22 @@
+//窗口显示输出端声明 (SDL2)
+
+#ifndef DISPLAY_SINK_H
+#define DISPLAY_SINK_H
+
+#include <atomic>
+#include <memory>
+#include "frame_sink.h"
+
+// 解码线程只把最新一帧放入信箱，主线程在Run中按VSYNC渲染，解码不被显示节奏阻塞
+class DisplaySink : public FrameSink {
+public:
+    // 主线程: 显示直到窗口关闭或stop置位，返回进程退出码
+    virtual int Run(const std::atomic<bool>& stop) = 0;
+};
+
+// 编译环境没有SDL2或定义了NO_SDL时不支持窗口显示: DisplaySupported返回false，CreateDisplaySink返回nullptr。
+// 无界面接收端因此可以在没有SDL的机器上编译，且不链接SDL
+bool DisplaySupported();
+std::unique_ptr<DisplaySink> CreateDisplaySink();
+
+#endif
@@ -0,0 +1,101 @@
+//解码输出端实现
+
+#include "frame_sink.h"
+#include "../../../utils/logging/logger.h"
+
+extern "C" {
+#include <libavutil/adler32.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace {
+
+const size_t kFileBufferSize = 1 << 20;
+
+// 按行遍历视频帧可见区域的每个平面 (跳过linesize中的对齐填充)
+template <class Fn>
+bool ForEachRow(const AVFrame* frame, Fn&& fn) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) return false;
+
+    const int planes = av_pix_fmt_count_planes(static_cast<AVPixelFormat>(frame->format));
+    for (int p = 0; p < planes; p++) {
+        const int row_bytes = av_image_get_linesize(static_cast<AVPixelFormat>(frame->format), frame->width, p);
+        if (row_bytes <= 0) return false;
+        // 平面1、2为色度平面 (alpha平面与亮度同高)
+        const bool chroma = (p == 1 || p == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        const int rows = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        const uint8_t* row = frame->data[p];
+        for (int y = 0; y < rows; y++, row += frame->linesize[p]) {
+            if (!fn(row, static_cast<size_t>(row_bytes))) return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+FileSink::FileSink(const std::string& path)
+    : path_(path), file_(nullptr), bytes_(0) {
+    file_ = path == "-" ? stdout : fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR("Could not open %s for writing", path.c_str());
+        return;
+    }
+    setvbuf(file_, nullptr, _IOFBF, kFileBufferSize);
+}
+
+FileSink::~FileSink() {
+    Finish();
+}
+
+bool FileSink::Consume(const AVFrame* frame) {
+    if (!file_) return false;
+    return ForEachRow(frame, [this](const uint8_t* row, size_t len) {
+        if (fwrite(row, 1, len, file_) != len) return false;
+        bytes_ += len;
+        return true;
+    });
+}
+
+void FileSink::Finish() {
+    if (!file_) return;
+    if (file_ == stdout) fflush(file_);
+    else fclose(file_);
+    file_ = nullptr;
+}
+
+std::string FileSink::Summary() const {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "wrote %" PRIu64 " bytes to %s", bytes_, path_.c_str());
+    return buf;
+}
+
+bool ChecksumSink::Consume(const AVFrame* frame) {
+    frames_++;
+    return ForEachRow(frame, [this](const uint8_t* row, size_t len) {
+        checksum_ = av_adler32_update(checksum_, row, len);
+        return true;
+    });
+}
+
+std::string ChecksumSink::Summary() const {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "adler32 %08x over %" PRIu64 " frames", checksum_, frames_);
+    return buf;
+}
+
+std::unique_ptr<FrameSink> CreateFrameSink(const std::string& type, const std::string& path) {
+    if (type == "null") return std::unique_ptr<FrameSink>(new NullSink());
+    if (type == "checksum") return std::unique_ptr<FrameSink>(new ChecksumSink());
+    if (type == "file") {
+        std::unique_ptr<FileSink> sink(new FileSink(path));
+        if (!sink->IsOpen()) return nullptr;
+        return std::unique_ptr<FrameSink>(sink.release());
+    }
+    return nullptr;
+}
@@ -0,0 +1,65 @@
+//解码输出端声明 (无界面接收模式)
+
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// 解码线程逐帧调用Consume; frame在返回后即被回收，需要保留时自行av_frame_ref。
+// ConsumeAudio在音频解码线程调用，可能与Consume并发; 默认丢弃音频
+class FrameSink {
+public:
+    virtual ~FrameSink() {}
+    virtual bool Consume(const AVFrame* frame) = 0;
+    virtual bool ConsumeAudio(const AVFrame*) { return true; }
+    virtual void Finish() {}
+    // 结束时打印的摘要 (如校验和)
+    virtual std::string Summary() const { return std::string(); }
+};
+
+// 只计数，用于测量接收+解密+解码的吞吐
+class NullSink : public FrameSink {
+public:
+    bool Consume(const AVFrame*) override { return true; }
+};
+
+// 把可见区域逐行写成原始帧序列 (格式与输入帧相同，不做转换); path为"-"时写到stdout
+class FileSink : public FrameSink {
+public:
+    explicit FileSink(const std::string& path);
+    ~FileSink() override;
+    bool IsOpen() const { return file_ != nullptr; }
+    bool Consume(const AVFrame* frame) override;
+    void Finish() override;
+    std::string Summary() const override;
+
+private:
+    std::string path_;
+    FILE* file_;
+    uint64_t bytes_;
+};
+
+// 对可见区域做Adler-32，用于比对不同版本/不同机器上的解码输出是否一致
+class ChecksumSink : public FrameSink {
+public:
+    ChecksumSink() : checksum_(1), frames_(0) {}
+    bool Consume(const AVFrame* frame) override;
+    std::string Summary() const override;
+    uint32_t Checksum() const { return checksum_; }
+
+private:
+    uint32_t checksum_;
+    uint64_t frames_;
+};
+
+// type: "null" | "file" | "checksum"，未知类型或文件无法打开时返回nullptr
+std::unique_ptr<FrameSink> CreateFrameSink(const std::string& type, const std::string& path);
+
+#endif
@@ -0,0 +1,284 @@
+//接收端自适应抖动缓冲区实现
+
+#include "jitter_buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const double kJitterGain = 1.0 / 16;   // RFC 3550 抖动平滑系数
+    const double kJitterMultiplier = 3.0;  // 目标缓冲深度 = 下限 + 3倍抖动
+}
+
+JitterBuffer::JitterBuffer(const JitterBufferConfig& config)
+    : config_(config),
+      started_(false),
+      next_frame_id_(0),
+      last_playout_us_(0),
+      waiting_keyframe_(false),
+      last_keyframe_request_us_(0),
+      clock_anchored_(false),
+      last_timestamp_(0),
+      timestamp_ext_(0),
+      base_transit_us_(0),
+      last_frame_arrival_us_(0),
+      jitter_us_(0),
+      target_delay_us_(config.min_delay_us),
+      delay_floor_us_(0),
+      lost_frames_(0),
+      late_fragments_(0) {
+    config_.clock_rate = std::max<uint32_t>(config_.clock_rate, 1);
+    // 分片下标使用uint16_t，kNoFragment保留
+    config_.fragment_slots = std::min<size_t>(config_.fragment_slots, kNoFragment);
+    config_.max_fragments_per_frame = std::min<size_t>(config_.max_fragments_per_frame, kNoFragment);
+
+    frames_.resize(config_.frame_slots);
+    frag_index_.assign(config_.frame_slots * config_.max_fragments_per_frame, kNoFragment);
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        frames_[i].in_use = false;
+        frames_[i].fragments = &frag_index_[i * config_.max_fragments_per_frame];
+    }
+
+    frag_pool_.resize(config_.fragment_slots * config_.fragment_size);
+    frag_len_.resize(config_.fragment_slots);
+    frag_unit_end_.resize(config_.fragment_slots);
+    free_frags_.reserve(config_.fragment_slots);
+    for (size_t i = config_.fragment_slots; i > 0; --i) {
+        free_frags_.push_back(static_cast<uint16_t>(i - 1));
+    }
+    assembly_.resize(config_.max_fragments_per_frame * config_.fragment_size);
+}
+
+bool JitterBuffer::Insert(uint32_t seq, uint16_t fragment_id, uint16_t total_fragments, bool keyframe, bool unit_end,
+                          uint32_t timestamp, const uint8_t* payload, size_t len, uint64_t now_us) {
+    if (!payload || len == 0 || len > config_.fragment_size) return false;
+    if (total_fragments == 0 || total_fragments > config_.max_fragments_per_frame ||
+        fragment_id >= total_fragments) {
+        return false;
+    }
+
+    uint32_t frame_id = seq - fragment_id;
+    if (started_ && Before(frame_id, next_frame_id_)) {
+        ++late_fragments_;  // 所属帧已出队或已判定丢失
+        return false;
+    }
+    if (!started_ && (!HeadFrame() || Before(frame_id, next_frame_id_))) {
+        next_frame_id_ = frame_id;  // 首帧出队前以见到的最早帧为起点，容忍开头的乱序
+    }
+
+    FrameSlot* slot = FindFrame(frame_id);
+    if (!slot) {
+        slot = AllocFrame(frame_id, total_fragments, timestamp, now_us);
+        if (!slot) return false;
+    } else if (slot->total_fragments != total_fragments) {
+        return false;  // 与已收分片的帧信息不一致
+    }
+
+    if (slot->fragments[fragment_id] != kNoFragment) return false;  // 重复分片
+    if (free_frags_.empty()) return false;
+
+    uint16_t idx = free_frags_.back();
+    free_frags_.pop_back();
+    memcpy(&frag_pool_[idx * config_.fragment_size], payload, len);
+    frag_len_[idx] = static_cast<uint16_t>(len);
+    frag_unit_end_[idx] = unit_end;
+    slot->fragments[fragment_id] = idx;
+    ++slot->received;
+    slot->keyframe = slot->keyframe || keyframe;
+    return true;
+}
+
+bool JitterBuffer::PopFrame(uint64_t now_us, JitterFrame* out) {
+    FrameSlot* head = FindFrame(next_frame_id_);
+
+    if (!head) {
+        // 期望的帧一个分片都没到: 后续帧的播放时间到达时判定整帧丢失
+        FrameSlot* earliest = HeadFrame();
+        if (!earliest || !started_ || now_us < earliest->playout_us) return false;
+
+        out->data = nullptr;
+        out->size = 0;
+        out->frame_id = next_frame_id_;
+        out->timestamp = 0;
+        out->arrival_us = 0;
+        out->keyframe = false;
+        out->conceal = true;
+        out->frame_start = true;
+        out->frame_end = true;
+        next_frame_id_ = earliest->frame_id;
+        ++lost_frames_;
+        RequestKeyframe(now_us);
+        return true;
+    }
+
+    if (now_us < head->playout_us) return false;
+
+    if (head->received < head->total_fragments) {
+        // 截止时间已过仍不完整: 丢弃并要求错误隐藏，同时加深缓冲
+        out->data = nullptr;
+        out->size = 0;
+        out->frame_id = head->frame_id;
+        out->timestamp = head->timestamp;
+        out->arrival_us = head->first_arrival_us;
+        out->keyframe = head->keyframe;
+        out->conceal = true;
+        out->frame_start = head->emitted == 0;   // 逐片出队时可能已交出前面的切片
+        out->frame_end = true;
+        next_frame_id_ = head->frame_id + head->total_fragments;
+        started_ = true;
+        ++lost_frames_;
+        jitter_us_ += config_.frame_interval_us / 3.0;
+        FreeFrame(head);
+        RequestKeyframe(now_us);
+        return true;
+    }
+
+    Assemble(head, head->emitted, head->total_fragments, out);
+    CompleteFrame(head, now_us);
+    return true;
+}
+
+bool JitterBuffer::PopSlices(uint64_t now_us, JitterFrame* out) {
+    FrameSlot* head = FindFrame(next_frame_id_);
+    if (head) {
+        uint16_t ready = head->emitted;
+        for (uint16_t i = head->emitted; i < head->total_fragments && head->fragments[i] != kNoFragment; ++i) {
+            if (frag_unit_end_[head->fragments[i]]) ready = i + 1;
+        }
+        if (ready > head->emitted) {
+            Assemble(head, head->emitted, ready, out);
+            head->emitted = ready;
+            started_ = true;   // 已有数据交给解码器，起点不再因乱序前移
+            if (ready == head->total_fragments) CompleteFrame(head, now_us);
+            return true;
+        }
+    }
+    // 没有可交出的切片: 截止时间到达时按整帧规则判定丢失
+    return PopFrame(now_us, out);
+}
+
+void JitterBuffer::Assemble(const FrameSlot* slot, uint16_t begin, uint16_t end, JitterFrame* out) {
+    // 按分片顺序拼接
+    size_t offset = 0;
+    for (uint16_t i = begin; i < end; ++i) {
+        uint16_t idx = slot->fragments[i];
+        memcpy(&assembly_[offset], &frag_pool_[idx * config_.fragment_size], frag_len_[idx]);
+        offset += frag_len_[idx];
+    }
+
+    out->data = assembly_.data();
+    out->size = offset;
+    out->frame_id = slot->frame_id;
+    out->timestamp = slot->timestamp;
+    out->arrival_us = slot->first_arrival_us;
+    out->keyframe = slot->keyframe;
+    out->conceal = false;
+    out->frame_start = begin == 0;
+    out->frame_end = end == slot->total_fragments;
+}
+
+void JitterBuffer::CompleteFrame(FrameSlot* slot, uint64_t now_us) {
+    if (slot->keyframe) {
+        waiting_keyframe_ = false;
+    } else if (waiting_keyframe_) {
+        RequestKeyframe(now_us);  // 关键帧到达前按间隔重复请求
+    }
+    next_frame_id_ = slot->frame_id + slot->total_fragments;
+    last_playout_us_ = now_us;
+    started_ = true;
+    FreeFrame(slot);
+}
+
+uint64_t JitterBuffer::NextDeadline() const {
+    uint64_t deadline = UINT64_MAX;
+    for (const FrameSlot& f : frames_) {
+        if (f.in_use) deadline = std::min(deadline, f.playout_us);
+    }
+    return deadline;
+}
+
+JitterBuffer::FrameSlot* JitterBuffer::FindFrame(uint32_t frame_id) {
+    for (FrameSlot& f : frames_) {
+        if (f.in_use && f.frame_id == frame_id) return &f;
+    }
+    return nullptr;
+}
+
+JitterBuffer::FrameSlot* JitterBuffer::AllocFrame(uint32_t frame_id, uint16_t total_fragments, uint32_t timestamp,
+                                                  uint64_t now_us) {
+    for (FrameSlot& f : frames_) {
+        if (f.in_use) continue;
+        UpdateJitter(now_us);
+        f.in_use = true;
+        f.keyframe = false;
+        f.frame_id = frame_id;
+        f.timestamp = timestamp;
+        f.total_fragments = total_fragments;
+        f.received = 0;
+        f.emitted = 0;
+        f.first_arrival_us = now_us;
+        f.playout_us = PlayoutTime(timestamp, now_us);
+        return &f;
+    }
+    return nullptr;  // 帧槽已满
+}
+
+uint64_t JitterBuffer::PlayoutTime(uint32_t timestamp, uint64_t now_us) {
+    if (!clock_anchored_) {
+        last_timestamp_ = timestamp;
+        timestamp_ext_ = 0;
+    }
+    // 按与最新时间戳的有符号差展开回绕，乱序或B帧的较早时间戳不推进基准
+    const int64_t ext = timestamp_ext_ + static_cast<int32_t>(timestamp - last_timestamp_);
+    if (ext > timestamp_ext_) {
+        timestamp_ext_ = ext;
+        last_timestamp_ = timestamp;
+    }
+    const int64_t media_us = ext * 1000000 / config_.clock_rate;
+    const int64_t transit_us = static_cast<int64_t>(now_us) - media_us;
+    // 以最小传输时延锚定; 时延比基准高出缓冲上限 (路径变化、发送端时间戳跳变) 时按本帧重新锚定
+    if (!clock_anchored_ || transit_us < base_transit_us_ ||
+        transit_us - base_transit_us_ > static_cast<int64_t>(config_.max_delay_us)) {
+        base_transit_us_ = transit_us;
+        clock_anchored_ = true;
+    }
+    return static_cast<uint64_t>(media_us + base_transit_us_) + target_delay_us_;
+}
+
+JitterBuffer::FrameSlot* JitterBuffer::HeadFrame() {
+    FrameSlot* head = nullptr;
+    for (FrameSlot& f : frames_) {
+        if (f.in_use && (!head || Before(f.frame_id, head->frame_id))) head = &f;
+    }
+    return head;
+}
+
+void JitterBuffer::FreeFrame(FrameSlot* slot) {
+    for (uint16_t i = 0; i < slot->total_fragments; ++i) {
+        if (slot->fragments[i] != kNoFragment) {
+            free_frags_.push_back(slot->fragments[i]);
+            slot->fragments[i] = kNoFragment;
+        }
+    }
+    slot->in_use = false;
+}
+
+void JitterBuffer::UpdateJitter(uint64_t arrival_us) {
+    if (last_frame_arrival_us_ != 0) {
+        double d = static_cast<double>(arrival_us - last_frame_arrival_us_) - config_.frame_interval_us;
+        jitter_us_ += (std::abs(d) - jitter_us_) * kJitterGain;
+    }
+    last_frame_arrival_us_ = arrival_us;
+
+    double target = config_.min_delay_us + kJitterMultiplier * jitter_us_;
+    target = std::max<double>(target, delay_floor_us_);
+    target = std::min<double>(std::max<double>(target, config_.min_delay_us), config_.max_delay_us);
+    target_delay_us_ = static_cast<uint32_t>(target);
+}
+
+void JitterBuffer::RequestKeyframe(uint64_t now_us) {
+    waiting_keyframe_ = true;
+    if (now_us - last_keyframe_request_us_ < config_.keyframe_request_interval_us) return;
+    last_keyframe_request_us_ = now_us;
+    if (keyframe_handler_) keyframe_handler_();
+}
@@ -0,0 +1,133 @@
+//接收端自适应抖动缓冲区声明
+
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+struct JitterBufferConfig {
+    uint32_t frame_interval_us = 33333;   // 标称帧间隔 (30fps)
+    uint32_t clock_rate = 90000;          // 帧时间戳频率
+    uint32_t min_delay_us = 10000;        // 缓冲深度下限
+    uint32_t max_delay_us = 500000;       // 缓冲深度上限
+    size_t frame_slots = 64;              // 同时在途的最大帧数
+    size_t fragment_slots = 4096;         // 分片池容量
+    size_t fragment_size = 1500;          // 单个分片的最大负载
+    size_t max_fragments_per_frame = 1024;
+    uint32_t keyframe_request_interval_us = 200000;  // 关键帧请求的最小间隔
+};
+
+// 出队的帧: conceal为true时表示该帧已丢失 (data为空)，解码端应做错误隐藏。
+// PopSlices可能把一帧分几次交出，frame_start/frame_end标明本段是否为帧的开头/结尾
+struct JitterFrame {
+    const uint8_t* data;     // 指向内部拼接缓冲区，下次出队前有效
+    size_t size;
+    uint32_t frame_id;       // 帧首分片的seq
+    uint32_t timestamp;      // 媒体时间戳 (取自帧的分片)
+    uint64_t arrival_us;     // 帧首个到达分片的到达时刻 (整帧未到时为0)
+    bool keyframe;
+    bool conceal;
+    bool frame_start;
+    bool frame_end;
+};
+
+// 按seq重组帧，播放时刻 = 媒体时刻 + 最小传输时延 + 目标缓冲深度 (首帧锚定)，超过截止时间判丢失
+// 预分配、非线程安全
+class JitterBuffer {
+public:
+    using KeyframeRequestHandler = std::function<void()>;
+
+    explicit JitterBuffer(const JitterBufferConfig& config = JitterBufferConfig());
+
+    // 插入一个分片。frame_id = seq - fragment_id; unit_end表示分片结束于可独立解码的单元 (NAL) 边界
+    // 返回false表示分片被丢弃 (重复、过期、超出容量)
+    bool Insert(uint32_t seq, uint16_t fragment_id, uint16_t total_fragments, bool keyframe, bool unit_end,
+                uint32_t timestamp, const uint8_t* payload, size_t len, uint64_t now_us);
+
+    // 取出下一个到达播放时间的帧，没有可出队的帧时返回false
+    bool PopFrame(uint64_t now_us, JitterFrame* out);
+
+    // 逐片出队: 当前帧从上次交出处起连续到达、且结束于单元边界的分片立即交出，不等播放时间;
+    // 帧不完整时仍按播放截止时间判定丢失。与PopFrame二选一使用
+    bool PopSlices(uint64_t now_us, JitterFrame* out);
+
+    // 下一次需要调用PopFrame的时间，用于接收线程计算等待超时
+    uint64_t NextDeadline() const;
+
+    void SetKeyframeRequestHandler(KeyframeRequestHandler handler) { keyframe_handler_ = std::move(handler); }
+
+    // 缓冲深度不低于floor_us (仍受max_delay_us限制)，用于让另一路流的播放延迟与之对齐
+    void SetDelayFloor(uint32_t floor_us) { delay_floor_us_ = floor_us; }
+
+    uint32_t GetTargetDelay() const { return target_delay_us_; }
+    uint32_t GetJitter() const { return static_cast<uint32_t>(jitter_us_); }
+    uint64_t GetLostFrames() const { return lost_frames_; }
+    uint64_t GetLateFragments() const { return late_fragments_; }
+
+private:
+    static constexpr uint16_t kNoFragment = 0xFFFF;
+
+    struct FrameSlot {
+        bool in_use;
+        bool keyframe;
+        uint32_t frame_id;
+        uint32_t timestamp;
+        uint16_t total_fragments;
+        uint16_t received;
+        uint16_t emitted;         // 已交出的分片数 (逐片出队)
+        uint64_t first_arrival_us;
+        uint64_t playout_us;
+        uint16_t* fragments;      // 指向frag_index_中本帧的区段，元素为分片池下标
+    };
+
+    FrameSlot* FindFrame(uint32_t frame_id);
+    FrameSlot* AllocFrame(uint32_t frame_id, uint16_t total_fragments, uint32_t timestamp, uint64_t now_us);
+    uint64_t PlayoutTime(uint32_t timestamp, uint64_t now_us);
+    FrameSlot* HeadFrame();
+    // 拼接[begin, end)分片到out; 帧的最后一段交出后由CompleteFrame推进到下一帧
+    void Assemble(const FrameSlot* slot, uint16_t begin, uint16_t end, JitterFrame* out);
+    void CompleteFrame(FrameSlot* slot, uint64_t now_us);
+    void FreeFrame(FrameSlot* slot);
+    void UpdateJitter(uint64_t arrival_us);
+    void RequestKeyframe(uint64_t now_us);
+    static bool Before(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+    JitterBufferConfig config_;
+
+    // 预分配存储
+    std::vector<FrameSlot> frames_;
+    std::vector<uint16_t> frag_index_;
+    std::vector<uint8_t> frag_pool_;
+    std::vector<uint16_t> frag_len_;
+    std::vector<uint8_t> frag_unit_end_;
+    std::vector<uint16_t> free_frags_;
+    std::vector<uint8_t> assembly_;
+
+    // 播放状态
+    bool started_;
+    uint32_t next_frame_id_;        // 下一帧期望的frame_id
+    uint64_t last_playout_us_;
+    bool waiting_keyframe_;
+    uint64_t last_keyframe_request_us_;
+
+    // 播放时钟
+    bool clock_anchored_;
+    uint32_t last_timestamp_;
+    int64_t timestamp_ext_;         // last_timestamp_展开32位回绕后相对首帧的值
+    int64_t base_transit_us_;       // 到达时刻减媒体时刻的最小值
+
+    // 抖动估计 (RFC 3550 到达间隔抖动)
+    uint64_t last_frame_arrival_us_;
+    double jitter_us_;
+    uint32_t target_delay_us_;
+    uint32_t delay_floor_us_;
+
+    uint64_t lost_frames_;
+    uint64_t late_fragments_;
+    KeyframeRequestHandler keyframe_handler_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+//自适应码率控制器实现
+
+#include "abr_controller.h"
+#include <algorithm>
+
+namespace {
+
+// 分辨率阶梯相对最高档的缩放比例 (分子/分母)
+const int kRungScale[4][2] = {{1, 1}, {2, 3}, {1, 2}, {1, 3}};
+
+}  // namespace
+
+AbrController::AbrController(const AbrConfig& config)
+    : config_(config), rung_(0), last_decrease_us_(0), last_increase_us_(0),
+      upswitch_since_us_(0), last_loss_(0) {
+    config_.min_bitrate = std::max<int64_t>(config_.min_bitrate, 1);
+    config_.max_bitrate = std::max(config_.max_bitrate, config_.min_bitrate);
+    config_.fps = std::max(config_.fps, 1);
+    target_.bitrate = Clamp(config_.start_bitrate > 0 ? config_.start_bitrate : config_.max_bitrate);
+    if (config_.adapt_resolution) {
+        while (rung_ + 1 < kRungs && target_.bitrate < RungBitrate(rung_)) rung_++;
+    }
+    SetRungSize(rung_, &target_.width, &target_.height);
+}
+
+void AbrController::SetRungSize(int rung, int* width, int* height) const {
+    // 宽高取偶数，满足YUV420的色度采样要求
+    *width = std::max(2, (config_.max_width * kRungScale[rung][0] / kRungScale[rung][1]) & ~1);
+    *height = std::max(2, (config_.max_height * kRungScale[rung][0] / kRungScale[rung][1]) & ~1);
+}
+
+int64_t AbrController::RungBitrate(int rung) const {
+    int width = 0, height = 0;
+    SetRungSize(rung, &width, &height);
+    return static_cast<int64_t>(static_cast<double>(width) * height * config_.fps * config_.min_bits_per_pixel);
+}
+
+int64_t AbrController::Clamp(int64_t bitrate) const {
+    return std::min(std::max(bitrate, config_.min_bitrate), config_.max_bitrate);
+}
+
+bool AbrController::Update(const NetworkFeedback& fb) {
+    const uint32_t total = fb.acked + fb.lost;
+    if (total > 0) last_loss_ = static_cast<double>(fb.lost) / total;
+    const uint32_t queue_delay = fb.srtt_us > fb.min_rtt_us ? fb.srtt_us - fb.min_rtt_us : 0;
+    const bool congested = last_loss_ > config_.loss_threshold ||
+                           (fb.min_rtt_us > 0 && queue_delay > config_.max_queue_delay_us);
+
+    int64_t bitrate = target_.bitrate;
+    const uint64_t decrease_interval = static_cast<uint64_t>(config_.decrease_interval_ms) * 1000;
+    const uint64_t increase_interval = static_cast<uint64_t>(config_.increase_interval_ms) * 1000;
+    if (congested) {
+        if (fb.now_us - last_decrease_us_ >= decrease_interval) {
+            // 拥塞时带宽估计接近实际可用带宽，直接降到该值附近，但单次最多减半
+            int64_t next = static_cast<int64_t>(bitrate * config_.decrease_factor);
+            if (fb.bandwidth_bps > 0) next = std::min<int64_t>(next, fb.bandwidth_bps);
+            bitrate = std::max(next, bitrate / 2);
+            last_decrease_us_ = fb.now_us;
+        }
+    } else if (total > 0 && last_loss_ <= config_.loss_threshold / 2 &&
+               fb.now_us - last_increase_us_ >= increase_interval &&
+               fb.now_us - last_decrease_us_ >= 2 * increase_interval) {
+        bitrate = static_cast<int64_t>(bitrate * (1 + config_.increase_step));
+        last_increase_us_ = fb.now_us;
+    }
+    bitrate = Clamp(bitrate);
+
+    int rung = rung_;
+    if (config_.adapt_resolution) {
+        // 降档: 码率低于本档下限的90%立即降; 升档: 码率达到上一档下限的125%并保持一段时间
+        while (rung + 1 < kRungs && bitrate < RungBitrate(rung) * 9 / 10) rung++;
+        if (rung == rung_ && rung > 0 && bitrate >= RungBitrate(rung - 1) * 5 / 4) {
+            if (upswitch_since_us_ == 0) {
+                upswitch_since_us_ = fb.now_us;
+            } else if (fb.now_us - upswitch_since_us_ >= static_cast<uint64_t>(config_.upswitch_hold_ms) * 1000) {
+                rung--;
+            }
+        } else {
+            upswitch_since_us_ = 0;
+        }
+    }
+
+    if (bitrate == target_.bitrate && rung == rung_) return false;
+    if (rung != rung_) upswitch_since_us_ = 0;
+    rung_ = rung;
+    target_.bitrate = bitrate;
+    SetRungSize(rung_, &target_.width, &target_.height);
+    return true;
+}
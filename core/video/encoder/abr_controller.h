@@ -0,0 +1,70 @@
+//自适应码率控制器声明
+
+#ifndef ABR_CONTROLLER_H
+#define ABR_CONTROLLER_H
+
+#include <cstdint>
+
+struct AbrConfig {
+    int64_t min_bitrate = 300000;
+    int64_t max_bitrate = 2500000;
+    int64_t start_bitrate = 0;             // 0表示从max_bitrate开始
+    int max_width = 1280;                  // 分辨率阶梯的最高档 (编码器配置的分辨率)
+    int max_height = 720;
+    int fps = 30;
+    bool adapt_resolution = true;
+
+    double loss_threshold = 0.05;          // 周期丢包率超过该值视为拥塞
+    uint32_t max_queue_delay_us = 40000;   // srtt - min_rtt 超过该值视为瓶颈排队
+    uint32_t decrease_interval_ms = 300;   // 相邻两次降码率的最小间隔 (等上次调整生效)
+    uint32_t increase_interval_ms = 1000;  // 无拥塞时每隔多久上调一次
+    double increase_step = 0.08;
+    double decrease_factor = 0.85;
+    double min_bits_per_pixel = 0.05;      // 每档分辨率所需的最低码率 = 像素数 * fps * bpp
+    uint32_t upswitch_hold_ms = 4000;      // 码率持续足够高多久后才切到更高分辨率
+};
+
+// 一个反馈周期内的网络状况 (由发送端从拥塞控制器和ACK/丢包计数汇总)
+struct NetworkFeedback {
+    uint64_t now_us;
+    uint64_t bandwidth_bps;     // 瓶颈带宽估计; 发送受码率限制时接近当前码率，0表示尚无样本
+    uint32_t srtt_us;
+    uint32_t min_rtt_us;
+    uint32_t acked;             // 本周期确认的包数
+    uint32_t lost;              // 本周期判定丢失的包数
+};
+
+struct EncoderTarget {
+    int64_t bitrate;
+    int width;
+    int height;
+};
+
+// 类GCC的码率控制: 拥塞信号出现时按带宽估计下调，否则缓慢上调，分辨率随码率切换; 非线程安全
+class AbrController {
+public:
+    explicit AbrController(const AbrConfig& config);
+
+    // 返回true表示目标码率或分辨率有变化
+    bool Update(const NetworkFeedback& feedback);
+
+    const EncoderTarget& Target() const { return target_; }
+    double LastLoss() const { return last_loss_; }
+
+private:
+    static const int kRungs = 4;
+
+    void SetRungSize(int rung, int* width, int* height) const;
+    int64_t RungBitrate(int rung) const;
+    int64_t Clamp(int64_t bitrate) const;
+
+    AbrConfig config_;
+    EncoderTarget target_;
+    int rung_;                        // 0为最高分辨率
+    uint64_t last_decrease_us_;
+    uint64_t last_increase_us_;
+    uint64_t upswitch_since_us_;      // 码率满足更高一档的起始时间，0表示未满足
+    double last_loss_;
+};
+
+#endif
@@ -0,0 +1,255 @@
+//AVFrame/AVPacket对象池实现
+
+#include "frame_pool.h"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/samplefmt.h>
+}
+
+#include <errno.h>
+#include <string.h>
+
+namespace {
+
+const int kImageAlign = 64;     // 行宽与平面起点对齐，满足SIMD缩放/编码的要求
+
+}  // namespace
+
+FramePool::FramePool()
+    : shell_hits_(0), shell_misses_(0), buffer_requests_(0), buffer_misses_(0), outstanding_(0) {}
+
+FramePool::~FramePool() {
+    for (AVFrame* frame : free_) av_frame_free(&frame);
+    // 仍被引用的缓冲在最后一个引用释放时才真正回收
+    for (auto& bucket : buckets_) av_buffer_pool_uninit(&bucket.second);
+}
+
+AVBufferRef* FramePool::AllocBuffer(void* opaque, size_t size) {
+    static_cast<FramePool*>(opaque)->buffer_misses_.fetch_add(1, std::memory_order_relaxed);
+    return av_buffer_alloc(size);
+}
+
+AVBufferRef* FramePool::GetBuffer(const Key& key, size_t size) {
+    AVBufferPool* pool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = buckets_.find(key);
+        if (it == buckets_.end()) {
+            pool = av_buffer_pool_init2(size, this, &FramePool::AllocBuffer, nullptr);
+            if (!pool) return nullptr;
+            buckets_.emplace(key, pool);
+        } else {
+            pool = it->second;
+        }
+    }
+    buffer_requests_.fetch_add(1, std::memory_order_relaxed);
+    return av_buffer_pool_get(pool);
+}
+
+AVFrame* FramePool::Acquire() {
+    AVFrame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            frame = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (frame) {
+        shell_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        frame = av_frame_alloc();
+        if (!frame) return nullptr;
+        shell_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    return frame;
+}
+
+AVFrame* FramePool::AcquireVideo(AVPixelFormat format, int width, int height) {
+    int size = av_image_get_buffer_size(format, width, height, kImageAlign);
+    if (size < 0) return nullptr;
+
+    AVFrame* frame = Acquire();
+    if (!frame) return nullptr;
+    // 尾部留出填充，SIMD越界读取不会触及下一块内存
+    frame->buf[0] = GetBuffer(Key(0, format, width, height), size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!frame->buf[0] ||
+        av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data,
+                             format, width, height, kImageAlign) < 0) {
+        Release(&frame);
+        return nullptr;
+    }
+    frame->extended_data = frame->data;
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    return frame;
+}
+
+AVFrame* FramePool::AcquireAudio(AVSampleFormat format, const AVChannelLayout& layout,
+                                 int sample_rate, int nb_samples) {
+    AVFrame* frame = Acquire();
+    if (!frame) return nullptr;
+    frame->format = format;
+    frame->sample_rate = sample_rate;
+    frame->nb_samples = nb_samples;
+    if (av_channel_layout_copy(&frame->ch_layout, &layout) < 0) {
+        Release(&frame);
+        return nullptr;
+    }
+
+    const int channels = layout.nb_channels;
+    if (av_sample_fmt_is_planar(format) && channels > AV_NUM_DATA_POINTERS) {
+        // 平面数超过data[]容量时需要独立的extended_data，交给FFmpeg分配
+        buffer_requests_.fetch_add(1, std::memory_order_relaxed);
+        buffer_misses_.fetch_add(1, std::memory_order_relaxed);
+        if (av_frame_get_buffer(frame, 0) < 0) Release(&frame);
+        return frame;
+    }
+
+    int linesize = 0;
+    int size = av_samples_get_buffer_size(&linesize, channels, nb_samples, format, 0);
+    if (size < 0) {
+        Release(&frame);
+        return nullptr;
+    }
+    frame->buf[0] = GetBuffer(Key(1, format, channels, nb_samples), size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!frame->buf[0] ||
+        av_samples_fill_arrays(frame->data, &linesize, frame->buf[0]->data,
+                               channels, nb_samples, format, 0) < 0) {
+        Release(&frame);
+        return nullptr;
+    }
+    frame->linesize[0] = linesize;
+    frame->extended_data = frame->data;
+    return frame;
+}
+
+void FramePool::Release(AVFrame** frame) {
+    if (!frame || !*frame) return;
+    av_frame_unref(*frame);
+    outstanding_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < kPoolMaxFreeShells) {
+            free_.push_back(*frame);
+            *frame = nullptr;
+            return;
+        }
+    }
+    av_frame_free(frame);
+}
+
+PoolStats FramePool::GetStats() const {
+    PoolStats s;
+    s.shell_hits = shell_hits_.load(std::memory_order_relaxed);
+    s.shell_misses = shell_misses_.load(std::memory_order_relaxed);
+    s.buffer_misses = buffer_misses_.load(std::memory_order_relaxed);
+    uint64_t requests = buffer_requests_.load(std::memory_order_relaxed);
+    s.buffer_hits = requests > s.buffer_misses ? requests - s.buffer_misses : 0;
+    s.outstanding = outstanding_.load(std::memory_order_relaxed);
+    return s;
+}
+
+PacketPool::PacketPool()
+    : shell_hits_(0), shell_misses_(0), buffer_requests_(0), buffer_misses_(0), outstanding_(0) {
+    for (int i = 0; i <= kMaxClassBits - kMinClassBits; i++) {
+        classes_[i] = av_buffer_pool_init2(size_t(1) << (kMinClassBits + i), this, &PacketPool::AllocBuffer, nullptr);
+    }
+}
+
+PacketPool::~PacketPool() {
+    for (AVPacket* pkt : free_) av_packet_free(&pkt);
+    for (AVBufferPool*& pool : classes_) av_buffer_pool_uninit(&pool);
+}
+
+AVBufferRef* PacketPool::AllocBuffer(void* opaque, size_t size) {
+    static_cast<PacketPool*>(opaque)->buffer_misses_.fetch_add(1, std::memory_order_relaxed);
+    return av_buffer_alloc(size);
+}
+
+AVPacket* PacketPool::Acquire() {
+    AVPacket* pkt = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            pkt = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (pkt) {
+        shell_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        pkt = av_packet_alloc();
+        if (!pkt) return nullptr;
+        shell_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    return pkt;
+}
+
+bool PacketPool::AllocData(AVPacket* pkt, int size) {
+    if (size < 0) return false;
+    buffer_requests_.fetch_add(1, std::memory_order_relaxed);
+
+    const size_t need = static_cast<size_t>(size) + AV_INPUT_BUFFER_PADDING_SIZE;
+    int bits = kMinClassBits;
+    while (bits <= kMaxClassBits && (size_t(1) << bits) < need) bits++;
+    if (bits > kMaxClassBits || !classes_[bits - kMinClassBits]) {
+        buffer_misses_.fetch_add(1, std::memory_order_relaxed);
+        AVBufferRef* buf = av_buffer_alloc(need);
+        if (!buf) return false;
+        pkt->buf = buf;
+    } else {
+        pkt->buf = av_buffer_pool_get(classes_[bits - kMinClassBits]);
+        if (!pkt->buf) return false;
+    }
+    pkt->data = pkt->buf->data;
+    pkt->size = size;
+    memset(pkt->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return true;
+}
+
+AVPacket* PacketPool::AcquireData(int size) {
+    AVPacket* pkt = Acquire();
+    if (pkt && !AllocData(pkt, size)) Release(&pkt);
+    return pkt;
+}
+
+void PacketPool::Release(AVPacket** pkt) {
+    if (!pkt || !*pkt) return;
+    av_packet_unref(*pkt);
+    outstanding_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < kPoolMaxFreeShells) {
+            free_.push_back(*pkt);
+            *pkt = nullptr;
+            return;
+        }
+    }
+    av_packet_free(pkt);
+}
+
+int PacketPool::GetEncodeBuffer(AVCodecContext* ctx, AVPacket* pkt, int) {
+    PacketPool* pool = static_cast<PacketPool*>(ctx->opaque);
+    return pool->AllocData(pkt, pkt->size) ? 0 : AVERROR(ENOMEM);
+}
+
+void PacketPool::AttachEncoder(AVCodecContext* encoder) {
+    encoder->opaque = this;
+    encoder->get_encode_buffer = &PacketPool::GetEncodeBuffer;
+}
+
+PoolStats PacketPool::GetStats() const {
+    PoolStats s;
+    s.shell_hits = shell_hits_.load(std::memory_order_relaxed);
+    s.shell_misses = shell_misses_.load(std::memory_order_relaxed);
+    s.buffer_misses = buffer_misses_.load(std::memory_order_relaxed);
+    uint64_t requests = buffer_requests_.load(std::memory_order_relaxed);
+    s.buffer_hits = requests > s.buffer_misses ? requests - s.buffer_misses : 0;
+    s.outstanding = outstanding_.load(std::memory_order_relaxed);
+    return s;
+}
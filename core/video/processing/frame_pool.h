@@ -0,0 +1,105 @@
+//AVFrame/AVPacket对象池声明
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// 空闲链表保留的结构体上限，超出的直接释放
+const size_t kPoolMaxFreeShells = 256;
+
+// 命中: 从空闲链表或缓冲池直接取得; 未命中: 需要新分配
+struct PoolStats {
+    uint64_t shell_hits;        // AVFrame/AVPacket结构体复用
+    uint64_t shell_misses;
+    uint64_t buffer_hits;       // 数据缓冲复用
+    uint64_t buffer_misses;
+    uint64_t outstanding;       // 已取出未归还的结构体
+};
+
+// 按(格式, 尺寸, 样本数)分桶的AVFrame池，缓冲来自AVBufferPool; 线程安全
+class FramePool {
+public:
+    FramePool();
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // 取一个空的AVFrame (供解码器等自行填充)
+    AVFrame* Acquire();
+    // 取一个已分配好缓冲的视频帧/音频帧，内容未初始化
+    AVFrame* AcquireVideo(AVPixelFormat format, int width, int height);
+    AVFrame* AcquireAudio(AVSampleFormat format, const AVChannelLayout& layout, int sample_rate, int nb_samples);
+    // 归还帧 (nullptr忽略)，并把指针置空
+    void Release(AVFrame** frame);
+
+    PoolStats GetStats() const;
+
+private:
+    // (类型, 格式, 宽或声道数, 高或样本数)，同一个键对应的缓冲大小固定
+    typedef std::tuple<int, int, int, int> Key;
+
+    AVBufferRef* GetBuffer(const Key& key, size_t size);
+    static AVBufferRef* AllocBuffer(void* opaque, size_t size);
+
+    mutable std::mutex mutex_;
+    std::vector<AVFrame*> free_;
+    std::map<Key, AVBufferPool*> buckets_;
+    std::atomic<uint64_t> shell_hits_;
+    std::atomic<uint64_t> shell_misses_;
+    std::atomic<uint64_t> buffer_requests_;
+    std::atomic<uint64_t> buffer_misses_;
+    std::atomic<uint64_t> outstanding_;
+};
+
+// 压缩包池，线程安全。AttachEncoder后支持直接渲染(DR1)的编码器把码流写入
+// 按2的幂分级的缓冲池，而不是每包重新分配
+class PacketPool {
+public:
+    PacketPool();
+    ~PacketPool();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    AVPacket* Acquire();
+    // 取一个带size字节数据缓冲的包 (尾部填充已清零)
+    AVPacket* AcquireData(int size);
+    void Release(AVPacket** pkt);
+
+    // 编码器输出包的数据缓冲改为从本池分配 (须在avcodec_open2之前调用; 池须比编码器活得久)
+    void AttachEncoder(AVCodecContext* encoder);
+
+    PoolStats GetStats() const;
+
+private:
+    static constexpr int kMinClassBits = 12;    // 4KB
+    static constexpr int kMaxClassBits = 24;    // 16MB，更大的包直接分配
+
+    static int GetEncodeBuffer(AVCodecContext* ctx, AVPacket* pkt, int flags);
+    static AVBufferRef* AllocBuffer(void* opaque, size_t size);
+    bool AllocData(AVPacket* pkt, int size);
+
+    mutable std::mutex mutex_;
+    std::vector<AVPacket*> free_;
+    AVBufferPool* classes_[kMaxClassBits - kMinClassBits + 1];
+    std::atomic<uint64_t> shell_hits_;
+    std::atomic<uint64_t> shell_misses_;
+    std::atomic<uint64_t> buffer_requests_;
+    std::atomic<uint64_t> buffer_misses_;
+    std::atomic<uint64_t> outstanding_;
+};
+
+#endif
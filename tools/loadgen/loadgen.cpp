@@ -0,0 +1,781 @@
+//负载生成器: 在本机回环上模拟大量并发推流 (真实握手、封装与UDP传输)，测量服务端吞吐与延迟
+//  loadgen --sessions 2000 --duration 20
+
+#include "../../core/network/packets/packet_builder.h"
+#include "../../core/network/session/handshake.h"
+#include "../../core/network/session/session_manager.h"
+#include "../../core/network/transport/udp_transport.h"
+#include "../../core/security/asymmetric/sm2_curve.h"
+#include "../../core/storage/segment_reader.h"
+#include "../../utils/performance/frame_trace.h"
+#include "../../utils/performance/metrics.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t kFragmentPayload = 1200;       // 与发送端的分片长度一致
+const size_t kBatch = 64;
+const uint32_t kAacFrameSamples = 1024;
+const uint64_t kLateUs = 50000;             // 生成线程落后超过该值的数据报计为迟发
+
+std::atomic<bool> g_interrupted(false);
+
+void OnSignal(int) {
+    g_interrupted.store(true);
+}
+
+struct Options {
+    size_t sessions = 100;
+    double duration_sec = 10;
+    double warmup_sec = 2;
+    uint16_t port = 6000;
+    int rcvbuf = 8 << 20;                   // 服务端接收缓冲区，0为内核默认
+    size_t generators = 1;
+    int fps = 30;
+    int64_t video_bitrate = 2500000;
+    int gop = 120;
+    double keyframe_ratio = 8;              // I帧与P帧的大小比
+    int64_t audio_bitrate = 128000;         // 0为不带音频
+    int audio_sample_rate = 44100;
+    std::string replay_dir;
+    uint8_t key[16] = {};
+    bool has_key = false;
+    TransportBackend backend = TransportBackend::Syscall;
+    std::string metrics_path;
+};
+
+void Usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --sessions N             concurrent sessions (default 100)\n"
+        "  --duration SEC           measurement window (default 10)\n"
+        "  --warmup SEC             run before measuring (default 2)\n"
+        "  --generators N           sending threads (default 1)\n"
+        "  --port N                 server UDP port (default 6000)\n"
+        "  --backend syscall|uring  server receive backend; send path: tools/bench/send_bench\n"
+        "  --rcvbuf BYTES           server socket receive buffer, 0 keeps the kernel default (default 8388608)\n"
+        "  --fps N --video-bitrate BPS --gop N --keyframe-ratio R\n"
+        "                           synthetic H.264 trace (default 30, 2500000, 120, 8)\n"
+        "  --audio-bitrate BPS      synthetic AAC trace, 0 disables (default 128000)\n"
+        "  --replay DIR --key HEX32 loop the datagram trace of a recording instead\n"
+        "  --metrics FILE           export per-stage metrics (JSON lines)\n", prog);
+}
+
+bool ParseOptions(int argc, char* argv[], Options* opt) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--sessions") opt->sessions = static_cast<size_t>(atol(v));
+        else if (a == "--duration") opt->duration_sec = atof(v);
+        else if (a == "--warmup") opt->warmup_sec = atof(v);
+        else if (a == "--generators") opt->generators = static_cast<size_t>(atoi(v));
+        else if (a == "--port") opt->port = static_cast<uint16_t>(atoi(v));
+        else if (a == "--rcvbuf") opt->rcvbuf = atoi(v);
+        else if (a == "--backend") opt->backend = strcmp(v, "uring") == 0 ? TransportBackend::IoUring : TransportBackend::Syscall;
+        else if (a == "--fps") opt->fps = atoi(v);
+        else if (a == "--video-bitrate") opt->video_bitrate = atoll(v);
+        else if (a == "--gop") opt->gop = atoi(v);
+        else if (a == "--keyframe-ratio") opt->keyframe_ratio = atof(v);
+        else if (a == "--audio-bitrate") opt->audio_bitrate = atoll(v);
+        else if (a == "--replay") opt->replay_dir = v;
+        else if (a == "--key") opt->has_key = ParseStorageKey(v, opt->key);
+        else if (a == "--metrics") opt->metrics_path = v;
+        else return false;
+    }
+    // 会话地址为127.0.0.2起顺序分配，须留在127.0.0.0/8内
+    if (opt->sessions == 0 || opt->sessions > 0xFFFFFD || opt->rcvbuf < 0 || opt->generators == 0 || opt->duration_sec <= 0) return false;
+    if (opt->fps <= 0 || opt->gop <= 0 || opt->video_bitrate <= 0 || opt->keyframe_ratio < 1) return false;
+    return opt->replay_dir.empty() || opt->has_key;
+}
+
+uint64_t NowMicros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ull + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+// 本机UDP因接收缓冲区满被内核丢弃的数据报总数(/proc/net/snmp的RcvbufErrors)，读取失败返回-1
+int64_t UdpReceiveBufferErrors() {
+    FILE* fp = fopen("/proc/net/snmp", "r");
+    if (!fp) return -1;
+    char names[1024];
+    char values[1024];
+    int64_t result = -1;
+    while (fgets(names, sizeof(names), fp) && fgets(values, sizeof(values), fp)) {
+        if (strncmp(names, "Udp:", 4) != 0 || strncmp(values, "Udp:", 4) != 0) continue;
+        char* name_save = nullptr;
+        char* value_save = nullptr;
+        char* name = strtok_r(names + 4, " \n", &name_save);
+        char* value = strtok_r(values + 4, " \n", &value_save);
+        while (name && value) {
+            if (strcmp(name, "RcvbufErrors") == 0) {
+                result = atoll(value);
+                break;
+            }
+            name = strtok_r(nullptr, " \n", &name_save);
+            value = strtok_r(nullptr, " \n", &value_save);
+        }
+        break;
+    }
+    fclose(fp);
+    return result;
+}
+
+double ThreadCpuSeconds(std::thread& thread) {
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0 || clock_gettime(clock, &ts) != 0) return 0;
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+// 轨迹中的一个数据报 (明文)，按发出时刻排序; 每个会话从随机相位开始循环播放整条轨迹
+struct TraceDatagram {
+    uint64_t offset_us;
+    uint32_t timestamp;         // 相对轨迹起点 (MEDIA_CLOCK_HZ)
+    uint16_t fragment_id;
+    uint16_t total_fragments;
+    uint16_t len;
+    uint8_t stream_id;
+    uint8_t flags;              // KEYFRAME / UNIT_END
+};
+
+struct Trace {
+    std::vector<TraceDatagram> datagrams;
+    uint64_t period_us = 0;
+    uint32_t period_ts = 0;
+    uint64_t bytes = 0;         // 每个周期的明文字节数
+};
+
+void AddFrame(Trace* trace, uint64_t offset_us, uint32_t timestamp, size_t size, uint8_t stream, bool keyframe) {
+    const uint16_t total = static_cast<uint16_t>((size + kFragmentPayload - 1) / kFragmentPayload);
+    for (uint16_t i = 0; i < total; ++i) {
+        TraceDatagram d;
+        d.offset_us = offset_us;
+        d.timestamp = timestamp;
+        d.fragment_id = i;
+        d.total_fragments = total;
+        d.len = static_cast<uint16_t>(i + 1 < total ? kFragmentPayload : size - i * kFragmentPayload);
+        d.stream_id = stream;
+        d.flags = (keyframe ? PACKET_FLAG_KEYFRAME : 0) | (i + 1 == total ? PACKET_FLAG_UNIT_END : 0);
+        trace->datagrams.push_back(d);
+        trace->bytes += d.len;
+    }
+}
+
+// 一个GOP: 首帧为I帧，其余P帧，帧长在均值附近 ±20% 波动; AAC帧长固定
+void BuildSyntheticTrace(const Options& opt, Trace* trace) {
+    const double frame_bytes = static_cast<double>(opt.video_bitrate) / 8 / opt.fps;
+    const double p_bytes = frame_bytes * opt.gop / (opt.keyframe_ratio + opt.gop - 1);
+    uint32_t rng = 12345;
+    for (int k = 0; k < opt.gop; ++k) {
+        rng = rng * 1103515245u + 12345u;
+        const double jitter = 0.8 + 0.4 * static_cast<double>((rng >> 8) & 0xFFFF) / 65535.0;
+        const double bytes = (k == 0 ? opt.keyframe_ratio * p_bytes : p_bytes * jitter);
+        AddFrame(trace, static_cast<uint64_t>(k) * 1000000 / opt.fps,
+                 static_cast<uint32_t>(static_cast<uint64_t>(k) * MEDIA_CLOCK_HZ / opt.fps),
+                 std::max<size_t>(static_cast<size_t>(bytes), 1), MEDIA_STREAM_VIDEO, k == 0);
+    }
+    trace->period_us = static_cast<uint64_t>(opt.gop) * 1000000 / opt.fps;
+    trace->period_ts = static_cast<uint32_t>(static_cast<uint64_t>(opt.gop) * MEDIA_CLOCK_HZ / opt.fps);
+
+    if (opt.audio_bitrate > 0 && opt.audio_sample_rate > 0) {
+        const size_t bytes = std::max<size_t>(
+            static_cast<size_t>(opt.audio_bitrate / 8 * kAacFrameSamples / opt.audio_sample_rate), 1);
+        for (uint64_t n = 0;; ++n) {
+            const uint64_t offset = n * kAacFrameSamples * 1000000 / opt.audio_sample_rate;
+            if (offset >= trace->period_us) break;
+            AddFrame(trace, offset, static_cast<uint32_t>(n * kAacFrameSamples * MEDIA_CLOCK_HZ / opt.audio_sample_rate),
+                     bytes, MEDIA_STREAM_AUDIO, false);
+        }
+    }
+    std::stable_sort(trace->datagrams.begin(), trace->datagrams.end(),
+                     [](const TraceDatagram& a, const TraceDatagram& b) { return a.offset_us < b.offset_us; });
+}
+
+// 录制中通过校验的数据报按到达时刻排列，保留原有的突发与间隔
+bool LoadReplayTrace(const Options& opt, Trace* trace) {
+    Recording recording;
+    if (!recording.Open(opt.replay_dir)) {
+        fprintf(stderr, "[ERROR] No segments in %s\n", opt.replay_dir.c_str());
+        return false;
+    }
+    std::vector<uint8_t> plain(SEGMENT_MAX_RECORD);
+    bool first = true;
+    uint64_t first_arrival = 0;
+    uint32_t first_ts = 0;
+    for (size_t s = 0; s < recording.SegmentCount(); ++s) {
+        const SegmentReader& segment = recording.Segment(s);
+        RecordDecryptor decryptor;
+        if (!decryptor.Load(segment.Header(), opt.key)) {
+            fprintf(stderr, "[ERROR] Wrong storage key or corrupted segment %08u\n", segment.Header().sequence);
+            return false;
+        }
+        SegmentRecord record;
+        for (uint64_t pos = segment.DataBegin(); segment.ReadRecord(pos, &record); pos = record.next_offset) {
+            PacketHeader header;
+            const size_t len = decryptor.Open(record.data, record.len, &header, plain.data());
+            if (len == 0 || len > kFragmentPayload || header.stream_id >= MEDIA_STREAM_COUNT) continue;
+            if (first) {
+                first_arrival = record.arrival_us;
+                first_ts = header.timestamp;
+                first = false;
+            }
+            TraceDatagram d;
+            d.offset_us = record.arrival_us - first_arrival;
+            d.timestamp = header.timestamp - first_ts;
+            d.fragment_id = header.fragment_id;
+            d.total_fragments = header.total_fragments;
+            d.len = static_cast<uint16_t>(len);
+            d.stream_id = header.stream_id;
+            d.flags = header.flags & (PACKET_FLAG_KEYFRAME | PACKET_FLAG_UNIT_END);
+            trace->datagrams.push_back(d);
+            trace->bytes += len;
+        }
+    }
+    if (trace->datagrams.empty()) {
+        fprintf(stderr, "[ERROR] No readable datagrams in %s\n", opt.replay_dir.c_str());
+        return false;
+    }
+    // 录制的到达时刻单调递增; 循环之间留一帧间隔
+    const uint64_t gap_us = 1000000 / 30;
+    trace->period_us = trace->datagrams.back().offset_us + gap_us;
+    trace->period_ts = static_cast<uint32_t>(trace->period_us * MEDIA_CLOCK_HZ / 1000000);
+    return true;
+}
+
+// 生成端的一个会话: 地址在握手时绑定，服务端只接受从该地址发来的数据报
+struct Session {
+    SessionHandle handle;
+    uint32_t id;
+    sockaddr_in addr;
+    size_t next;                // 下一个要发出的轨迹下标
+    uint64_t loop_start_us;     // 当前循环的起点
+    uint32_t loop_ts;           // 当前循环的媒体时间戳基准
+    uint32_t stream_seq[MEDIA_STREAM_COUNT];
+};
+
+struct GeneratorStats {
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> late{0};
+    std::atomic<uint64_t> seal_errors{0};
+    std::atomic<uint64_t> send_errors{0};
+};
+
+// 一个生成线程: 一个套接字 (绑定端口，源IP按会话逐个指定) 与一组会话，按到期时刻出堆
+class Generator {
+public:
+    Generator(const Trace& trace, const sockaddr_in& server, GeneratorStats* stats)
+        : trace_(trace), server_(server), stats_(stats), fd_(-1), port_(0), count_(0) {}
+
+    ~Generator() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    // 阻塞套接字: 本机发送缓冲区满时等待，接收端来不及收的数据报由内核丢弃，服务端按序号缺口统计
+    bool Open() {
+        fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) return false;
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);   // 源IP由IP_PKTINFO逐个指定，须绑定通配地址
+        socklen_t len = sizeof(addr);
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        const int sndbuf = 4 * 1024 * 1024;
+        setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        port_ = addr.sin_port;
+        return true;
+    }
+
+    uint16_t Port() const { return port_; }
+    void Add(Session* session) { sessions_.push_back(session); }
+
+    void Run(const std::atomic<bool>& stop) {
+        memset(payload_, 0x5A, sizeof(payload_));
+        std::priority_queue<Due, std::vector<Due>, std::greater<Due>> queue;
+        for (size_t i = 0; i < sessions_.size(); ++i) queue.push(Due{DueTime(*sessions_[i]), i});
+        while (!stop.load(std::memory_order_relaxed)) {
+            const uint64_t now = NowMicros();
+            while (!queue.empty() && queue.top().us <= now) {
+                const Due due = queue.top();
+                queue.pop();
+                Session& s = *sessions_[due.index];
+                if (now - due.us > kLateUs) stats_->late.fetch_add(1, std::memory_order_relaxed);
+                Emit(s, due.us);
+                if (++s.next == trace_.datagrams.size()) {
+                    s.next = 0;
+                    s.loop_start_us += trace_.period_us;
+                    s.loop_ts += trace_.period_ts;
+                }
+                queue.push(Due{DueTime(s), due.index});
+            }
+            Flush();
+            if (queue.empty()) break;
+            const uint64_t next = queue.top().us;
+            const uint64_t after = NowMicros();
+            if (next > after) usleep(static_cast<useconds_t>(std::min<uint64_t>(next - after, 1000)));
+        }
+        Flush();
+    }
+
+private:
+    struct Due {
+        uint64_t us;
+        size_t index;
+        bool operator>(const Due& other) const { return us > other.us; }
+    };
+
+    struct Slot {
+        uint8_t data[sizeof(PacketHeader) + kFragmentPayload + 16 + sizeof(FrameTrace)];
+        size_t len;
+        bool traced;
+        iovec iov;
+        alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(in_pktinfo))];
+    };
+
+    uint64_t DueTime(const Session& s) const {
+        return s.loop_start_us + trace_.datagrams[s.next].offset_us;
+    }
+
+    // 与发送端相同: 填写包头与明文，原地SM4加密并计算SM3摘要; 视频帧的最后一个分片附带追踪扩展
+    void Emit(Session& s, uint64_t due_us) {
+        const TraceDatagram& d = trace_.datagrams[s.next];
+        Slot& slot = slots_[count_];
+        PacketHeader header;
+        memset(&header, 0, sizeof(header));
+        header.session_id = htonl(s.id);
+        header.seq_num = htonl(s.handle->GetAndIncrementSeq());
+        header.fragment_id = htons(d.fragment_id);
+        header.total_fragments = htons(d.total_fragments);
+        header.payload_len = htons(d.len);
+        header.flags = d.flags;
+        header.stream_id = d.stream_id;
+        header.stream_seq = htonl(s.stream_seq[d.stream_id]++);
+        header.timestamp = htonl(s.loop_ts + d.timestamp);
+        memcpy(slot.data, &header, sizeof(header));
+        memcpy(slot.data + sizeof(header), payload_, d.len);
+        slot.len = PacketBuilder::SealInPlace(*s.handle, slot.data, sizeof(slot.data) - sizeof(FrameTrace));
+        if (slot.len == 0) {
+            stats_->seal_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slot.traced = d.stream_id == MEDIA_STREAM_VIDEO && d.fragment_id + 1 == d.total_fragments;
+        if (slot.traced) {
+            FrameTrace trace;
+            trace.capture_us = htonl(static_cast<uint32_t>(due_us));   // 轨迹中的计划发出时刻
+            trace.encode_us = 0;
+            trace.encrypt_us = htonl(utils::FrameTracer::NowMicros());
+            trace.send_us = 0;
+            memcpy(slot.data + slot.len, &trace, sizeof(trace));
+            slot.data[offsetof(PacketHeader, flags)] |= PACKET_FLAG_TRACE;
+            slot.len += sizeof(trace);
+        }
+
+        slot.iov.iov_base = slot.data;
+        slot.iov.iov_len = slot.len;
+        mmsghdr& msg = msgs_[count_];
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_hdr.msg_name = &server_;
+        msg.msg_hdr.msg_namelen = sizeof(server_);
+        msg.msg_hdr.msg_iov = &slot.iov;
+        msg.msg_hdr.msg_iovlen = 1;
+        msg.msg_hdr.msg_control = slot.control;
+        msg.msg_hdr.msg_controllen = sizeof(slot.control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+        in_pktinfo info;
+        memset(&info, 0, sizeof(info));
+        info.ipi_spec_dst = s.addr.sin_addr;
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(info));
+        if (++count_ == kBatch) Flush();
+    }
+
+    void Flush() {
+        if (count_ == 0) return;
+        const uint32_t send_us = htonl(utils::FrameTracer::NowMicros());
+        for (size_t i = 0; i < count_; ++i) {
+            Slot& slot = slots_[i];
+            if (slot.traced) {
+                memcpy(slot.data + slot.len - sizeof(FrameTrace) + offsetof(FrameTrace, send_us), &send_us, sizeof(send_us));
+            }
+        }
+        size_t sent = 0;
+        while (sent < count_) {
+            int ret = sendmmsg(fd_, msgs_ + sent, static_cast<unsigned>(count_ - sent), 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                stats_->send_errors.fetch_add(count_ - sent, std::memory_order_relaxed);
+                break;
+            }
+            uint64_t bytes = 0;
+            for (int i = 0; i < ret; ++i) bytes += slots_[sent + i].len;
+            stats_->packets.fetch_add(static_cast<uint64_t>(ret), std::memory_order_relaxed);
+            stats_->bytes.fetch_add(bytes, std::memory_order_relaxed);
+            sent += static_cast<size_t>(ret);
+        }
+        count_ = 0;
+    }
+
+    const Trace& trace_;
+    sockaddr_in server_;
+    GeneratorStats* stats_;
+    int fd_;
+    uint16_t port_;                 // 网络字节序
+    std::vector<Session*> sessions_;
+    Slot slots_[kBatch];
+    mmsghdr msgs_[kBatch];
+    size_t count_;
+    uint8_t payload_[kFragmentPayload];
+};
+
+// 服务端: 收包线程内完成分流、校验与解密，按会话与流检查序号缺口
+class Server {
+public:
+    Server() : packets_(0), bytes_(0), rejected_(0), lost_(0), measuring_(false),
+               latency_(new utils::HistogramSnapshot()), schedule_latency_(new utils::HistogramSnapshot()) {
+        memset(latency_.get(), 0, sizeof(utils::HistogramSnapshot));
+        memset(schedule_latency_.get(), 0, sizeof(utils::HistogramSnapshot));
+    }
+
+    bool Initialize(uint16_t port, TransportBackend backend) {
+        return transport_.Initialize(port, backend);
+    }
+
+    int SetReceiveBuffer(int bytes) { return transport_.SetReceiveBuffer(bytes); }
+
+    void AddSession(uint32_t session_id) {
+        index_[session_id] = peers_.size();
+        peers_.push_back(Peer());
+    }
+
+    void Run(const std::atomic<bool>& stop) {
+        const ReceiveHandler handler = [this](const uint8_t* data, size_t len, const sockaddr_in& src) {
+            OnDatagram(data, len, src);
+        };
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (transport_.PollReceive(10, handler) < 0) break;
+        }
+    }
+
+    void SetMeasuring(bool measuring) { measuring_.store(measuring, std::memory_order_relaxed); }
+
+    uint64_t Packets() const { return packets_.load(std::memory_order_relaxed); }
+    uint64_t Bytes() const { return bytes_.load(std::memory_order_relaxed); }
+    uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    uint64_t Lost() const { return lost_.load(std::memory_order_relaxed); }
+    // 收包线程退出后读取
+    const utils::HistogramSnapshot& Latency() const { return *latency_; }
+    const utils::HistogramSnapshot& ScheduleLatency() const { return *schedule_latency_; }
+
+private:
+    struct Peer {
+        bool started[MEDIA_STREAM_COUNT] = {};
+        uint32_t expected[MEDIA_STREAM_COUNT] = {};
+    };
+
+    static void Add(utils::HistogramSnapshot* h, uint32_t us) {
+        const uint64_t ns = static_cast<uint64_t>(us) * 1000;
+        ++h->counts[utils::LatencyBuckets::Index(ns)];
+        ++h->count;
+        h->sum_ns += ns;
+    }
+
+    void OnDatagram(const uint8_t* data, size_t len, const sockaddr_in& src) {
+        PacketHeader header;
+        if (PacketBuilder::OpenPacket(src, data, len, header, plain_) == 0 || header.stream_id >= MEDIA_STREAM_COUNT) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const uint32_t now_us = utils::FrameTracer::NowMicros();
+        packets_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(len, std::memory_order_relaxed);
+
+        auto it = index_.find(header.session_id);
+        if (it != index_.end()) {
+            // 回环上不会乱序: 流内序号的缺口即为丢包 (接收缓冲区溢出)
+            Peer& peer = peers_[it->second];
+            const uint8_t stream = header.stream_id;
+            if (peer.started[stream] && header.stream_seq > peer.expected[stream]) {
+                lost_.fetch_add(header.stream_seq - peer.expected[stream], std::memory_order_relaxed);
+            }
+            peer.started[stream] = true;
+            peer.expected[stream] = header.stream_seq + 1;
+        }
+
+        if ((header.flags & PACKET_FLAG_TRACE) && measuring_.load(std::memory_order_relaxed)) {
+            FrameTrace trace;
+            memcpy(&trace, data + sizeof(PacketHeader) + header.payload_len, sizeof(trace));
+            Add(latency_.get(), now_us - ntohl(trace.send_us));
+            Add(schedule_latency_.get(), now_us - ntohl(trace.capture_us));
+        }
+    }
+
+    UdpTransport transport_;
+    std::unordered_map<uint32_t, size_t> index_;    // 启动前建好，收包线程只读
+    std::vector<Peer> peers_;                       // 仅收包线程使用
+    uint8_t plain_[2048];
+    std::atomic<uint64_t> packets_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> rejected_;
+    std::atomic<uint64_t> lost_;
+    std::atomic<bool> measuring_;
+    std::unique_ptr<utils::HistogramSnapshot> latency_;            // 发出 -> 解密完成
+    std::unique_ptr<utils::HistogramSnapshot> schedule_latency_;   // 轨迹计划时刻 -> 解密完成 (含生成端滞后)
+};
+
+void PrintLatency(const char* name, const utils::HistogramSnapshot& h) {
+    if (h.count == 0) {
+        printf("%-22s no samples\n", name);
+        return;
+    }
+    printf("%-22s p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f ms  (%llu frames)\n", name,
+           h.Percentile(0.5) / 1e6, h.Percentile(0.9) / 1e6, h.Percentile(0.99) / 1e6,
+           h.Percentile(0.999) / 1e6, h.Max() / 1e6, (unsigned long long)h.count);
+}
+
+struct Totals {
+    uint64_t offered_packets;
+    uint64_t offered_bytes;
+    uint64_t late;
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t rejected;
+    uint64_t lost;
+    int64_t rcvbuf_errors;
+    double server_cpu;
+    double generator_cpu;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!ParseOptions(argc, argv, &opt)) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    Trace trace;
+    if (!opt.replay_dir.empty()) {
+        if (!LoadReplayTrace(opt, &trace)) return 1;
+    } else {
+        BuildSyntheticTrace(opt, &trace);
+    }
+    const double stream_mbps = trace.bytes * 8.0 / trace.period_us;
+    printf("trace: %zu datagrams per %.2fs loop, %.2f Mbit/s payload per session\n",
+           trace.datagrams.size(), trace.period_us / 1e6, stream_mbps);
+
+    if (!opt.metrics_path.empty()) {
+        utils::MetricsExportConfig metrics;
+        metrics.path = opt.metrics_path;
+        if (!utils::Metrics::Instance().StartExport(metrics)) {
+            fprintf(stderr, "[ERROR] Failed to open metrics output\n");
+            return 1;
+        }
+    }
+
+    // 服务端不重传，不为每个会话保留重传缓冲区
+    RetransmitConfig rtx;
+    rtx.slot_count = 0;
+    SessionManager::GetInstance().SetRetransmitConfig(rtx);
+
+    Server server;
+    if (!server.Initialize(opt.port, opt.backend)) {
+        fprintf(stderr, "[ERROR] Failed to bind UDP port %u\n", opt.port);
+        return 1;
+    }
+    // 收包线程被短暂调度走时，数据报堆积在内核接收缓冲区，默认大小(约200KB)下会溢出丢包
+    if (opt.rcvbuf > 0) {
+        const int actual = server.SetReceiveBuffer(opt.rcvbuf);
+        if (actual < 0) {
+            fprintf(stderr, "[ERROR] Failed to set server receive buffer\n");
+            return 1;
+        }
+        printf("server receive buffer: %d bytes (requested %d)\n", actual, opt.rcvbuf);
+        if (actual < opt.rcvbuf) {
+            printf("  capped by net.core.rmem_max; raise it or run with CAP_NET_ADMIN\n");
+        }
+    }
+    sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server_addr.sin_port = htons(opt.port);
+
+    GeneratorStats stats;
+    std::vector<std::unique_ptr<Generator>> generators;
+    for (size_t g = 0; g < opt.generators; ++g) {
+        generators.emplace_back(new Generator(trace, server_addr, &stats));
+        if (!generators.back()->Open()) {
+            fprintf(stderr, "[ERROR] Failed to open generator socket: %s\n", strerror(errno));
+            return 1;
+        }
+    }
+
+    // 每个会话一次完整握手; 地址 127.0.0.2 起依次分配，端口为所属生成线程的端口
+    sm2_precompute();
+    auto setup_start = std::chrono::steady_clock::now();
+    std::vector<Session> sessions(opt.sessions);
+    uint32_t rng = 2463534242u;
+    const uint64_t start_us = NowMicros() + 100000;
+    for (size_t i = 0; i < opt.sessions; ++i) {
+        Session& s = sessions[i];
+        Generator& generator = *generators[i % opt.generators];
+        memset(&s.addr, 0, sizeof(s.addr));
+        s.addr.sin_family = AF_INET;
+        s.addr.sin_addr.s_addr = htonl(0x7F000002u + static_cast<uint32_t>(i));
+        s.addr.sin_port = generator.Port();
+
+        Handshake client;
+        KeyExchangePacket init, reply;
+        if (!client.Start(&init) ||
+            (s.id = Handshake::Accept(s.addr, reinterpret_cast<const uint8_t*>(&init), sizeof(init), &reply)) == 0 ||
+            !(s.handle = SessionManager::GetInstance().GetSession(s.id))) {
+            fprintf(stderr, "[ERROR] Handshake failed for session %zu\n", i);
+            return 1;
+        }
+
+        // 随机相位: 各会话的关键帧错开，和真实推流一样不会同时到达
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const uint64_t phase = rng % trace.period_us;
+        s.next = static_cast<size_t>(std::lower_bound(trace.datagrams.begin(), trace.datagrams.end(), phase,
+            [](const TraceDatagram& d, uint64_t us) { return d.offset_us < us; }) - trace.datagrams.begin());
+        s.loop_start_us = start_us - phase;
+        s.loop_ts = rng;
+        if (s.next == trace.datagrams.size()) {
+            s.next = 0;
+            s.loop_start_us += trace.period_us;
+            s.loop_ts += trace.period_ts;
+        }
+        memset(s.stream_seq, 0, sizeof(s.stream_seq));
+        server.AddSession(s.id);
+        generator.Add(&s);
+    }
+    const double setup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setup_start).count();
+    printf("sessions: %zu established in %.1f ms (%.0f handshakes/s)\n", opt.sessions, setup_ms,
+           opt.sessions * 1000.0 / std::max(setup_ms, 1e-3));
+    fflush(stdout);
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    std::atomic<bool> stop_generators(false);
+    std::atomic<bool> stop_server(false);
+    std::thread server_thread(&Server::Run, &server, std::cref(stop_server));
+    std::vector<std::thread> generator_threads;
+    for (const std::unique_ptr<Generator>& g : generators) {
+        generator_threads.emplace_back(&Generator::Run, g.get(), std::cref(stop_generators));
+    }
+
+    auto sample = [&](Totals* t) {
+        t->offered_packets = stats.packets.load();
+        t->offered_bytes = stats.bytes.load();
+        t->late = stats.late.load();
+        t->packets = server.Packets();
+        t->bytes = server.Bytes();
+        t->rejected = server.Rejected();
+        t->lost = server.Lost();
+        t->rcvbuf_errors = UdpReceiveBufferErrors();
+        t->server_cpu = ThreadCpuSeconds(server_thread);
+        t->generator_cpu = 0;
+        for (std::thread& g : generator_threads) t->generator_cpu += ThreadCpuSeconds(g);
+    };
+    auto sleep_until = [](std::chrono::steady_clock::time_point deadline) {
+        while (!g_interrupted.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    };
+
+    auto clock = std::chrono::steady_clock::now();
+    sleep_until(clock + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(opt.warmup_sec)));
+    Totals begin, previous, current;
+    sample(&begin);
+    server.SetMeasuring(true);
+    const auto window_start = std::chrono::steady_clock::now();
+    previous = begin;
+    for (int second = 1; !g_interrupted.load() && second <= static_cast<int>(opt.duration_sec + 0.999); ++second) {
+        sleep_until(window_start + std::chrono::seconds(second));
+        sample(&current);
+        printf("%5ds  offered %8llu pkt/s  server %8llu pkt/s  %8.1f Mbit/s  lost %llu  rejected %llu  cpu %.1f%%\n",
+               second, (unsigned long long)(current.offered_packets - previous.offered_packets),
+               (unsigned long long)(current.packets - previous.packets),
+               (current.bytes - previous.bytes) * 8 / 1e6, (unsigned long long)(current.lost - previous.lost),
+               (unsigned long long)(current.rejected - previous.rejected),
+               (current.server_cpu - previous.server_cpu) * 100);
+        fflush(stdout);
+        previous = current;
+    }
+    Totals end;
+    sample(&end);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start).count();
+    server.SetMeasuring(false);
+
+    // 先停生成端，给服务端留出时间收完在途数据报
+    stop_generators.store(true);
+    for (std::thread& g : generator_threads) g.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stop_server.store(true);
+    server_thread.join();
+    utils::Metrics::Instance().StopExport();
+
+    const uint64_t packets = end.packets - begin.packets;
+    const uint64_t offered = end.offered_packets - begin.offered_packets;
+    const uint64_t lost = end.lost - begin.lost;
+    const double server_cpu = end.server_cpu - begin.server_cpu;
+    const double generator_cpu = end.generator_cpu - begin.generator_cpu;
+    printf("\nwindow %.1fs  sessions %zu  backend %s\n", seconds, opt.sessions,
+           opt.backend == TransportBackend::IoUring ? "uring" : "syscall");
+    printf("offered   %10.0f pkt/s  %9.1f Mbit/s  late %llu  seal errors %llu  send errors %llu\n",
+           offered / seconds, (end.offered_bytes - begin.offered_bytes) * 8 / seconds / 1e6,
+           (unsigned long long)(end.late - begin.late), (unsigned long long)stats.seal_errors.load(),
+           (unsigned long long)stats.send_errors.load());
+    printf("server    %10.0f pkt/s  %9.1f Mbit/s  rejected %llu  lost %llu (%.3f%%)\n",
+           packets / seconds, (end.bytes - begin.bytes) * 8 / seconds / 1e6,
+           (unsigned long long)(end.rejected - begin.rejected), (unsigned long long)lost,
+           packets + lost > 0 ? lost * 100.0 / (packets + lost) : 0.0);
+    printf("server cpu %.1f%% of one core  %.4f%% per stream  %.2f us per packet\n",
+           server_cpu / seconds * 100, server_cpu / seconds * 100 / opt.sessions,
+           packets > 0 ? server_cpu * 1e6 / packets : 0.0);
+    printf("generator cpu %.1f%% of one core (%zu threads)\n", generator_cpu / seconds * 100, opt.generators);
+    // 序号缺口区分原因: 内核接收缓冲区溢出(收包线程来不及取)还是服务端处理饱和
+    if (end.rcvbuf_errors >= 0 && begin.rcvbuf_errors >= 0) {
+        const uint64_t overflow = static_cast<uint64_t>(end.rcvbuf_errors - begin.rcvbuf_errors);
+        printf("kernel receive-buffer drops %llu (host-wide UDP RcvbufErrors)\n", (unsigned long long)overflow);
+        if (lost > 0 && server_cpu / seconds < 0.9) {
+            printf("  lost datagrams were dropped by the kernel while the receive thread had CPU headroom;\n"
+                   "  this is receive-buffer overflow, not server saturation (try a larger --rcvbuf)\n");
+        }
+    }
+    PrintLatency("latency send->open", server.Latency());
+    PrintLatency("latency due->open", server.ScheduleLatency());
+    return 0;
+}
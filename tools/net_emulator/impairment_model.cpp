@@ -0,0 +1,82 @@
+//网络损伤模型实现
+
+#include "impairment_model.h"
+#include <algorithm>
+
+ImpairmentModel::ImpairmentModel(const ImpairmentConfig& config, uint64_t seed)
+    : config_(config), rng_(seed), uniform_(0.0, 1.0), normal_(0.0, 1.0),
+      ge_bad_(false), link_free_us_(0), last_deliver_us_(0) {}
+
+bool ImpairmentModel::SampleLoss() {
+    if (!config_.ge_enabled) {
+        return config_.loss_rate > 0 && uniform_(rng_) < config_.loss_rate;
+    }
+
+    // Gilbert-Elliott: 先按当前状态决定丢包，再做状态转移
+    double loss = ge_bad_ ? config_.ge_loss_bad : config_.ge_loss_good;
+    bool lost = uniform_(rng_) < loss;
+    double flip = uniform_(rng_);
+    if (ge_bad_) {
+        if (flip < config_.ge_r) ge_bad_ = false;
+    } else {
+        if (flip < config_.ge_p) ge_bad_ = true;
+    }
+    return lost;
+}
+
+uint64_t ImpairmentModel::SampleDelay() {
+    double delay = config_.delay_us;
+    if (config_.jitter_us > 0) {
+        double j = normal_(rng_);
+        j = std::min(3.0, std::max(-3.0, j));
+        delay += j * config_.jitter_us;
+    }
+    return static_cast<uint64_t>(std::max(0.0, delay));
+}
+
+ImpairmentDecision ImpairmentModel::Decide(uint64_t arrival_us, size_t bytes) {
+    ImpairmentDecision d;
+    d.action = ImpairmentAction::Deliver;
+    d.deliver_us = arrival_us;
+    d.duplicate = false;
+    d.duplicate_us = 0;
+
+    // 随机数的消耗顺序固定，保证同一到达序列下结果可复现
+    bool lost = SampleLoss();
+    uint64_t delay = SampleDelay();
+    bool reorder = config_.reorder_rate > 0 && uniform_(rng_) < config_.reorder_rate;
+    bool dup = config_.duplicate_rate > 0 && uniform_(rng_) < config_.duplicate_rate;
+
+    // 瓶颈链路: 排队时间超过队列容量对应的时长则尾部丢弃
+    uint64_t depart_us = arrival_us;
+    if (config_.rate_bps > 0) {
+        uint64_t start = std::max(arrival_us, link_free_us_);
+        uint64_t backlog_bytes = (start - arrival_us) * config_.rate_bps / 8 / 1000000;
+        if (backlog_bytes + bytes > config_.queue_bytes) {
+            d.action = ImpairmentAction::DropQueue;
+            return d;
+        }
+        link_free_us_ = start + bytes * 8 * 1000000 / config_.rate_bps;
+        depart_us = link_free_us_;
+    }
+
+    if (lost) {
+        d.action = ImpairmentAction::DropLoss;
+        return d;
+    }
+
+    uint64_t deliver = depart_us + delay;
+    if (reorder) {
+        deliver += config_.reorder_gap_us;  // 被后续包超越
+    } else {
+        deliver = std::max(deliver, last_deliver_us_);  // 抖动不引入额外乱序
+        last_deliver_us_ = deliver;
+    }
+    d.deliver_us = deliver;
+
+    if (dup) {
+        d.duplicate = true;
+        d.duplicate_us = deliver + SampleDelay() / 4;
+    }
+    return d;
+}
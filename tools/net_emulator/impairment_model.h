@@ -0,0 +1,64 @@
+//网络损伤模型声明 (丢包/时延/抖动/乱序/重复/带宽限制)
+
+#ifndef IMPAIRMENT_MODEL_H
+#define IMPAIRMENT_MODEL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+
+struct ImpairmentConfig {
+    // 丢包: Bernoulli (loss_rate) 或 Gilbert-Elliott 两状态模型 (ge_enabled)
+    double loss_rate = 0.0;
+    bool ge_enabled = false;
+    double ge_p = 0.0;          // Good -> Bad 转移概率
+    double ge_r = 1.0;          // Bad -> Good 转移概率
+    double ge_loss_good = 0.0;  // Good 状态丢包率
+    double ge_loss_bad = 1.0;   // Bad 状态丢包率
+
+    uint32_t delay_us = 0;      // 固定单向时延
+    uint32_t jitter_us = 0;     // 时延抖动 (正态分布标准差，截断到 ±3σ)
+    double reorder_rate = 0.0;  // 乱序概率: 命中的包额外延迟 reorder_gap_us
+    uint32_t reorder_gap_us = 10000;
+    double duplicate_rate = 0.0;
+
+    uint64_t rate_bps = 0;      // 瓶颈带宽，0表示不限速
+    size_t queue_bytes = 64 * 1024;  // 瓶颈队列长度 (尾部丢弃)
+};
+
+enum class ImpairmentAction {
+    Deliver,
+    DropLoss,       // 随机丢包
+    DropQueue,      // 瓶颈队列溢出
+};
+
+struct ImpairmentDecision {
+    ImpairmentAction action;
+    uint64_t deliver_us;        // 投递时间
+    bool duplicate;             // 是否额外投递一份副本
+    uint64_t duplicate_us;
+};
+
+// 给定种子与相同的到达序列，决策序列完全可复现
+class ImpairmentModel {
+public:
+    ImpairmentModel(const ImpairmentConfig& config, uint64_t seed);
+
+    ImpairmentDecision Decide(uint64_t arrival_us, size_t bytes);
+
+    bool InBadState() const { return ge_bad_; }
+
+private:
+    bool SampleLoss();
+    uint64_t SampleDelay();
+
+    ImpairmentConfig config_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::normal_distribution<double> normal_;
+    bool ge_bad_;
+    uint64_t link_free_us_;     // 瓶颈链路空闲时刻 (串行化队列)
+    uint64_t last_deliver_us_;  // 未乱序包保持FIFO
+};
+
+#endif
@@ -0,0 +1,280 @@
+//本地UDP网络损伤中继: sender -> listen端口 -> 损伤 -> forward地址 -> receiver，反向流量原路返回
+//  net_emulator --listen 6000 --forward 127.0.0.1:5002 --ge 0.01,0.3,0,0.5 --delay-ms 30
+
+#include "impairment_model.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile sig_atomic_t g_running = 1;
+
+void OnSignal(int) { g_running = 0; }
+
+uint64_t NowMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+enum Direction { kForward = 0, kReverse = 1 };
+
+struct PendingPacket {
+    uint64_t deliver_us;
+    uint64_t id;
+    int dir;
+    std::vector<uint8_t> data;
+
+    bool operator>(const PendingPacket& o) const {
+        return deliver_us != o.deliver_us ? deliver_us > o.deliver_us : id > o.id;
+    }
+};
+
+struct DirectionStats {
+    uint64_t received = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped_loss = 0;
+    uint64_t dropped_queue = 0;
+    uint64_t duplicated = 0;
+};
+
+struct Options {
+    uint16_t listen_port = 0;
+    sockaddr_in forward_addr;
+    uint64_t seed = 1;
+    ImpairmentConfig forward;
+    bool symmetric = false;     // 反向也施加丢包与限速 (默认只施加时延)
+    std::string trace_path;
+};
+
+void Usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s --listen PORT --forward IP:PORT [options]\n"
+        "  --seed N                 random seed (default 1)\n"
+        "  --loss P                 Bernoulli loss rate\n"
+        "  --ge p,r,loss_good,loss_bad  Gilbert-Elliott loss model\n"
+        "  --delay-ms MS            one-way delay\n"
+        "  --jitter-ms MS           delay jitter (stddev)\n"
+        "  --reorder P              reorder probability\n"
+        "  --reorder-gap-ms MS      extra delay of reordered packets (default 10)\n"
+        "  --dup P                  duplication probability\n"
+        "  --rate-kbps K            bottleneck rate\n"
+        "  --queue-kb K             bottleneck queue size (default 64)\n"
+        "  --symmetric              apply loss/rate to the reverse path as well\n"
+        "  --trace FILE             per-packet CSV trace\n", prog);
+}
+
+bool ParseAddr(const char* s, sockaddr_in* out) {
+    std::string str(s);
+    size_t colon = str.rfind(':');
+    if (colon == std::string::npos) return false;
+    memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    out->sin_port = htons(static_cast<uint16_t>(atoi(str.c_str() + colon + 1)));
+    return inet_pton(AF_INET, str.substr(0, colon).c_str(), &out->sin_addr) == 1;
+}
+
+bool ParseOptions(int argc, char* argv[], Options* opt) {
+    bool has_forward = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (a == "--symmetric") { opt->symmetric = true; continue; }
+        if (!v) return false;
+        ++i;
+        if (a == "--listen") opt->listen_port = static_cast<uint16_t>(atoi(v));
+        else if (a == "--forward") has_forward = ParseAddr(v, &opt->forward_addr);
+        else if (a == "--seed") opt->seed = strtoull(v, nullptr, 10);
+        else if (a == "--loss") opt->forward.loss_rate = atof(v);
+        else if (a == "--ge") {
+            ImpairmentConfig& c = opt->forward;
+            if (sscanf(v, "%lf,%lf,%lf,%lf", &c.ge_p, &c.ge_r, &c.ge_loss_good, &c.ge_loss_bad) != 4) return false;
+            c.ge_enabled = true;
+        }
+        else if (a == "--delay-ms") opt->forward.delay_us = static_cast<uint32_t>(atof(v) * 1000);
+        else if (a == "--jitter-ms") opt->forward.jitter_us = static_cast<uint32_t>(atof(v) * 1000);
+        else if (a == "--reorder") opt->forward.reorder_rate = atof(v);
+        else if (a == "--reorder-gap-ms") opt->forward.reorder_gap_us = static_cast<uint32_t>(atof(v) * 1000);
+        else if (a == "--dup") opt->forward.duplicate_rate = atof(v);
+        else if (a == "--rate-kbps") opt->forward.rate_bps = strtoull(v, nullptr, 10) * 1000;
+        else if (a == "--queue-kb") opt->forward.queue_bytes = strtoull(v, nullptr, 10) * 1024;
+        else if (a == "--trace") opt->trace_path = v;
+        else return false;
+    }
+    return opt->listen_port != 0 && has_forward;
+}
+
+int OpenSocket(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int buf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+const char* ActionName(ImpairmentAction a) {
+    switch (a) {
+    case ImpairmentAction::Deliver:   return "deliver";
+    case ImpairmentAction::DropLoss:  return "drop_loss";
+    case ImpairmentAction::DropQueue: return "drop_queue";
+    }
+    return "?";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!ParseOptions(argc, argv, &opt)) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    ImpairmentConfig reverse_cfg;
+    if (opt.symmetric) {
+        reverse_cfg = opt.forward;
+    } else {
+        reverse_cfg.delay_us = opt.forward.delay_us;
+        reverse_cfg.jitter_us = opt.forward.jitter_us;
+    }
+    // 两个方向使用由同一种子派生的独立随机序列
+    ImpairmentModel models[2] = {
+        ImpairmentModel(opt.forward, opt.seed),
+        ImpairmentModel(reverse_cfg, opt.seed ^ 0x9E3779B97F4A7C15ull),
+    };
+
+    int client_fd = OpenSocket(opt.listen_port);
+    int server_fd = OpenSocket(0);
+    if (client_fd < 0 || server_fd < 0) {
+        fprintf(stderr, "[ERROR] socket setup failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    FILE* trace = nullptr;
+    if (!opt.trace_path.empty()) {
+        trace = fopen(opt.trace_path.c_str(), "w");
+        if (!trace) {
+            fprintf(stderr, "[ERROR] cannot open trace file %s\n", opt.trace_path.c_str());
+            return 1;
+        }
+        fprintf(trace, "id,dir,arrival_us,bytes,action,deliver_us,duplicate_us,ge_bad\n");
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    std::priority_queue<PendingPacket, std::vector<PendingPacket>, std::greater<PendingPacket>> pending;
+    DirectionStats stats[2];
+    sockaddr_in client_addr;
+    bool has_client = false;
+    uint64_t next_id = 0;
+    uint8_t buf[65536];
+
+    while (g_running) {
+        // 等待到下一个待投递包的时刻
+        timespec ts;
+        ts.tv_sec = 0;
+        ts.tv_nsec = 100 * 1000 * 1000;
+        if (!pending.empty()) {
+            uint64_t now = NowMicros();
+            uint64_t wait = pending.top().deliver_us > now ? pending.top().deliver_us - now : 0;
+            ts.tv_sec = wait / 1000000;
+            ts.tv_nsec = (wait % 1000000) * 1000;
+        }
+        pollfd fds[2] = {{client_fd, POLLIN, 0}, {server_fd, POLLIN, 0}};
+        if (ppoll(fds, 2, &ts, nullptr) < 0 && errno != EINTR) break;
+
+        for (int dir = kForward; dir <= kReverse; ++dir) {
+            int fd = dir == kForward ? client_fd : server_fd;
+            for (;;) {
+                sockaddr_in src;
+                socklen_t src_len = sizeof(src);
+                ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&src), &src_len);
+                if (n < 0) break;
+                if (dir == kForward) {
+                    client_addr = src;
+                    has_client = true;
+                }
+
+                uint64_t arrival = NowMicros();
+                ImpairmentDecision d = models[dir].Decide(arrival, static_cast<size_t>(n));
+                uint64_t id = next_id++;
+                ++stats[dir].received;
+
+                if (trace) {
+                    fprintf(trace, "%llu,%s,%llu,%zd,%s,%llu,%llu,%d\n",
+                            (unsigned long long)id, dir == kForward ? "fwd" : "rev",
+                            (unsigned long long)arrival, n, ActionName(d.action),
+                            (unsigned long long)(d.action == ImpairmentAction::Deliver ? d.deliver_us : 0),
+                            (unsigned long long)(d.duplicate ? d.duplicate_us : 0),
+                            models[dir].InBadState() ? 1 : 0);
+                }
+
+                if (d.action == ImpairmentAction::DropLoss) { ++stats[dir].dropped_loss; continue; }
+                if (d.action == ImpairmentAction::DropQueue) { ++stats[dir].dropped_queue; continue; }
+
+                pending.push(PendingPacket{d.deliver_us, id, dir, std::vector<uint8_t>(buf, buf + n)});
+                if (d.duplicate) {
+                    ++stats[dir].duplicated;
+                    pending.push(PendingPacket{d.duplicate_us, id, dir, std::vector<uint8_t>(buf, buf + n)});
+                }
+            }
+        }
+
+        // 投递到期的包
+        uint64_t now = NowMicros();
+        while (!pending.empty() && pending.top().deliver_us <= now) {
+            const PendingPacket& p = pending.top();
+            if (p.dir == kForward) {
+                sendto(server_fd, p.data.data(), p.data.size(), 0,
+                       reinterpret_cast<const sockaddr*>(&opt.forward_addr), sizeof(opt.forward_addr));
+                ++stats[kForward].delivered;
+            } else if (has_client) {
+                sendto(client_fd, p.data.data(), p.data.size(), 0,
+                       reinterpret_cast<const sockaddr*>(&client_addr), sizeof(client_addr));
+                ++stats[kReverse].delivered;
+            }
+            pending.pop();
+        }
+    }
+
+    if (trace) fclose(trace);
+    close(client_fd);
+    close(server_fd);
+
+    const char* names[2] = {"forward", "reverse"};
+    for (int dir = kForward; dir <= kReverse; ++dir) {
+        const DirectionStats& s = stats[dir];
+        fprintf(stderr, "%s: received=%llu delivered=%llu loss=%llu queue_drop=%llu duplicated=%llu\n",
+                names[dir], (unsigned long long)s.received, (unsigned long long)s.delivered,
+                (unsigned long long)s.dropped_loss, (unsigned long long)s.dropped_queue,
+                (unsigned long long)s.duplicated);
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+//录制回放: 列出关键帧索引，或从指定时间点解密重组出H.264码流
+//  rec_play --dir rec/ --key <32位十六进制> --seek 12.5 --length 10 --output clip.h264
+
+#include "../../core/storage/segment_reader.h"
+#include "../../core/video/decoder/jitter_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string directory;
+    uint8_t key[16] = {};
+    bool has_key = false;
+    bool list = false;
+    double seek_sec = 0;
+    double length_sec = 0;      // 0表示到录制末尾
+    std::string output_path;
+};
+
+void Usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s --dir DIR --key HEX32 [options]\n"
+        "  --list                   list segments and keyframe index\n"
+        "  --seek SEC               start at the last keyframe at or before SEC (relative to recording start)\n"
+        "  --length SEC             stop after SEC of media time\n"
+        "  --output FILE            write reassembled Annex B video\n", prog);
+}
+
+bool ParseOptions(int argc, char* argv[], Options* opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (a == "--list") { opt->list = true; continue; }
+        if (!v) return false;
+        ++i;
+        if (a == "--dir") opt->directory = v;
+        else if (a == "--key") opt->has_key = ParseStorageKey(v, opt->key);
+        else if (a == "--seek") opt->seek_sec = atof(v);
+        else if (a == "--length") opt->length_sec = atof(v);
+        else if (a == "--output") opt->output_path = v;
+        else return false;
+    }
+    return !opt->directory.empty() && opt->has_key && (opt->list || !opt->output_path.empty());
+}
+
+double Seconds(uint64_t pts, uint64_t base) {
+    return static_cast<double>(pts - base) / MEDIA_CLOCK_HZ;
+}
+
+// 录制起点: 第一个带关键帧的分段的首个关键帧
+bool FirstKeyframe(const Recording& recording, uint64_t* pts) {
+    for (size_t i = 0; i < recording.SegmentCount(); ++i) {
+        const SegmentReader& segment = recording.Segment(i);
+        if (segment.KeyframeCount() > 0) {
+            *pts = segment.Keyframe(0).pts;
+            return true;
+        }
+    }
+    return false;
+}
+
+void List(const Recording& recording, uint64_t base) {
+    for (size_t i = 0; i < recording.SegmentCount(); ++i) {
+        const SegmentReader& segment = recording.Segment(i);
+        const SegmentHeader& h = segment.Header();
+        const size_t keyframes = segment.KeyframeCount();
+        printf("segment %08u  session %u  epoch %u  %s  data %llu bytes  keyframes %zu",
+               h.sequence, h.session_id, h.key_epoch, h.sealed ? "sealed" : "open",
+               (unsigned long long)(h.data_end - h.header_size), keyframes);
+        if (keyframes > 0) {
+            printf("  [%.3fs .. %.3fs]", Seconds(segment.Keyframe(0).pts, base),
+                   Seconds(segment.Keyframe(keyframes - 1).pts, base));
+        }
+        printf("\n");
+        for (size_t k = 0; k < keyframes; ++k) {
+            const IndexEntry& entry = segment.Keyframe(k);
+            printf("  key %5zu  %10.3fs  offset %llu\n", k, Seconds(entry.pts, base),
+                   (unsigned long long)entry.offset);
+        }
+    }
+}
+
+struct PlaybackStats {
+    uint64_t records = 0;
+    uint64_t rejected = 0;
+    uint64_t frames = 0;
+    uint64_t lost = 0;
+    uint64_t bytes = 0;
+};
+
+// 出队所有到期的帧并写出; 丢失的帧只计数
+void Drain(JitterBuffer* jitter, uint64_t now_us, uint64_t end_pts, uint64_t base_pts, FILE* out,
+           PlaybackStats* stats, bool* done) {
+    JitterFrame frame;
+    while (jitter->PopFrame(now_us, &frame)) {
+        // 帧时间戳为32位，与起点的差值按无符号回绕计算
+        const uint32_t elapsed = frame.timestamp - static_cast<uint32_t>(base_pts);
+        if (end_pts != 0 && elapsed >= end_pts - base_pts) {
+            *done = true;
+            return;
+        }
+        if (frame.conceal) {
+            ++stats->lost;
+            continue;
+        }
+        if (fwrite(frame.data, 1, frame.size, out) != frame.size) {
+            *done = true;
+            return;
+        }
+        ++stats->frames;
+        stats->bytes += frame.size;
+    }
+}
+
+int Play(const Recording& recording, const Options& opt, uint64_t base) {
+    const uint64_t seek_pts = base + static_cast<uint64_t>(opt.seek_sec * MEDIA_CLOCK_HZ);
+    size_t segment_index = 0;
+    uint64_t offset = 0;
+    if (!recording.Seek(seek_pts, &segment_index, &offset)) {
+        fprintf(stderr, "[ERROR] No keyframe in recording\n");
+        return 1;
+    }
+    const uint64_t start_pts = recording.Segment(segment_index).Keyframe(
+        recording.Segment(segment_index).FindKeyframe(seek_pts)).pts;
+    const uint64_t end_pts = opt.length_sec > 0 ? start_pts + static_cast<uint64_t>(opt.length_sec * MEDIA_CLOCK_HZ) : 0;
+
+    FILE* out = fopen(opt.output_path.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "[ERROR] Cannot open %s\n", opt.output_path.c_str());
+        return 1;
+    }
+
+    // 回放不受实时约束: 固定用最深的缓冲，只有录制中确实缺失的分片才导致丢帧
+    JitterBufferConfig jitter_config;
+    jitter_config.min_delay_us = jitter_config.max_delay_us;
+    JitterBuffer jitter(jitter_config);
+    PlaybackStats stats;
+    std::vector<uint8_t> plain(SEGMENT_MAX_RECORD);
+    uint64_t now_us = 0;
+    bool done = false;
+    for (size_t s = segment_index; s < recording.SegmentCount() && !done; ++s) {
+        const SegmentReader& segment = recording.Segment(s);
+        RecordDecryptor decryptor;
+        if (!decryptor.Load(segment.Header(), opt.key)) {
+            fprintf(stderr, "[ERROR] Wrong storage key or corrupted segment %08u\n", segment.Header().sequence);
+            fclose(out);
+            return 1;
+        }
+        SegmentRecord record;
+        for (uint64_t pos = s == segment_index ? offset : segment.DataBegin();
+             !done && segment.ReadRecord(pos, &record); pos = record.next_offset) {
+            ++stats.records;
+            now_us = record.arrival_us;
+            PacketHeader header;
+            const size_t len = decryptor.Open(record.data, record.len, &header, plain.data());
+            if (len == 0) {
+                ++stats.rejected;
+                continue;
+            }
+            if (header.stream_id != MEDIA_STREAM_VIDEO) continue;
+            jitter.Insert(header.seq_num, header.fragment_id, header.total_fragments,
+                          (header.flags & PACKET_FLAG_KEYFRAME) != 0, (header.flags & PACKET_FLAG_UNIT_END) != 0,
+                          header.timestamp, plain.data(), len, now_us);
+            Drain(&jitter, now_us, end_pts, start_pts, out, &stats, &done);
+        }
+    }
+    // 录制末尾: 把剩余的帧全部推到播放截止时间之后
+    if (!done) Drain(&jitter, now_us + 10 * 1000000ull, end_pts, start_pts, out, &stats, &done);
+    fclose(out);
+
+    printf("start %.3fs  records %llu  rejected %llu  frames %llu  lost %llu  bytes %llu\n",
+           Seconds(start_pts, base), (unsigned long long)stats.records, (unsigned long long)stats.rejected,
+           (unsigned long long)stats.frames, (unsigned long long)stats.lost, (unsigned long long)stats.bytes);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!ParseOptions(argc, argv, &opt)) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    Recording recording;
+    if (!recording.Open(opt.directory)) {
+        fprintf(stderr, "[ERROR] No segments in %s\n", opt.directory.c_str());
+        return 1;
+    }
+    uint64_t base = 0;
+    const bool has_keyframe = FirstKeyframe(recording, &base);
+
+    if (opt.list) {
+        List(recording, base);
+        if (opt.output_path.empty()) return 0;
+    }
+    if (!has_keyframe) {
+        fprintf(stderr, "[ERROR] No keyframe in recording\n");
+        return 1;
+    }
+    return Play(recording, opt, base);
+}
@@ -0,0 +1,128 @@
+//保序工作线程池
+
+#ifndef ORDERED_WORKER_POOL_H
+#define ORDERED_WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "spsc_queue.h"
+
+namespace utils {
+
+// 保序线程池: 任务按轮转分给工作线程，按同样顺序取回，结果顺序与提交顺序一致
+// 生产者与消费者为同一线程时须用TrySubmit，失败时先取回结果
+template <typename T>
+class OrderedWorkerPool {
+public:
+    using Handler = std::function<void(T&)>;
+
+    // workers为0时按核心数选择; depth为每个工作线程的输入/输出队列容量
+    OrderedWorkerPool(size_t workers, size_t depth, Handler handler)
+        : handler_(std::move(handler)), next_submit_(0), next_collect_(0), stop_(false) {
+        if (workers == 0) workers = DefaultWorkers();
+        for (size_t i = 0; i < workers; i++) lanes_.emplace_back(new Lane(depth));
+    }
+
+    ~OrderedWorkerPool() { Stop(); }
+
+    OrderedWorkerPool(const OrderedWorkerPool&) = delete;
+    OrderedWorkerPool& operator=(const OrderedWorkerPool&) = delete;
+
+    // 留一个核心给生产者/消费者所在的流水线线程，最多4个
+    static size_t DefaultWorkers() {
+        unsigned cores = std::thread::hardware_concurrency();
+        return std::max<size_t>(1, std::min<size_t>(4, cores > 1 ? cores - 1 : 1));
+    }
+
+    void Start() {
+        if (lanes_.empty() || lanes_[0]->thread.joinable()) return;
+        stop_.store(false);
+        for (auto& lane : lanes_) lane->thread = std::thread(&OrderedWorkerPool::Run, this, lane.get());
+    }
+
+    // 停止工作线程; 队列中未取回的任务直接丢弃 (T应为不拥有资源的指针)
+    void Stop() {
+        stop_.store(true);
+        for (auto& lane : lanes_) {
+            if (lane->thread.joinable()) lane->thread.join();
+        }
+        T item;
+        for (auto& lane : lanes_) {
+            while (lane->in.TryPop(&item)) {}
+            while (lane->out.TryPop(&item)) {}
+        }
+        next_submit_ = next_collect_ = 0;
+    }
+
+    size_t Workers() const { return lanes_.size(); }
+
+    // 生产者
+    bool TrySubmit(T item) {
+        if (!lanes_[next_submit_]->in.TryPush(std::move(item))) return false;
+        Advance(&next_submit_);
+        return true;
+    }
+
+    bool Submit(T item, const std::atomic<bool>& stop) {
+        if (!lanes_[next_submit_]->in.Push(std::move(item), stop)) return false;
+        Advance(&next_submit_);
+        return true;
+    }
+
+    // 消费者: 下一个结果尚未处理完时TryCollect返回false (即使后续任务已完成)
+    bool TryCollect(T* item) {
+        if (!lanes_[next_collect_]->out.TryPop(item)) return false;
+        Advance(&next_collect_);
+        return true;
+    }
+
+    bool Collect(T* item, const std::atomic<bool>& stop) {
+        if (!lanes_[next_collect_]->out.Pop(item, stop)) return false;
+        Advance(&next_collect_);
+        return true;
+    }
+
+    // 生产者因工作线程输入队列满而等待的次数
+    uint64_t SubmitWaits() const {
+        uint64_t waits = 0;
+        for (const auto& lane : lanes_) waits += lane->in.FullWaits();
+        return waits;
+    }
+
+private:
+    struct Lane {
+        explicit Lane(size_t depth) : in(depth), out(depth) {}
+        SpscQueue<T> in;
+        SpscQueue<T> out;
+        std::thread thread;
+    };
+
+    void Advance(size_t* index) const {
+        if (++*index == lanes_.size()) *index = 0;
+    }
+
+    void Run(Lane* lane) {
+        T item;
+        while (lane->in.Pop(&item, stop_)) {
+            handler_(item);
+            if (!lane->out.Push(std::move(item), stop_)) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    Handler handler_;
+    alignas(64) size_t next_submit_;    // 仅生产者使用
+    alignas(64) size_t next_collect_;   // 仅消费者使用
+    std::atomic<bool> stop_;
+};
+
+}  // namespace utils
+
+#endif
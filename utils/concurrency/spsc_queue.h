@@ -0,0 +1,127 @@
+//单生产者单消费者有界无锁队列
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace utils {
+
+// 等待策略: 先自旋，再让出CPU，最后短暂休眠 (流水线各级空闲时不占满核心)
+class Backoff {
+public:
+    void Pause() {
+        if (count_ < kSpinLimit) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        } else if (count_ < kYieldLimit) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        ++count_;
+    }
+    void Reset() { count_ = 0; }
+
+private:
+    static const uint32_t kSpinLimit = 64;
+    static const uint32_t kYieldLimit = 128;
+    uint32_t count_ = 0;
+};
+
+// 只允许一个线程Push、一个线程Pop; T应为可廉价复制的类型 (通常是指针)。容量向上取2的幂。
+// 头尾索引各占一条缓存行，并各自缓存对方索引，只在看似满/空时才读取对方的原子变量
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : head_(0), cached_tail_(0), tail_(0), cached_head_(0), full_waits_(0) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_.reset(new T[cap]);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t Capacity() const { return mask_ + 1; }
+
+    // 近似长度 (仅供统计)
+    size_t Size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    // 生产者: 队列满时返回false
+    bool TryPush(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者: 队列空时返回false
+    bool TryPop(T* out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        *out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 阻塞入队 (背压): 队列满时等待消费者，stop置位时放弃并返回false
+    bool Push(T value, const std::atomic<bool>& stop) {
+        if (TryPush(value)) return true;
+        full_waits_.fetch_add(1, std::memory_order_relaxed);
+        Backoff backoff;
+        while (!stop.load(std::memory_order_relaxed)) {
+            backoff.Pause();
+            if (TryPush(value)) return true;
+        }
+        return false;
+    }
+
+    // 阻塞出队: 队列空时等待生产者，stop置位时返回false
+    bool Pop(T* out, const std::atomic<bool>& stop) {
+        Backoff backoff;
+        while (!TryPop(out)) {
+            if (stop.load(std::memory_order_relaxed)) return false;
+            backoff.Pause();
+        }
+        return true;
+    }
+
+    // 生产者因队列满而等待的次数 (衡量下游是否为瓶颈)
+    uint64_t FullWaits() const { return full_waits_.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<size_t> head_;   // 消费者写
+    size_t cached_tail_;                     // 消费者私有
+    alignas(64) std::atomic<size_t> tail_;   // 生产者写
+    size_t cached_head_;                     // 生产者私有
+    alignas(64) std::atomic<uint64_t> full_waits_;
+    size_t mask_;
+    std::unique_ptr<T[]> slots_;
+};
+
+}  // namespace utils
+
+#endif
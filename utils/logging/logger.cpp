@@ -0,0 +1,281 @@
+//异步日志实现
+
+#include "logger.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+namespace utils {
+
+namespace {
+
+const char* const kLevelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+const auto kIdleWait = std::chrono::milliseconds(5);    // 后台线程无日志时的轮询间隔
+
+// 线程退出时标记其缓冲区，后台线程取空后回收
+struct BufferHolder {
+    std::shared_ptr<void> buffer;
+    std::atomic<bool>* retired = nullptr;
+    ~BufferHolder() {
+        if (retired) retired->store(true, std::memory_order_release);
+    }
+};
+
+void ShutdownAtExit() {
+    Logger::Instance().Shutdown();
+}
+
+// 把一个转换说明连同参数格式化进out; spec为 "%[flags][width][.precision]" (不含长度修饰与转换符)
+void AppendArg(const LogRecord& r, size_t index, char conv, const char* spec, std::string* out) {
+    const LogRecord::Arg& arg = r.args[index];
+    const uint8_t type = r.arg_types[index];
+    char format[48];
+    char buf[256];
+    int n = 0;
+    switch (conv) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+        snprintf(format, sizeof(format), "%sll%c", spec, conv);
+        long long value = type == LogRecord::kDouble ? static_cast<long long>(arg.d) : arg.i;
+        n = snprintf(buf, sizeof(buf), format, value);
+        break;
+    }
+    case 'c':
+        snprintf(format, sizeof(format), "%sc", spec);
+        n = snprintf(buf, sizeof(buf), format, static_cast<int>(arg.i));
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+        snprintf(format, sizeof(format), "%s%c", spec, conv);
+        double value = type == LogRecord::kDouble ? arg.d
+                       : type == LogRecord::kInt  ? static_cast<double>(arg.i)
+                                                  : static_cast<double>(arg.u);
+        n = snprintf(buf, sizeof(buf), format, value);
+        break;
+    }
+    case 's':
+        snprintf(format, sizeof(format), "%ss", spec);
+        n = snprintf(buf, sizeof(buf), format, type == LogRecord::kString ? r.text + arg.text : "(?)");
+        break;
+    case 'p':
+        snprintf(format, sizeof(format), "%sp", spec);
+        n = snprintf(buf, sizeof(buf), format, arg.p);
+        break;
+    default:
+        return;
+    }
+    if (n > 0) out->append(buf, std::min<size_t>(static_cast<size_t>(n), sizeof(buf) - 1));
+}
+
+}  // namespace
+
+Logger& Logger::Instance() {
+    static Logger* logger = new Logger();
+    return *logger;
+}
+
+Logger::Logger()
+    : file_(stderr), flush_requested_(0), flush_done_(0), dropped_reported_(0), dropped_(0), running_(true) {
+    const int64_t wall = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    wall_offset_us_ = wall - static_cast<int64_t>(NowMicros());
+    batch_.reserve(kThreadRecords);
+    output_.reserve(64 * 1024);
+    thread_ = std::thread(&Logger::Run, this);
+    atexit(ShutdownAtExit);
+}
+
+bool Logger::SetOutput(const std::string& path) {
+    FILE* file = stderr;
+    if (!path.empty()) {
+        file = fopen(path.c_str(), "a");
+        if (!file) return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    fflush(file_);
+    if (file_ != stderr) fclose(file_);
+    file_ = file;
+    return true;
+}
+
+void Logger::CaptureString(LogRecord* r, const char* value) {
+    LogRecord::Arg& arg = r->args[r->arg_count];
+    r->arg_types[r->arg_count++] = LogRecord::kString;
+    if (!value) value = "(null)";
+    const size_t room = LogRecord::kTextBytes - r->text_used;
+    if (room == 0) {
+        // 拷贝区已满: 指向上一个字符串的结尾 (空串)
+        arg.text = LogRecord::kTextBytes - 1;
+        return;
+    }
+    const size_t len = std::min(strlen(value), room - 1);
+    memcpy(r->text + r->text_used, value, len);
+    r->text[r->text_used + len] = '\0';
+    arg.text = r->text_used;
+    r->text_used = static_cast<uint16_t>(r->text_used + len + 1);
+}
+
+Logger::ThreadBuffer* Logger::LocalBuffer() {
+    thread_local BufferHolder holder;
+    if (!holder.buffer) {
+        std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(buffer);
+        }
+        holder.retired = &buffer->retired;
+        holder.buffer = buffer;
+    }
+    return static_cast<ThreadBuffer*>(holder.buffer.get());
+}
+
+void Logger::Submit(const LogRecord& record) {
+    if (!running_.load(std::memory_order_acquire)) {
+        // 已关闭 (进程退出阶段): 同步写出
+        std::string line;
+        Append(record, &line);
+        std::lock_guard<std::mutex> lock(mutex_);
+        fwrite(line.data(), 1, line.size(), file_);
+        fflush(file_);
+        return;
+    }
+    if (!LocalBuffer()->queue.TryPush(record)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::Append(const LogRecord& r, std::string* out) const {
+    const int64_t wall_us = static_cast<int64_t>(r.time_us) + wall_offset_us_;
+    const time_t seconds = static_cast<time_t>(wall_us / 1000000);
+    struct tm tm_value;
+    localtime_r(&seconds, &tm_value);
+    char prefix[64];
+    int n = snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06d [%s] ", tm_value.tm_hour, tm_value.tm_min,
+                     tm_value.tm_sec, static_cast<int>(wall_us % 1000000),
+                     kLevelNames[static_cast<int>(r.level) & 3]);
+    out->append(prefix, static_cast<size_t>(n));
+
+    // 逐个拆出转换说明，用记录中的参数单独格式化; 长度修饰按参数的实际类型重写
+    size_t index = 0;
+    for (const char* p = r.format; *p;) {
+        if (*p != '%') {
+            const char* next = strchr(p, '%');
+            const size_t len = next ? static_cast<size_t>(next - p) : strlen(p);
+            out->append(p, len);
+            p += len;
+            continue;
+        }
+        if (p[1] == '%') {
+            out->push_back('%');
+            p += 2;
+            continue;
+        }
+        char spec[24];
+        size_t len = 0;
+        spec[len++] = *p++;
+        while (*p && strchr("-+ #0", *p) && len < 8) spec[len++] = *p++;
+        while (*p && (isdigit(static_cast<unsigned char>(*p)) || *p == '.') && len < sizeof(spec) - 1) spec[len++] = *p++;
+        spec[len] = '\0';
+        while (*p && strchr("hlLqjzt", *p)) ++p;
+        const char conv = *p;
+        if (!conv) break;
+        ++p;
+        if (index >= r.arg_count) break;
+        AppendArg(r, index++, conv, spec, out);
+    }
+    if (r.suppressed > 0) {
+        n = snprintf(prefix, sizeof(prefix), " (%u similar messages suppressed)", r.suppressed);
+        out->append(prefix, static_cast<size_t>(n));
+    }
+    out->push_back('\n');
+}
+
+// 收集所有线程缓冲区中的日志，按时间排序后一次写出。返回是否写出了内容
+bool Logger::Drain() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers = buffers_;
+    }
+
+    batch_.clear();
+    LogRecord record;
+    for (const auto& buffer : buffers) {
+        while (buffer->queue.TryPop(&record)) batch_.push_back(record);
+    }
+    // 各线程内部有序，合并后按时间排序
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const LogRecord& a, const LogRecord& b) { return a.time_us < b.time_us; });
+
+    output_.clear();
+    for (const LogRecord& r : batch_) Append(r, &output_);
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported_) {
+        // 构造一条记录输出，与其它日志保持相同的时间前缀
+        LogRecord notice;
+        notice.time_us = NowMicros();
+        notice.format = "logging dropped records (thread buffer full): %llu";
+        notice.suppressed = 0;
+        notice.text_used = 0;
+        notice.level = LogLevel::Warn;
+        notice.arg_count = 1;
+        notice.arg_types[0] = LogRecord::kUint;
+        notice.args[0].u = dropped - dropped_reported_;
+        Append(notice, &output_);
+        dropped_reported_ = dropped;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!output_.empty()) {
+        fwrite(output_.data(), 1, output_.size(), file_);
+        fflush(file_);
+    }
+    // 回收已退出且取空的线程缓冲区
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<ThreadBuffer>& b) {
+                                      return b->retired.load(std::memory_order_acquire) && b->queue.Size() == 0;
+                                  }),
+                   buffers_.end());
+    return !batch_.empty();
+}
+
+void Logger::Run() {
+    while (running_.load(std::memory_order_acquire)) {
+        uint64_t requested;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requested = flush_requested_;
+        }
+        const bool wrote = Drain();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (requested != flush_done_) {
+            flush_done_ = requested;
+            flushed_.notify_all();
+        }
+        // 刚写出过日志时立即再取一轮，否则等待下一个轮询周期或Flush唤醒
+        if (!wrote && flush_requested_ == flush_done_) wake_.wait_for(lock, kIdleWait);
+    }
+}
+
+void Logger::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_.load(std::memory_order_acquire)) {
+        fflush(file_);
+        return;
+    }
+    const uint64_t target = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [this, target] { return flush_done_ >= target || !running_.load(); });
+}
+
+void Logger::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) return;
+        running_.store(false, std::memory_order_release);
+        wake_.notify_one();
+        flushed_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+    Drain();
+}
+
+}  // namespace utils
@@ -0,0 +1,222 @@
+//异步日志: 每线程无锁环形缓冲 + 后台线程格式化输出
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../concurrency/spsc_queue.h"
+
+// 编译期级别过滤: 低于LOG_MIN_LEVEL的调用不生成代码，参数也不求值 (编译选项 -DLOG_MIN_LEVEL=0 打开调试日志)
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+
+namespace utils {
+
+enum class LogLevel : uint8_t { Debug = 0, Info, Warn, Error };
+
+// 一条日志: 只保存格式串指针 (须为字符串字面量) 与参数的二进制值，格式化推迟到后台线程。
+// 字符串参数在调用时拷贝 (超长截断)，调用返回后即可释放
+struct LogRecord {
+    static constexpr size_t kMaxArgs = 8;
+    static constexpr size_t kTextBytes = 152;
+
+    enum ArgType : uint8_t { kInt, kUint, kDouble, kPointer, kString };
+    union Arg {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        uint32_t text;          // kString: text中的偏移
+    };
+
+    uint64_t time_us;           // 单调时钟
+    const char* format;
+    uint32_t suppressed;        // 此前被限速丢弃的同一调用点条数
+    uint16_t text_used;
+    LogLevel level;
+    uint8_t arg_count;
+    uint8_t arg_types[kMaxArgs];
+    Arg args[kMaxArgs];
+    char text[kTextBytes];
+};
+
+// 每个调用点一个: 每秒最多放行burst条，其余只计数，在下一条放行的日志后报告被丢弃的条数
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(uint32_t burst = 20) : window_us_(0), count_(0), suppressed_(0), burst_(burst) {}
+
+    bool Allow(uint64_t now_us, uint32_t* suppressed) {
+        uint64_t window = window_us_.load(std::memory_order_relaxed);
+        if (now_us - window >= kWindowUs &&
+            window_us_.compare_exchange_strong(window, now_us, std::memory_order_relaxed)) {
+            count_.store(0, std::memory_order_relaxed);
+        }
+        if (count_.fetch_add(1, std::memory_order_relaxed) < burst_) {
+            *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+private:
+    static constexpr uint64_t kWindowUs = 1000000;
+    std::atomic<uint64_t> window_us_;
+    std::atomic<uint32_t> count_;
+    std::atomic<uint32_t> suppressed_;
+    const uint32_t burst_;
+};
+
+// 调用线程只做: 限速判断、取时间、把参数写入本线程的SPSC环 (不加锁、不分配、不做I/O)。
+// 环满时丢弃并计数，绝不阻塞调用线程。后台线程定期收集各线程的环，按时间排序后格式化，一次写出
+class Logger {
+public:
+    static Logger& Instance();
+
+    // 输出到文件 (追加)，空串表示stderr
+    bool SetOutput(const std::string& path);
+
+    template <typename... Args>
+    void Log(LogLevel level, LogRateLimiter* limiter, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "too many log arguments");
+        const uint64_t now_us = NowMicros();
+        uint32_t suppressed = 0;
+        if (limiter && !limiter->Allow(now_us, &suppressed)) return;
+
+        LogRecord record;
+        record.time_us = now_us;
+        record.format = format;
+        record.suppressed = suppressed;
+        record.text_used = 0;
+        record.level = level;
+        record.arg_count = 0;
+        int expand[] = {0, (Capture(&record, args), 0)...};
+        (void)expand;
+        Submit(record);
+    }
+
+    // 等待此前提交的日志全部写出
+    void Flush();
+
+    // 停止后台线程并写出剩余日志; 之后的日志在调用线程同步写出。进程退出时自动调用
+    void Shutdown();
+
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static uint64_t NowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static constexpr size_t kThreadRecords = 1024;   // 每线程在途日志条数
+
+    struct ThreadBuffer {
+        ThreadBuffer() : queue(kThreadRecords), retired(false) {}
+        SpscQueue<LogRecord> queue;
+        std::atomic<bool> retired;      // 所属线程已退出，取空后回收
+    };
+
+    Logger();
+    ~Logger() = delete;     // 不析构: 其它静态对象析构时仍可能写日志
+
+    template <typename T>
+    static void Capture(LogRecord* r, const T& value) {
+        LogRecord::Arg& arg = r->args[r->arg_count];
+        uint8_t& type = r->arg_types[r->arg_count++];
+        if constexpr (std::is_floating_point<T>::value) {
+            type = LogRecord::kDouble;
+            arg.d = value;
+        } else if constexpr (std::is_enum<T>::value || (std::is_integral<T>::value && std::is_signed<T>::value)) {
+            type = LogRecord::kInt;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral<T>::value) {
+            type = LogRecord::kUint;
+            arg.u = static_cast<uint64_t>(value);
+        } else {
+            static_assert(std::is_pointer<T>::value, "unsupported log argument type");
+            type = LogRecord::kPointer;
+            arg.p = value;
+        }
+    }
+    static void Capture(LogRecord* r, const char* value) { CaptureString(r, value); }
+    static void Capture(LogRecord* r, char* value) { CaptureString(r, value); }
+    template <size_t N>
+    static void Capture(LogRecord* r, const char (&value)[N]) { CaptureString(r, value); }
+    template <size_t N>
+    static void Capture(LogRecord* r, char (&value)[N]) { CaptureString(r, value); }
+    static void CaptureString(LogRecord* r, const char* value);
+
+    void Submit(const LogRecord& record);
+    ThreadBuffer* LocalBuffer();
+    void Run();
+    bool Drain();
+    void Append(const LogRecord& record, std::string* out) const;
+
+    std::mutex mutex_;                                   // 保护buffers_、输出与刷新状态
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::vector<LogRecord> batch_;                       // 仅后台线程使用
+    std::string output_;                                 // 仅后台线程使用
+    FILE* file_;
+    int64_t wall_offset_us_;                             // 单调时钟 -> 墙上时间
+    uint64_t flush_requested_;
+    uint64_t flush_done_;
+    uint64_t dropped_reported_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+}  // namespace utils
+
+#define UTILS_LOG(level, fmt, ...)                                                           \
+    do {                                                                                     \
+        static ::utils::LogRateLimiter utils_log_limiter_;                                   \
+        if (0) printf(fmt, ##__VA_ARGS__);  /* 只用于编译期检查格式串与参数 */               \
+        ::utils::Logger::Instance().Log(level, &utils_log_limiter_, fmt, ##__VA_ARGS__);      \
+    } while (0)
+
+#define UTILS_LOG_DISABLED(fmt, ...)          \
+    do {                                      \
+        if (0) printf(fmt, ##__VA_ARGS__);    \
+    } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) UTILS_LOG(::utils::LogLevel::Debug, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) UTILS_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) UTILS_LOG(::utils::LogLevel::Info, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) UTILS_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) UTILS_LOG(::utils::LogLevel::Warn, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) UTILS_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#define LOG_ERROR(fmt, ...) UTILS_LOG(::utils::LogLevel::Error, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,142 @@
+//端到端帧追踪实现
+
+#include "frame_trace.h"
+#include <string.h>
+
+namespace utils {
+
+namespace {
+
+const char* const kTraceStageNames[] = {
+    "encode", "encrypt", "send", "network", "verify", "decode", "present",
+    "sender", "receiver", "end_to_end",
+};
+static_assert(sizeof(kTraceStageNames) / sizeof(kTraceStageNames[0]) == static_cast<size_t>(TraceStage::Count),
+              "trace stage names out of sync");
+
+const uint32_t kMaxDeltaUs = 0x80000000u;   // 差值超过半个回绕周期视为时刻倒序，丢弃
+
+}  // namespace
+
+const char* TraceStageName(TraceStage stage) {
+    return static_cast<size_t>(stage) < static_cast<size_t>(TraceStage::Count)
+               ? kTraceStageNames[static_cast<size_t>(stage)] : "?";
+}
+
+FrameTracer::FrameTracer(bool single_clock)
+    : single_clock_(single_clock), pending_(0),
+      histograms_(new HistogramSnapshot[static_cast<size_t>(TraceStage::Count)]()),
+      frames_(0), incomplete_(0), file_(nullptr) {
+    memset(slots_, 0, sizeof(slots_));
+    memset(max_us_, 0, sizeof(max_us_));
+}
+
+FrameTracer::~FrameTracer() {
+    if (file_) fclose(file_);
+}
+
+bool FrameTracer::SetOutput(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    fprintf(file, "timestamp,capture_us,encode_us,encrypt_us,send_us,receive_us,verify_us,decode_us,present_us\n");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) fclose(file_);
+    file_ = file;
+    return true;
+}
+
+void FrameTracer::OnReceived(uint32_t timestamp, const FrameTimeline& timeline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* target = nullptr;
+    Slot* oldest = nullptr;
+    for (Slot& s : slots_) {
+        if (!s.in_use) {
+            if (!target) target = &s;
+            continue;
+        }
+        if (s.timestamp == timestamp) {
+            target = &s;   // 同一帧重复登记: 以后到的为准
+            break;
+        }
+        if (!oldest || static_cast<int32_t>(s.timeline.receive_us - oldest->timeline.receive_us) < 0) oldest = &s;
+    }
+    if (!target) {
+        // 丢失或被丢弃的帧不会输出，挤出最早登记的
+        target = oldest;
+        target->in_use = false;
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        ++incomplete_;
+    }
+    if (!target->in_use) pending_.fetch_add(1, std::memory_order_relaxed);
+    target->in_use = true;
+    target->timestamp = timestamp;
+    target->timeline = timeline;
+}
+
+void FrameTracer::OnOutput(uint32_t timestamp, uint32_t decode_us, uint32_t present_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Slot& s : slots_) {
+        if (!s.in_use || s.timestamp != timestamp) continue;
+        s.in_use = false;
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        s.timeline.decode_us = decode_us;
+        s.timeline.present_us = present_us;
+        Complete(s.timeline);
+        if (file_) {
+            const FrameTimeline& t = s.timeline;
+            fprintf(file_, "%u,%u,%u,%u,%u,%u,%u,%u,%u\n", timestamp, t.capture_us, t.encode_us, t.encrypt_us,
+                    t.send_us, t.receive_us, t.verify_us, t.decode_us, t.present_us);
+        }
+        return;
+    }
+}
+
+void FrameTracer::Complete(const FrameTimeline& t) {
+    Add(TraceStage::Encode, t.capture_us, t.encode_us);
+    Add(TraceStage::Encrypt, t.encode_us, t.encrypt_us);
+    Add(TraceStage::Send, t.encrypt_us, t.send_us);
+    Add(TraceStage::Verify, t.receive_us, t.verify_us);
+    Add(TraceStage::Decode, t.verify_us, t.decode_us);
+    Add(TraceStage::Present, t.decode_us, t.present_us);
+    Add(TraceStage::Sender, t.capture_us, t.send_us);
+    Add(TraceStage::Receiver, t.receive_us, t.present_us);
+    if (single_clock_) {
+        Add(TraceStage::Network, t.send_us, t.receive_us);
+        Add(TraceStage::EndToEnd, t.capture_us, t.present_us);
+    }
+    if (t.present_us) ++frames_;
+    else ++incomplete_;
+}
+
+void FrameTracer::Add(TraceStage stage, uint32_t from_us, uint32_t to_us) {
+    if (from_us == 0 || to_us == 0) return;
+    const uint32_t delta_us = to_us - from_us;
+    if (delta_us >= kMaxDeltaUs) return;
+    const size_t i = static_cast<size_t>(stage);
+    HistogramSnapshot& h = histograms_[i];
+    const uint64_t ns = static_cast<uint64_t>(delta_us) * 1000;
+    ++h.counts[LatencyBuckets::Index(ns)];
+    ++h.count;
+    h.sum_ns += ns;
+    if (delta_us > max_us_[i]) max_us_[i] = delta_us;
+}
+
+void FrameTracer::Summarize(FrameTraceSummary* out) const {
+    memset(out, 0, sizeof(*out));
+    std::lock_guard<std::mutex> lock(mutex_);
+    out->frames = frames_;
+    out->incomplete = incomplete_;
+    for (size_t i = 0; i < static_cast<size_t>(TraceStage::Count); ++i) {
+        const HistogramSnapshot& h = histograms_[i];
+        FrameTraceSummary::Stage& s = out->stages[i];
+        if (h.count == 0) continue;
+        s.count = h.count;
+        s.mean_us = static_cast<double>(h.sum_ns) / 1000.0 / static_cast<double>(h.count);
+        s.p50_us = static_cast<uint32_t>(h.Percentile(0.5) / 1000);
+        s.p90_us = static_cast<uint32_t>(h.Percentile(0.9) / 1000);
+        s.p99_us = static_cast<uint32_t>(h.Percentile(0.99) / 1000);
+        s.max_us = max_us_[i];
+    }
+}
+
+}  // namespace utils
@@ -0,0 +1,114 @@
+//端到端帧追踪: 汇总数据报中携带的发送端时刻与接收端各环节时刻，按阶段统计延迟
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <time.h>
+#include "metrics.h"
+
+namespace utils {
+
+// 一帧在两端各环节的时刻: CLOCK_MONOTONIC微秒的低32位，差值按无符号回绕计算; 0表示未记录
+struct FrameTimeline {
+    uint32_t capture_us;        // 发送端: 采集读到该帧
+    uint32_t encode_us;         // 编码器输出
+    uint32_t encrypt_us;        // 帧最后一个分片封装完成
+    uint32_t send_us;           // 交给套接字
+    uint32_t receive_us;        // 接收端: 帧最后一个分片到达
+    uint32_t verify_us;         // 该分片通过校验并解密
+    uint32_t decode_us;         // 解码器输出该帧
+    uint32_t present_us;        // 交给输出端 (显示模式下为送入显示队列)
+};
+
+// 相邻时刻之差; Network与EndToEnd跨越两端时钟，只在单时钟域 (同机回环) 下统计
+enum class TraceStage : uint8_t {
+    Encode,         // capture -> encode
+    Encrypt,        // encode -> encrypt (含分片与加密线程排队)
+    Send,           // encrypt -> send (含发送限速)
+    Network,        // send -> receive
+    Verify,         // receive -> verify (含校验线程排队)
+    Decode,         // verify -> decode (含抖动缓冲区等待)
+    Present,        // decode -> present (含音视频同步等待与格式转换)
+    Sender,         // capture -> send
+    Receiver,       // receive -> present
+    EndToEnd,       // capture -> present
+    Count
+};
+
+const char* TraceStageName(TraceStage stage);
+
+struct FrameTraceSummary {
+    uint64_t frames;            // 完整记录的帧数
+    uint64_t incomplete;        // 收到追踪扩展但未输出 (丢失、被丢弃或被挤出)
+    struct Stage {
+        uint64_t count;
+        double mean_us;
+        uint32_t p50_us;
+        uint32_t p90_us;
+        uint32_t p99_us;
+        uint32_t max_us;        // 精确值
+    } stages[static_cast<size_t>(TraceStage::Count)];
+};
+
+// 收包线程登记带扩展的帧，解码线程在输出后补齐接收端时刻并计入直方图。
+// 每帧只有一次登记和一次匹配，用互斥锁保护; 未收到扩展时解码线程只读一次原子计数
+class FrameTracer {
+public:
+    // single_clock: 两端运行在同一台机器上 (CLOCK_MONOTONIC相同)，跨端差值有意义
+    explicit FrameTracer(bool single_clock);
+    ~FrameTracer();
+
+    FrameTracer(const FrameTracer&) = delete;
+    FrameTracer& operator=(const FrameTracer&) = delete;
+
+    // 每帧一行CSV (各时刻原值)，供回归比对; 须在开始登记前调用
+    bool SetOutput(const std::string& path);
+
+    static uint32_t NowMicros() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint32_t>(static_cast<uint64_t>(ts.tv_sec) * 1000000ull +
+                                     static_cast<uint64_t>(ts.tv_nsec) / 1000);
+    }
+
+    // timeline中解码与输出时刻尚未填写; 按媒体时间戳匹配
+    void OnReceived(uint32_t timestamp, const FrameTimeline& timeline);
+    bool HasPending() const { return pending_.load(std::memory_order_relaxed) > 0; }
+    // present_us为0表示该帧解码后未输出
+    void OnOutput(uint32_t timestamp, uint32_t decode_us, uint32_t present_us);
+
+    void Summarize(FrameTraceSummary* out) const;
+
+private:
+    static constexpr size_t kSlots = 64;    // 在途帧 (约2秒@30fps)，满时挤出最早的
+
+    struct Slot {
+        bool in_use;
+        uint32_t timestamp;
+        FrameTimeline timeline;
+    };
+
+    void Complete(const FrameTimeline& t);
+    void Add(TraceStage stage, uint32_t from_us, uint32_t to_us);
+
+    const bool single_clock_;
+    mutable std::mutex mutex_;
+    Slot slots_[kSlots];
+    std::atomic<size_t> pending_;
+    std::unique_ptr<HistogramSnapshot[]> histograms_;   // 按TraceStage，延迟以纳秒计
+    uint32_t max_us_[static_cast<size_t>(TraceStage::Count)];
+    uint64_t frames_;
+    uint64_t incomplete_;
+    FILE* file_;
+};
+
+}  // namespace utils
+
+#endif
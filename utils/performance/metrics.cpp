@@ -0,0 +1,227 @@
+//性能埋点实现与导出
+
+#include "metrics.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+namespace utils {
+
+namespace {
+
+const char* const kStageNames[] = {
+    "capture", "encode", "encrypt", "hash", "send",
+    "receive", "verify", "decrypt", "reassembly", "decode",
+};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(Stage::Count),
+              "stage names out of sync");
+
+const char* const kEventNames[] = {
+    "packets_sent", "packets_received", "send_errors", "retransmits", "packets_lost",
+    "receive_drops", "malformed", "auth_failures", "demux_failures", "key_unavailable", "key_rotations",
+    "sessions_created", "sessions_removed", "sessions_expired",
+};
+static_assert(sizeof(kEventNames) / sizeof(kEventNames[0]) == static_cast<size_t>(Event::Count),
+              "event names out of sync");
+
+double Micros(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+}  // namespace
+
+std::atomic<bool> Metrics::enabled_(false);
+
+const char* StageName(Stage stage) {
+    return static_cast<size_t>(stage) < static_cast<size_t>(Stage::Count) ? kStageNames[static_cast<size_t>(stage)] : "?";
+}
+
+const char* EventName(Event event) {
+    return static_cast<size_t>(event) < static_cast<size_t>(Event::Count) ? kEventNames[static_cast<size_t>(event)] : "?";
+}
+
+uint64_t HistogramSnapshot::Percentile(double q) const {
+    // 按桶计数求总数: 快照与写入并发时count与各桶之和可能略有出入
+    uint64_t total = 0;
+    for (size_t i = 0; i < LatencyBuckets::kCount; ++i) total += counts[i];
+    if (total == 0) return 0;
+    // 第rank个样本 (从1计) 所在的桶
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LatencyBuckets::kCount; ++i) {
+        seen += counts[i];
+        if (seen >= rank) return LatencyBuckets::LowerBound(i);
+    }
+    return LatencyBuckets::LowerBound(LatencyBuckets::kCount - 1);
+}
+
+uint64_t HistogramSnapshot::Max() const {
+    for (size_t i = LatencyBuckets::kCount; i > 0; --i) {
+        if (counts[i - 1]) return LatencyBuckets::LowerBound(i - 1);
+    }
+    return 0;
+}
+
+void MetricsSnapshot::Subtract(const MetricsSnapshot& earlier) {
+    for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+        HistogramSnapshot& h = stages[s];
+        const HistogramSnapshot& e = earlier.stages[s];
+        for (size_t i = 0; i < LatencyBuckets::kCount; ++i) h.counts[i] -= e.counts[i];
+        h.count -= e.count;
+        h.sum_ns -= e.sum_ns;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(Event::Count); ++i) events[i] -= earlier.events[i];
+}
+
+Metrics& Metrics::Instance() {
+    static Metrics* metrics = new Metrics();   // 不析构: 线程退出时仍可能记录
+    return *metrics;
+}
+
+Metrics::Metrics() : file_(nullptr), socket_fd_(-1), stop_(false) {}
+
+Metrics::ThreadData* Metrics::Register() {
+    // 值初始化: 计数全部为0
+    std::unique_ptr<ThreadData> data(new ThreadData());
+    ThreadData* raw = data.get();
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.push_back(std::move(data));
+    return raw;
+}
+
+void Metrics::Snapshot(MetricsSnapshot* out) const {
+    memset(out, 0, sizeof(*out));
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& thread : threads_) {
+        for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+            const ThreadData::StageData& src = thread->stages[s];
+            HistogramSnapshot& dst = out->stages[s];
+            // 与写入并发: count与桶计数之间的微小出入只影响当前区间，下一次导出自然抵消
+            dst.count += src.count.load(std::memory_order_relaxed);
+            dst.sum_ns += src.sum_ns.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < LatencyBuckets::kCount; ++i) {
+                dst.counts[i] += src.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Event::Count); ++i) {
+            out->events[i] += thread->events[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Metrics::StartExport(const MetricsExportConfig& config) {
+    if (thread_.joinable()) return false;
+    if (config.path.empty() && config.socket_path.empty()) return false;
+    config_ = config;
+    if (config_.interval_ms == 0) config_.interval_ms = 1000;
+
+    if (!config_.path.empty()) {
+        file_ = fopen(config_.path.c_str(), "a");
+        if (!file_) return false;
+    } else {
+        sockaddr_un addr;
+        if (config_.socket_path.size() >= sizeof(addr.sun_path)) return false;
+        socket_fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (socket_fd_ < 0) return false;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, config_.socket_path.c_str(), config_.socket_path.size());
+        // 收集端未启动时connect失败; 之后每次导出前重试，不阻塞启动
+        connect(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+
+    SetEnabled(true);
+    stop_.store(false);
+    thread_ = std::thread(&Metrics::ExportLoop, this);
+    return true;
+}
+
+void Metrics::StopExport() {
+    stop_.store(true);
+    if (thread_.joinable()) thread_.join();
+    if (file_) fclose(file_);
+    file_ = nullptr;
+    if (socket_fd_ >= 0) close(socket_fd_);
+    socket_fd_ = -1;
+}
+
+void Metrics::ExportLoop() {
+    // 每份快照约100KB，放在堆上
+    std::unique_ptr<MetricsSnapshot> previous(new MetricsSnapshot());
+    std::unique_ptr<MetricsSnapshot> current(new MetricsSnapshot());
+    std::unique_ptr<MetricsSnapshot> delta(new MetricsSnapshot());
+    Snapshot(previous.get());
+    auto last = std::chrono::steady_clock::now();
+    bool stopping = false;
+    while (!stopping) {
+        // 分小段睡眠，StopExport不必等满一个周期
+        const auto deadline = last + std::chrono::milliseconds(config_.interval_ms);
+        while (!(stopping = stop_.load()) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(config_.interval_ms, 50)));
+        }
+        const auto now = std::chrono::steady_clock::now();
+        Snapshot(current.get());
+        *delta = *current;
+        delta->Subtract(*previous);
+        Export(*delta, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - last).count()));
+        previous.swap(current);
+        last = now;
+    }
+}
+
+// 一个区间一行JSON: 各阶段的样本数、均值与分位数 (微秒)，以及事件增量
+bool Metrics::Export(const MetricsSnapshot& delta, uint64_t interval_ms) {
+    char buf[256];
+    line_.clear();
+    const auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    snprintf(buf, sizeof(buf), "{\"time_ms\":%lld,\"interval_ms\":%llu,\"stages\":{",
+             static_cast<long long>(wall), static_cast<unsigned long long>(interval_ms));
+    line_ += buf;
+    bool first = true;
+    for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+        const HistogramSnapshot& h = delta.stages[s];
+        if (h.count == 0) continue;
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,"
+                 "\"p999_us\":%.3f,\"max_us\":%.3f}",
+                 first ? "" : ",", kStageNames[s], static_cast<unsigned long long>(h.count),
+                 Micros(h.sum_ns) / static_cast<double>(h.count), Micros(h.Percentile(0.5)),
+                 Micros(h.Percentile(0.9)), Micros(h.Percentile(0.99)), Micros(h.Percentile(0.999)),
+                 Micros(h.Max()));
+        line_ += buf;
+        first = false;
+    }
+    line_ += "},\"events\":{";
+    for (size_t i = 0; i < static_cast<size_t>(Event::Count); ++i) {
+        snprintf(buf, sizeof(buf), "%s\"%s\":%llu", i ? "," : "", kEventNames[i],
+                 static_cast<unsigned long long>(delta.events[i]));
+        line_ += buf;
+    }
+    line_ += "}}\n";
+
+    if (file_) {
+        const bool ok = fwrite(line_.data(), 1, line_.size(), file_) == line_.size();
+        fflush(file_);
+        return ok;
+    }
+    if (socket_fd_ >= 0) {
+        if (send(socket_fd_, line_.data(), line_.size(), 0) >= 0) return true;
+        // 收集端重启后重新连接，本区间丢弃
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, config_.socket_path.c_str(), config_.socket_path.size());
+        connect(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    return false;
+}
+
+}  // namespace utils
@@ -0,0 +1,192 @@
+//性能埋点: 分阶段延迟直方图与事件计数 (每线程单写者，后台线程定期导出)
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+namespace utils {
+
+// 流水线各阶段; 发送端: 采集 -> 编码 -> 加密 -> 摘要 -> 发送，接收端: 收包 -> 校验 -> 解密 -> 重组 -> 解码
+enum class Stage : uint8_t {
+    Capture, Encode, Encrypt, Hash, Send,
+    Receive, Verify, Decrypt, Reassembly, Decode,
+    Count
+};
+
+// 传输与会话表事件
+enum class Event : uint8_t {
+    PacketsSent, PacketsReceived, SendErrors, Retransmits, PacketsLost,
+    ReceiveDrops,       // 接收端流水线槽位用尽而丢弃的数据报
+    Malformed, AuthFailures, DemuxFailures, KeyUnavailable,
+    KeyRotations,       // 发送端发起的密钥轮换 (接收端跟随不计)
+    SessionsCreated, SessionsRemoved, SessionsExpired,
+    Count
+};
+
+const char* StageName(Stage stage);
+const char* EventName(Event event);
+
+// 对数-线性分桶 (HDR风格): 每个2的幂区间再均分kSubBuckets个子桶，相对误差约3%，覆盖1ns到约18分钟
+struct LatencyBuckets {
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+    static constexpr int kMaxBits = 40;
+    static constexpr size_t kCount = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t Index(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        const int msb = 63 - __builtin_clzll(value);
+        if (msb >= kMaxBits) return kCount - 1;
+        const int shift = msb - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    // 桶的下界 (含)
+    static uint64_t LowerBound(size_t index) {
+        if (index < 2 * kSubBuckets) return index;
+        const size_t shift = index / kSubBuckets - 1;
+        return (kSubBuckets + index % kSubBuckets) << shift;
+    }
+};
+
+// 合并后的直方图 (导出线程使用，非原子)
+struct HistogramSnapshot {
+    uint64_t counts[LatencyBuckets::kCount];
+    uint64_t count;
+    uint64_t sum_ns;
+
+    // q取[0,1]; 返回所在桶的下界，空直方图返回0
+    uint64_t Percentile(double q) const;
+    uint64_t Max() const;
+};
+
+struct MetricsSnapshot {
+    HistogramSnapshot stages[static_cast<size_t>(Stage::Count)];
+    uint64_t events[static_cast<size_t>(Event::Count)];
+
+    // 本快照减去较早的快照，得到区间内的增量
+    void Subtract(const MetricsSnapshot& earlier);
+};
+
+struct MetricsExportConfig {
+    std::string path;                   // 追加写入的文件，每次导出一行JSON
+    std::string socket_path;            // 或发送到本地UNIX数据报套接字 (每次导出一个数据报)
+    uint32_t interval_ms = 1000;
+};
+
+// 每线程一份计数区，只由该线程写入，导出线程以relaxed读取合并
+class Metrics {
+public:
+    static Metrics& Instance();
+
+    static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    static uint64_t NowNanos() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    static void Record(Stage stage, uint64_t ns) {
+        if (!Enabled()) return;
+        ThreadData::StageData& s = Local()->stages[static_cast<size_t>(stage)];
+        Bump(&s.buckets[LatencyBuckets::Index(ns)], 1);
+        Bump(&s.count, 1);
+        Bump(&s.sum_ns, ns);
+    }
+
+    static void Count(Event event, uint64_t n = 1) {
+        if (!Enabled()) return;
+        Bump(&Local()->events[static_cast<size_t>(event)], n);
+    }
+
+    // 合并所有线程 (含已退出线程) 的累计值
+    void Snapshot(MetricsSnapshot* out) const;
+
+    // 启用埋点并启动导出线程
+    bool StartExport(const MetricsExportConfig& config);
+    // 导出最后一个区间后停止 (埋点保持启用状态)
+    void StopExport();
+
+private:
+    struct alignas(64) ThreadData {
+        struct StageData {
+            std::atomic<uint64_t> buckets[LatencyBuckets::kCount];
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> sum_ns;
+        };
+        StageData stages[static_cast<size_t>(Stage::Count)];
+        std::atomic<uint64_t> events[static_cast<size_t>(Event::Count)];
+    };
+
+    Metrics();
+
+    // 单写者自增: 不需要lock前缀的读改写
+    static void Bump(std::atomic<uint64_t>* value, uint64_t n) {
+        value->store(value->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static ThreadData* Local() {
+        thread_local ThreadData* local = nullptr;
+        if (!local) local = Instance().Register();
+        return local;
+    }
+
+    ThreadData* Register();
+    void ExportLoop();
+    bool Export(const MetricsSnapshot& delta, uint64_t interval_ms);
+
+    static std::atomic<bool> enabled_;
+
+    mutable std::mutex mutex_;                          // 保护threads_
+    std::vector<std::unique_ptr<ThreadData>> threads_;  // 线程退出后保留，计数不丢失
+
+    MetricsExportConfig config_;
+    FILE* file_;
+    int socket_fd_;
+    std::string line_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+};
+
+// 作用域计时: 构造时取时，析构或Stop时记入直方图; Next结束当前阶段并开始下一阶段，两阶段共用一次取时
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), start_(Metrics::Enabled() ? Metrics::NowNanos() : 0) {}
+    ~StageTimer() { Stop(); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    void Next(Stage stage) {
+        if (start_) {
+            const uint64_t now = Metrics::NowNanos();
+            Metrics::Record(stage_, now - start_);
+            start_ = now;
+        }
+        stage_ = stage;
+    }
+
+    void Stop() {
+        if (start_) Metrics::Record(stage_, Metrics::NowNanos() - start_);
+        start_ = 0;
+    }
+
+private:
+    Stage stage_;
+    uint64_t start_;
+};
+
+}  // namespace utils
+
+#endif